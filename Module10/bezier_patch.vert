@@ -0,0 +1,12 @@
+#version 410 core
+
+// Bezier patch control point. The tessellation shaders do all the work.
+layout (location = 0) in vec3 vtx_position;
+
+// Control point in model coordinates
+layout (location = 0) out vec3 control_point;
+
+void main()
+{
+	control_point = vtx_position;
+}
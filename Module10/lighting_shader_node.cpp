@@ -1,6 +1,5 @@
 #include "Module10/lighting_shader_node.hpp"
 
-#include <cstdio>
 #include <iostream>
 
 namespace cg
@@ -50,43 +49,9 @@ bool LightingShaderNode::get_locations()
     // Populate camera position uniform location in scene state
     camera_position_loc = glGetUniformLocation(shader_program_.get_program(), "camera_position");
 
-    // Set the number of lights to 3
-    light_count_ = 3;
-    light_count_loc_ = glGetUniformLocation(shader_program_.get_program(), "num_lights");
-    if(light_count_loc_ < 0)
-    {
-        std::cout << "LightingShaderNode: Error getting num_lights location\n";
-    }
+    // Lights come from the shared light uniform block
+    if(!LightBuffer::bind_block(shader_program_.get_program())) { return false; }
 
-    // Get light uniforms
-    char name[128];
-    for(int i = 0; i < light_count_; i++)
-    {
-        snprintf(name, 128, "lights[%d].enabled", i);
-        lights_[i].enabled = glGetUniformLocation(shader_program_.get_program(), name);
-        snprintf(name, 128, "lights[%d].spotlight", i);
-        lights_[i].spotlight = glGetUniformLocation(shader_program_.get_program(), name);
-        snprintf(name, 128, "lights[%d].position", i);
-        lights_[i].position = glGetUniformLocation(shader_program_.get_program(), name);
-        snprintf(name, 128, "lights[%d].ambient", i);
-        lights_[i].ambient = glGetUniformLocation(shader_program_.get_program(), name);
-        snprintf(name, 128, "lights[%d].diffuse", i);
-        lights_[i].diffuse = glGetUniformLocation(shader_program_.get_program(), name);
-        snprintf(name, 128, "lights[%d].specular", i);
-        lights_[i].specular = glGetUniformLocation(shader_program_.get_program(), name);
-        snprintf(name, 128, "lights[%d].constant_attenuation", i);
-        lights_[i].att_constant = glGetUniformLocation(shader_program_.get_program(), name);
-        snprintf(name, 128, "lights[%d].linear_attenuation", i);
-        lights_[i].att_linear = glGetUniformLocation(shader_program_.get_program(), name);
-        snprintf(name, 128, "lights[%d].quadratic_attenuation", i);
-        lights_[i].att_quadratic = glGetUniformLocation(shader_program_.get_program(), name);
-        snprintf(name, 128, "lights[%d].spot_cutoff", i);
-        lights_[i].spot_cutoff = glGetUniformLocation(shader_program_.get_program(), name);
-        snprintf(name, 128, "lights[%d].spot_exponent", i);
-        lights_[i].spot_exponent = glGetUniformLocation(shader_program_.get_program(), name);
-        snprintf(name, 128, "lights[%d].spot_direction", i);
-        lights_[i].spot_direction = glGetUniformLocation(shader_program_.get_program(), name);
-    }
     global_ambient_loc_ =
         glGetUniformLocation(shader_program_.get_program(), "global_light_ambient");
     if(global_ambient_loc_ < 0)
@@ -94,15 +59,14 @@ bool LightingShaderNode::get_locations()
         std::cout << "LightingShaderNode: Error getting global ambient location\n";
     }
 
-    // Populate material uniform locations in scene state
-    material_ambient_loc_ = glGetUniformLocation(shader_program_.get_program(), "material_ambient");
-    material_diffuse_loc_ = glGetUniformLocation(shader_program_.get_program(), "material_diffuse");
-    material_specular_loc_ =
-        glGetUniformLocation(shader_program_.get_program(), "material_specular");
-    material_emission_loc_ =
-        glGetUniformLocation(shader_program_.get_program(), "material_emission");
-    material_shininess_loc_ =
-        glGetUniformLocation(shader_program_.get_program(), "material_shininess");
+    // Materials come from the shared material table
+    if(!MaterialRegistry::bind_block(shader_program_.get_program())) { return false; }
+    material_index_loc_ = glGetUniformLocation(shader_program_.get_program(), "material_index");
+    if(material_index_loc_ < 0)
+    {
+        std::cout << "LightingShaderNode: Error getting material_index location\n";
+        return false;
+    }
 
     texture_sampler_loc_ = glGetUniformLocation(shader_program_.get_program(), "texture_sampler");
     if(texture_sampler_loc_ < 0)
@@ -110,19 +74,36 @@ bool LightingShaderNode::get_locations()
         std::cout << "Warning: texture_sampler location not found\n";
     }
 
-    use_texture_loc_ = glGetUniformLocation(shader_program_.get_program(), "use_texture");
-    if(use_texture_loc_ < 0)
+    // Instanced drawing is optional - without it each geometry node is drawn
+    // with its own draw call
+    instanced_loc_ = glGetUniformLocation(shader_program_.get_program(), "instanced");
+    pv_matrix_loc_ = glGetUniformLocation(shader_program_.get_program(), "pv_matrix");
+    instance_model_loc_ =
+        glGetAttribLocation(shader_program_.get_program(), "instance_model_matrix");
+    instance_normal_loc_ =
+        glGetAttribLocation(shader_program_.get_program(), "instance_normal_matrix");
+    instance_material_loc_ =
+        glGetAttribLocation(shader_program_.get_program(), "instance_material");
+    if(instanced_loc_ < 0 || pv_matrix_loc_ < 0 || instance_model_loc_ < 0 ||
+       instance_normal_loc_ < 0 || instance_material_loc_ < 0)
     {
-        std::cout << "Warning: use_texture location not found\n";
+        std::cout << "Warning: instance locations not found, instancing disabled\n";
+        instanced_loc_ = -1;
     }
 
+    // Packed vertex buffers are decoded in the vertex shader
+    vertex_packing_loc_ = glGetUniformLocation(shader_program_.get_program(), "vertex_packing");
+    position_offset_loc_ =
+        glGetUniformLocation(shader_program_.get_program(), "position_offset");
+    position_scale_loc_ = glGetUniformLocation(shader_program_.get_program(), "position_scale");
+
     return true;
 }
 
-void LightingShaderNode::draw(SceneState &scene_state)
+void LightingShaderNode::apply(SceneState &scene_state)
 {
     // Enable this program
-    shader_program_.use();
+    scene_state.gl_state.use_program(shader_program_.get_program());
 
     // Set scene state locations to ones needed for this program
     scene_state.position_loc = position_loc_;
@@ -133,22 +114,30 @@ void LightingShaderNode::draw(SceneState &scene_state)
     scene_state.normal_matrix_loc = normal_matrix_loc_;
     scene_state.camera_position_loc = camera_position_loc;
 
-    // Set material uniform location
-    scene_state.material_ambient_loc = material_ambient_loc_;
-    scene_state.material_diffuse_loc = material_diffuse_loc_;
-    scene_state.material_specular_loc = material_specular_loc_;
-    scene_state.material_emission_loc = material_emission_loc_;
-    scene_state.material_shininess_loc = material_shininess_loc_;
+    // Presentation nodes select their material from the material table.
+    // The program has no material uniforms to fall back to.
+    scene_state.material_index_loc = material_index_loc_;
+    scene_state.material_ambient_loc = -1;
+    scene_state.material_diffuse_loc = -1;
+    scene_state.material_specular_loc = -1;
+    scene_state.material_emission_loc = -1;
+    scene_state.material_shininess_loc = -1;
+    scene_state.use_texture_loc = -1;
 
     scene_state.texture_sampler_loc = texture_sampler_loc_;
-    scene_state.use_texture_loc = use_texture_loc_;
-
-    // Set the light locations
-    scene_state.lightcount_loc = light_count_loc_;
-    for(uint32_t i = 0; i < light_count_; i++) { scene_state.lights[i] = lights_[i]; }
 
-    // Draw all children
-    SceneNode::draw(scene_state);
+    // Render queues may draw instances with this program
+    scene_state.instanced_loc = instanced_loc_;
+    scene_state.pv_matrix_loc = pv_matrix_loc_;
+    scene_state.instance_model_loc = instance_model_loc_;
+    scene_state.instance_normal_loc = instance_normal_loc_;
+    scene_state.instance_material_loc = instance_material_loc_;
+    scene_state.gl_state.uniform1i(instanced_loc_, 0);
+
+    // Surfaces tell the program how their vertex buffers are packed
+    scene_state.vertex_packing_loc = vertex_packing_loc_;
+    scene_state.position_offset_loc = position_offset_loc_;
+    scene_state.position_scale_loc = position_scale_loc_;
 }
 
 void LightingShaderNode::set_global_ambient(const Color4 &global_ambient)
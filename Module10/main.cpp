@@ -18,9 +18,13 @@
 #include "scene/scene.hpp"
 
 #include "Module10/lighting_shader_node.hpp"
+#include "Module10/patch_lighting_shader_node.hpp"
 
 #include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <memory>
 #include <thread>
 #include <vector>
 
@@ -62,6 +66,12 @@ std::shared_ptr<cg::LightNode> Spotlight;
 
 cg::SceneState g_scene_state;
 
+// Software occlusion buffer (walls, table, and box hide what is behind them)
+cg::OcclusionBuffer g_occlusion_buffer(256, 192);
+
+// Hardware occlusion queries (optional, toggled with 'g')
+cg::OcclusionQueries g_occlusion_queries;
+
 // While mouse button is down, the view will be updated
 bool    g_animate = false;
 bool    g_forward = true;
@@ -71,6 +81,23 @@ int32_t g_mouse_y = 0;
 int32_t g_render_width = 800;
 int32_t g_render_height = 600;
 
+// Size of the optional grid of boxes (stress test, set from the command line)
+int32_t g_box_grid = 0;
+
+// Bake the static scene into merged surfaces (set from the command line).
+// The original graph is kept since the baked materials share its textures.
+bool                           g_bake_static = false;
+std::shared_ptr<cg::SceneNode> g_unbaked_scene;
+
+// Geometry pools holding the static meshes (one per vertex layout)
+std::unique_ptr<cg::GeometryPool> g_pool;
+std::unique_ptr<cg::GeometryPool> g_textured_pool;
+
+// Draw the teapot on the table from its Bezier patches, tessellated by
+// the GPU each frame (set from the command line)
+bool                                         g_tessellate_teapot = false;
+std::shared_ptr<cg::PatchLightingShaderNode> g_patch_shader;
+
 // Sleep function to help run a reasonable timer
 void sleep(int32_t milliseconds)
 {
@@ -88,6 +115,7 @@ void display()
     // Init scene state and draw the scene graph
     g_scene_state.init();
     g_scene_root->draw(g_scene_state);
+    g_scene_state.gl_state.end_frame();
 
     // Swap buffers
     SDL_GL_SwapWindow(g_sdl_window);
@@ -106,6 +134,9 @@ void reshape(int32_t width, int32_t height)
     // Reset the viewport
     glViewport(0, 0, width, height);
 
+    // The teapot is tessellated to the size of its edges on screen
+    if(g_patch_shader != nullptr) g_patch_shader->set_viewport(width, height);
+
     // Reset the perspective projection to reflect the change of aspect ratio
     // Make sure we cast to float so we get a fractional aspect ratio.
     g_camera->change_aspect_ratio(static_cast<float>(width) / static_cast<float>(height));
@@ -262,6 +293,86 @@ bool handle_key_event(const SDL_Event &event)
             else g_camera->slide(0.0f, 0.0f, 5.0f);
             update_spotlight();
             break;
+
+        // Print the culling and GL call counts for the last frame
+        case SDLK_C:
+            if(event.type == SDL_EVENT_KEY_DOWN)
+            {
+                std::cout << "Frustum culling: " << g_scene_state.nodes_drawn << " drawn, "
+                          << g_scene_state.nodes_culled << " culled, "
+                          << g_scene_state.nodes_occluded << " occluded, "
+                          << g_scene_state.draws_skipped << " skipped by queries\n";
+                std::cout << "State changes: " << g_scene_state.state_changes_unsorted
+                          << " in compiled order, " << g_scene_state.state_changes << " drawn ("
+                          << (g_scene_state.sort_draws ? "sorted" : "unsorted") << ")\n";
+                std::cout << "GL state calls: " << g_scene_state.gl_state.get_issued_calls()
+                          << " issued, " << g_scene_state.gl_state.get_elided_calls()
+                          << " elided\n";
+                std::cout << "Material table: " << g_scene_state.materials.size()
+                          << " unique materials\n";
+                std::cout << "Draw calls: " << g_scene_state.draw_calls << " ("
+                          << g_scene_state.instanced_calls << " instanced, "
+                          << g_scene_state.multi_draw_calls << " multi-draw)\n";
+            }
+            break;
+
+        // Toggle draw sorting in render queues
+        case SDLK_S:
+            if(event.type == SDL_EVENT_KEY_DOWN)
+            {
+                g_scene_state.sort_draws = !g_scene_state.sort_draws;
+                std::cout << "Draw sorting " << (g_scene_state.sort_draws ? "on" : "off") << '\n';
+            }
+            break;
+
+        // Toggle instanced drawing in render queues
+        case SDLK_N:
+            if(event.type == SDL_EVENT_KEY_DOWN)
+            {
+                g_scene_state.instance_draws = !g_scene_state.instance_draws;
+                std::cout << "Instanced drawing " << (g_scene_state.instance_draws ? "on" : "off")
+                          << '\n';
+            }
+            break;
+
+        // Toggle occlusion culling
+        case SDLK_O:
+            if(event.type == SDL_EVENT_KEY_DOWN)
+            {
+                g_scene_state.occlusion_buffer =
+                    (g_scene_state.occlusion_buffer == nullptr) ? &g_occlusion_buffer : nullptr;
+                std::cout << "Occlusion culling "
+                          << (g_scene_state.occlusion_buffer != nullptr ? "on" : "off") << '\n';
+            }
+            break;
+
+        // Toggle hardware occlusion queries
+        case SDLK_G:
+            if(event.type == SDL_EVENT_KEY_DOWN)
+            {
+                if(g_scene_state.occlusion_queries != nullptr)
+                {
+                    g_scene_state.occlusion_queries = nullptr;
+                }
+                else if(g_occlusion_queries.init())
+                {
+                    g_scene_state.occlusion_queries = &g_occlusion_queries;
+                }
+                std::cout << "Occlusion queries "
+                          << (g_scene_state.occlusion_queries != nullptr ? "on" : "off") << '\n';
+            }
+            break;
+
+        // Coarser/finer tessellation of the teapot patches
+        case SDLK_T:
+            if(event.type == SDL_EVENT_KEY_DOWN && g_patch_shader != nullptr)
+            {
+                float pixels = g_patch_shader->get_edge_pixels();
+                g_patch_shader->set_edge_pixels(upper_case ? pixels * 2.0f : pixels * 0.5f);
+                std::cout << "Teapot edges " << g_patch_shader->get_edge_pixels()
+                          << " pixels long\n";
+            }
+            break;
         default: break;
     }
 
@@ -446,6 +557,61 @@ std::shared_ptr<cg::SceneNode> construct_table(std::shared_ptr<cg::SceneNode>
     return table;
 }
 
+/**
+ * Construct a grid of boxes, each with a cone on top, covering the floor.
+ * Used to stress the render queue with many draws of the same geometry.
+ * @param  box   Geometry node to use for the boxes
+ * @param  cone  Geometry node to use for the cones
+ * @param  n     Number of boxes along each side of the grid
+ * @return Returns a scene node holding the grid.
+ */
+std::shared_ptr<cg::SceneNode> construct_box_grid(std::shared_ptr<cg::SceneNode>    box,
+                                                  std::shared_ptr<cg::ConicSurface> cone,
+                                                  int32_t                           n)
+{
+    // Each box gets its own presentation node using one of a few colors
+    // (the material table stores each color once)
+    const cg::Color4 colors[] = {cg::Color4(0.6f, 0.2f, 0.2f),
+                                 cg::Color4(0.2f, 0.6f, 0.2f),
+                                 cg::Color4(0.2f, 0.2f, 0.6f),
+                                 cg::Color4(0.6f, 0.6f, 0.2f)};
+
+    // Boxes are spaced evenly over the floor (-90 to 90 in x and y)
+    auto  grid = std::make_shared<cg::SceneNode>();
+    float spacing = 180.0f / static_cast<float>(n);
+    float size = spacing * 0.5f;
+    for(int32_t i = 0; i < n; i++)
+    {
+        for(int32_t j = 0; j < n; j++)
+        {
+            auto cell = std::make_shared<cg::TransformNode>();
+            cell->translate(-90.0f + (i + 0.5f) * spacing, -90.0f + (j + 0.5f) * spacing, 0.0f);
+
+            auto box_transform = std::make_shared<cg::TransformNode>();
+            box_transform->translate(0.0f, 0.0f, size * 0.5f);
+            box_transform->scale(size, size, size);
+            auto cone_transform = std::make_shared<cg::TransformNode>();
+            cone_transform->translate(0.0f, 0.0f, size);
+            cone_transform->scale(size * 0.5f, size * 0.5f, size);
+
+            const cg::Color4 &c = colors[(i + j) % 4];
+            auto material = std::make_shared<cg::PresentationNode>(
+                cg::Color4(c.r * 0.5f, c.g * 0.5f, c.b * 0.5f),
+                c,
+                cg::Color4(0.3f, 0.3f, 0.3f),
+                cg::Color4(0.0f, 0.0f, 0.0f),
+                32.0f);
+            grid->add_child(cell);
+            cell->add_child(material);
+            material->add_child(box_transform);
+            box_transform->add_child(box);
+            material->add_child(cone_transform);
+            cone_transform->add_child(cone);
+        }
+    }
+    return grid;
+}
+
 /**
  * Construct a unit box with outward facing normals.
  * @param  unit_square  Geometry node to use
@@ -729,6 +895,46 @@ void construct_lighting(std::shared_ptr<cg::LightingShaderNode> lighting)
     light_1->add_child(Spotlight);
 }
 
+/**
+ * Construct the teapot from its Bezier patches with a program that
+ * tessellates them on the GPU, placed on the table.
+ * @param  material  Teapot material.
+ * @return Returns the shader node (root of the teapot).
+ */
+std::shared_ptr<cg::SceneNode>
+construct_patch_teapot(std::shared_ptr<cg::PresentationNode> material)
+{
+    g_patch_shader = std::make_shared<cg::PatchLightingShaderNode>();
+    if(!g_patch_shader->create("Module10/bezier_patch.vert",
+                               "Module10/bezier_patch.tesc",
+                               "Module10/bezier_patch.tese",
+                               "Module10/pixel_lighting.frag") ||
+       !g_patch_shader->get_locations())
+    {
+        exit(-1);
+    }
+    g_patch_shader->set_global_ambient(cg::Color4(0.4f, 0.4f, 0.4f, 1.0f));
+
+    // Only the control points and patch indexes are uploaded
+    std::vector<cg::Point3> points;
+    std::vector<uint16_t>   indices;
+    cg::MeshTeapot::get_control_points(points, indices);
+    auto teapot =
+        std::make_shared<cg::BezierPatchNode>(points, indices, g_patch_shader->get_position_loc());
+    std::cout << "Tessellated teapot: " << teapot->get_patch_count() << " patches, "
+              << teapot->get_control_point_count() << " control points, "
+              << teapot->get_buffer_size() << " bytes\n";
+
+    // Table position, then the teapot on top of the table
+    auto transform = std::make_shared<cg::TransformNode>();
+    transform->translate(-50.0f, 50.0f, 0.0f);
+    transform->rotate_z(30.0f);
+    transform->translate(0.0f, 0.0f, 26.0f);
+    transform->scale(2.5f, 2.5f, 2.5f);
+    add_sub_tree(g_patch_shader, material, transform, teapot);
+    return g_patch_shader;
+}
+
 /**
  * Construct the scene
  */
@@ -761,6 +967,9 @@ void construct_scene()
     // Construct subdivided square - subdivided 10x in both x and y
     auto unit_square = std::make_shared<cg::UnitSquareSurface>(2, position_loc, normal_loc);
 
+    // The walls, table, and box are large and simple, so use them as occluders
+    unit_square->set_occluder(true);
+
     // NEW: Create textured floor with texture coordinates
     auto textured_floor = std::make_shared<cg::UnitSquareSurface>(
         40,           // More subdivisions for better quality
@@ -797,7 +1006,7 @@ void construct_scene()
     table_transform->rotate_z(30.0f);
 
     // Teapot
-    auto teapot = std::make_shared<cg::MeshTeapot>(4, position_loc, normal_loc);
+    auto teapot = std::make_shared<cg::MeshTeapot>(5, position_loc, normal_loc);
 
     // Silver material (for the teapot)
     auto teapot_material =
@@ -857,9 +1066,9 @@ void construct_scene()
 
     // Construct a base node for the rest of the scene, it will be a child
     // of the last light node (so entire scene is under influence of all
-    // lights)
-    auto myscene = std::make_shared<cg::SceneNode>();
-    Spotlight->add_child(myscene);
+    // lights). The scene below is static, so draw it from a compiled render
+    // queue rather than traversing the graph each frame.
+    auto myscene = std::make_shared<cg::CompiledSceneNode>();
 
     // Add the room (walls, floor, ceiling)
     myscene->add_child(room);
@@ -887,6 +1096,48 @@ void construct_scene()
     
     // Add Coke can to scene
     myscene->add_child(create_coke_can(position_loc, normal_loc, texcoord_loc));
+
+    // Add the optional grid of boxes
+    if(g_box_grid > 0) { myscene->add_child(construct_box_grid(unit_box, cone, g_box_grid)); }
+
+    // Optionally replace the scene with pre-transformed merged surfaces
+    std::shared_ptr<cg::SceneNode> static_scene = myscene;
+    if(g_bake_static)
+    {
+        cg::StaticBaker baker(position_loc, normal_loc, texcoord_loc);
+        auto            baked = std::make_shared<cg::CompiledSceneNode>();
+        baked->add_child(baker.bake(*myscene));
+        std::cout << "Static bake: " << baker.get_surface_count() << " surfaces merged into "
+                  << baker.get_merged_count() << ", " << baker.get_kept_count()
+                  << " nodes kept\n";
+        g_unbaked_scene = myscene;
+        static_scene = baked;
+    }
+    Spotlight->add_child(static_scene);
+
+    // The tessellated teapot has its own program, so it is drawn after the
+    // rest of the scene
+    if(g_tessellate_teapot) { Spotlight->add_child(construct_patch_teapot(teapot_material)); }
+
+    // Move the static meshes into shared vertex and index buffers
+    g_pool = std::make_unique<cg::GeometryPool>(
+        cg::VertexLayout::POSITION_NORMAL, position_loc, normal_loc);
+    g_textured_pool = std::make_unique<cg::GeometryPool>(
+        cg::VertexLayout::POSITION_NORMAL_TEXTURE, position_loc, normal_loc, texcoord_loc);
+    uint32_t pooled =
+        g_pool->add_subtree(*static_scene) + g_textured_pool->add_subtree(*static_scene);
+    std::cout << "Geometry pools: " << pooled << " meshes, "
+              << g_pool->get_vertex_count() + g_textured_pool->get_vertex_count()
+              << " vertices\n";
+
+    // Binding the pools uploads them and frees their copies of the meshes.
+    // Everything is on the GPU then (occluders keep their own copies), so
+    // free the CPU vertex and face lists.
+    g_pool->bind(g_scene_state);
+    g_textured_pool->bind(g_scene_state);
+    size_t released = cg::release_cpu_data(*myscene);
+    if(static_scene != myscene) { released += cg::release_cpu_data(*static_scene); }
+    std::cout << "Released " << released / 1024 << " KB of CPU vertex and face lists\n";
 }
 
 /**
@@ -896,6 +1147,16 @@ int main(int argc, char **argv)
 {
     cg::set_root_paths(argv[0]);
 
+    // An optional argument n adds an n x n grid of boxes to the room and
+    // "bake" merges the static scene into a few surfaces, and "tess" adds
+    // the teapot, tessellated on the GPU
+    for(int i = 1; i < argc; i++)
+    {
+        if(std::strcmp(argv[i], "bake") == 0) g_bake_static = true;
+        else if(std::strcmp(argv[i], "tess") == 0) g_tessellate_teapot = true;
+        else g_box_grid = std::atoi(argv[i]);
+    }
+
     // Print the keyboard commands
     std::cout << "i - Reset to initial view\n";
     std::cout << "R - Roll    5 degrees clockwise   r - Counter-clockwise\n";
@@ -905,6 +1166,12 @@ int main(int argc, char **argv)
     std::cout << "Y - Slide camera up               y - Slide camera down\n";
     std::cout << "F - Move camera forward           f - Move camera backwards\n";
     std::cout << "V - Faster mouse movement         v - Slower mouse movement\n";
+    std::cout << "c - Print culling and GL state call counts\n";
+    std::cout << "s - Toggle draw sorting\n";
+    std::cout << "n - Toggle instanced drawing\n";
+    std::cout << "o - Toggle occlusion culling\n";
+    std::cout << "g - Toggle hardware occlusion queries\n";
+    std::cout << "T - Coarser teapot tessellation   t - Finer (with \"tess\")\n";
     std::cout << "ESC - Exit Program\n";
 
     // Initialize SDL
@@ -965,6 +1232,7 @@ int main(int argc, char **argv)
 
     // Construct scene.
     construct_scene();
+    g_scene_state.occlusion_buffer = &g_occlusion_buffer;
 
     // Enable multi-sample anti-aliasing
     glEnable(GL_MULTISAMPLE);
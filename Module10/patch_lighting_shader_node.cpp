@@ -0,0 +1,106 @@
+#include "Module10/patch_lighting_shader_node.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+namespace cg
+{
+
+PatchLightingShaderNode::PatchLightingShaderNode() :
+    viewport_size_loc_(-1), edge_pixels_loc_(-1), max_tess_level_loc_(-1),
+    viewport_width_(1.0f), viewport_height_(1.0f), edge_pixels_(DEFAULT_EDGE_PIXELS),
+    max_tess_level_(64.0f)
+{
+}
+
+bool PatchLightingShaderNode::get_locations()
+{
+    GLuint program = shader_program_.get_program();
+    position_loc_ = glGetAttribLocation(program, "vtx_position");
+    if(position_loc_ < 0)
+    {
+        std::cout << "PatchLightingShaderNode: Error getting vtx_position location\n";
+        return false;
+    }
+
+    // Normals and texture coordinates come from the tessellation
+    // evaluation shader
+    vertex_normal_loc_ = -1;
+    texcoord_loc_ = -1;
+
+    pvm_matrix_loc_ = glGetUniformLocation(program, "pvm_matrix");
+    model_matrix_loc_ = glGetUniformLocation(program, "model_matrix");
+    normal_matrix_loc_ = glGetUniformLocation(program, "normal_matrix");
+    if(pvm_matrix_loc_ < 0 || model_matrix_loc_ < 0 || normal_matrix_loc_ < 0)
+    {
+        std::cout << "PatchLightingShaderNode: Error getting matrix locations\n";
+        return false;
+    }
+    camera_position_loc = glGetUniformLocation(program, "camera_position");
+
+    // Lights and materials come from the shared uniform blocks
+    if(!LightBuffer::bind_block(program) || !MaterialRegistry::bind_block(program))
+    {
+        return false;
+    }
+    global_ambient_loc_ = glGetUniformLocation(program, "global_light_ambient");
+    material_index_loc_ = glGetUniformLocation(program, "material_index");
+    if(material_index_loc_ < 0)
+    {
+        std::cout << "PatchLightingShaderNode: Error getting material_index location\n";
+        return false;
+    }
+    texture_sampler_loc_ = glGetUniformLocation(program, "texture_sampler");
+
+    // Patches are drawn one node at a time and are not packed
+    instanced_loc_ = -1;
+    pv_matrix_loc_ = -1;
+    instance_model_loc_ = -1;
+    instance_normal_loc_ = -1;
+    instance_material_loc_ = -1;
+    vertex_packing_loc_ = -1;
+    position_offset_loc_ = -1;
+    position_scale_loc_ = -1;
+
+    viewport_size_loc_ = glGetUniformLocation(program, "viewport_size");
+    edge_pixels_loc_ = glGetUniformLocation(program, "edge_pixels");
+    max_tess_level_loc_ = glGetUniformLocation(program, "max_tess_level");
+    if(viewport_size_loc_ < 0 || edge_pixels_loc_ < 0 || max_tess_level_loc_ < 0)
+    {
+        std::cout << "PatchLightingShaderNode: Error getting tessellation locations\n";
+        return false;
+    }
+    GLint max_level = 64;
+    glGetIntegerv(GL_MAX_TESS_GEN_LEVEL, &max_level);
+    max_tess_level_ = static_cast<float>(max_level);
+    return true;
+}
+
+void PatchLightingShaderNode::apply(SceneState &scene_state)
+{
+    // The camera sets its position in the program current when it is drawn,
+    // so set it here for this one
+    scene_state.gl_state.use_program(shader_program_.get_program());
+    scene_state.gl_state.uniform3fv(camera_position_loc, &scene_state.camera_position.x);
+    scene_state.gl_state.uniform2f(viewport_size_loc_, viewport_width_, viewport_height_);
+    scene_state.gl_state.uniform1f(edge_pixels_loc_, edge_pixels_);
+    scene_state.gl_state.uniform1f(max_tess_level_loc_, max_tess_level_);
+
+    // Set the scene state locations
+    LightingShaderNode::apply(scene_state);
+}
+
+void PatchLightingShaderNode::set_viewport(int32_t width, int32_t height)
+{
+    viewport_width_ = static_cast<float>(std::max(width, 1));
+    viewport_height_ = static_cast<float>(std::max(height, 1));
+}
+
+void PatchLightingShaderNode::set_edge_pixels(float pixels)
+{
+    edge_pixels_ = std::max(pixels, 0.5f);
+}
+
+float PatchLightingShaderNode::get_edge_pixels() const { return edge_pixels_; }
+
+} // namespace cg
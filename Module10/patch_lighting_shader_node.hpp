@@ -0,0 +1,85 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:	David W. Nesbitt
+//	File:    patch_lighting_shader_node.hpp
+//	Purpose: Lighting shader program that tessellates Bezier patches.
+//
+//============================================================================
+
+#ifndef __MODULE10_PATCH_LIGHTING_SHADER_NODE_HPP__
+#define __MODULE10_PATCH_LIGHTING_SHADER_NODE_HPP__
+
+#include "Module10/lighting_shader_node.hpp"
+
+namespace cg
+{
+
+// Default target length of a tessellated patch edge, in pixels
+constexpr float DEFAULT_EDGE_PIXELS = 4.0f;
+
+/**
+ * Lighting shader node for BezierPatchNode geometry. The tessellation
+ * control shader divides each patch edge so its pieces are about
+ * edge_pixels long on screen, so detail follows the distance to the
+ * camera every frame. The fragment shader is the one of
+ * LightingShaderNode. Patches have no normal or texture coordinate
+ * attributes and are not instanced or packed.
+ */
+class PatchLightingShaderNode : public LightingShaderNode
+{
+  public:
+    /**
+     * Constructor.
+     */
+    PatchLightingShaderNode();
+
+    /**
+     * Gets uniform and attribute locations.
+     */
+    bool get_locations() override;
+
+    /**
+     * Apply method for this shader - enable the program and set the camera
+     * and tessellation uniforms.
+     * @param  scene_state   Current scene state.
+     */
+    void apply(SceneState &scene_state) override;
+
+    /**
+     * Set the viewport size used to measure edges on screen. Call when
+     * the window is resized.
+     * @param  width   Viewport width in pixels
+     * @param  height  Viewport height in pixels
+     */
+    void set_viewport(int32_t width, int32_t height);
+
+    /**
+     * Set the target length of a tessellated patch edge.
+     * @param  pixels  Length in pixels (smaller is finer)
+     */
+    void set_edge_pixels(float pixels);
+
+    /**
+     * Get the target length of a tessellated patch edge.
+     * @return  Returns the length in pixels.
+     */
+    float get_edge_pixels() const;
+
+  protected:
+    // Tessellation uniform locations
+    GLint viewport_size_loc_;
+    GLint edge_pixels_loc_;
+    GLint max_tess_level_loc_;
+
+    float viewport_width_;
+    float viewport_height_;
+    float edge_pixels_;
+    float max_tess_level_; // Largest level the implementation supports
+};
+
+} // namespace cg
+
+#endif
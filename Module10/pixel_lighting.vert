@@ -8,16 +8,46 @@ layout (location = 1) in vec3 vtx_normal;
 
 layout (location = 2) in vec2 vtx_texcoord;
 
+// Per-instance model matrix, normal matrix, and material index (used by
+// instanced draws only). Each matrix takes 4 locations.
+layout (location = 3) in mat4 instance_model_matrix;
+layout (location = 7) in mat4 instance_normal_matrix;
+layout (location = 11) in int instance_material;
+
 // Outgoing normal and vertex (interpolated) in world coordinates
 layout (location = 0) smooth out vec3 normal;
 layout (location = 1) smooth out vec3 vertex;
 
 layout (location = 2) smooth out vec2 texcoord;
 
+// Index of the material in the material table
+layout (location = 3) flat out int material_id;
+
 // Uniforms for matrices
 uniform mat4 pvm_matrix;	// Composite projection, view, model matrix
 uniform mat4 model_matrix;	// Modeling  matrix
 uniform mat4 normal_matrix;	// Normal transformation matrix
+uniform mat4 pv_matrix;		// Composite projection and view matrix (instanced draws)
+
+uniform int  material_index;	// Material table index (non-instanced draws)
+uniform bool instanced;		// Take matrices and material from the instance attributes
+
+// Packed vertex buffers (TriSurface::pack_vertices). Flag 1: the normal is
+// octahedral encoded in xy. Flag 4: the position is quantized to the bounds
+// of the mesh, position_offset + vtx_position * position_scale.
+uniform int  vertex_packing;
+uniform vec3 position_offset;
+uniform vec3 position_scale;
+
+// Decode a unit vector folded onto a square by the octahedral encoding
+vec3 octahedral_decode(vec2 e)
+{
+	vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-v.z, 0.0);
+	v.x += (v.x >= 0.0) ? -t : t;
+	v.y += (v.y >= 0.0) ? -t : t;
+	return normalize(v);
+}
 
 // Simple shader for Phong (per-pixel) shading. The fragment shader will
 // do all the work. We need to pass per-vertex normals to the fragment
@@ -25,11 +55,28 @@ uniform mat4 normal_matrix;	// Normal transformation matrix
 // the fragment shader can interpolate world coordinates.
 void main()
 {
-	// Transform normal and position to world coords. 
-	normal = normalize(vec3(normal_matrix * vec4(vtx_normal, 0.0)));
-	vertex = vec3((model_matrix * vec4(vtx_position, 1.0)));
+	// Model coordinate position and normal (decoded if packed)
+	vec3 model_position = ((vertex_packing & 4) != 0) ?
+		position_offset + vtx_position * position_scale : vtx_position;
+	vec3 model_normal = ((vertex_packing & 1) != 0) ?
+		octahedral_decode(vtx_normal.xy) : vtx_normal;
+	if (instanced)
+	{
+		// Transform normal and position to world coords, then to clip coords
+		normal = normalize(vec3(instance_normal_matrix * vec4(model_normal, 0.0)));
+		vertex = vec3(instance_model_matrix * vec4(model_position, 1.0));
+		gl_Position = pv_matrix * vec4(vertex, 1.0);
+		material_id = instance_material;
+	}
+	else
+	{
+		// Transform normal and position to world coords. 
+		normal = normalize(vec3(normal_matrix * vec4(model_normal, 0.0)));
+		vertex = vec3((model_matrix * vec4(model_position, 1.0)));
 
-	// Convert position to clip coordinates and pass along
-	gl_Position = pvm_matrix * vec4(vtx_position, 1.0);
+		// Convert position to clip coordinates and pass along
+		gl_Position = pvm_matrix * vec4(model_position, 1.0);
+		material_id = material_index;
+	}
    texcoord = vtx_texcoord;
 }
@@ -30,11 +30,11 @@ class LightingShaderNode : public ShaderNode
     bool get_locations() override;
 
     /**
-     * Draw method for this shader - enable the program and set up uniforms
+     * Apply method for this shader - enable the program and set up uniforms
      * and vertex attribute locations
      * @param  scene_state   Current scene state.
      */
-    void draw(SceneState &scene_state) override;
+    void apply(SceneState &scene_state) override;
 
     /**
      * Set the global ambient lighting property. This sets uniforms in the
@@ -64,18 +64,11 @@ class LightingShaderNode : public ShaderNode
     GLint normal_matrix_loc_;  // Normal transformation matrix location
     GLint camera_position_loc; // Camera position uniform location
 
-    // Material uniform locations
-    GLint material_ambient_loc_;   // Material ambient location
-    GLint material_diffuse_loc_;   // Material diffuse location
-    GLint material_specular_loc_;  // Material specular location
-    GLint material_emission_loc_;  // Material emission location
-    GLint material_shininess_loc_; // Material shininess location
+    // Index into the material table
+    GLint material_index_loc_;
 
     // Lighting uniforms
-    int32_t       light_count_;        // Number of lights
-    GLint         light_count_loc_;    // Light count uniform locations
-    GLint         global_ambient_loc_; // Global ambient uniform location
-    LightUniforms lights_[3];          // Light source uniform locations
+    GLint global_ambient_loc_; // Global ambient uniform location
 };
 
 } // namespace cg
@@ -89,6 +89,7 @@ void display()
     // Init scene state and draw the scene graph
     g_scene_state.init();
     g_scene_root->draw(g_scene_state);
+    g_scene_state.gl_state.end_frame();
 
     // Swap buffers
     SDL_GL_SwapWindow(g_sdl_window);
@@ -697,7 +698,7 @@ void construct_scene()
     table_transform->rotate_z(30.0f);
 
     // Teapot
-    auto teapot = std::make_shared<cg::MeshTeapot>(4, position_loc, normal_loc);
+    auto teapot = std::make_shared<cg::MeshTeapot>(5, position_loc, normal_loc);
 
     // Silver material (for the teapot)
     auto teapot_material =
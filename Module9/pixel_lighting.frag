@@ -8,12 +8,27 @@ layout (location = 1) smooth in vec3 vertex;
 
 layout (location = 0) out vec4 frag_color; 
 
-// Uniforms for material properties
-uniform vec4 material_ambient;
-uniform vec4 material_diffuse;
-uniform vec4 material_specular;
-uniform vec4 material_emission;
-uniform float material_shininess;
+// Materials, shared by all programs that use the material table through a
+// uniform block (std140 layout, matches cg::Material). MAX_MATERIALS must
+// match the application.
+const int MAX_MATERIALS = 128;
+struct Material
+{
+   vec4  ambient;
+   vec4  diffuse;
+   vec4  specular;
+   vec4  emission;
+   float shininess;
+   int   use_texture;
+};
+layout (std140) uniform MaterialBlock
+{
+   Material materials[MAX_MATERIALS];
+};
+uniform int material_index;  // Material of the current draw
+
+// Material of the current draw (set at the start of main)
+Material material;
 
 // Global lighting environment ambient intensity
 uniform vec4  global_light_ambient;
@@ -21,27 +36,30 @@ uniform vec4  global_light_ambient;
 // Camera position in world coordinates
 uniform vec3  camera_position;
 
-// Number of active lights
-uniform int num_lights;
-
-// Structure for a light source. Allow up to 8 lights.
-const int MAX_LIGHTS = 8; 
+// Light sources, shared by all lighting programs through a uniform block
+// (std140 layout, matches cg::LightSource). MAX_LIGHTS must match the
+// application.
+const int MAX_LIGHTS = 32;
 struct LightSource
 {
-   int  enabled;
-   int  spotlight;
-   vec4 position;
-   vec4 ambient;
-   vec4 diffuse;
-   vec4 specular;
+   vec4  position;
+   vec4  ambient;
+   vec4  diffuse;
+   vec4  specular;
+   vec3  spot_direction;
+   float spot_cutoff;
+   float spot_exponent;
    float constant_attenuation;
    float linear_attenuation;
    float quadratic_attenuation;
-   float spot_cutoff;
-   float spot_exponent;
-   vec3  spot_direction;
+   int   enabled;
+   int   spotlight;
+};
+layout (std140) uniform LightBlock
+{
+   int         num_lights;  // Number of lights in use
+   LightSource lights[MAX_LIGHTS];
 };
-uniform LightSource lights[MAX_LIGHTS]; 
 
 // Convenience method to compute attenuation for the ith light source
 // given a distance
@@ -77,7 +95,7 @@ void directional_light(in int i, in vec3 N, in vec3 vtx, in vec3 V, inout vec4 a
       
       // Find dot product of N and H and add specular contribution due to this light source
       float N_dot_H = dot(N, H);
-      if (N_dot_H > 0.0) specular += lights[i].specular * pow(N_dot_H, material_shininess);
+      if (N_dot_H > 0.0) specular += lights[i].specular * pow(N_dot_H, material.shininess);
    }
 }
 
@@ -109,7 +127,7 @@ void point_light(in int i, in vec3 N, in vec3 vtx, in vec3 V, inout vec4 ambient
       // Construct the halfway vector and add specular contribution (if N dot H > 0)
       vec3 H = normalize(L + V);
       float N_dot_H = dot(N, H);
-      if (N_dot_H > 0.0) specular += lights[i].specular * attenuation * pow(N_dot_H, material_shininess);
+      if (N_dot_H > 0.0) specular += lights[i].specular * attenuation * pow(N_dot_H, material.shininess);
    }
 }
 
@@ -144,7 +162,7 @@ void spot_light(in int i, in vec3 N, in vec3 vtx, in vec3 V, inout vec4 ambient,
          // Construct the halfway vector and add specular contribution (if N dot H > 0)
          vec3 H = normalize(L + V);
          float N_dot_H = dot(N, H);
-         if (N_dot_H > 0.0) specular += lights[i].specular * attenuation * pow(N_dot_H, material_shininess);
+         if (N_dot_H > 0.0) specular += lights[i].specular * attenuation * pow(N_dot_H, material.shininess);
       }
       else attenuation = 0.0;
    }
@@ -158,6 +176,8 @@ void spot_light(in int i, in vec3 N, in vec3 vtx, in vec3 V, inout vec4 ambient,
 // Main fragment shader. 
 void main()
 {
+   material = materials[material_index];
+
    // Normalize the normal - as a linear interpolation of normals can result
    // in non unit-length vectors. Cannot directly modify the varying value, so
    // create a temporary variable here. 
@@ -183,8 +203,8 @@ void main()
 
    // Compute color. Emmission + global ambient contribution + light sources ambient, diffuse,
    // and specular contributions
-   vec4 color = material_emission + global_light_ambient * material_ambient +
-			(ambient  * material_ambient) + (diffuse  * material_diffuse) + (specular * material_specular);
+   vec4 color = material.emission + global_light_ambient * material.ambient +
+			(ambient  * material.ambient) + (diffuse  * material.diffuse) + (specular * material.specular);
      
 	frag_color = clamp(color, 0.0, 1.0);
 }
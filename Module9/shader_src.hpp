@@ -30,32 +30,46 @@ layout (location = 0) smooth in vec3 normal;
 layout (location = 1) smooth in vec3 vertex;
 layout (location = 0) out vec4 frag_color; 
 
-uniform vec4 material_ambient;
-uniform vec4 material_diffuse;
-uniform vec4 material_specular;
-uniform vec4 material_emission;
-uniform float material_shininess;
+const int MAX_MATERIALS = 128;
+struct Material
+{
+   vec4  ambient;
+   vec4  diffuse;
+   vec4  specular;
+   vec4  emission;
+   float shininess;
+   int   use_texture;
+};
+layout (std140) uniform MaterialBlock
+{
+   Material materials[MAX_MATERIALS];
+};
+uniform int material_index;
+Material material;
 uniform vec4  global_light_ambient;
 uniform vec3  camera_position;
 
-uniform int num_lights;
-const int MAX_LIGHTS = 8; 
+const int MAX_LIGHTS = 32;
 struct LightSource
 {
-   int  enabled;
-   int  spotlight;
-   vec4 position;
-   vec4 ambient;
-   vec4 diffuse;
-   vec4 specular;
+   vec4  position;
+   vec4  ambient;
+   vec4  diffuse;
+   vec4  specular;
+   vec3  spot_direction;
+   float spot_cutoff;
+   float spot_exponent;
    float constant_attenuation;
    float linear_attenuation;
    float quadratic_attenuation;
-   float spot_cutoff;
-   float spot_exponent;
-   vec3  spot_direction;
+   int   enabled;
+   int   spotlight;
+};
+layout (std140) uniform LightBlock
+{
+   int         num_lights;  // Number of lights in use
+   LightSource lights[MAX_LIGHTS];
 };
-uniform LightSource lights[MAX_LIGHTS]; 
 
 float calculate_attenuation(in int i, in float distance)
 {
@@ -75,7 +89,7 @@ void directional_light(in int i, in vec3 N, in vec3 vtx, in vec3 V, inout vec4 a
     diffuse += lights[i].diffuse * N_dot_L;
     vec3 H = normalize(L + V);
     float N_dot_H = dot(N, H);
-    if (N_dot_H > 0.0) specular += lights[i].specular * pow(N_dot_H, material_shininess);
+    if (N_dot_H > 0.0) specular += lights[i].specular * pow(N_dot_H, material.shininess);
   }
 }
 
@@ -94,7 +108,7 @@ void point_light(in int i, in vec3 N, in vec3 vtx, in vec3 V, inout vec4 ambient
     diffuse += lights[i].diffuse  * attenuation * N_dot_L;
     vec3 H = normalize(L + V);
     float N_dot_H = dot(N, H);
-    if (N_dot_H > 0.0) specular += lights[i].specular * attenuation * pow(N_dot_H, material_shininess);
+    if (N_dot_H > 0.0) specular += lights[i].specular * attenuation * pow(N_dot_H, material.shininess);
   }
 }
 
@@ -116,7 +130,7 @@ void spot_light(in int i, in vec3 N, in vec3 vtx, in vec3 V, inout vec4 ambient,
       diffuse += lights[i].diffuse  * attenuation * N_dot_L;
       vec3 H = normalize(L + V);
       float N_dot_H = dot(N, H);
-      if (N_dot_H > 0.0) specular += lights[i].specular * attenuation * pow(N_dot_H, material_shininess);
+      if (N_dot_H > 0.0) specular += lights[i].specular * attenuation * pow(N_dot_H, material.shininess);
     }
     else attenuation = 0.0;
   }
@@ -127,6 +141,8 @@ void spot_light(in int i, in vec3 N, in vec3 vtx, in vec3 V, inout vec4 ambient,
 // Main fragment shader. 
 void main()
 {
+   material = materials[material_index];
+
   vec3 n = normalize(normal);
   vec3 V = normalize(camera_position - vertex);
   vec4 ambient  = vec4(0.0);
@@ -141,8 +157,8 @@ void main()
     else point_light(i, n, vertex, V, ambient, diffuse, specular);
   }
 
-	vec4 color = material_emission + global_light_ambient * material_ambient +
-			(ambient  * material_ambient) + (diffuse  * material_diffuse) + (specular * material_specular);
+	vec4 color = material.emission + global_light_ambient * material.ambient +
+			(ambient  * material.ambient) + (diffuse  * material.diffuse) + (specular * material.specular);
      
 	frag_color = clamp(color, 0.0, 1.0);
 }
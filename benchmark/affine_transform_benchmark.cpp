@@ -0,0 +1,138 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:  David W. Nesbitt
+//	File:    benchmark/affine_transform_benchmark.cpp
+//	Purpose: Compare the per-node transform work done by TransformNode using
+//           general 4x4 matrices versus AffineTransform3.
+//
+//============================================================================
+
+#include "benchmark/benchmark.hpp"
+
+#include "geometry/geometry.hpp"
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace bench
+{
+
+namespace
+{
+
+constexpr uint32_t NODE_COUNT = 4096;
+constexpr uint32_t ITERATIONS = 200;
+
+// Build a mix of local transforms like those in the Module10 scene: rigid
+// placements, uniform scales, and non-uniform (box/leg) scales
+void build_transforms(std::vector<cg::Matrix4x4> &m, std::vector<cg::AffineTransform3> &a)
+{
+    for(uint32_t i = 0; i < NODE_COUNT; i++)
+    {
+        cg::Matrix4x4        mi;
+        cg::AffineTransform3 ai;
+        float                x = static_cast<float>(i % 17) - 8.0f;
+        float                deg = static_cast<float>(i % 360);
+        mi.translate(x, 0.5f * x, 2.0f);
+        ai.translate(x, 0.5f * x, 2.0f);
+        mi.rotate_z(deg);
+        ai.rotate_z(deg);
+        switch(i % 3)
+        {
+            case 0: break;
+            case 1:
+                mi.scale(2.5f, 2.5f, 2.5f);
+                ai.scale(2.5f, 2.5f, 2.5f);
+                break;
+            default:
+                mi.scale(6.0f, 6.0f, 20.0f);
+                ai.scale(6.0f, 6.0f, 20.0f);
+                break;
+        }
+        m.push_back(mi);
+        a.push_back(ai);
+    }
+}
+
+float max_difference(const cg::Matrix4x4 &a, const cg::Matrix4x4 &b)
+{
+    float d = 0.0f;
+    for(uint32_t i = 0; i < 16; i++) d = std::max(d, std::abs(a.get()[i] - b.get()[i]));
+    return d;
+}
+
+} // namespace
+
+void run_affine_transform_benchmark()
+{
+    std::vector<cg::Matrix4x4>        local_m;
+    std::vector<cg::AffineTransform3> local_a;
+    build_transforms(local_m, local_a);
+
+    // Parent transform and projection-view matrix
+    cg::Matrix4x4 parent_m;
+    parent_m.translate(-50.0f, 50.0f, 0.0f);
+    parent_m.rotate_z(30.0f);
+    cg::AffineTransform3 parent_a;
+    parent_a.translate(-50.0f, 50.0f, 0.0f);
+    parent_a.rotate_z(30.0f);
+    cg::Matrix4x4 pv;
+    pv.m32() = -1.0f;
+    pv.m33() = 0.0f;
+    pv.translate(0.0f, 0.0f, -100.0f);
+
+    // Same work TransformNode::draw does per node: compose with the parent,
+    // form the normal matrix, and form the composite pvm matrix
+    cg::Matrix4x4 world, normal, pvm;
+    Timer         t_matrix;
+    for(uint32_t it = 0; it < ITERATIONS; it++)
+    {
+        for(const auto &m : local_m)
+        {
+            world = parent_m * m;
+            normal = world.get_inverse().transpose();
+            pvm = pv * world;
+            g_sink = g_sink + normal.m00() + pvm.m33();
+        }
+    }
+    double matrix_seconds = t_matrix.seconds();
+
+    cg::AffineTransform3 world_a;
+    Timer                t_affine;
+    for(uint32_t it = 0; it < ITERATIONS; it++)
+    {
+        for(const auto &a : local_a)
+        {
+            world_a = parent_a * a;
+            normal = world_a.get_normal_matrix();
+            pvm = pv * world_a;
+            g_sink = g_sink + normal.m00() + pvm.m33();
+        }
+    }
+    double affine_seconds = t_affine.seconds();
+
+    // Verify both paths upload the same matrices
+    float max_diff = 0.0f;
+    for(uint32_t i = 0; i < NODE_COUNT; i++)
+    {
+        cg::Matrix4x4        wm = parent_m * local_m[i];
+        cg::AffineTransform3 wa = parent_a * local_a[i];
+        max_diff = std::max(max_diff, max_difference(wm, wa.get_matrix()));
+        max_diff = std::max(max_diff,
+                            max_difference(wm.get_inverse().transpose(), wa.get_normal_matrix()));
+        max_diff = std::max(max_diff, max_difference(pv * wm, pv * wa));
+    }
+
+    double n = static_cast<double>(NODE_COUNT) * ITERATIONS;
+    std::cout << "Affine transform: " << NODE_COUNT << " nodes x " << ITERATIONS << " iterations\n";
+    std::cout << "  Matrix4x4        : " << (matrix_seconds * 1.0e9 / n) << " ns/node\n";
+    std::cout << "  AffineTransform3 : " << (affine_seconds * 1.0e9 / n) << " ns/node\n";
+    std::cout << "  Speedup          : " << (matrix_seconds / affine_seconds) << "x\n";
+    std::cout << "  Max difference   : " << max_diff << '\n';
+}
+
+} // namespace bench
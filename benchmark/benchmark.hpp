@@ -0,0 +1,61 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:  David W. Nesbitt
+//	File:    benchmark/benchmark.hpp
+//	Purpose: Support for CPU microbenchmarks of the geometry and scene
+//           libraries. These do not require an OpenGL context.
+//
+//============================================================================
+
+#ifndef __BENCHMARK_BENCHMARK_HPP__
+#define __BENCHMARK_BENCHMARK_HPP__
+
+#include <chrono>
+#include <cstdint>
+
+namespace bench
+{
+
+/**
+ * Simple wall clock timer.
+ */
+class Timer
+{
+  public:
+    Timer() : start_(std::chrono::steady_clock::now()) {}
+
+    /**
+     * Get elapsed time since construction.
+     * @return  Returns the elapsed time in seconds.
+     */
+    double seconds() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    }
+
+  private:
+    std::chrono::steady_clock::time_point start_;
+};
+
+// Keep a value alive so the optimizer does not remove the benchmarked work
+extern volatile float g_sink;
+
+// Benchmarks. Each prints its results to std::cout.
+void run_affine_transform_benchmark();
+void run_bezier_benchmark();
+void run_bvh_benchmark();
+void run_draw_sort_benchmark();
+void run_matrix_benchmark();
+void run_occlusion_benchmark();
+void run_ray_packet_benchmark();
+void run_triangle_batch_benchmark();
+void run_vertex_cache_benchmark();
+void run_vertex_stream_benchmark();
+void run_weld_benchmark();
+
+} // namespace bench
+
+#endif
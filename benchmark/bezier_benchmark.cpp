@@ -0,0 +1,151 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:  David W. Nesbitt
+//	File:    benchmark/bezier_benchmark.cpp
+//	Purpose: Compare the time to tessellate the teapot patches by recursive
+//           subdivision and with BezierTessellator, by level.
+//
+//============================================================================
+
+#include "benchmark/benchmark.hpp"
+
+#include "geometry/geometry.hpp"
+#include "scene/mesh_teapot.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace bench
+{
+
+namespace
+{
+
+constexpr uint32_t MIN_LEVEL = 2;
+constexpr uint32_t MAX_LEVEL = 8;
+
+// Grid vertices each method generates per level, over as many runs as
+// that takes
+constexpr uint32_t VERTEX_BUDGET = 1u << 22;
+
+// The recursive de Casteljau subdivision MeshTeapot used: every level of
+// every curve allocates and concatenates vectors
+std::vector<cg::Point3> divide_curve(const cg::Point3 &c0,
+                                     const cg::Point3 &c1,
+                                     const cg::Point3 &c2,
+                                     const cg::Point3 &c3,
+                                     uint32_t          level)
+{
+    if(level == 0) { return {c0, c3}; }
+    cg::Point3 t = c1.mid_point(c2);
+    cg::Point3 l1 = c0.mid_point(c1);
+    cg::Point3 r2 = c2.mid_point(c3);
+    cg::Point3 l2 = l1.mid_point(t);
+    cg::Point3 r1 = t.mid_point(r2);
+    cg::Point3 mid = l2.mid_point(r1);
+    auto       left = divide_curve(c0, l1, l2, mid, level - 1);
+    auto       right = divide_curve(mid, r1, r2, c3, level - 1);
+    left.insert(left.end(), right.begin() + 1, right.end());
+    return left;
+}
+
+// Subdivide each patch and weld the patch edges as MeshTeapot::add_patch did
+size_t subdivide(const std::vector<cg::BezierPatch> &patches, uint32_t level)
+{
+    std::vector<cg::Point3> vertices;
+    std::vector<uint32_t>   faces;
+    cg::VertexWelder        welder;
+    for(const auto &patch : patches)
+    {
+        std::vector<std::vector<cg::Point3>> rows(4);
+        for(uint32_t r = 0; r < 4; r++)
+        {
+            rows[r] = divide_curve(patch.points[0][r],
+                                   patch.points[1][r],
+                                   patch.points[2][r],
+                                   patch.points[3][r],
+                                   level);
+        }
+        size_t                             n = rows[0].size();
+        std::vector<std::vector<uint32_t>> index(n, std::vector<uint32_t>(n));
+        for(size_t c = 0; c < n; c++)
+        {
+            auto column = divide_curve(rows[0][c], rows[1][c], rows[2][c], rows[3][c], level);
+            for(size_t r = 0; r < n; r++)
+            {
+                uint32_t next = static_cast<uint32_t>(vertices.size());
+                bool     edge = (c == 0 || r == 0 || c == n - 1 || r == n - 1);
+                index[c][r] = edge ? welder.weld(column[r], next) : next;
+                if(index[c][r] == next) { vertices.push_back(column[r]); }
+            }
+        }
+        for(size_t r = 0; r + 1 < n; r++)
+        {
+            for(size_t c = 0; c + 1 < n; c++)
+            {
+                faces.insert(faces.end(),
+                             {index[c][r],
+                              index[c + 1][r + 1],
+                              index[c + 1][r],
+                              index[c][r],
+                              index[c][r + 1],
+                              index[c + 1][r + 1]});
+            }
+        }
+    }
+    g_sink = g_sink + vertices.back().x;
+    return vertices.size();
+}
+
+// Milliseconds per run of f
+template <typename F> double time_ms(uint32_t runs, F &&f)
+{
+    Timer t;
+    for(uint32_t i = 0; i < runs; i++) { f(); }
+    return t.seconds() * 1.0e3 / runs;
+}
+
+} // namespace
+
+void run_bezier_benchmark()
+{
+    std::vector<cg::BezierPatch> patches;
+    cg::MeshTeapot::get_patches(patches);
+    uint32_t threads = std::max(1u, std::thread::hardware_concurrency());
+
+    // Tessellators are reused between runs, as their buffers are
+    cg::BezierTessellator serial(1);
+    cg::BezierTessellator parallel;
+    std::cout << "Bezier tessellation: " << patches.size() << " teapot patches, " << threads
+              << " threads\n";
+    for(uint32_t level = MIN_LEVEL; level <= MAX_LEVEL; level++)
+    {
+        uint32_t             segments = 1u << level;
+        cg::BezierResolution resolution{segments, segments};
+        uint32_t             runs = std::max(1u, VERTEX_BUDGET / (32 * segments * segments));
+        size_t               vertex_count = 0;
+        double recursive = time_ms(runs, [&]() { vertex_count = subdivide(patches, level); });
+        double one = time_ms(runs, [&]() { serial.tessellate(patches, resolution); });
+        double all = time_ms(runs, [&]() { parallel.tessellate(patches, resolution); });
+        std::cout << "  level " << level << ": " << parallel.get_vertices().size()
+                  << " vertices (" << vertex_count << " recursive), recursive " << recursive
+                  << " ms, tessellator " << one << " ms, " << all << " ms parallel\n";
+    }
+
+    // Resolutions that are not powers of 2
+    for(uint32_t segments : {24u, 100u})
+    {
+        cg::BezierResolution resolution{segments, segments / 2};
+        double all = time_ms(4, [&]() { parallel.tessellate(patches, resolution); });
+        std::cout << "  " << resolution.u_segments << " x " << resolution.v_segments
+                  << " segments: " << parallel.get_vertices().size() << " vertices, "
+                  << parallel.get_faces().size() / 3 << " faces, " << all << " ms parallel\n";
+    }
+}
+
+} // namespace bench
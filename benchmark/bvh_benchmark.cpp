@@ -0,0 +1,144 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:  David W. Nesbitt
+//	File:    benchmark/bvh_benchmark.cpp
+//	Purpose: Time MeshBVH build and ray queries against brute force ray
+//           mesh intersection.
+//
+//============================================================================
+
+#include "benchmark/benchmark.hpp"
+
+#include "geometry/geometry.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace bench
+{
+
+namespace
+{
+
+// Bumpy sphere with about 250k triangles
+constexpr uint32_t STACKS = 300;
+constexpr uint32_t SLICES = 420;
+constexpr uint32_t RAY_COUNT = 200000;
+constexpr uint32_t BRUTE_FORCE_RAY_COUNT = 200;
+
+void build_sphere(std::vector<cg::Point3> &vertices, std::vector<uint32_t> &faces)
+{
+    for(uint32_t i = 0; i <= STACKS; i++)
+    {
+        float phi = cg::PI * i / STACKS;
+        for(uint32_t j = 0; j <= SLICES; j++)
+        {
+            float theta = 2.0f * cg::PI * j / SLICES;
+            float r = 10.0f + 0.3f * std::sin(phi * 17.0f) * std::cos(theta * 11.0f);
+            vertices.emplace_back(r * std::sin(phi) * std::cos(theta),
+                                  r * std::sin(phi) * std::sin(theta),
+                                  r * std::cos(phi));
+        }
+    }
+    for(uint32_t i = 0; i < STACKS; i++)
+    {
+        for(uint32_t j = 0; j < SLICES; j++)
+        {
+            uint32_t a = i * (SLICES + 1) + j;
+            uint32_t b = a + SLICES + 1;
+            faces.insert(faces.end(), {a, b, a + 1, a + 1, b, b + 1});
+        }
+    }
+}
+
+// Rays from points around the sphere aimed near its center
+std::vector<cg::Ray3> build_rays(uint32_t count)
+{
+    std::vector<cg::Ray3> rays;
+    uint32_t              seed = 12345;
+    auto                  rnd = [&seed]() {
+        seed = seed * 1664525u + 1013904223u;
+        return static_cast<float>(seed >> 8) / 16777216.0f;
+    };
+    for(uint32_t i = 0; i < count; i++)
+    {
+        cg::Point3 o(rnd() * 60.0f - 30.0f, rnd() * 60.0f - 30.0f, 25.0f + rnd() * 5.0f);
+        cg::Point3 target(rnd() * 20.0f - 10.0f, rnd() * 20.0f - 10.0f, rnd() * 20.0f - 10.0f);
+        rays.emplace_back(o, target, true);
+    }
+    return rays;
+}
+
+cg::RayMeshIntersectResult brute_force(const cg::Ray3                &ray,
+                                       const std::vector<cg::Point3> &vertices,
+                                       const std::vector<uint32_t>   &faces)
+{
+    cg::RayMeshIntersectResult result{false, 1.0e30f, 0.0f, 0.0f, 0};
+    for(size_t i = 0; i < faces.size(); i += 3)
+    {
+        cg::RayTriangleIntersectResult r =
+            ray.intersect(vertices[faces[i]], vertices[faces[i + 1]], vertices[faces[i + 2]]);
+        if(r.intersects && r.distance < result.distance)
+        {
+            result = {true, r.distance, r.barycentric_u, r.barycentric_v, static_cast<uint32_t>(i / 3)};
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+void run_bvh_benchmark()
+{
+    std::vector<cg::Point3> vertices;
+    std::vector<uint32_t>   faces;
+    build_sphere(vertices, faces);
+
+    cg::MeshBVH bvh;
+    Timer       t_build;
+    bvh.build(vertices, faces);
+    double build_seconds = t_build.seconds();
+
+    std::vector<cg::Ray3> rays = build_rays(RAY_COUNT);
+    uint32_t              hits = 0;
+    Timer                 t_closest;
+    for(const auto &ray : rays)
+    {
+        cg::RayMeshIntersectResult r = bvh.intersect(ray, 1.0e30f);
+        hits += r.intersects ? 1 : 0;
+    }
+    double closest_seconds = t_closest.seconds();
+
+    uint32_t occluded = 0;
+    Timer    t_any;
+    for(const auto &ray : rays) { occluded += bvh.does_intersect_exist(ray, 1.0e30f) ? 1 : 0; }
+    double any_seconds = t_any.seconds();
+
+    // Compare against brute force for a subset of the rays
+    uint32_t mismatches = 0;
+    Timer    t_brute;
+    for(uint32_t i = 0; i < BRUTE_FORCE_RAY_COUNT; i++)
+    {
+        cg::RayMeshIntersectResult a = brute_force(rays[i], vertices, faces);
+        cg::RayMeshIntersectResult b = bvh.intersect(rays[i], 1.0e30f);
+        if(a.intersects != b.intersects || (a.intersects && a.distance != b.distance)) { mismatches++; }
+    }
+    double brute_seconds = t_brute.seconds();
+    g_sink = g_sink + static_cast<float>(hits + occluded);
+
+    std::cout << "MeshBVH: " << faces.size() / 3 << " triangles, " << bvh.get_nodes().size() << " nodes\n";
+    std::cout << "  Build           : " << build_seconds * 1.0e3 << " ms\n";
+    std::cout << "  Closest hit     : " << closest_seconds * 1.0e9 / RAY_COUNT << " ns/ray (" << hits
+              << " hits)\n";
+    std::cout << "  Any hit         : " << any_seconds * 1.0e9 / RAY_COUNT << " ns/ray (" << occluded
+              << " hits)\n";
+    std::cout << "  Brute force     : " << brute_seconds * 1.0e9 / BRUTE_FORCE_RAY_COUNT << " ns/ray\n";
+    std::cout << "  Mismatches      : " << mismatches << " of " << BRUTE_FORCE_RAY_COUNT << '\n';
+}
+
+} // namespace bench
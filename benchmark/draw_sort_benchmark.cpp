@@ -0,0 +1,174 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:  David W. Nesbitt
+//	File:    benchmark/draw_sort_benchmark.cpp
+//	Purpose: Time sorting the draw keys of a compiled render queue with the
+//           radix sort against std::stable_sort and count state changes
+//           before and after.
+//
+//============================================================================
+
+#include "benchmark/benchmark.hpp"
+
+#include "geometry/geometry.hpp"
+#include "scene/scene.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace bench
+{
+
+namespace
+{
+
+constexpr uint32_t DRAW_COUNT = 4096;
+constexpr uint32_t PROGRAM_COUNT = 4;
+constexpr uint32_t TEXTURE_COUNT = 16;
+constexpr uint32_t MATERIAL_COUNT = 64;
+constexpr uint32_t ITERATIONS = 200;
+
+// Shader node that is never applied. Compiling does not need a program.
+class BenchmarkShaderNode : public cg::ShaderNode
+{
+  public:
+    bool get_locations() override { return true; }
+    void apply(cg::SceneState & /* scene_state */) override {}
+};
+
+// Material with a texture name that is never bound
+class BenchmarkMaterialNode : public cg::PresentationNode
+{
+  public:
+    explicit BenchmarkMaterialNode(GLuint texture)
+    {
+        texture_id_ = texture;
+        has_texture_ = true;
+        use_texture_ = true;
+    }
+};
+
+// Program, texture, and material changes drawing the records in order. The
+// material is applied again after a new program (see RenderQueue).
+uint32_t count_state_changes(const std::vector<cg::DrawRecord> &records,
+                             const std::vector<cg::SortItem>   &order)
+{
+    const cg::ShaderNode       *shader = nullptr;
+    const cg::PresentationNode *material = nullptr;
+    GLuint                      texture = 0;
+    uint32_t                    changes = 0;
+    for(const auto &item : order)
+    {
+        const cg::DrawRecord &r = records[item.index];
+        if(r.shader != shader)
+        {
+            shader = r.shader;
+            material = nullptr;
+            changes++;
+        }
+        if(r.material != material)
+        {
+            material = r.material;
+            changes++;
+            if(material->get_texture() != texture)
+            {
+                texture = material->get_texture();
+                changes++;
+            }
+        }
+    }
+    return changes;
+}
+
+} // namespace
+
+void run_draw_sort_benchmark()
+{
+    // Each draw is a transform below one of the shader nodes, over one of the
+    // materials (each using one texture), over the same geometry
+    std::vector<std::shared_ptr<BenchmarkShaderNode>> programs;
+    for(uint32_t i = 0; i < PROGRAM_COUNT; i++)
+    {
+        programs.push_back(std::make_shared<BenchmarkShaderNode>());
+    }
+    auto geometry = std::make_shared<cg::GeometryNode>();
+    std::vector<std::shared_ptr<BenchmarkMaterialNode>> materials;
+    for(uint32_t i = 0; i < MATERIAL_COUNT; i++)
+    {
+        materials.push_back(std::make_shared<BenchmarkMaterialNode>(1 + i % TEXTURE_COUNT));
+        materials.back()->add_child(geometry);
+    }
+
+    std::mt19937                          rng(7);
+    std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+    std::uniform_real_distribution<float> depth(0.1f, 100.0f);
+    cg::SceneNode                         root;
+    for(auto &program : programs) { root.add_child(program); }
+    for(uint32_t i = 0; i < DRAW_COUNT; i++)
+    {
+        auto transform = std::make_shared<cg::TransformNode>();
+        transform->translate(position(rng), position(rng), -depth(rng));
+        transform->add_child(materials[rng() % MATERIAL_COUNT]);
+        programs[rng() % PROGRAM_COUNT]->add_child(transform);
+    }
+
+    // Keys from the compiled queue, with the depth added as RenderQueue::draw
+    // does (the eye is at the origin looking down -z)
+    cg::RenderQueue queue;
+    queue.compile(root);
+    const std::vector<cg::DrawRecord> &records = queue.get_records();
+    std::vector<cg::SortItem>          unsorted(records.size());
+    for(uint32_t i = 0; i < records.size(); i++)
+    {
+        float z = -records[i].world_matrix.m23();
+        unsorted[i] = {records[i].sort_key | (cg::float_to_sortable(z) >> 16), i};
+    }
+
+    // Radix sort
+    std::vector<cg::SortItem> radix;
+    std::vector<cg::SortItem> scratch(unsorted.size());
+    Timer                     t_radix;
+    for(uint32_t it = 0; it < ITERATIONS; it++)
+    {
+        radix = unsorted;
+        cg::radix_sort(radix.data(), scratch.data(), radix.size());
+    }
+    double radix_seconds = t_radix.seconds();
+
+    // Comparison sort
+    auto by_key = [](const cg::SortItem &a, const cg::SortItem &b) { return a.key < b.key; };
+    std::vector<cg::SortItem> comparison;
+    Timer                     t_comparison;
+    for(uint32_t it = 0; it < ITERATIONS; it++)
+    {
+        comparison = unsorted;
+        std::stable_sort(comparison.begin(), comparison.end(), by_key);
+    }
+    double comparison_seconds = t_comparison.seconds();
+
+    uint32_t mismatches = 0;
+    for(uint32_t i = 0; i < unsorted.size(); i++)
+    {
+        if(radix[i].index != comparison[i].index) { mismatches++; }
+    }
+    g_sink = g_sink + static_cast<float>(radix[0].index);
+
+    double us = 1.0e6 / ITERATIONS;
+    std::cout << "Draw sort: " << records.size() << " compiled records, " << PROGRAM_COUNT
+              << " programs, " << TEXTURE_COUNT << " textures, " << MATERIAL_COUNT
+              << " materials\n";
+    std::cout << "  Radix sort       : " << radix_seconds * us << " us\n";
+    std::cout << "  std::stable_sort : " << comparison_seconds * us << " us\n";
+    std::cout << "  Speedup          : " << comparison_seconds / radix_seconds << "x\n";
+    std::cout << "  State changes    : " << count_state_changes(records, unsorted)
+              << " unsorted, " << count_state_changes(records, radix) << " sorted\n";
+    std::cout << "  Mismatches       : " << mismatches << '\n';
+}
+
+} // namespace bench
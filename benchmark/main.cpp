@@ -0,0 +1,80 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:  David W. Nesbitt
+//	File:    benchmark/main.cpp
+//	Purpose: Runs CPU microbenchmarks. Pass benchmark names on the command
+//           line to run a subset, otherwise all benchmarks are run.
+//           Build with CMAKE_BUILD_TYPE=Release for meaningful timings.
+//
+//============================================================================
+
+#include "benchmark/benchmark.hpp"
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace cg
+{
+
+// Simple logging function, should be defined in the cg namespace
+void logmsg(const char *message, ...)
+{
+    // Open file if not already opened
+    static FILE *lfile = NULL;
+    if(lfile == NULL) { lfile = fopen("benchmark.log", "w"); }
+
+    va_list arg;
+    va_start(arg, message);
+    vfprintf(lfile, message, arg);
+    putc('\n', lfile);
+    fflush(lfile);
+    va_end(arg);
+}
+
+} // namespace cg
+
+namespace bench
+{
+
+volatile float g_sink = 0.0f;
+
+} // namespace bench
+
+struct BenchmarkEntry
+{
+    const char *name;
+    void (*run)();
+};
+
+static const BenchmarkEntry BENCHMARKS[] = {
+    {"affine", bench::run_affine_transform_benchmark},
+    {"bezier", bench::run_bezier_benchmark},
+    {"bvh", bench::run_bvh_benchmark},
+    {"draw_sort", bench::run_draw_sort_benchmark},
+    {"matrix", bench::run_matrix_benchmark},
+    {"occlusion", bench::run_occlusion_benchmark},
+    {"packet", bench::run_ray_packet_benchmark},
+    {"triangle", bench::run_triangle_batch_benchmark},
+    {"vertex_cache", bench::run_vertex_cache_benchmark},
+    {"vertex_stream", bench::run_vertex_stream_benchmark},
+    {"weld", bench::run_weld_benchmark},
+};
+
+int main(int argc, char **argv)
+{
+    for(const auto &b : BENCHMARKS)
+    {
+        bool run = (argc < 2);
+        for(int i = 1; i < argc; i++)
+        {
+            if(std::strcmp(argv[i], b.name) == 0) run = true;
+        }
+        if(run) b.run();
+    }
+    return 0;
+}
@@ -0,0 +1,109 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:  David W. Nesbitt
+//	File:    benchmark/matrix_benchmark.cpp
+//	Purpose: Time the Matrix4x4 kernels and the batched point and vector
+//           transforms against per-element transforms.
+//
+//============================================================================
+
+#include "benchmark/benchmark.hpp"
+
+#include "geometry/geometry.hpp"
+#include "geometry/simd.hpp"
+
+#include <iostream>
+#include <vector>
+
+namespace bench
+{
+
+void run_matrix_benchmark()
+{
+    constexpr uint32_t MATRIX_ITERATIONS = 2000000;
+    constexpr uint32_t POINT_COUNT = 65536;
+    constexpr uint32_t POINT_ITERATIONS = 100;
+
+#if defined(CG_SIMD_AVX)
+    std::cout << "Matrix4x4 (AVX)\n";
+#elif defined(CG_SIMD_SSE)
+    std::cout << "Matrix4x4 (SSE)\n";
+#else
+    std::cout << "Matrix4x4 (scalar)\n";
+#endif
+
+    cg::Matrix4x4 a;
+    a.translate(1.0f, 2.0f, 3.0f);
+    a.rotate(33.0f, 1.0f, 2.0f, 3.0f);
+    a.scale(2.0f, 3.0f, 4.0f);
+    cg::Matrix4x4 b = a.get_transpose();
+
+    Timer t_mul;
+    for(uint32_t i = 0; i < MATRIX_ITERATIONS; i++)
+    {
+        b = a * b;
+        b.m03() = 1.0f; // Keep values bounded
+        g_sink = g_sink + b.m00();
+    }
+    double mul_ns = t_mul.seconds() * 1.0e9 / MATRIX_ITERATIONS;
+
+    Timer t_inv;
+    for(uint32_t i = 0; i < MATRIX_ITERATIONS; i++)
+    {
+        b = a.get_inverse();
+        a.m03() = static_cast<float>(i & 7);
+        g_sink = g_sink + b.m00();
+    }
+    double inv_ns = t_inv.seconds() * 1.0e9 / MATRIX_ITERATIONS;
+
+    Timer t_transpose;
+    for(uint32_t i = 0; i < MATRIX_ITERATIONS; i++)
+    {
+        b = a.get_transpose();
+        a.m01() = b.m33();
+        g_sink = g_sink + b.m00();
+    }
+    double transpose_ns = t_transpose.seconds() * 1.0e9 / MATRIX_ITERATIONS;
+
+    std::vector<cg::Point3>  points(POINT_COUNT);
+    std::vector<cg::Vector3> vectors(POINT_COUNT);
+    for(uint32_t i = 0; i < POINT_COUNT; i++)
+    {
+        points[i] = cg::Point3(static_cast<float>(i), 1.0f, 2.0f);
+        vectors[i] = cg::Vector3(1.0f, static_cast<float>(i), 2.0f);
+    }
+    std::vector<cg::HPoint3> hpoints(POINT_COUNT);
+    std::vector<cg::Vector3> out_vectors(POINT_COUNT);
+
+    Timer t_single;
+    for(uint32_t it = 0; it < POINT_ITERATIONS; it++)
+    {
+        for(uint32_t i = 0; i < POINT_COUNT; i++)
+        {
+            hpoints[i] = a * points[i];
+            out_vectors[i] = a * vectors[i];
+        }
+        g_sink = g_sink + hpoints[it].x + out_vectors[it].y;
+    }
+    double single_ns = t_single.seconds() * 1.0e9 / (static_cast<double>(POINT_COUNT) * POINT_ITERATIONS);
+
+    Timer t_batch;
+    for(uint32_t it = 0; it < POINT_ITERATIONS; it++)
+    {
+        a.transform_points(points.data(), hpoints.data(), POINT_COUNT);
+        a.transform_vectors(vectors.data(), out_vectors.data(), POINT_COUNT);
+        g_sink = g_sink + hpoints[it].x + out_vectors[it].y;
+    }
+    double batch_ns = t_batch.seconds() * 1.0e9 / (static_cast<double>(POINT_COUNT) * POINT_ITERATIONS);
+
+    std::cout << "  multiply          : " << mul_ns << " ns\n";
+    std::cout << "  inverse           : " << inv_ns << " ns\n";
+    std::cout << "  transpose         : " << transpose_ns << " ns\n";
+    std::cout << "  point+vector, one  : " << single_ns << " ns/element\n";
+    std::cout << "  point+vector, batch: " << batch_ns << " ns/element\n";
+}
+
+} // namespace bench
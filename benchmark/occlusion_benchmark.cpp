@@ -0,0 +1,149 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:  David W. Nesbitt
+//	File:    benchmark/occlusion_benchmark.cpp
+//	Purpose: Time rasterizing an occluder into the software occlusion buffer
+//           on one thread and on all cores, and testing boxes against it.
+//
+//============================================================================
+
+#include "benchmark/benchmark.hpp"
+
+#include "geometry/geometry.hpp"
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace bench
+{
+
+namespace
+{
+
+constexpr uint32_t WALL_COLS = 96;
+constexpr uint32_t WALL_ROWS = 48;
+constexpr uint32_t BOX_GRID = 24;
+constexpr uint32_t ITERATIONS = 50;
+
+// Perspective projection looking down -z (as set by CameraNode)
+cg::Matrix4x4 perspective(float fov, float aspect, float n, float f)
+{
+    float         h = n * std::tan(cg::degrees_to_radians(fov * 0.5f));
+    float         w = aspect * h;
+    cg::Matrix4x4 m;
+    m.m00() = n / w;
+    m.m11() = n / h;
+    m.m22() = -(f + n) / (f - n);
+    m.m23() = -(2.0f * f * n) / (f - n);
+    m.m32() = -1.0f;
+    m.m33() = 0.0f;
+    return m;
+}
+
+// Subdivided wall facing the viewer at z = -20
+void build_wall(cg::OccluderMesh &wall)
+{
+    for(uint32_t i = 0; i <= WALL_ROWS; i++)
+    {
+        for(uint32_t j = 0; j <= WALL_COLS; j++)
+        {
+            wall.vertices.emplace_back(-15.0f + 30.0f * j / WALL_COLS,
+                                       -8.0f + 16.0f * i / WALL_ROWS,
+                                       -20.0f);
+        }
+    }
+    for(uint32_t i = 0; i < WALL_ROWS; i++)
+    {
+        for(uint32_t j = 0; j < WALL_COLS; j++)
+        {
+            uint32_t a = i * (WALL_COLS + 1) + j;
+            uint32_t b = a + WALL_COLS + 1;
+            wall.faces.insert(wall.faces.end(), {a, a + 1, b + 1, a, b + 1, b});
+        }
+    }
+}
+
+} // namespace
+
+void run_occlusion_benchmark()
+{
+    cg::OccluderMesh wall;
+    build_wall(wall);
+    cg::Matrix4x4 pv = perspective(60.0f, 4.0f / 3.0f, 1.0f, 300.0f);
+
+    // Unit boxes behind the wall, some hidden and some around its edges
+    std::vector<cg::AABB> boxes;
+    for(uint32_t i = 0; i < BOX_GRID; i++)
+    {
+        for(uint32_t j = 0; j < BOX_GRID; j++)
+        {
+            float x = -60.0f + 120.0f * j / (BOX_GRID - 1);
+            float y = -40.0f + 80.0f * i / (BOX_GRID - 1);
+            float z = -40.0f - 20.0f * ((i + j) % 3);
+            boxes.emplace_back(cg::Point3(x - 0.5f, y - 0.5f, z - 0.5f),
+                               cg::Point3(x + 0.5f, y + 0.5f, z + 0.5f));
+        }
+    }
+
+    // Rasterize on one thread
+    cg::OcclusionBuffer single(256, 192);
+    single.set_max_threads(1);
+    Timer t_single;
+    for(uint32_t i = 0; i < ITERATIONS; i++)
+    {
+        single.clear();
+        single.add_occluder(wall, pv);
+        single.rasterize();
+    }
+    double single_seconds = t_single.seconds();
+
+    // Rasterize on all cores
+    cg::OcclusionBuffer multi(256, 192);
+    Timer               t_multi;
+    for(uint32_t i = 0; i < ITERATIONS; i++)
+    {
+        multi.clear();
+        multi.add_occluder(wall, pv);
+        multi.rasterize();
+    }
+    double multi_seconds = t_multi.seconds();
+
+    // Both must produce the same depth
+    uint32_t mismatches = 0;
+    for(uint32_t y = 0; y < single.get_height(); y++)
+    {
+        for(uint32_t x = 0; x < single.get_width(); x++)
+        {
+            if(single.get_depth(x, y) != multi.get_depth(x, y)) { mismatches++; }
+        }
+    }
+
+    // Box tests
+    uint32_t occluded = 0;
+    Timer    t_test;
+    for(uint32_t i = 0; i < ITERATIONS; i++)
+    {
+        for(const auto &box : boxes)
+        {
+            if(multi.is_occluded(box, pv)) { occluded++; }
+        }
+    }
+    double test_seconds = t_test.seconds();
+    occluded /= ITERATIONS;
+    g_sink = g_sink + static_cast<float>(occluded);
+
+    std::cout << "Occlusion buffer (" << multi.get_width() << "x" << multi.get_height() << ", "
+              << cg::simd::WIDTH << " wide): " << multi.triangle_count() << " occluder triangles\n";
+    std::cout << "  Rasterize 1 thread  : " << single_seconds * 1.0e3 / ITERATIONS << " ms\n";
+    std::cout << "  Rasterize all cores : " << multi_seconds * 1.0e3 / ITERATIONS << " ms\n";
+    std::cout << "  Speedup             : " << single_seconds / multi_seconds << "x\n";
+    std::cout << "  Box test            : " << test_seconds * 1.0e9 / (ITERATIONS * boxes.size())
+              << " ns/box (" << occluded << " of " << boxes.size() << " occluded)\n";
+    std::cout << "  Mismatches          : " << mismatches << "\n";
+}
+
+} // namespace bench
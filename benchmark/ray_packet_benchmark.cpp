@@ -0,0 +1,162 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:  David W. Nesbitt
+//	File:    benchmark/ray_packet_benchmark.cpp
+//	Purpose: Compare ray packet traversal of a MeshBVH against single ray
+//           traversal for coherent primary and shadow rays.
+//
+//============================================================================
+
+#include "benchmark/benchmark.hpp"
+
+#include "geometry/geometry.hpp"
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace bench
+{
+
+namespace
+{
+
+constexpr uint32_t IMAGE_SIZE = 512;
+constexpr uint32_t ITERATIONS = 4;
+
+// Packet tile: 2x2 pixels for 4 lanes, 4x2 pixels for 8 lanes
+constexpr uint32_t TILE_W = cg::Ray3Packet::SIZE / 2;
+constexpr uint32_t TILE_H = 2;
+
+// Wavy height field with about 130k triangles under a pinhole camera
+void build_terrain(std::vector<cg::Point3> &vertices, std::vector<uint32_t> &faces)
+{
+    constexpr uint32_t N = 256;
+    for(uint32_t row = 0; row < N; row++)
+    {
+        for(uint32_t col = 0; col < N; col++)
+        {
+            float x = static_cast<float>(col) / (N - 1) * 20.0f - 10.0f;
+            float y = static_cast<float>(row) / (N - 1) * 20.0f - 10.0f;
+            vertices.emplace_back(x, y, std::sin(x * 1.3f) * std::cos(y * 0.7f) + 0.2f * std::sin(x * y));
+        }
+    }
+    for(uint32_t row = 0; row < N - 1; row++)
+    {
+        for(uint32_t col = 0; col < N - 1; col++)
+        {
+            uint32_t a = row * N + col;
+            faces.insert(faces.end(), {a, a + 1, a + N, a + 1, a + N + 1, a + N});
+        }
+    }
+}
+
+cg::Ray3 primary_ray(uint32_t px, uint32_t py)
+{
+    const cg::Point3 eye(0.0f, -14.0f, 9.0f);
+    float            sx = (px + 0.5f) / IMAGE_SIZE * 2.0f - 1.0f;
+    float            sy = (py + 0.5f) / IMAGE_SIZE * 2.0f - 1.0f;
+    cg::Vector3      dir(sx * 0.8f, 1.0f, -0.55f + sy * 0.8f);
+    return cg::Ray3(eye, dir, true);
+}
+
+} // namespace
+
+void run_ray_packet_benchmark()
+{
+    std::vector<cg::Point3> vertices;
+    std::vector<uint32_t>   faces;
+    build_terrain(vertices, faces);
+    cg::MeshBVH bvh;
+    bvh.build(vertices, faces);
+
+    const cg::Point3 light(30.0f, 20.0f, 40.0f);
+    const float      far_t = 1.0e30f;
+    const uint32_t   ray_count = IMAGE_SIZE * IMAGE_SIZE;
+
+    // Single rays: primary ray then a shadow ray toward the light
+    std::vector<cg::RayMeshIntersectResult> single(ray_count);
+    uint32_t                                single_shadowed = 0;
+    Timer                                   t_single;
+    for(uint32_t it = 0; it < ITERATIONS; it++)
+    {
+        single_shadowed = 0;
+        for(uint32_t py = 0; py < IMAGE_SIZE; py++)
+        {
+            for(uint32_t px = 0; px < IMAGE_SIZE; px++)
+            {
+                cg::Ray3                   ray = primary_ray(px, py);
+                cg::RayMeshIntersectResult r = bvh.intersect(ray, far_t);
+                single[py * IMAGE_SIZE + px] = r;
+                if(r.intersects)
+                {
+                    cg::Ray3 shadow(ray.intersect(r.distance), light, false);
+                    single_shadowed += bvh.does_intersect_exist(shadow, 1.0f) ? 1 : 0;
+                }
+            }
+        }
+    }
+    double single_seconds = t_single.seconds();
+
+    // Packets of neighboring pixels
+    std::vector<cg::RayMeshIntersectResult> packet(ray_count);
+    uint32_t                                packet_shadowed = 0;
+    cg::RayMeshIntersectResult              results[cg::Ray3Packet::SIZE];
+    Timer                                   t_packet;
+    for(uint32_t it = 0; it < ITERATIONS; it++)
+    {
+        packet_shadowed = 0;
+        for(uint32_t py = 0; py < IMAGE_SIZE; py += TILE_H)
+        {
+            for(uint32_t px = 0; px < IMAGE_SIZE; px += TILE_W)
+            {
+                cg::Ray3Packet rays;
+                for(uint32_t i = 0; i < cg::Ray3Packet::SIZE; i++)
+                {
+                    rays.set(i, primary_ray(px + i % TILE_W, py + i / TILE_W), far_t);
+                }
+                bvh.intersect(rays, results);
+
+                cg::Ray3Packet shadows;
+                for(uint32_t i = 0; i < cg::Ray3Packet::SIZE; i++)
+                {
+                    packet[(py + i / TILE_W) * IMAGE_SIZE + px + i % TILE_W] = results[i];
+                    if(results[i].intersects)
+                    {
+                        cg::Point3 p = rays.get(i).intersect(results[i].distance);
+                        shadows.set(i, cg::Ray3(p, light, false), 1.0f);
+                    }
+                }
+                uint32_t occluded = bvh.does_intersect_exist(shadows);
+                for(; occluded != 0; occluded &= occluded - 1) { packet_shadowed++; }
+            }
+        }
+    }
+    double packet_seconds = t_packet.seconds();
+
+    uint32_t mismatches = 0;
+    for(uint32_t i = 0; i < ray_count; i++)
+    {
+        if(single[i].intersects != packet[i].intersects ||
+           (single[i].intersects && single[i].distance != packet[i].distance))
+        {
+            mismatches++;
+        }
+    }
+    g_sink = g_sink + static_cast<float>(single_shadowed + packet_shadowed);
+
+    double n = static_cast<double>(ray_count) * ITERATIONS;
+    std::cout << "Ray packets (" << cg::Ray3Packet::SIZE << " wide): " << faces.size() / 3
+              << " triangles, " << ray_count << " primary rays\n";
+    std::cout << "  Single ray  : " << single_seconds * 1.0e9 / n << " ns/pixel (" << single_shadowed
+              << " shadowed)\n";
+    std::cout << "  Packet      : " << packet_seconds * 1.0e9 / n << " ns/pixel (" << packet_shadowed
+              << " shadowed)\n";
+    std::cout << "  Speedup     : " << single_seconds / packet_seconds << "x\n";
+    std::cout << "  Mismatches  : " << mismatches << '\n';
+}
+
+} // namespace bench
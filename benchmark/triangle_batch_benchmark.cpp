@@ -0,0 +1,145 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:  David W. Nesbitt
+//	File:    benchmark/triangle_batch_benchmark.cpp
+//	Purpose: Compare testing a ray against one triangle at a time with
+//           testing it against batches of precomputed triangles.
+//
+//============================================================================
+
+#include "benchmark/benchmark.hpp"
+
+#include "geometry/geometry.hpp"
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace bench
+{
+
+namespace
+{
+
+// Grid of triangles in the z = 0 plane with a small bump in z
+constexpr uint32_t GRID_SIZE = 64;
+constexpr uint32_t RAY_COUNT = 2000;
+
+void build_grid(std::vector<cg::Point3> &vertices, std::vector<uint32_t> &faces)
+{
+    for(uint32_t i = 0; i <= GRID_SIZE; i++)
+    {
+        for(uint32_t j = 0; j <= GRID_SIZE; j++)
+        {
+            float x = static_cast<float>(j);
+            float y = static_cast<float>(i);
+            vertices.emplace_back(x, y, 0.5f * std::sin(x * 0.3f) * std::cos(y * 0.2f));
+        }
+    }
+    for(uint32_t i = 0; i < GRID_SIZE; i++)
+    {
+        for(uint32_t j = 0; j < GRID_SIZE; j++)
+        {
+            uint32_t a = i * (GRID_SIZE + 1) + j;
+            uint32_t b = a + GRID_SIZE + 1;
+            faces.insert(faces.end(), {a, a + 1, b, a + 1, b + 1, b});
+        }
+    }
+}
+
+} // namespace
+
+void run_triangle_batch_benchmark()
+{
+    std::vector<cg::Point3> vertices;
+    std::vector<uint32_t>   faces;
+    build_grid(vertices, faces);
+    uint32_t face_count = static_cast<uint32_t>(faces.size() / 3);
+
+    std::vector<cg::TriangleBatch> batches;
+    Timer                          t_build;
+    cg::build_triangle_batches(vertices, faces, batches);
+    double build_seconds = t_build.seconds();
+
+    // Rays from above the grid aimed at random points on it
+    std::vector<cg::Ray3> rays;
+    uint32_t              seed = 777;
+    auto                  rnd = [&seed]() {
+        seed = seed * 1664525u + 1013904223u;
+        return static_cast<float>(seed >> 8) / 16777216.0f;
+    };
+    for(uint32_t i = 0; i < RAY_COUNT; i++)
+    {
+        cg::Point3 o(rnd() * GRID_SIZE, rnd() * GRID_SIZE, 10.0f);
+        cg::Point3 target(rnd() * GRID_SIZE, rnd() * GRID_SIZE, 0.0f);
+        rays.emplace_back(o, target, true);
+    }
+
+    // One triangle at a time
+    std::vector<cg::RayMeshIntersectResult> single(RAY_COUNT);
+    Timer                                   t_single;
+    for(uint32_t r = 0; r < RAY_COUNT; r++)
+    {
+        cg::RayMeshIntersectResult result{false, 1.0e30f, 0.0f, 0.0f, 0};
+        for(uint32_t f = 0; f < face_count; f++)
+        {
+            cg::RayTriangleIntersectResult t = rays[r].intersect(
+                vertices[faces[f * 3]], vertices[faces[f * 3 + 1]], vertices[faces[f * 3 + 2]]);
+            if(t.intersects && t.distance < result.distance)
+            {
+                result = {true, t.distance, t.barycentric_u, t.barycentric_v, f};
+            }
+        }
+        single[r] = result;
+    }
+    double single_seconds = t_single.seconds();
+
+    // Batches of triangles
+    uint32_t mismatches = 0;
+    Timer    t_batch;
+    for(uint32_t r = 0; r < RAY_COUNT; r++)
+    {
+        cg::RayMeshIntersectResult result{false, 1.0e30f, 0.0f, 0.0f, 0};
+        for(const auto &batch : batches) { batch.intersect(rays[r], result); }
+        if(result.intersects != single[r].intersects ||
+           (result.intersects && (result.distance != single[r].distance ||
+                                  result.face_index != single[r].face_index)))
+        {
+            mismatches++;
+        }
+    }
+    double batch_seconds = t_batch.seconds();
+
+    // Any hit (shadow rays)
+    uint32_t occluded = 0;
+    Timer    t_any;
+    for(uint32_t r = 0; r < RAY_COUNT; r++)
+    {
+        for(const auto &batch : batches)
+        {
+            if(batch.does_intersect_exist(rays[r], 1.0e30f))
+            {
+                occluded++;
+                break;
+            }
+        }
+    }
+    double any_seconds = t_any.seconds();
+    g_sink = g_sink + static_cast<float>(occluded);
+
+    double tests = static_cast<double>(RAY_COUNT) * face_count;
+    std::cout << "Triangle batches (" << cg::TriangleBatch::SIZE << " wide): " << face_count
+              << " triangles, " << batches.size() << " batches\n";
+    std::cout << "  Build       : " << build_seconds * 1.0e3 << " ms\n";
+    std::cout << "  Single      : " << single_seconds * 1.0e9 / tests << " ns/triangle\n";
+    std::cout << "  Batch       : " << batch_seconds * 1.0e9 / tests << " ns/triangle\n";
+    std::cout << "  Any hit     : " << any_seconds * 1.0e9 / RAY_COUNT << " ns/ray (" << occluded
+              << " hits)\n";
+    std::cout << "  Speedup     : " << single_seconds / batch_seconds << "x\n";
+    std::cout << "  Mismatches  : " << mismatches << "\n";
+}
+
+} // namespace bench
@@ -0,0 +1,122 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:  David W. Nesbitt
+//	File:    benchmark/vertex_cache_benchmark.cpp
+//	Purpose: Measure the ACMR of face lists in generation order and after
+//           vertex cache, overdraw, and vertex fetch optimization.
+//
+//============================================================================
+
+#include "benchmark/benchmark.hpp"
+
+#include "geometry/geometry.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace bench
+{
+
+namespace
+{
+
+// Torus grid in the order TriSurface::construct_row_col_face_list emits it
+constexpr uint32_t NUM_TUBE = 256;
+constexpr uint32_t NUM_RING = 128;
+constexpr uint32_t ITERATIONS = 10;
+
+void build_torus(std::vector<cg::Point3> &positions, std::vector<uint32_t> &faces)
+{
+    const float two_pi = 6.2831853f;
+    for(uint32_t row = 0; row <= NUM_TUBE; row++)
+    {
+        float theta = two_pi * row / NUM_TUBE;
+        for(uint32_t col = 0; col <= NUM_RING; col++)
+        {
+            float phi = two_pi * col / NUM_RING;
+            float r = 3.0f + std::cos(phi);
+            positions.emplace_back(r * std::cos(theta), r * std::sin(theta), std::sin(phi));
+        }
+    }
+    uint32_t num_cols = NUM_RING + 1;
+    for(uint32_t row = 0; row < NUM_TUBE; row++)
+    {
+        for(uint32_t col = 0; col < NUM_RING; col++)
+        {
+            uint32_t i00 = row * num_cols + col;
+            uint32_t i10 = i00 + num_cols;
+            faces.insert(faces.end(), {i10, i00, i00 + 1, i10, i00 + 1, i10 + 1});
+        }
+    }
+}
+
+// Reorder faces as TriSurface::optimize_face_order does
+void optimize(std::vector<uint32_t>         &faces,
+              const std::vector<cg::Point3> &positions,
+              bool                           reduce_overdraw)
+{
+    uint32_t vertex_count = static_cast<uint32_t>(positions.size());
+    cg::optimize_vertex_cache(faces, vertex_count);
+    if(reduce_overdraw) { cg::optimize_overdraw(faces, positions); }
+    std::vector<uint32_t> remap;
+    cg::optimize_vertex_fetch(faces, vertex_count, remap);
+}
+
+void report(const char                  *name,
+            const std::vector<uint32_t> &faces,
+            uint32_t                     vertex_count,
+            double                       seconds)
+{
+    std::cout << "  " << name << ": ACMR " << cg::compute_acmr(faces, vertex_count, 16)
+              << " (16), " << cg::compute_acmr(faces, vertex_count, 32) << " (32)";
+    if(seconds > 0.0) { std::cout << ", " << seconds * 1.0e3 / ITERATIONS << " ms/mesh"; }
+    std::cout << '\n';
+}
+
+} // namespace
+
+void run_vertex_cache_benchmark()
+{
+    std::vector<cg::Point3> positions;
+    std::vector<uint32_t>   generated;
+    build_torus(positions, generated);
+    uint32_t vertex_count = static_cast<uint32_t>(positions.size());
+
+    // Triangles in random order (as from a file written by another tool)
+    std::vector<uint32_t> shuffled(generated.size());
+    std::vector<uint32_t> order(generated.size() / 3);
+    for(uint32_t i = 0; i < order.size(); i++) { order[i] = i; }
+    std::shuffle(order.begin(), order.end(), std::mt19937(7));
+    for(size_t i = 0; i < order.size(); i++)
+    {
+        std::copy_n(&generated[order[i] * 3], 3, &shuffled[i * 3]);
+    }
+
+    std::cout << "Vertex cache: " << vertex_count << " vertices, " << generated.size() / 3
+              << " faces\n";
+    report("Generation order   ", generated, vertex_count, 0.0);
+    report("Random order       ", shuffled, vertex_count, 0.0);
+    for(bool reduce_overdraw : {false, true})
+    {
+        std::vector<uint32_t> faces;
+        Timer                 t;
+        for(uint32_t it = 0; it < ITERATIONS; it++)
+        {
+            faces = shuffled;
+            optimize(faces, positions, reduce_overdraw);
+            g_sink = g_sink + static_cast<float>(faces[it]);
+        }
+        report(reduce_overdraw ? "Tipsify + overdraw " : "Tipsify            ",
+               faces,
+               vertex_count,
+               t.seconds());
+    }
+}
+
+} // namespace bench
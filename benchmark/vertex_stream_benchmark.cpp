@@ -0,0 +1,172 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:  David W. Nesbitt
+//	File:    benchmark/vertex_stream_benchmark.cpp
+//	Purpose: Compare vertex normal and tangent space generation using the
+//           interleaved vertex lists versus VertexStream.
+//
+//============================================================================
+
+#include "benchmark/benchmark.hpp"
+
+#include "geometry/geometry.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace bench
+{
+
+namespace
+{
+
+// Grid of a wavy surface - about the size of a dense surface of revolution
+constexpr uint32_t GRID_SIZE = 200;
+constexpr uint32_t ITERATIONS = 20;
+
+void build_grid(std::vector<cg::VertexNormalTexture> &vertices, std::vector<uint16_t> &faces)
+{
+    for(uint32_t row = 0; row < GRID_SIZE; row++)
+    {
+        for(uint32_t col = 0; col < GRID_SIZE; col++)
+        {
+            float s = static_cast<float>(col) / (GRID_SIZE - 1);
+            float t = static_cast<float>(row) / (GRID_SIZE - 1);
+            cg::Point3 p(s * 10.0f, t * 10.0f, std::sin(s * 12.0f) * std::cos(t * 7.0f));
+            vertices.emplace_back(p, cg::Vector3(0.0f, 0.0f, 0.0f), cg::Point2(s, t));
+        }
+    }
+    for(uint32_t row = 0; row < GRID_SIZE - 1; row++)
+    {
+        for(uint32_t col = 0; col < GRID_SIZE - 1; col++)
+        {
+            uint16_t i00 = static_cast<uint16_t>(row * GRID_SIZE + col);
+            uint16_t i01 = static_cast<uint16_t>(i00 + 1);
+            uint16_t i10 = static_cast<uint16_t>(i00 + GRID_SIZE);
+            uint16_t i11 = static_cast<uint16_t>(i10 + 1);
+            faces.insert(faces.end(), {i10, i00, i01, i10, i01, i11});
+        }
+    }
+}
+
+// Per-face vertex normals and tangent space as previously done in TriSurface
+void interleaved_tangent_space(std::vector<cg::VertexNormalTexture>        &vertices,
+                               const std::vector<uint16_t>                 &faces,
+                               std::vector<cg::VertexNormalTextureTangent> &out)
+{
+    for(auto &v : vertices) { v.normal.set(0.0f, 0.0f, 0.0f); }
+    for(size_t i = 0; i < faces.size(); i += 3)
+    {
+        cg::Vector3 e1(vertices[faces[i]].vertex, vertices[faces[i + 1]].vertex);
+        cg::Vector3 e2(vertices[faces[i]].vertex, vertices[faces[i + 2]].vertex);
+        cg::Vector3 n = e1.cross(e2).normalize();
+        for(uint32_t c = 0; c < 3; c++) { vertices[faces[i + c]].normal += n; }
+    }
+    for(auto &v : vertices) { v.normal.normalize(); }
+
+    out.resize(vertices.size());
+    for(size_t i = 0; i < vertices.size(); i++)
+    {
+        out[i] = cg::VertexNormalTextureTangent(vertices[i].vertex, vertices[i].normal,
+                                                vertices[i].texcoord, cg::Vector3(), cg::Vector3());
+    }
+    for(size_t i = 0; i < faces.size(); i += 3)
+    {
+        auto       &a = out[faces[i]];
+        auto       &b = out[faces[i + 1]];
+        auto       &c = out[faces[i + 2]];
+        cg::Vector3 e1(a.vertex, b.vertex);
+        cg::Vector3 e2(a.vertex, c.vertex);
+        float       du1 = b.texcoord.x - a.texcoord.x;
+        float       dv1 = b.texcoord.y - a.texcoord.y;
+        float       du2 = c.texcoord.x - a.texcoord.x;
+        float       dv2 = c.texcoord.y - a.texcoord.y;
+        float       det = du1 * dv2 - du2 * dv1;
+        if(std::abs(det) < 1e-6f) continue;
+        float       r = 1.0f / det;
+        cg::Vector3 t = (e1 * dv2 - e2 * dv1) * r;
+        cg::Vector3 bt = (e2 * du1 - e1 * du2) * r;
+        for(auto *v : {&a, &b, &c})
+        {
+            v->tangent += t;
+            v->bitangent += bt;
+        }
+    }
+    for(auto &v : out)
+    {
+        v.tangent = v.tangent - v.normal * v.normal.dot(v.tangent);
+        v.tangent.normalize();
+        v.bitangent = v.normal.cross(v.tangent);
+        v.bitangent.normalize();
+    }
+}
+
+void stream_tangent_space(const std::vector<cg::VertexNormalTexture>  &vertices,
+                          const std::vector<uint16_t>                 &faces,
+                          cg::VertexStream                            &stream,
+                          std::vector<cg::VertexNormalTextureTangent> &out)
+{
+    stream.load(vertices);
+    stream.accumulate_face_normals(faces.data(), faces.size());
+    stream.normalize_normals();
+    stream.accumulate_tangents(faces.data(), faces.size());
+    stream.orthonormalize_tangents();
+    stream.store(out);
+}
+
+float max_difference(const cg::Vector3 &a, const cg::Vector3 &b)
+{
+    return std::max({std::abs(a.x - b.x), std::abs(a.y - b.y), std::abs(a.z - b.z)});
+}
+
+} // namespace
+
+void run_vertex_stream_benchmark()
+{
+    std::vector<cg::VertexNormalTexture> vertices;
+    std::vector<uint16_t>                faces;
+    build_grid(vertices, faces);
+
+    std::vector<cg::VertexNormalTextureTangent> out_interleaved;
+    Timer                                       t_interleaved;
+    for(uint32_t it = 0; it < ITERATIONS; it++)
+    {
+        interleaved_tangent_space(vertices, faces, out_interleaved);
+        g_sink = g_sink + out_interleaved[it].tangent.x;
+    }
+    double interleaved_seconds = t_interleaved.seconds();
+
+    // Normals start at 0 as they do for TriSurface::end
+    for(auto &v : vertices) { v.normal.set(0.0f, 0.0f, 0.0f); }
+    std::vector<cg::VertexNormalTextureTangent> out_stream;
+    cg::VertexStream                            stream;
+    Timer                                       t_stream;
+    for(uint32_t it = 0; it < ITERATIONS; it++)
+    {
+        stream_tangent_space(vertices, faces, stream, out_stream);
+        g_sink = g_sink + out_stream[it].tangent.x;
+    }
+    double stream_seconds = t_stream.seconds();
+
+    float max_diff = 0.0f;
+    for(size_t i = 0; i < out_stream.size(); i++)
+    {
+        max_diff = std::max(max_diff, max_difference(out_stream[i].normal, out_interleaved[i].normal));
+        max_diff = std::max(max_diff, max_difference(out_stream[i].tangent, out_interleaved[i].tangent));
+        max_diff = std::max(max_diff, max_difference(out_stream[i].bitangent, out_interleaved[i].bitangent));
+    }
+
+    double ms = 1.0e3 / ITERATIONS;
+    std::cout << "Vertex stream: " << vertices.size() << " vertices, " << faces.size() / 3 << " faces\n";
+    std::cout << "  Interleaved    : " << interleaved_seconds * ms << " ms/mesh\n";
+    std::cout << "  VertexStream   : " << stream_seconds * ms << " ms/mesh\n";
+    std::cout << "  Speedup        : " << (interleaved_seconds / stream_seconds) << "x\n";
+    std::cout << "  Max difference : " << max_diff << '\n';
+}
+
+} // namespace bench
@@ -0,0 +1,153 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:  David W. Nesbitt
+//	File:    benchmark/weld_benchmark.cpp
+//	Purpose: Compare finding shared patch boundary vertices by a linear scan
+//           of the vertex list and with the VertexWelder spatial hash.
+//
+//============================================================================
+
+#include "benchmark/benchmark.hpp"
+
+#include "geometry/geometry.hpp"
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace bench
+{
+
+namespace
+{
+
+// 32 patches, as in the teapot, laid out on a wavy 8 x 4 sheet
+constexpr uint32_t PATCH_COLS = 8;
+constexpr uint32_t PATCH_ROWS = 4;
+
+// Linear scans are not run again for higher levels once one takes longer
+constexpr double MAX_SCAN_SECONDS = 5.0;
+
+cg::Point3 sheet_point(float u, float v)
+{
+    return cg::Point3(u, v, 0.25f * std::sin(u * 1.7f) * std::cos(v * 2.3f));
+}
+
+// Add the vertices of each patch the way MeshTeapot::add_patch does: edge
+// vertices look for an existing match, interior vertices are appended
+template <typename Find>
+uint32_t build_patches(uint32_t level, std::vector<cg::Point3> &vertices, Find find)
+{
+    uint32_t n = (1u << level) + 1;
+    uint32_t faces = 0;
+    vertices.clear();
+    for(uint32_t pr = 0; pr < PATCH_ROWS; pr++)
+    {
+        for(uint32_t pc = 0; pc < PATCH_COLS; pc++)
+        {
+            for(uint32_t r = 0; r < n; r++)
+            {
+                for(uint32_t c = 0; c < n; c++)
+                {
+                    float      u = pc + static_cast<float>(c) / (n - 1);
+                    float      v = pr + static_cast<float>(r) / (n - 1);
+                    cg::Point3 p = sheet_point(u, v);
+                    bool       edge = (r == 0 || c == 0 || r == n - 1 || c == n - 1);
+                    uint32_t   index = edge ? find(vertices, p) : UINT32_MAX;
+                    if(index == UINT32_MAX) { vertices.push_back(p); }
+                }
+            }
+            faces += 2 * (n - 1) * (n - 1);
+        }
+    }
+    return faces;
+}
+
+// The brute force search TriSurface::add_vertex used to do
+uint32_t scan(const std::vector<cg::Point3> &vertices, const cg::Point3 &p)
+{
+    for(uint32_t i = 0; i < vertices.size(); i++)
+    {
+        if(vertices[i] == p) { return i; }
+    }
+    return UINT32_MAX;
+}
+
+} // namespace
+
+void run_weld_benchmark()
+{
+    std::cout << "Vertex welding: " << PATCH_COLS * PATCH_ROWS << " patches\n";
+    bool run_scan = true;
+    for(uint32_t level = 3; level <= 7; level++)
+    {
+        std::vector<cg::Point3> vertices;
+        double                  scan_seconds = 0.0;
+        if(run_scan)
+        {
+            Timer t;
+            build_patches(level, vertices, scan);
+            scan_seconds = t.seconds();
+            run_scan = (scan_seconds < MAX_SCAN_SECONDS);
+        }
+
+        // The welder hashes interior vertices too, as TriSurface does
+        cg::VertexWelder welder;
+        Timer            t;
+        uint32_t         faces = build_patches(
+            level,
+            vertices,
+            [&welder](std::vector<cg::Point3> &v, const cg::Point3 &p)
+            {
+                for(size_t i = welder.size(); i < v.size(); i++)
+                {
+                    welder.insert(v[i], static_cast<uint32_t>(i));
+                }
+                return welder.find(p);
+            });
+        double hash_seconds = t.seconds();
+        g_sink = g_sink + vertices.back().x;
+
+        std::cout << "  level " << level << ": " << vertices.size() << " vertices, " << faces
+                  << " faces, hash " << hash_seconds * 1.0e3 << " ms";
+        if(scan_seconds > 0.0)
+        {
+            std::cout << ", linear scan " << scan_seconds * 1.0e3 << " ms ("
+                      << scan_seconds / hash_seconds << "x)";
+        }
+        std::cout << '\n';
+    }
+
+    // Weld pass over a triangle soup (every triangle has its own vertices)
+    uint32_t                         n = 257;
+    std::vector<cg::VertexAndNormal> soup;
+    std::vector<uint32_t>            faces;
+    for(uint32_t r = 0; r + 1 < n; r++)
+    {
+        for(uint32_t c = 0; c + 1 < n; c++)
+        {
+            float u0 = static_cast<float>(c) / (n - 1), u1 = static_cast<float>(c + 1) / (n - 1);
+            float v0 = static_cast<float>(r) / (n - 1), v1 = static_cast<float>(r + 1) / (n - 1);
+            for(const auto &p : {sheet_point(u0, v0),
+                                 sheet_point(u1, v0),
+                                 sheet_point(u1, v1),
+                                 sheet_point(u0, v0),
+                                 sheet_point(u1, v1),
+                                 sheet_point(u0, v1)})
+            {
+                faces.push_back(static_cast<uint32_t>(soup.size()));
+                soup.push_back(cg::VertexAndNormal(p));
+            }
+        }
+    }
+    size_t   soup_size = soup.size();
+    Timer    t;
+    uint32_t removed = cg::weld(soup, faces);
+    std::cout << "  weld of a " << soup_size << " vertex soup: " << removed << " removed, "
+              << soup.size() << " left, " << t.seconds() * 1.0e3 << " ms\n";
+}
+
+} // namespace bench
@@ -21,24 +21,30 @@ uniform float material_shininess;
 uniform vec4 global_light_ambient;
 uniform vec3 camera_position;
 
-// Light structure (support up to 8 lights)
-const int MAX_LIGHTS = 8;
-struct Light {
-    int  enabled;
-    int  spotlight;  // Changed from is_spotlight
-    vec4 position;      // w=0 directional, w=1 point
-    vec4 ambient;
-    vec4 diffuse;
-    vec4 specular;
-    float constant_attenuation;  // Changed from constant_atten
-    float linear_attenuation;    // Changed from linear_atten
-    float quadratic_attenuation; // Changed from quadratic_atten
+// Light sources, shared by all lighting programs through a uniform block
+// (std140 layout, matches cg::LightSource). MAX_LIGHTS must match the
+// application.
+const int MAX_LIGHTS = 32;
+struct LightSource
+{
+    vec4  position;
+    vec4  ambient;
+    vec4  diffuse;
+    vec4  specular;
+    vec3  spot_direction;
     float spot_cutoff;
     float spot_exponent;
-    vec3  spot_direction;
+    float constant_attenuation;
+    float linear_attenuation;
+    float quadratic_attenuation;
+    int   enabled;
+    int   spotlight;
+};
+layout (std140) uniform LightBlock
+{
+    int         num_lights;  // Number of lights in use
+    LightSource lights[MAX_LIGHTS];
 };
-uniform Light lights[MAX_LIGHTS];
-uniform int num_lights;
 
 // Normal map texture
 uniform sampler2D normal_map;
@@ -2,7 +2,7 @@
 
 // Vertex attributes with explicit layout locations
 layout(location = 0) in vec3 vtx_position;
-layout(location = 1) in vec3 vtx_normal;
+layout(location = 1) in vec4 vtx_normal;    // Normal, or QTangent when packed
 layout(location = 2) in vec2 vtx_texcoord;
 layout(location = 3) in vec3 vtx_tangent;
 layout(location = 4) in vec3 vtx_bitangent;
@@ -19,18 +19,67 @@ uniform mat4 pvm_matrix;      // Projection * View * Model
 uniform mat4 model_matrix;    // Model matrix
 uniform mat4 normal_matrix;   // Transpose of inverse model matrix
 
+// Packed vertex buffers (TriSurface::pack_vertices). Flag 1: the normal is
+// octahedral encoded in xy. Flag 2: vtx_normal is a QTangent holding the
+// whole tangent frame. Flag 4: the position is quantized to the bounds of
+// the mesh, position_offset + vtx_position * position_scale.
+uniform int  vertex_packing;
+uniform vec3 position_offset;
+uniform vec3 position_scale;
+
+// Decode a unit vector folded onto a square by the octahedral encoding
+vec3 octahedral_decode(vec2 e)
+{
+    vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-v.z, 0.0);
+    v.x += (v.x >= 0.0) ? -t : t;
+    v.y += (v.y >= 0.0) ? -t : t;
+    return normalize(v);
+}
+
+// Rotate the x, y, and z axes by a unit quaternion to get the tangent,
+// bitangent, and normal. The sign of w gives the handedness.
+void qtangent_decode(vec4 q, out vec3 n, out vec3 t, out vec3 b)
+{
+    t = vec3(1.0 - 2.0 * (q.y * q.y + q.z * q.z),
+             2.0 * (q.x * q.y + q.w * q.z),
+             2.0 * (q.x * q.z - q.w * q.y));
+    b = vec3(2.0 * (q.x * q.y - q.w * q.z),
+             1.0 - 2.0 * (q.x * q.x + q.z * q.z),
+             2.0 * (q.y * q.z + q.w * q.x));
+    n = vec3(2.0 * (q.x * q.z + q.w * q.y),
+             2.0 * (q.y * q.z - q.w * q.x),
+             1.0 - 2.0 * (q.x * q.x + q.y * q.y));
+    b *= (q.w < 0.0) ? -1.0 : 1.0;
+}
+
 void main()
 {
+    // Model coordinate position and tangent frame (decoded if packed)
+    vec3 position = ((vertex_packing & 4) != 0) ?
+        position_offset + vtx_position * position_scale : vtx_position;
+    vec3 normal = vtx_normal.xyz;
+    vec3 tangent = vtx_tangent;
+    vec3 bitangent = vtx_bitangent;
+    if ((vertex_packing & 2) != 0)
+    {
+        qtangent_decode(normalize(vtx_normal), normal, tangent, bitangent);
+    }
+    else if ((vertex_packing & 1) != 0)
+    {
+        normal = octahedral_decode(vtx_normal.xy);
+    }
+
     // Transform position to clip space
-    gl_Position = pvm_matrix * vec4(vtx_position, 1.0);
+    gl_Position = pvm_matrix * vec4(position, 1.0);
 
     // Transform position to world space for lighting
-    frag_position = vec3(model_matrix * vec4(vtx_position, 1.0));
+    frag_position = vec3(model_matrix * vec4(position, 1.0));
 
     // Transform TBN basis vectors to world space
-    frag_normal = normalize(vec3(normal_matrix * vec4(vtx_normal, 0.0)));
-    frag_tangent = normalize(vec3(normal_matrix * vec4(vtx_tangent, 0.0)));
-    frag_bitangent = normalize(vec3(normal_matrix * vec4(vtx_bitangent, 0.0)));
+    frag_normal = normalize(vec3(normal_matrix * vec4(normal, 0.0)));
+    frag_tangent = normalize(vec3(normal_matrix * vec4(tangent, 0.0)));
+    frag_bitangent = normalize(vec3(normal_matrix * vec4(bitangent, 0.0)));
 
     // Pass texture coordinates through
     frag_texcoord = vtx_texcoord;
@@ -1,6 +1,5 @@
 #include "final/bump_mapping_shader_node.hpp"
 
-#include <cstdio>
 #include <iostream>
 
 namespace cg
@@ -10,8 +9,7 @@ BumpMappingShaderNode::BumpMappingShaderNode()
     : normal_map_texture_id_(0),
       normal_map_bound_(false),
       normal_mapping_enabled_(true),
-      bump_strength_(1.0f),
-      light_count_(3)  // Support 3 lights like LightingShaderNode
+      bump_strength_(1.0f)
 {
     node_type_ = SceneNodeType::SHADER;
 
@@ -98,11 +96,9 @@ bool BumpMappingShaderNode::get_locations()
     material_emission_loc_ = glGetUniformLocation(shader_program_.get_program(), "material_emission");
     material_shininess_loc_ = glGetUniformLocation(shader_program_.get_program(), "material_shininess");
 
-    // Get lighting uniform locations (EXACTLY like LightingShaderNode)
-    light_count_loc_ = glGetUniformLocation(shader_program_.get_program(), "num_lights");
-    if (light_count_loc_ < 0)
+    // Lights come from the shared light uniform block
+    if (!LightBuffer::bind_block(shader_program_.get_program()))
     {
-        std::cout << "Error getting num_lights location\n";
         return false;
     }
 
@@ -113,60 +109,24 @@ bool BumpMappingShaderNode::get_locations()
         return false;
     }
 
-    // Get light array uniforms (use same names as LightingShaderNode/LightNode expect)
-    char name[128];
-    for (int i = 0; i < light_count_; i++)
-    {
-        snprintf(name, 128, "lights[%d].enabled", i);
-        lights_[i].enabled = glGetUniformLocation(shader_program_.get_program(), name);
-
-        snprintf(name, 128, "lights[%d].spotlight", i);
-        lights_[i].spotlight = glGetUniformLocation(shader_program_.get_program(), name);
-
-        snprintf(name, 128, "lights[%d].position", i);
-        lights_[i].position = glGetUniformLocation(shader_program_.get_program(), name);
-
-        snprintf(name, 128, "lights[%d].ambient", i);
-        lights_[i].ambient = glGetUniformLocation(shader_program_.get_program(), name);
-
-        snprintf(name, 128, "lights[%d].diffuse", i);
-        lights_[i].diffuse = glGetUniformLocation(shader_program_.get_program(), name);
-
-        snprintf(name, 128, "lights[%d].specular", i);
-        lights_[i].specular = glGetUniformLocation(shader_program_.get_program(), name);
-
-        snprintf(name, 128, "lights[%d].constant_attenuation", i);
-        lights_[i].att_constant = glGetUniformLocation(shader_program_.get_program(), name);
-
-        snprintf(name, 128, "lights[%d].linear_attenuation", i);
-        lights_[i].att_linear = glGetUniformLocation(shader_program_.get_program(), name);
-
-        snprintf(name, 128, "lights[%d].quadratic_attenuation", i);
-        lights_[i].att_quadratic = glGetUniformLocation(shader_program_.get_program(), name);
-
-        snprintf(name, 128, "lights[%d].spot_cutoff", i);
-        lights_[i].spot_cutoff = glGetUniformLocation(shader_program_.get_program(), name);
-
-        snprintf(name, 128, "lights[%d].spot_exponent", i);
-        lights_[i].spot_exponent = glGetUniformLocation(shader_program_.get_program(), name);
-
-        snprintf(name, 128, "lights[%d].spot_direction", i);
-        lights_[i].spot_direction = glGetUniformLocation(shader_program_.get_program(), name);
-    }
-
     // Get normal map uniform locations
     normal_map_loc_ = glGetUniformLocation(shader_program_.get_program(), "normal_map");
     use_normal_map_loc_ = glGetUniformLocation(shader_program_.get_program(), "use_normal_map");
     bump_strength_loc_ = glGetUniformLocation(shader_program_.get_program(), "bump_strength");
 
+    // Packed vertex buffers (QTangent frames) are decoded in the vertex shader
+    vertex_packing_loc_ = glGetUniformLocation(shader_program_.get_program(), "vertex_packing");
+    position_offset_loc_ = glGetUniformLocation(shader_program_.get_program(), "position_offset");
+    position_scale_loc_ = glGetUniformLocation(shader_program_.get_program(), "position_scale");
+
     std::cout << "BumpMappingShaderNode: All shader locations retrieved\n";
     return true;
 }
 
-void BumpMappingShaderNode::draw(SceneState &scene_state)
+void BumpMappingShaderNode::apply(SceneState &scene_state)
 {
     // Enable this shader program
-    shader_program_.use();
+    scene_state.gl_state.use_program(shader_program_.get_program());
     
     // Set scene state locations
     scene_state.position_loc = position_loc_;
@@ -180,7 +140,13 @@ void BumpMappingShaderNode::draw(SceneState &scene_state)
     scene_state.normal_matrix_loc = normal_matrix_loc_;
     scene_state.camera_position_loc = camera_position_loc;
 
-    // Set material uniform locations
+    // Set material uniform locations (this program does not use the
+    // material table)
+    scene_state.material_index_loc = -1;
+    scene_state.instanced_loc = -1;
+    scene_state.vertex_packing_loc = vertex_packing_loc_;
+    scene_state.position_offset_loc = position_offset_loc_;
+    scene_state.position_scale_loc = position_scale_loc_;
     scene_state.material_ambient_loc = material_ambient_loc_;
     scene_state.material_diffuse_loc = material_diffuse_loc_;
     scene_state.material_specular_loc = material_specular_loc_;
@@ -188,42 +154,36 @@ void BumpMappingShaderNode::draw(SceneState &scene_state)
     scene_state.material_shininess_loc = material_shininess_loc_;
 
     // Set global ambient uniform
-    glUniform4f(global_ambient_loc_, 0.2f, 0.2f, 0.2f, 1.0f);
-
-    // Set number of lights uniform (we expect exactly 1 light)
-    glUniform1i(light_count_loc_, 1);
+    scene_state.gl_state.uniform4f(global_ambient_loc_, 0.2f, 0.2f, 0.2f, 1.0f);
 
     // Set camera position
-    glUniform3f(camera_position_loc,
+    scene_state.gl_state.uniform3f(camera_position_loc,
                 scene_state.camera_position.x,
                 scene_state.camera_position.y,
                 scene_state.camera_position.z);
 
-    // CRITICAL: Set light state BEFORE binding textures
-    glUniform1i(lights_[0].enabled, 1);
-    glUniform1i(lights_[0].spotlight, 0);
-    glUniform4f(lights_[0].position, 0.0f, -50.0f, 80.0f, 1.0f);
-    glUniform4f(lights_[0].ambient, 0.2f, 0.2f, 0.2f, 1.0f);
-    glUniform4f(lights_[0].diffuse, 1.0f, 1.0f, 1.0f, 1.0f);
-    glUniform4f(lights_[0].specular, 1.0f, 1.0f, 1.0f, 1.0f);
-    glUniform1f(lights_[0].att_constant, 1.0f);
-    glUniform1f(lights_[0].att_linear, 0.0f);
-    glUniform1f(lights_[0].att_quadratic, 0.0f);
+    // The scene has a single point light, set in light 0 of the shared
+    // light block
+    LightSource light = {};
+    light.enabled = 1;
+    light.position = HPoint3(0.0f, -50.0f, 80.0f, 1.0f);
+    light.ambient = Color4(0.2f, 0.2f, 0.2f, 1.0f);
+    light.diffuse = Color4(1.0f, 1.0f, 1.0f, 1.0f);
+    light.specular = Color4(1.0f, 1.0f, 1.0f, 1.0f);
+    light.constant_attenuation = 1.0f;
+    scene_state.light_buffer.set_light(0, light);
 
     // Bind normal map if available
     if (normal_map_bound_)
     {
-        glActiveTexture(GL_TEXTURE5);
-        glBindTexture(GL_TEXTURE_2D, normal_map_texture_id_);
-        glUniform1i(normal_map_loc_, 5);
+        scene_state.gl_state.bind_texture(5, normal_map_texture_id_);
+        scene_state.gl_state.uniform1i(normal_map_loc_, 5);
     }
 
     // Set normal mapping uniforms
-    glUniform1i(use_normal_map_loc_, (normal_map_bound_ && normal_mapping_enabled_) ? 1 : 0);
-    glUniform1f(bump_strength_loc_, bump_strength_);
-
-    // Draw all children
-    SceneNode::draw(scene_state);
+    bool use_normal_map = normal_map_bound_ && normal_mapping_enabled_;
+    scene_state.gl_state.uniform1i(use_normal_map_loc_, use_normal_map ? 1 : 0);
+    scene_state.gl_state.uniform1f(bump_strength_loc_, bump_strength_);
 }
 
 bool BumpMappingShaderNode::bind_normal_map(ImageData *im_data)
@@ -25,10 +25,10 @@ class BumpMappingShaderNode : public ShaderNode
     bool get_locations() override;
 
     /**
-     * Draw method - enables shader, sets uniforms, draws children.
+     * Apply method - enables shader, sets uniforms.
      * @param scene_state Current scene state.
      */
-    void draw(SceneState &scene_state) override;
+    void apply(SceneState &scene_state) override;
 
     /**
      * Bind a normal map texture.
@@ -70,6 +70,11 @@ class BumpMappingShaderNode : public ShaderNode
     GLint tangent_loc_;
     GLint bitangent_loc_;
 
+    // Packed vertex decoding locations
+    GLint vertex_packing_loc_;
+    GLint position_offset_loc_;
+    GLint position_scale_loc_;
+
     // Matrix uniform locations
     GLint pvm_matrix_loc_;
     GLint model_matrix_loc_;
@@ -83,11 +88,8 @@ class BumpMappingShaderNode : public ShaderNode
     GLint material_emission_loc_;
     GLint material_shininess_loc_;
 
-    // Lighting uniforms (match LightingShaderNode pattern EXACTLY)
-    int32_t       light_count_;
-    GLint         light_count_loc_;
-    GLint         global_ambient_loc_;
-    LightUniforms lights_[3];  // Support 3 lights like LightingShaderNode
+    // Lighting uniforms (lights are in the shared light block)
+    GLint global_ambient_loc_;
 
     // Normal map uniform locations
     GLint normal_map_loc_;
@@ -30,11 +30,11 @@ class LightingShaderNode : public ShaderNode
     bool get_locations() override;
 
     /**
-     * Draw method for this shader - enable the program and set up uniforms
+     * Apply method for this shader - enable the program and set up uniforms
      * and vertex attribute locations
      * @param  scene_state   Current scene state.
      */
-    void draw(SceneState &scene_state) override;
+    void apply(SceneState &scene_state) override;
 
     /**
      * Set the global ambient lighting property. This sets uniforms in the
@@ -72,20 +72,25 @@ class LightingShaderNode : public ShaderNode
     GLint normal_matrix_loc_;  // Normal transformation matrix location
     GLint camera_position_loc; // Camera position uniform location
 
-    // Material uniform locations
-    GLint material_ambient_loc_;   // Material ambient location
-    GLint material_diffuse_loc_;   // Material diffuse location
-    GLint material_specular_loc_;  // Material specular location
-    GLint material_emission_loc_;  // Material emission location
-    GLint material_shininess_loc_; // Material shininess location
+    // Index into the material table
+    GLint material_index_loc_;
 
     GLint texture_sampler_loc_; // Texture sampler location
-    GLint use_texture_loc_;     // Use texture flag location
+
+    // Instanced drawing locations (instanced_loc_ is -1 if not supported)
+    GLint instanced_loc_;         // Instanced flag location
+    GLint pv_matrix_loc_;         // Composite projection and view matrix location
+    GLint instance_model_loc_;    // Per-instance model matrix attribute location
+    GLint instance_normal_loc_;   // Per-instance normal matrix attribute location
+    GLint instance_material_loc_; // Per-instance material index attribute location
+
+    // Packed vertex decoding locations
+    GLint vertex_packing_loc_;  // Packing flags location
+    GLint position_offset_loc_; // Quantized position offset location
+    GLint position_scale_loc_;  // Quantized position scale location
+
     // Lighting uniforms
-    int32_t       light_count_;        // Number of lights
-    GLint         light_count_loc_;    // Light count uniform locations
-    GLint         global_ambient_loc_; // Global ambient uniform location
-    LightUniforms lights_[3];          // Light source uniform locations
+    GLint global_ambient_loc_; // Global ambient uniform location
 };
 
 } // namespace cg
@@ -78,6 +78,7 @@ void display()
 
     g_scene_state.init();
     g_scene_root->draw(g_scene_state);
+    g_scene_state.gl_state.end_frame();
 
     SDL_GL_SwapWindow(g_sdl_window);
 }
@@ -457,6 +458,11 @@ void construct_scene()
         bump_tan_loc, bump_bitan_loc
     );
 
+    // Pack the tangent frames into QTangents, texture coordinates into half
+    // floats, and positions into 16 bit integers (56 -> 20 bytes per vertex)
+    bump_sphere->pack_vertices(cg::VertexPacking::ATTRIBUTES_AND_POSITIONS);
+    std::cout << "Bump sphere vertex size: " << bump_sphere->get_vertex_size() << " bytes\n";
+
     // Transform for bump-mapped sphere - position center
     auto bump_transform = std::make_shared<cg::TransformNode>();
     bump_transform->translate(0.0f, 0.0f, 25.0f);
@@ -520,6 +526,7 @@ void construct_scene()
         blue_pos_loc, blue_norm_loc, blue_tex_loc,
         blue_tan_loc, blue_bitan_loc
     );
+    particle_sphere->pack_vertices(cg::VertexPacking::ATTRIBUTES_AND_POSITIONS);
 
     // Transform for particle sphere - position right
     auto particle_sphere_transform = std::make_shared<cg::TransformNode>();
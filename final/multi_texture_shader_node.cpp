@@ -122,10 +122,10 @@ bool MultiTextureShaderNode::get_locations()
     return true;
 }
 
-void MultiTextureShaderNode::draw(SceneState &scene_state)
+void MultiTextureShaderNode::apply(SceneState &scene_state)
 {
     // Enable this program
-    shader_program_.use();
+    scene_state.gl_state.use_program(shader_program_.get_program());
 
     // Set scene state locations
     scene_state.position_loc = position_loc_;
@@ -135,27 +135,28 @@ void MultiTextureShaderNode::draw(SceneState &scene_state)
     scene_state.model_matrix_loc = model_matrix_loc_;
     scene_state.normal_matrix_loc = normal_matrix_loc_;
     scene_state.material_diffuse_loc = material_diffuse_loc_;
+    scene_state.material_index_loc = -1; // No material table
+    scene_state.instanced_loc = -1;      // No instanced drawing
+    scene_state.vertex_packing_loc = -1; // No packed vertices
+    scene_state.position_offset_loc = -1;
+    scene_state.position_scale_loc = -1;
 
     // Bind and activate all enabled textures
     for(int i = 0; i < MAX_TEXTURES; i++)
     {
         if(texture_bound_[i])
         {
-            glActiveTexture(GL_TEXTURE0 + i);
-            glBindTexture(GL_TEXTURE_2D, texture_ids_[i]);
-            glUniform1i(texture_sampler_locs_[i], i);
+            scene_state.gl_state.bind_texture(i, texture_ids_[i]);
+            scene_state.gl_state.uniform1i(texture_sampler_locs_[i], i);
         }
-        glUniform1i(texture_enabled_locs_[i], texture_enabled_[i] ? 1 : 0);
+        scene_state.gl_state.uniform1i(texture_enabled_locs_[i], texture_enabled_[i] ? 1 : 0);
     }
 
     // Set blend mode uniform
-    glUniform1i(blend_mode_loc_, static_cast<int>(blend_mode_));
+    scene_state.gl_state.uniform1i(blend_mode_loc_, static_cast<int>(blend_mode_));
     
     // Set mix factor uniform
-    glUniform1f(mix_factor_loc_, mix_factor_);
-
-    // Draw all children
-    SceneNode::draw(scene_state);
+    scene_state.gl_state.uniform1f(mix_factor_loc_, mix_factor_);
 }
 
 bool MultiTextureShaderNode::bind_texture(int unit, ImageData *im_data)
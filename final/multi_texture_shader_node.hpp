@@ -41,10 +41,10 @@ class MultiTextureShaderNode : public ShaderNode
     bool get_locations() override;
 
     /**
-     * Draw method - enables the program and sets up uniforms
+     * Apply method - enables the program and sets up uniforms
      * @param  scene_state   Current scene state.
      */
-    void draw(SceneState &scene_state) override;
+    void apply(SceneState &scene_state) override;
 
     /**
      * Bind a texture to a specific texture unit (0-3).
@@ -204,29 +204,37 @@ void ParticleSystemNode::draw(SceneState& scene_state)
     // Update time (automatically advances animation)
     current_time_ += 1.0f / 60.0f;  // Advance by one frame at 60 FPS
 
-    // Enable shader program
-    glUseProgram(shader_program_.get_program());
-
-    // Particles are in local space, so use full PVM matrix
-    Matrix4x4 pvm = scene_state.pv * scene_state.model_matrix;
-    glUniformMatrix4fv(pvm_matrix_loc_, 1, GL_FALSE, pvm.get());
-    glUniform1f(point_size_loc_, point_size_);
-    glUniform3fv(particle_color_loc_, 1, particle_color_);
-    glUniform1f(current_time_loc_, current_time_);  // Send time to shader
-    glUniform1f(min_distance_loc_, min_distance_);
+    // Enable shader program and set uniforms
+    apply(scene_state);
 
     // Enable point sprites
     glEnable(GL_PROGRAM_POINT_SIZE);
 
     // Draw particles
-    glBindVertexArray(vao_);
+    scene_state.gl_state.bind_vertex_array(vao_);
     glDrawArrays(GL_POINTS, 0, particles_.size());
-    glBindVertexArray(0);
 
     // Draw children (if any)
     SceneNode::draw(scene_state);
 }
 
+void ParticleSystemNode::apply(SceneState& scene_state)
+{
+    // Enable shader program
+    GLStateCache &gl = scene_state.gl_state;
+    gl.use_program(shader_program_.get_program());
+
+    // Particles are in local space, so use full PVM matrix
+    Matrix4x4 pvm = scene_state.pv * scene_state.model_matrix;
+    gl.uniform_matrix4fv(pvm_matrix_loc_, pvm.get());
+    gl.uniform1f(point_size_loc_, point_size_);
+    gl.uniform3fv(particle_color_loc_, particle_color_);
+    gl.uniform1f(current_time_loc_, current_time_);  // Send time to shader
+    gl.uniform1f(min_distance_loc_, min_distance_);
+}
+
+bool ParticleSystemNode::can_flatten() const { return false; }
+
 void ParticleSystemNode::add_particles(int count)
 {
     for (int i = 0; i < count; ++i)
@@ -55,6 +55,18 @@ class ParticleSystemNode : public ShaderNode
      */
     void draw(SceneState &scene_state) override;
 
+    /**
+     * Apply method - enables the program and sets the particle uniforms
+     * @param  scene_state   Current scene state.
+     */
+    void apply(SceneState &scene_state) override;
+
+    /**
+     * The particles are drawn by this node, so it cannot be flattened.
+     * @return  Returns false.
+     */
+    bool can_flatten() const override;
+
     /**
      * Add more particles to the swarm
      * @param count  Number of particles to add
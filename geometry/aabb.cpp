@@ -2,56 +2,78 @@
 
 #include "geometry/geometry.hpp"
 
+#include <algorithm>
+#include <limits>
+
 namespace cg
 {
 
-// NOTE - this is not required until 605.767!
-
 AABB::AABB()
+    : min_point(std::numeric_limits<float>::max(),
+                std::numeric_limits<float>::max(),
+                std::numeric_limits<float>::max()),
+      max_point(-std::numeric_limits<float>::max(),
+                -std::numeric_limits<float>::max(),
+                -std::numeric_limits<float>::max())
 {
-    // Complete in 605.767
 }
 
-AABB::AABB(const Point3 &min, const Point3 &max)
-{
-    // Complete in 605.767
-}
+AABB::AABB(const Point3 &min, const Point3 &max) { update(min, max); }
 
-AABB::AABB(const std::vector<Point3> &vertex_list)
-{
-    // Complete in 605.767
-}
+AABB::AABB(const std::vector<Point3> &vertex_list) { create(vertex_list); }
 
 void AABB::create(const std::vector<Point3> &vertex_list)
 {
-    // Complete in 605.767
+    *this = AABB();
+    for(const auto &v : vertex_list) { merge(v); }
+    compute_center();
 }
 
 void AABB::update(const Point3 &min, const Point3 &max)
 {
-    // Complete in 605.767
+    min_point = min;
+    max_point = max;
+    compute_center();
 }
 
 void AABB::merge(const AABB &box)
 {
-    // Complete in 605.767
+    if(box.is_empty()) { return; }
+    min_point.set(std::min(min_point.x, box.min_point.x),
+                  std::min(min_point.y, box.min_point.y),
+                  std::min(min_point.z, box.min_point.z));
+    max_point.set(std::max(max_point.x, box.max_point.x),
+                  std::max(max_point.y, box.max_point.y),
+                  std::max(max_point.z, box.max_point.z));
+    compute_center();
 }
 
-Point3 AABB::min_pt() const
+void AABB::merge(const Point3 &p)
 {
-    // Complete in 605.767
-    return Point3();
+    min_point.set(std::min(min_point.x, p.x), std::min(min_point.y, p.y), std::min(min_point.z, p.z));
+    max_point.set(std::max(max_point.x, p.x), std::max(max_point.y, p.y), std::max(max_point.z, p.z));
 }
 
-Point3 AABB::max_pt() const
-{
-    // Complete in 605.767
-    return Point3();
-}
+bool AABB::is_empty() const { return min_point.x > max_point.x; }
+
+Point3 AABB::min_pt() const { return min_point; }
+
+Point3 AABB::max_pt() const { return max_point; }
 
-void compute_center()
+void AABB::compute_center()
 {
-    // Complete in 605.767
+    if(is_empty())
+    {
+        center.set(0.0f, 0.0f, 0.0f);
+        half_diagonal.set(0.0f, 0.0f, 0.0f);
+        return;
+    }
+    center.set(0.5f * (min_point.x + max_point.x),
+               0.5f * (min_point.y + max_point.y),
+               0.5f * (min_point.z + max_point.z));
+    half_diagonal.set(0.5f * (max_point.x - min_point.x),
+                      0.5f * (max_point.y - min_point.y),
+                      0.5f * (max_point.z - min_point.z));
 }
 
 } // namespace cg
@@ -12,6 +12,7 @@
 #define __GEOMETRY_AABB_HPP__
 
 #include "geometry/point3.hpp"
+#include "geometry/vector3.hpp"
 
 #include <vector>
 
@@ -23,8 +24,14 @@ namespace cg
  */
 struct AABB
 {
+    Point3  min_point;     // Minimum x,y,z
+    Point3  max_point;     // Maximum x,y,z
+    Point3  center;        // Center (set by compute_center)
+    Vector3 half_diagonal; // Half of the diagonal from min to max (set by compute_center)
+
     /**
-     * Default constructor.
+     * Default constructor. Creates an empty box (min > max) so that merging
+     * with another box or point gives that box or point.
      */
     AABB();
 
@@ -60,6 +67,19 @@ struct AABB
      */
     void merge(const AABB &box);
 
+    /**
+     * Expand this box to contain a point. Does not update the center and
+     * half diagonal - call compute_center when done adding points.
+     * @param  p  Point to add.
+     */
+    void merge(const Point3 &p);
+
+    /**
+     * Check whether the box is empty (no points have been added).
+     * @return  Returns true if the box is empty.
+     */
+    bool is_empty() const;
+
     /**
      * Get the point at the minimum x,y,z.
      * @return  Returns the min. point.
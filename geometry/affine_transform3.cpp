@@ -0,0 +1,460 @@
+#include "geometry/affine_transform3.hpp"
+
+#include "geometry/geometry.hpp"
+#include "geometry/simd.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace cg
+{
+
+// Forward declare logging function
+void logmsg(const char *message, ...);
+
+namespace
+{
+
+#if defined(CG_SIMD_SSE)
+// Lane x of the result comes from lane x of the source, etc.
+#define CG_AFFINE_SWIZZLE(v, x, y, z, w)                                                          \
+    _mm_shuffle_ps((v), (v), (x) | ((y) << 2) | ((z) << 4) | ((w) << 6))
+
+// Cross product of the x, y, z lanes (w is 0)
+inline __m128 cross3(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(
+        _mm_mul_ps(CG_AFFINE_SWIZZLE(a, 1, 2, 0, 3), CG_AFFINE_SWIZZLE(b, 2, 0, 1, 3)),
+        _mm_mul_ps(CG_AFFINE_SWIZZLE(a, 2, 0, 1, 3), CG_AFFINE_SWIZZLE(b, 1, 2, 0, 3)));
+}
+
+// Sum of columns c0, c1, c2 weighted by b[0], b[1], b[2]
+inline __m128 combine3(__m128 c0, __m128 c1, __m128 c2, const float *b)
+{
+    __m128 r = _mm_mul_ps(c0, _mm_set1_ps(b[0]));
+    r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_set1_ps(b[1])));
+    return _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(b[2])));
+}
+
+// Product of a 4x4 matrix (columns c0..c3) and an affine transform b
+// (column order, last row 0 0 0 1) stored to r. The last row of b means
+// each column needs 3 multiply-adds, plus c3 for the translation column.
+inline void mul_affine(__m128 c0, __m128 c1, __m128 c2, __m128 c3, const float *b, float *r)
+{
+    _mm_store_ps(&r[0], combine3(c0, c1, c2, &b[0]));
+    _mm_store_ps(&r[4], combine3(c0, c1, c2, &b[4]));
+    _mm_store_ps(&r[8], combine3(c0, c1, c2, &b[8]));
+    _mm_store_ps(&r[12], _mm_add_ps(combine3(c0, c1, c2, &b[12]), c3));
+}
+#else
+// Scalar version of the product above
+inline void mul_affine(const float *a, const float *b, float *r)
+{
+    for(uint32_t col = 0; col < 4; col++)
+    {
+        const float *bc = &b[col * 4];
+        for(uint32_t row = 0; row < 4; row++)
+        {
+            r[col * 4 + row] = a[row] * bc[0] + a[4 + row] * bc[1] + a[8 + row] * bc[2];
+        }
+    }
+    r[12] += a[12];
+    r[13] += a[13];
+    r[14] += a[14];
+    r[15] += a[15];
+}
+#endif
+
+} // namespace
+
+AffineTransform3::AffineTransform3() { set_identity(); }
+
+AffineTransform3::AffineTransform3(AffineType type, float scale) : type_(type), scale_(scale) {}
+
+AffineTransform3::AffineTransform3(const Matrix4x4 &m)
+{
+    for(uint32_t col = 0; col < 4; col++)
+    {
+        a_[col * 4] = m.m(0, col);
+        a_[col * 4 + 1] = m.m(1, col);
+        a_[col * 4 + 2] = m.m(2, col);
+        a_[col * 4 + 3] = (col == 3) ? 1.0f : 0.0f;
+    }
+    type_ = AffineType::GENERAL;
+    scale_ = 1.0f;
+}
+
+void AffineTransform3::set_identity()
+{
+    a_.fill(0.0f);
+    a_[0] = 1.0f;
+    a_[5] = 1.0f;
+    a_[10] = 1.0f;
+    a_[15] = 1.0f;
+    type_ = AffineType::IDENTITY;
+    scale_ = 1.0f;
+}
+
+bool AffineTransform3::operator==(const AffineTransform3 &n) const { return a_ == n.a_; }
+
+AffineType AffineTransform3::get_type() const { return type_; }
+
+float AffineTransform3::m(uint32_t row, uint32_t col) const
+{
+    return (row < 4 && col < 4) ? a_[col * 4 + row] : 0.0f;
+}
+
+AffineTransform3 AffineTransform3::operator*(const AffineTransform3 &n) const
+{
+    if(n.type_ == AffineType::IDENTITY) return *this;
+    if(type_ == AffineType::IDENTITY) return n;
+
+    // Linear part is the 3x3 product, translation is L * t_n + t. The last
+    // rows (0 0 0 1) come out of the same product.
+    AffineTransform3 t(std::max(type_, n.type_), scale_ * n.scale_);
+#if defined(CG_SIMD_SSE)
+    mul_affine(_mm_load_ps(&a_[0]),
+               _mm_load_ps(&a_[4]),
+               _mm_load_ps(&a_[8]),
+               _mm_load_ps(&a_[12]),
+               n.a_.data(),
+               t.a_.data());
+#else
+    mul_affine(a_.data(), n.a_.data(), t.a_.data());
+#endif
+    return t;
+}
+
+AffineTransform3 &AffineTransform3::operator*=(const AffineTransform3 &n)
+{
+    *this = *this * n;
+    return *this;
+}
+
+Point3 AffineTransform3::operator*(const Point3 &p) const
+{
+    return Point3(a_[0] * p.x + a_[4] * p.y + a_[8] * p.z + a_[12],
+                  a_[1] * p.x + a_[5] * p.y + a_[9] * p.z + a_[13],
+                  a_[2] * p.x + a_[6] * p.y + a_[10] * p.z + a_[14]);
+}
+
+Vector3 AffineTransform3::operator*(const Vector3 &v) const
+{
+    return Vector3(a_[0] * v.x + a_[4] * v.y + a_[8] * v.z,
+                   a_[1] * v.x + a_[5] * v.y + a_[9] * v.z,
+                   a_[2] * v.x + a_[6] * v.y + a_[10] * v.z);
+}
+
+BoundingSphere AffineTransform3::operator*(const BoundingSphere &s) const
+{
+    float scale = 1.0f;
+    if(type_ == AffineType::UNIFORM_SCALE) { scale = std::abs(scale_); }
+    else if(type_ == AffineType::GENERAL)
+    {
+        // Length of the longest transformed axis
+        float sx = a_[0] * a_[0] + a_[1] * a_[1] + a_[2] * a_[2];
+        float sy = a_[4] * a_[4] + a_[5] * a_[5] + a_[6] * a_[6];
+        float sz = a_[8] * a_[8] + a_[9] * a_[9] + a_[10] * a_[10];
+        scale = std::sqrt(std::max(sx, std::max(sy, sz)));
+    }
+    return BoundingSphere((*this) * s.center, s.radius * scale);
+}
+
+void AffineTransform3::translate(float x, float y, float z)
+{
+    AffineTransform3 t;
+    t.a_[12] = x;
+    t.a_[13] = y;
+    t.a_[14] = z;
+    t.type_ = AffineType::RIGID;
+
+    // Right-multiply the current transform
+    *this *= t;
+}
+
+void AffineTransform3::scale(float x, float y, float z)
+{
+    if(x == 1.0f && y == 1.0f && z == 1.0f) return;
+
+    AffineTransform3 s;
+    s.a_[0] = x;
+    s.a_[5] = y;
+    s.a_[10] = z;
+    if(x == y && y == z)
+    {
+        s.type_ = AffineType::UNIFORM_SCALE;
+        s.scale_ = x;
+    }
+    else s.type_ = AffineType::GENERAL;
+
+    // Right-multiply the current transform
+    *this *= s;
+}
+
+void AffineTransform3::rotate(float angle, float x, float y, float z)
+{
+    // Handle simple cases of rotation about a single axis
+    if(x > 0.0f && y == 0.0f && z == 0.0f)
+    {
+        rotate_x(angle);
+        return;
+    }
+    else if(y > 0.0f && x == 0.0f && z == 0.0f)
+    {
+        rotate_y(angle);
+        return;
+    }
+    else if(z > 0.0f && x == 0.0f && y == 0.0f)
+    {
+        rotate_z(angle);
+        return;
+    }
+
+    // Set up the standard rotation using quaternions (see Matrix4x4::rotate)
+    float   s = std::cos(degrees_to_radians(angle * 0.5f));
+    Vector3 v(x, y, z);
+    v.normalize();
+    v *= std::sin(degrees_to_radians(angle * 0.5f));
+    float a = v.x;
+    float b = v.y;
+    float c = v.z;
+
+    AffineTransform3 r;
+    r.a_[0] = 1.0f - 2.0f * b * b - 2.0f * c * c;
+    r.a_[4] = 2.0f * a * b - 2.0f * s * c;
+    r.a_[8] = 2.0f * a * c + 2.0f * s * b;
+    r.a_[1] = 2.0f * a * b + 2.0f * s * c;
+    r.a_[5] = 1.0f - 2.0f * a * a - 2.0f * c * c;
+    r.a_[9] = 2.0f * b * c - 2.0f * s * a;
+    r.a_[2] = 2.0f * a * c - 2.0f * s * b;
+    r.a_[6] = 2.0f * b * c + 2.0f * s * a;
+    r.a_[10] = 1.0f - 2.0f * a * a - 2.0f * b * b;
+    r.type_ = AffineType::RIGID;
+
+    // Right-multiply the current transform
+    *this *= r;
+}
+
+void AffineTransform3::rotate_x(float angle)
+{
+    AffineTransform3 r;
+    float            radians = degrees_to_radians(angle);
+    float            cosa = std::cos(radians);
+    float            sina = std::sin(radians);
+    r.a_[5] = cosa;
+    r.a_[9] = -sina;
+    r.a_[6] = sina;
+    r.a_[10] = cosa;
+    r.type_ = AffineType::RIGID;
+
+    // Right-multiply the current transform
+    *this *= r;
+}
+
+void AffineTransform3::rotate_y(float angle)
+{
+    AffineTransform3 r;
+    float            radians = degrees_to_radians(angle);
+    float            cosa = std::cos(radians);
+    float            sina = std::sin(radians);
+    r.a_[0] = cosa;
+    r.a_[8] = sina;
+    r.a_[2] = -sina;
+    r.a_[10] = cosa;
+    r.type_ = AffineType::RIGID;
+
+    // Right-multiply the current transform
+    *this *= r;
+}
+
+void AffineTransform3::rotate_z(float angle)
+{
+    AffineTransform3 r;
+    float            radians = degrees_to_radians(angle);
+    float            cosa = std::cos(radians);
+    float            sina = std::sin(radians);
+    r.a_[0] = cosa;
+    r.a_[4] = -sina;
+    r.a_[1] = sina;
+    r.a_[5] = cosa;
+    r.type_ = AffineType::RIGID;
+
+    // Right-multiply the current transform
+    *this *= r;
+}
+
+AffineTransform3 AffineTransform3::get_inverse() const
+{
+    AffineTransform3 inv;
+    if(type_ == AffineType::IDENTITY) return inv;
+
+    if(type_ == AffineType::RIGID || type_ == AffineType::UNIFORM_SCALE)
+    {
+        // Linear part is s R, so the inverse is R^T / s = L^T / s^2
+        if(scale_ == 0.0f)
+        {
+            logmsg("AffineTransform3: Singular matrix");
+            return inv;
+        }
+        float k = (type_ == AffineType::RIGID) ? 1.0f : 1.0f / (scale_ * scale_);
+        inv.a_[0] = a_[0] * k;
+        inv.a_[1] = a_[4] * k;
+        inv.a_[2] = a_[8] * k;
+        inv.a_[4] = a_[1] * k;
+        inv.a_[5] = a_[5] * k;
+        inv.a_[6] = a_[9] * k;
+        inv.a_[8] = a_[2] * k;
+        inv.a_[9] = a_[6] * k;
+        inv.a_[10] = a_[10] * k;
+        inv.scale_ = 1.0f / scale_;
+    }
+    else
+    {
+        // General 3x3 inverse using cofactors: inverse = adjugate / determinant
+        float c00 = a_[5] * a_[10] - a_[9] * a_[6];
+        float c01 = a_[9] * a_[2] - a_[1] * a_[10];
+        float c02 = a_[1] * a_[6] - a_[5] * a_[2];
+        float det = a_[0] * c00 + a_[4] * c01 + a_[8] * c02;
+        if(det == 0.0f)
+        {
+            logmsg("AffineTransform3: Singular matrix");
+            return inv;
+        }
+        float inv_det = 1.0f / det;
+        inv.a_[0] = c00 * inv_det;
+        inv.a_[4] = (a_[8] * a_[6] - a_[4] * a_[10]) * inv_det;
+        inv.a_[8] = (a_[4] * a_[9] - a_[8] * a_[5]) * inv_det;
+        inv.a_[1] = c01 * inv_det;
+        inv.a_[5] = (a_[0] * a_[10] - a_[8] * a_[2]) * inv_det;
+        inv.a_[9] = (a_[8] * a_[1] - a_[0] * a_[9]) * inv_det;
+        inv.a_[2] = c02 * inv_det;
+        inv.a_[6] = (a_[4] * a_[2] - a_[0] * a_[6]) * inv_det;
+        inv.a_[10] = (a_[0] * a_[5] - a_[4] * a_[1]) * inv_det;
+    }
+
+    // Inverse translation is -L^-1 t
+    inv.a_[12] = -(inv.a_[0] * a_[12] + inv.a_[4] * a_[13] + inv.a_[8] * a_[14]);
+    inv.a_[13] = -(inv.a_[1] * a_[12] + inv.a_[5] * a_[13] + inv.a_[9] * a_[14]);
+    inv.a_[14] = -(inv.a_[2] * a_[12] + inv.a_[6] * a_[13] + inv.a_[10] * a_[14]);
+    inv.type_ = type_;
+    return inv;
+}
+
+Matrix4x4 AffineTransform3::get_matrix() const
+{
+    // The elements are already a 4x4 matrix in column order
+    Matrix4x4 t;
+    t.a_ = a_;
+    return t;
+}
+
+Matrix4x4 AffineTransform3::get_normal_matrix() const
+{
+    // Transpose of the 4x4 inverse: the upper 3x3 is the transpose of the
+    // inverse linear part, L^-T, and the last row holds the inverse
+    // translation -L^-1 t. Row i of L^-1 is column i of L^-T, so element i
+    // of the last row is -(column i of L^-T) . t.
+    Matrix4x4 t;
+    if(type_ == AffineType::IDENTITY) return t;
+
+#if defined(CG_SIMD_SSE)
+    __m128 c0 = _mm_load_ps(&a_[0]);
+    __m128 c1 = _mm_load_ps(&a_[4]);
+    __m128 c2 = _mm_load_ps(&a_[8]);
+    __m128 n0, n1, n2;
+    float  k;
+    if(type_ == AffineType::GENERAL)
+    {
+        // Columns of L^-T are the cross products of the columns of L over
+        // the determinant
+        n0 = cross3(c1, c2);
+        n1 = cross3(c2, c0);
+        n2 = cross3(c0, c1);
+        alignas(16) float p[4];
+        _mm_store_ps(p, _mm_mul_ps(c0, n0));
+        float det = p[0] + p[1] + p[2];
+        if(det == 0.0f)
+        {
+            logmsg("AffineTransform3: Singular matrix");
+            return t;
+        }
+        k = 1.0f / det;
+    }
+    else
+    {
+        // L = s R, so L^-T = R / s = L / s^2
+        if(scale_ == 0.0f)
+        {
+            logmsg("AffineTransform3: Singular matrix");
+            return t;
+        }
+        n0 = c0;
+        n1 = c1;
+        n2 = c2;
+        k = (type_ == AffineType::RIGID) ? 1.0f : 1.0f / (scale_ * scale_);
+    }
+    __m128 kk = _mm_set1_ps(k);
+    n0 = _mm_mul_ps(n0, kk);
+    n1 = _mm_mul_ps(n1, kk);
+    n2 = _mm_mul_ps(n2, kk);
+
+    // Dot products with the translation: transpose the products so the
+    // sums are lane by lane (the w lanes of the columns are 0)
+    __m128 tr = _mm_load_ps(&a_[12]);
+    __m128 p0 = _mm_mul_ps(n0, tr);
+    __m128 p1 = _mm_mul_ps(n1, tr);
+    __m128 p2 = _mm_mul_ps(n2, tr);
+    __m128 p3 = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+    alignas(16) float d[4];
+    _mm_store_ps(d, _mm_add_ps(_mm_add_ps(p0, p1), p2));
+
+    _mm_store_ps(&t.a_[0], n0);
+    _mm_store_ps(&t.a_[4], n1);
+    _mm_store_ps(&t.a_[8], n2);
+    t.a_[3] = -d[0];
+    t.a_[7] = -d[1];
+    t.a_[11] = -d[2];
+#else
+    AffineTransform3 inv = get_inverse();
+    t.m00() = inv.a_[0];
+    t.m01() = inv.a_[1];
+    t.m02() = inv.a_[2];
+    t.m10() = inv.a_[4];
+    t.m11() = inv.a_[5];
+    t.m12() = inv.a_[6];
+    t.m20() = inv.a_[8];
+    t.m21() = inv.a_[9];
+    t.m22() = inv.a_[10];
+    t.m30() = inv.a_[12];
+    t.m31() = inv.a_[13];
+    t.m32() = inv.a_[14];
+#endif
+    return t;
+}
+
+void AffineTransform3::log(const char *str) const
+{
+    logmsg("  %s", str);
+    logmsg("%.3f %.3f %.3f %.3f", a_[0], a_[4], a_[8], a_[12]);
+    logmsg("%.3f %.3f %.3f %.3f", a_[1], a_[5], a_[9], a_[13]);
+    logmsg("%.3f %.3f %.3f %.3f", a_[2], a_[6], a_[10], a_[14]);
+}
+
+Matrix4x4 operator*(const Matrix4x4 &m, const AffineTransform3 &a)
+{
+    Matrix4x4 t;
+#if defined(CG_SIMD_SSE)
+    mul_affine(_mm_load_ps(&m.a_[0]),
+               _mm_load_ps(&m.a_[4]),
+               _mm_load_ps(&m.a_[8]),
+               _mm_load_ps(&m.a_[12]),
+               a.a_.data(),
+               t.a_.data());
+#else
+    mul_affine(m.a_.data(), a.a_.data(), t.a_.data());
+#endif
+    return t;
+}
+
+} // namespace cg
@@ -0,0 +1,227 @@
+//============================================================================
+//	Johns Hopkins University Engineering for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+
+//	Author:  David W. Nesbitt
+//	File:    affine_transform3.hpp
+//	Purpose: 3x4 affine transformation (implicit last row 0 0 0 1)
+//============================================================================
+
+#ifndef __GEOMETRY_AFFINE_TRANSFORM3_HPP__
+#define __GEOMETRY_AFFINE_TRANSFORM3_HPP__
+
+#include "bounding_sphere.hpp"
+#include "matrix.hpp"
+#include "point3.hpp"
+#include "vector3.hpp"
+
+#include <array>
+#include <cstdint>
+
+namespace cg
+{
+
+/**
+ * Classification of an affine transformation. Ordered so that the type of a
+ * composite transform is the larger of the types being composed.
+ */
+enum class AffineType : uint8_t
+{
+    IDENTITY,      // Identity
+    RIGID,         // Rotation and translation only
+    UNIFORM_SCALE, // Rotation, translation, and uniform scaling
+    GENERAL        // Any affine transformation
+};
+
+/**
+ * 3x4 affine transformation. Stored as a 16-byte aligned 4x4 matrix whose
+ * last row is always (0 0 0 1), so columns load straight into SIMD
+ * registers and the matrix copies out without rearranging. Composition and
+ * products with a Matrix4x4 skip the work the last row makes trivial.
+ * Tracks whether the transform is rigid or a uniform scaling so that
+ * inverses and normal matrices can skip the general 3x3 inverse. All matrix
+ * elements (row, col) are indexed base 0.
+ */
+class AffineTransform3
+{
+  public:
+    /**
+     * Constructor. Sets the transform to the identity.
+     */
+    AffineTransform3();
+
+    /**
+     * Constructor from a 4x4 matrix. The last row of the matrix is ignored
+     * (it is assumed to be 0 0 0 1). The transform is classified as general.
+     * @param  m  4x4 matrix.
+     */
+    explicit AffineTransform3(const Matrix4x4 &m);
+
+    /**
+     * Sets the transform to the identity.
+     */
+    void set_identity();
+
+    /**
+     * Equality operator. Compares elements only.
+     * @param  n  Transform to compare to.
+     * @return  Returns true if all elements are equal.
+     */
+    bool operator==(const AffineTransform3 &n) const;
+
+    /**
+     * Get the classification of this transform.
+     * @return  Returns the affine transform type.
+     */
+    AffineType get_type() const;
+
+    /**
+     * Gets a matrix element given by row,column.
+     * @param  row   Matrix row (0-2)
+     * @param  col   Matrix column (0-3)
+     * @return Returns the element at the specified row,col.
+     */
+    float m(uint32_t row, uint32_t col) const;
+
+    /**
+     * Affine composition. Returns this * n.
+     * @param   n   Transform to multiply the current transform by
+     * @return  Returns the composite transform.
+     */
+    AffineTransform3 operator*(const AffineTransform3 &n) const;
+
+    /**
+     * Affine composition. Sets this = this * n.
+     * @param   n   Transform to multiply the current transform by
+     * @return  Returns the address of the current transform.
+     */
+    AffineTransform3 &operator*=(const AffineTransform3 &n);
+
+    /**
+     * Transforms a point.
+     * @param   p  3D point to transform.
+     * @return  Returns the transformed point.
+     */
+    Point3 operator*(const Point3 &p) const;
+
+    /**
+     * Transforms a vector (direction). Translation is not applied.
+     * @param   v  3D vector to transform.
+     * @return  Returns the transformed vector.
+     */
+    Vector3 operator*(const Vector3 &v) const;
+
+    /**
+     * Transforms a bounding sphere. The radius is scaled by the largest
+     * scaling of any axis, so the result bounds the transformed sphere.
+     * @param   s  Sphere to transform.
+     * @return  Returns the transformed sphere.
+     */
+    BoundingSphere operator*(const BoundingSphere &s) const;
+
+    // The following methods right-multiply the current transform (similar to
+    // OpenGL and Matrix4x4)
+
+    /**
+     * Applies a translation.
+     * @param  x  x translation
+     * @param  y  y translation
+     * @param  z  z translation
+     */
+    void translate(float x, float y, float z);
+
+    /**
+     * Applies a scaling.
+     * @param  x  x scaling factor
+     * @param  y  y scaling factor
+     * @param  z  z scaling factor
+     */
+    void scale(float x, float y, float z);
+
+    /**
+     * Applies a rotation about an arbitrary axis.
+     * @param  angle  Angle in degrees
+     * @param  x      x coordinate of the axis
+     * @param  y      y coordinate of the axis
+     * @param  z      z coordinate of the axis
+     */
+    void rotate(float angle, float x, float y, float z);
+
+    /**
+     * Applies a rotation about the x axis.
+     * @param  angle  Angle in degrees
+     */
+    void rotate_x(float angle);
+
+    /**
+     * Applies a rotation about the y axis.
+     * @param  angle  Angle in degrees
+     */
+    void rotate_y(float angle);
+
+    /**
+     * Applies a rotation about the z axis.
+     * @param  angle  Angle in degrees
+     */
+    void rotate_z(float angle);
+
+    /**
+     * Calculates the inverse of this transform. Rigid and uniform scale
+     * transforms use the transpose of the rotation, general transforms use
+     * a 3x3 inverse. If the transform is singular the identity is returned.
+     * @return  Returns the inverse transform.
+     */
+    AffineTransform3 get_inverse() const;
+
+    /**
+     * Gets the 4x4 matrix for this transform (can be passed to GLSL mat4).
+     * @return  Returns the 4x4 matrix.
+     */
+    Matrix4x4 get_matrix() const;
+
+    /**
+     * Calculates the normal matrix (transpose of the inverse) as a 4x4
+     * matrix. The result is the same as get_matrix().get_inverse().transpose()
+     * but only costs a 3x3 inverse (or none for rigid transforms).
+     * @return  Returns the normal matrix.
+     */
+    Matrix4x4 get_normal_matrix() const;
+
+    /**
+     * Logs the transform.
+     * @param  s  String to log prior to the matrix elements.
+     */
+    void log(const char *s) const;
+
+    friend Matrix4x4 operator*(const Matrix4x4 &m, const AffineTransform3 &a);
+
+  protected:
+    /**
+     * Constructor for results that set every element. The elements are
+     * left uninitialized.
+     * @param  type   Classification of the result
+     * @param  scale  Uniform scale factor of the result
+     */
+    AffineTransform3(AffineType type, float scale);
+
+    // Elements stored in column order: a_[col * 4 + row]. Row 3 is 0 0 0 1.
+    alignas(16) std::array<float, 16> a_;
+
+    // Classification and uniform scale factor (1 unless UNIFORM_SCALE)
+    AffineType type_;
+    float      scale_;
+};
+
+/**
+ * Multiplies a 4x4 matrix by an affine transform (m * a). Used to form the
+ * composite projection, view, model matrix without a full 4x4 product.
+ * @param   m  4x4 matrix
+ * @param   a  Affine transform
+ * @return  Returns the 4x4 product.
+ */
+Matrix4x4 operator*(const Matrix4x4 &m, const AffineTransform3 &a);
+
+} // namespace cg
+
+#endif
@@ -0,0 +1,223 @@
+#include "geometry/bezier_patch.hpp"
+
+#include <algorithm>
+#include <future>
+#include <thread>
+
+namespace cg
+{
+
+BezierTessellator::BezierTessellator(uint32_t max_threads) :
+    max_threads_(max_threads), welder_(BEZIER_STITCH_EPSILON)
+{
+}
+
+template <typename F> void BezierTessellator::for_each_patch(size_t patch_count, F &&f) const
+{
+    // Patches are interleaved between threads; each writes its own range
+    uint32_t threads = (max_threads_ > 0) ? max_threads_ : std::thread::hardware_concurrency();
+    threads = static_cast<uint32_t>(std::min<size_t>(patch_count, std::max(1u, threads)));
+    if(positions_.size() < BEZIER_PARALLEL_MIN_VERTICES || threads < 2)
+    {
+        for(size_t p = 0; p < patch_count; p++) { f(p); }
+        return;
+    }
+    std::vector<std::future<void>> workers;
+    for(uint32_t i = 1; i < threads; i++)
+    {
+        workers.push_back(std::async(std::launch::async, [&f, i, threads, patch_count]() {
+            for(size_t p = i; p < patch_count; p += threads) { f(p); }
+        }));
+    }
+    for(size_t p = 0; p < patch_count; p += threads) { f(p); }
+    for(auto &w : workers) { w.get(); }
+}
+
+bool BezierTessellator::tessellate(const std::vector<BezierPatch> &patches,
+                                   BezierResolution                resolution)
+{
+    resolutions_.assign(patches.size(), resolution);
+    return tessellate(patches, resolutions_);
+}
+
+bool BezierTessellator::tessellate(const std::vector<BezierPatch>      &patches,
+                                   const std::vector<BezierResolution> &resolutions)
+{
+    // Count the grid vertices and face indexes. Each must be addressable with
+    // 32 bit indexes (a patch with 6 nu nv below 2^32 also keeps the sums
+    // below from overflowing).
+    uint64_t vertex_count = 0;
+    uint64_t index_count = 0;
+    for(size_t p = 0; p < patches.size(); p++)
+    {
+        uint64_t nu = std::max(resolutions[p].u_segments, 1u);
+        uint64_t nv = std::max(resolutions[p].v_segments, 1u);
+        if(nu * nv > UINT32_MAX / 6)
+        {
+            index_count = static_cast<uint64_t>(UINT32_MAX) + 1;
+            break;
+        }
+        vertex_count += (nu + 1) * (nv + 1);
+        index_count += 6 * nu * nv;
+    }
+    if(vertex_count > UINT32_MAX || index_count > UINT32_MAX)
+    {
+        vertices_.clear();
+        faces_.clear();
+        return false;
+    }
+
+    // Lay out the grids of the patches one after another
+    ranges_.resize(patches.size());
+    uint32_t first_vertex = 0;
+    uint32_t first_face = 0;
+    for(size_t p = 0; p < patches.size(); p++)
+    {
+        uint32_t nu = std::max(resolutions[p].u_segments, 1u);
+        uint32_t nv = std::max(resolutions[p].v_segments, 1u);
+        ranges_[p] = {first_vertex, first_face, get_basis(nu), get_basis(nv)};
+        first_vertex += (nu + 1) * (nv + 1);
+        first_face += 6 * nu * nv;
+    }
+    positions_.resize(vertex_count);
+    grid_faces_.resize(index_count);
+
+    for_each_patch(patches.size(),
+                   [&](size_t p) { evaluate(patches[p], resolutions[p], ranges_[p]); });
+    stitch(resolutions);
+
+    // Point the faces at the stitched vertices
+    for_each_patch(patches.size(),
+                   [&](size_t p)
+                   {
+                       size_t last = (p + 1 < ranges_.size()) ? ranges_[p + 1].first_face
+                                                              : grid_faces_.size();
+                       for(size_t i = ranges_[p].first_face; i < last; i++)
+                       {
+                           grid_faces_[i] = remap_[grid_faces_[i]];
+                       }
+                   });
+
+    // Remove the triangles that collapsed
+    faces_.resize(grid_faces_.size());
+    size_t out = 0;
+    for(size_t f = 0; f < grid_faces_.size(); f += 3)
+    {
+        uint32_t a = grid_faces_[f], b = grid_faces_[f + 1], c = grid_faces_[f + 2];
+        if(a == b || b == c || c == a) { continue; }
+        faces_[out++] = a;
+        faces_[out++] = b;
+        faces_[out++] = c;
+    }
+    faces_.resize(out);
+    return true;
+}
+
+const std::vector<VertexAndNormal> &BezierTessellator::get_vertices() const { return vertices_; }
+
+const std::vector<uint32_t> &BezierTessellator::get_faces() const { return faces_; }
+
+uint32_t BezierTessellator::get_basis(uint32_t segments)
+{
+    if(segments >= basis_offsets_.size()) { basis_offsets_.resize(segments + 1, UINT32_MAX); }
+    if(basis_offsets_[segments] != UINT32_MAX) { return basis_offsets_[segments]; }
+
+    // The weights of sample k and segments - k are mirror images computed
+    // the same way, so patches that meet with opposite directions along an
+    // edge get the same boundary points (up to the order of the sum)
+    uint32_t offset = static_cast<uint32_t>(basis_.size());
+    for(uint32_t k = 0; k <= segments; k++)
+    {
+        float t = static_cast<float>(k) / segments;
+        float s = static_cast<float>(segments - k) / segments;
+        basis_.push_back({s * s * s, 3.0f * (s * s) * t, 3.0f * (t * t) * s, t * t * t});
+    }
+    basis_offsets_[segments] = offset;
+    return offset;
+}
+
+void BezierTessellator::evaluate(const BezierPatch &patch,
+                                 BezierResolution   resolution,
+                                 const PatchRange  &range)
+{
+    uint32_t                    nu = std::max(resolution.u_segments, 1u);
+    uint32_t                    nv = std::max(resolution.v_segments, 1u);
+    uint32_t                    rows = nv + 1;
+    const std::array<float, 4> *bu = &basis_[range.basis_u];
+    const std::array<float, 4> *bv = &basis_[range.basis_v];
+    Point3                     *out = &positions_[range.first_vertex];
+
+    for(uint32_t a = 0; a <= nu; a++)
+    {
+        // Control points of the curve along v at this u
+        Point3 q[4];
+        for(uint32_t j = 0; j < 4; j++)
+        {
+            const auto &w = bu[a];
+            q[j].set(w[0] * patch.points[0][j].x + w[1] * patch.points[1][j].x +
+                         w[2] * patch.points[2][j].x + w[3] * patch.points[3][j].x,
+                     w[0] * patch.points[0][j].y + w[1] * patch.points[1][j].y +
+                         w[2] * patch.points[2][j].y + w[3] * patch.points[3][j].y,
+                     w[0] * patch.points[0][j].z + w[1] * patch.points[1][j].z +
+                         w[2] * patch.points[2][j].z + w[3] * patch.points[3][j].z);
+        }
+        for(uint32_t b = 0; b < rows; b++)
+        {
+            const auto &w = bv[b];
+            out[a * rows + b].set(w[0] * q[0].x + w[1] * q[1].x + w[2] * q[2].x + w[3] * q[3].x,
+                                  w[0] * q[0].y + w[1] * q[1].y + w[2] * q[2].y + w[3] * q[3].y,
+                                  w[0] * q[0].z + w[1] * q[1].z + w[2] * q[2].z + w[3] * q[3].z);
+        }
+    }
+
+    // Two triangles per grid cell, counter-clockwise
+    uint32_t *faces = &grid_faces_[range.first_face];
+    for(uint32_t a = 0; a < nu; a++)
+    {
+        for(uint32_t b = 0; b < nv; b++)
+        {
+            uint32_t i00 = range.first_vertex + a * rows + b;
+            uint32_t i10 = i00 + rows;
+            faces[0] = i00;
+            faces[1] = i10 + 1;
+            faces[2] = i10;
+            faces[3] = i00;
+            faces[4] = i00 + 1;
+            faces[5] = i10 + 1;
+            faces += 6;
+        }
+    }
+}
+
+void BezierTessellator::stitch(const std::vector<BezierResolution> &resolutions)
+{
+    // Interior vertices are never shared. Boundary vertices are hashed and
+    // take the index of the first boundary vertex at their position.
+    welder_.clear();
+    remap_.resize(positions_.size());
+    vertices_.resize(positions_.size());
+    uint32_t count = 0;
+    for(size_t p = 0; p < ranges_.size(); p++)
+    {
+        uint32_t nu = std::max(resolutions[p].u_segments, 1u);
+        uint32_t nv = std::max(resolutions[p].v_segments, 1u);
+        uint32_t v = ranges_[p].first_vertex;
+        for(uint32_t a = 0; a <= nu; a++)
+        {
+            for(uint32_t b = 0; b <= nv; b++, v++)
+            {
+                const Point3 &position = positions_[v];
+                if(a == 0 || a == nu || b == 0 || b == nv)
+                {
+                    remap_[v] = welder_.weld(position, count);
+                    if(remap_[v] != count) { continue; }
+                }
+                else { remap_[v] = count; }
+                vertices_[count++] = VertexAndNormal(position);
+            }
+        }
+    }
+    vertices_.resize(count);
+}
+
+} // namespace cg
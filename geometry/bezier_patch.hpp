@@ -0,0 +1,158 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:  David W. Nesbitt
+//	File:    bezier_patch.hpp
+//	Purpose: Bicubic Bezier patches and a tessellator that evaluates them
+//           into a shared, stitched triangle mesh.
+//============================================================================
+
+#ifndef __GEOMETRY_BEZIER_PATCH_HPP__
+#define __GEOMETRY_BEZIER_PATCH_HPP__
+
+#include "geometry/point3.hpp"
+#include "geometry/types.hpp"
+#include "geometry/vertex_welder.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace cg
+{
+
+// Distance (per axis) within which patch boundary vertices are stitched
+constexpr float BEZIER_STITCH_EPSILON = 1.0e-5f;
+
+// Tessellations with fewer vertices are not split between threads
+constexpr uint32_t BEZIER_PARALLEL_MIN_VERTICES = 16384;
+
+/**
+ * Bicubic Bezier patch. points[i][j] is the control point in column i
+ * (along u) and row j (along v).
+ */
+struct BezierPatch
+{
+    Point3 points[4][4];
+};
+
+/**
+ * Number of segments a patch is divided into along u and v (any count of
+ * at least 1, not only powers of 2).
+ */
+struct BezierResolution
+{
+    uint32_t u_segments;
+    uint32_t v_segments;
+};
+
+/**
+ * Tessellates bicubic Bezier patches into one vertex and face list.
+ *
+ * Each patch is evaluated on a uniform grid with tables of the cubic
+ * Bernstein basis, one per segment count, into its own range of the
+ * output, so patches are evaluated in parallel with no locking. Vertices
+ * on patch boundaries are then stitched: those within
+ * BEZIER_STITCH_EPSILON of a boundary vertex of an earlier patch are
+ * replaced by it and triangles that collapse (at the poles of degenerate
+ * patches) are removed. Neighboring patches must use the same number of
+ * segments along a shared edge for the mesh to be watertight.
+ *
+ * Buffers are kept between calls, so tessellating again at the same or a
+ * lower resolution does not allocate. Normals are left at 0 for the
+ * caller to compute.
+ */
+class BezierTessellator
+{
+  public:
+    /**
+     * Constructor.
+     * @param  max_threads  Largest number of threads to use (0 for the
+     *                      number of hardware threads)
+     */
+    explicit BezierTessellator(uint32_t max_threads = 0);
+
+    /**
+     * Tessellate patches with the same resolution.
+     * @param  patches     Patches
+     * @param  resolution  Segments along u and v of every patch
+     * @return  Returns false (and no vertices or faces) if the mesh would
+     *          need more than 32 bit indexes.
+     */
+    bool tessellate(const std::vector<BezierPatch> &patches, BezierResolution resolution);
+
+    /**
+     * Tessellate patches, each with its own resolution.
+     * @param  patches      Patches
+     * @param  resolutions  Segments along u and v of each patch
+     * @return  Returns false (and no vertices or faces) if the mesh would
+     *          need more than 32 bit indexes.
+     */
+    bool tessellate(const std::vector<BezierPatch>      &patches,
+                    const std::vector<BezierResolution> &resolutions);
+
+    /**
+     * Get the stitched vertex list of the last tessellation.
+     * @return  Returns the vertices (normals are 0).
+     */
+    const std::vector<VertexAndNormal> &get_vertices() const;
+
+    /**
+     * Get the triangle list of the last tessellation. Each grid cell
+     * (i, j) becomes triangles (i, j) (i + 1, j + 1) (i + 1, j) and
+     * (i, j) (i, j + 1) (i + 1, j + 1).
+     * @return  Returns 3 indexes per face.
+     */
+    const std::vector<uint32_t> &get_faces() const;
+
+  protected:
+    // Grid of a patch in the unstitched output
+    struct PatchRange
+    {
+        uint32_t first_vertex;
+        uint32_t first_face; // Index of the first face index
+        uint32_t basis_u;    // Offsets of the basis tables in basis_
+        uint32_t basis_v;
+    };
+
+    uint32_t                          max_threads_;
+    std::vector<BezierResolution>     resolutions_;   // Of the uniform tessellate call
+    std::vector<std::array<float, 4>> basis_;         // Bernstein weights per sample
+    std::vector<uint32_t>             basis_offsets_; // Table of each segment count
+    std::vector<PatchRange>           ranges_;
+    std::vector<Point3>               positions_;  // Unstitched grid vertices
+    std::vector<uint32_t>             grid_faces_; // Faces of the unstitched grids
+    std::vector<uint32_t>             remap_;      // Stitched index of each grid vertex
+    VertexWelder                      welder_;     // Boundary vertices
+    std::vector<VertexAndNormal>      vertices_;
+    std::vector<uint32_t>             faces_;
+
+    /**
+     * Get the offset of the basis table for a segment count, building it
+     * if it does not exist.
+     */
+    uint32_t get_basis(uint32_t segments);
+
+    /**
+     * Evaluate the grid of a patch into positions_ and grid_faces_.
+     */
+    void evaluate(const BezierPatch &patch, BezierResolution resolution, const PatchRange &range);
+
+    /**
+     * Replace boundary vertices that match a boundary vertex of an earlier
+     * patch, building remap_ and the stitched vertex list.
+     */
+    void stitch(const std::vector<BezierResolution> &resolutions);
+
+    /**
+     * Call a function for each patch index, splitting them between threads.
+     */
+    template <typename F> void for_each_patch(size_t patch_count, F &&f) const;
+};
+
+} // namespace cg
+
+#endif
@@ -2,23 +2,86 @@
 
 #include "geometry/geometry.hpp"
 
+#include <cmath>
+
 namespace cg
 {
 
 BoundingSphere::BoundingSphere() : center{0.0f, 0.0f, 0.0f}, radius(1.0f) {}
 
-BoundingSphere::BoundingSphere(const BoundingSphere &s) : center(s.center), radius(s.radius) {}
-
 BoundingSphere::BoundingSphere(const Point3 &c, float r) : center(c), radius(r) {}
 
-BoundingSphere::BoundingSphere(std::vector<Point3> &vertex_list)
+BoundingSphere::BoundingSphere(const std::vector<Point3> &vertex_list)
+    : center{0.0f, 0.0f, 0.0f}, radius(0.0f)
 {
-    // Complete in 605.767
+    if(vertex_list.empty()) { return; }
+
+    // Find the points with minimum and maximum x, y, and z
+    const Point3 *min_x = &vertex_list[0], *max_x = min_x;
+    const Point3 *min_y = min_x, *max_y = min_x;
+    const Point3 *min_z = min_x, *max_z = min_x;
+    for(const auto &p : vertex_list)
+    {
+        if(p.x < min_x->x) min_x = &p;
+        if(p.x > max_x->x) max_x = &p;
+        if(p.y < min_y->y) min_y = &p;
+        if(p.y > max_y->y) max_y = &p;
+        if(p.z < min_z->z) min_z = &p;
+        if(p.z > max_z->z) max_z = &p;
+    }
+
+    // Initial sphere uses the pair that is furthest apart as its diameter
+    float dx = (*max_x - *min_x).norm_squared();
+    float dy = (*max_y - *min_y).norm_squared();
+    float dz = (*max_z - *min_z).norm_squared();
+    const Point3 *p0 = min_x, *p1 = max_x;
+    if(dy > dx && dy > dz)
+    {
+        p0 = min_y;
+        p1 = max_y;
+    }
+    else if(dz > dx && dz > dy)
+    {
+        p0 = min_z;
+        p1 = max_z;
+    }
+    center = *p0 + (*p1 - *p0) * 0.5f;
+    radius = (*p1 - center).norm();
+
+    // Grow the sphere to contain each point outside it. The new sphere
+    // touches the far side of the old sphere and the point.
+    for(const auto &p : vertex_list)
+    {
+        Vector3 v = p - center;
+        float   d2 = v.norm_squared();
+        if(d2 > radius * radius)
+        {
+            float d = std::sqrt(d2);
+            float new_radius = 0.5f * (radius + d);
+            center = center + v * ((new_radius - radius) / d);
+            radius = new_radius;
+        }
+    }
 }
 
 BoundingSphere &BoundingSphere::merge_with(const BoundingSphere &s2)
 {
-    // Complete in 605.767
+    Vector3 v = s2.center - center;
+    float   d = v.norm();
+
+    // One sphere contains the other
+    if(d + s2.radius <= radius) { return *this; }
+    if(d + radius <= s2.radius)
+    {
+        *this = s2;
+        return *this;
+    }
+
+    // The merged sphere spans from the far side of this sphere to the far
+    // side of s2 along the line between the centers
+    float new_radius = 0.5f * (d + radius + s2.radius);
+    center = center + v * ((new_radius - radius) / d);
+    radius = new_radius;
     return *this;
 }
 
@@ -36,7 +36,13 @@ struct BoundingSphere
      * Copy constructor
      * @param   s   Sphere to copy.
      */
-    BoundingSphere(const BoundingSphere &s);
+    BoundingSphere(const BoundingSphere &s) = default;
+
+    /**
+     * Assignment operator
+     * @param   s   Sphere to copy.
+     */
+    BoundingSphere &operator=(const BoundingSphere &s) = default;
 
     /**
      * Constructor given a center point and radius.
@@ -46,16 +52,20 @@ struct BoundingSphere
     BoundingSphere(const Point3 &c, float r);
 
     /**
-     * Construct a sphere given a vertex list. Method by Ritter.
+     * Construct a sphere given a vertex list. Method by Ritter: start with
+     * the sphere through the most separated pair of the axis extreme points,
+     * then grow it to contain any point that lies outside. Not the minimal
+     * sphere, but within a few percent of it. An empty list gives a sphere
+     * of radius 0 at the origin.
      * @param  vertex_list  Vertex list to surround with the sphere.
      */
-    BoundingSphere(std::vector<Point3> &vertex_list);
+    BoundingSphere(const std::vector<Point3> &vertex_list);
 
     /**
      * Merge this bounding sphere with another to create the smallest sphere
      * containing the 2.
      * @param  s2  Sphere to merge with this sphere.
-     * @return Reference to this ovbect sphere which combines this with s2
+     * @return Reference to this object sphere which combines this with s2
      */
     BoundingSphere &merge_with(const BoundingSphere &s2);
 
@@ -0,0 +1,40 @@
+#include "geometry/frustum.hpp"
+
+#include "geometry/geometry.hpp"
+
+namespace cg
+{
+
+Frustum::Frustum() {}
+
+void Frustum::set(const Matrix4x4 &pv)
+{
+    // Row r of the matrix dotted with (x,y,z,1) gives clip coordinate r. A
+    // point is inside if w + x >= 0, w - x >= 0, etc. Plane stores the
+    // constant term on the other side of the equation (ax + by + cz = d).
+    const float r[4][4] = {{pv.m00(), pv.m01(), pv.m02(), pv.m03()},
+                           {pv.m10(), pv.m11(), pv.m12(), pv.m13()},
+                           {pv.m20(), pv.m21(), pv.m22(), pv.m23()},
+                           {pv.m30(), pv.m31(), pv.m32(), pv.m33()}};
+    for(uint32_t i = 0; i < FRUSTUM_PLANE_COUNT; i++)
+    {
+        const float *row = r[i / 2];
+        float        sign = (i % 2 == 0) ? 1.0f : -1.0f;
+        planes[i].a = r[3][0] + sign * row[0];
+        planes[i].b = r[3][1] + sign * row[1];
+        planes[i].c = r[3][2] + sign * row[2];
+        planes[i].d = -(r[3][3] + sign * row[3]);
+        planes[i].normalize();
+    }
+}
+
+bool Frustum::is_outside(const BoundingSphere &sphere) const
+{
+    for(const auto &p : planes)
+    {
+        if(p.solve(sphere.center) < -sphere.radius) { return true; }
+    }
+    return false;
+}
+
+} // namespace cg
@@ -0,0 +1,69 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:  David W. Nesbitt
+//	File:    frustum.hpp
+//	Purpose: View frustum (6 planes) for culling bounding volumes.
+//============================================================================
+
+#ifndef __GEOMETRY_FRUSTUM_HPP__
+#define __GEOMETRY_FRUSTUM_HPP__
+
+#include "geometry/bounding_sphere.hpp"
+#include "geometry/matrix.hpp"
+#include "geometry/plane.hpp"
+
+#include <cstdint>
+
+namespace cg
+{
+
+enum FrustumPlane
+{
+    FRUSTUM_LEFT,
+    FRUSTUM_RIGHT,
+    FRUSTUM_BOTTOM,
+    FRUSTUM_TOP,
+    FRUSTUM_NEAR,
+    FRUSTUM_FAR,
+    FRUSTUM_PLANE_COUNT
+};
+
+/**
+ * View frustum. Stores the 6 bounding planes in world coordinates with unit
+ * normals pointing into the frustum, so Plane::solve gives the signed
+ * distance of a point (positive inside).
+ */
+struct Frustum
+{
+    Plane planes[FRUSTUM_PLANE_COUNT];
+
+    /**
+     * Default constructor. The planes are all zero so nothing is outside
+     * the frustum until set is called.
+     */
+    Frustum();
+
+    /**
+     * Extract the planes from a composite projection and view matrix (Gribb
+     * and Hartmann). Each plane is the 4th row of the matrix plus or minus
+     * one of the other rows, which is the clip space test -w <= x,y,z <= w
+     * written in world coordinates.
+     * @param  pv  Composite projection and view matrix.
+     */
+    void set(const Matrix4x4 &pv);
+
+    /**
+     * Test whether a sphere lies entirely outside the frustum. Conservative:
+     * a sphere near a corner of the frustum may be reported as not outside.
+     * @param  sphere  Bounding sphere in world coordinates.
+     * @return Returns true if the sphere is outside any of the planes.
+     */
+    bool is_outside(const BoundingSphere &sphere) const;
+};
+
+} // namespace cg
+
+#endif
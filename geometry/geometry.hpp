@@ -73,9 +73,22 @@ float fast_inv_sqrt(float x);
 #include "geometry/aabb.hpp"
 #include "geometry/bounding_sphere.hpp"
 #include "geometry/ray3.hpp"
+#include "geometry/triangle_batch.hpp"
+#include "geometry/ray3_packet.hpp"
 #include "geometry/noise.hpp"
 #include "geometry/matrix.hpp"
+#include "geometry/affine_transform3.hpp"
+#include "geometry/frustum.hpp"
+#include "geometry/occlusion_buffer.hpp"
+#include "geometry/radix_sort.hpp"
 #include "geometry/types.hpp"
+#include "geometry/vertex_cache.hpp"
+#include "geometry/vertex_packing.hpp"
+#include "geometry/vertex_stream.hpp"
+#include "geometry/vertex_welder.hpp"
+#include "geometry/bezier_patch.hpp"
+#include "geometry/index_list.hpp"
+#include "geometry/mesh_bvh.hpp"
 // clang-format on
 
 #endif
@@ -0,0 +1,78 @@
+#include "geometry/index_list.hpp"
+
+#include <algorithm>
+
+namespace cg
+{
+
+IndexList::IndexList() : wide_(false) {}
+
+void IndexList::clear()
+{
+    narrow_indexes_.clear();
+    wide_indexes_.clear();
+    wide_ = false;
+}
+
+void IndexList::reserve(size_t count)
+{
+    if(wide_) wide_indexes_.reserve(count);
+    else narrow_indexes_.reserve(count);
+}
+
+void IndexList::push_back(uint32_t index)
+{
+    if(!wide_ && index > MAX_NARROW_INDEX) { widen(); }
+    if(wide_) wide_indexes_.push_back(index);
+    else narrow_indexes_.push_back(static_cast<uint16_t>(index));
+}
+
+void IndexList::assign(const std::vector<uint16_t> &indexes)
+{
+    clear();
+    narrow_indexes_ = indexes;
+}
+
+void IndexList::assign(const std::vector<uint32_t> &indexes)
+{
+    clear();
+    if(!indexes.empty() && *std::max_element(indexes.begin(), indexes.end()) > MAX_NARROW_INDEX)
+    {
+        wide_indexes_ = indexes;
+        wide_ = true;
+    }
+    else narrow_indexes_.assign(indexes.begin(), indexes.end());
+}
+
+size_t IndexList::size() const { return wide_ ? wide_indexes_.size() : narrow_indexes_.size(); }
+
+bool IndexList::empty() const { return size() == 0; }
+
+uint32_t IndexList::operator[](size_t i) const
+{
+    return wide_ ? wide_indexes_[i] : narrow_indexes_[i];
+}
+
+bool IndexList::is_wide() const { return wide_; }
+
+size_t IndexList::index_size() const { return wide_ ? sizeof(uint32_t) : sizeof(uint16_t); }
+
+const void *IndexList::data() const
+{
+    return wide_ ? static_cast<const void *>(wide_indexes_.data())
+                 : static_cast<const void *>(narrow_indexes_.data());
+}
+
+const std::vector<uint16_t> &IndexList::narrow() const { return narrow_indexes_; }
+
+const std::vector<uint32_t> &IndexList::wide() const { return wide_indexes_; }
+
+void IndexList::widen()
+{
+    wide_indexes_.assign(narrow_indexes_.begin(), narrow_indexes_.end());
+    narrow_indexes_.clear();
+    narrow_indexes_.shrink_to_fit();
+    wide_ = true;
+}
+
+} // namespace cg
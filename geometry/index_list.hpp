@@ -0,0 +1,144 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:  David W. Nesbitt
+//	File:    index_list.hpp
+//	Purpose: Triangle index list that uses 16 bit indexes while they fit
+//           and widens to 32 bit indexes when they do not.
+//============================================================================
+
+#ifndef __GEOMETRY_INDEX_LIST_HPP__
+#define __GEOMETRY_INDEX_LIST_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace cg
+{
+
+/**
+ * Index list with automatic index width. Indexes are stored as uint16_t
+ * until one larger than MAX_NARROW_INDEX is added; the list is then
+ * converted to uint32_t, so meshes pay for 32 bit indexes only when they
+ * need them. The indexes of the current width are available as a vector
+ * (narrow() or wide()) or through visit(), which calls a function with
+ * whichever vector is in use so templated code (BVH build, vertex stream
+ * kernels) runs directly on the stored indexes.
+ */
+class IndexList
+{
+  public:
+    static constexpr uint32_t MAX_NARROW_INDEX = 0xFFFF;
+
+    /**
+     * Constructor. Creates an empty 16 bit list.
+     */
+    IndexList();
+
+    /**
+     * Remove all indexes and go back to 16 bit indexes.
+     */
+    void clear();
+
+    /**
+     * Reserve space for indexes of the current width.
+     * @param  count  Number of indexes
+     */
+    void reserve(size_t count);
+
+    /**
+     * Add an index, widening the list if the index does not fit in 16 bits.
+     * @param  index  Index to add
+     */
+    void push_back(uint32_t index);
+
+    /**
+     * Replace the list with 16 bit indexes.
+     * @param  indexes  Indexes
+     */
+    void assign(const std::vector<uint16_t> &indexes);
+
+    /**
+     * Replace the list with 32 bit indexes. They are stored as 16 bit
+     * indexes if all of them fit.
+     * @param  indexes  Indexes
+     */
+    void assign(const std::vector<uint32_t> &indexes);
+
+    /**
+     * Get the number of indexes.
+     * @return  Returns the number of indexes.
+     */
+    size_t size() const;
+
+    /**
+     * Check whether the list is empty.
+     * @return  Returns true if there are no indexes.
+     */
+    bool empty() const;
+
+    /**
+     * Get an index.
+     * @param  i  Position in the list
+     * @return  Returns the index at position i.
+     */
+    uint32_t operator[](size_t i) const;
+
+    /**
+     * Check whether 32 bit indexes are used.
+     * @return  Returns true if the list holds 32 bit indexes.
+     */
+    bool is_wide() const;
+
+    /**
+     * Get the size of one index.
+     * @return  Returns 2 or 4 (bytes).
+     */
+    size_t index_size() const;
+
+    /**
+     * Get the stored indexes.
+     * @return  Returns a pointer to the first index (of index_size() bytes).
+     */
+    const void *data() const;
+
+    /**
+     * Get the 16 bit indexes (empty if the list is wide).
+     * @return  Returns the 16 bit index vector.
+     */
+    const std::vector<uint16_t> &narrow() const;
+
+    /**
+     * Get the 32 bit indexes (empty unless the list is wide).
+     * @return  Returns the 32 bit index vector.
+     */
+    const std::vector<uint32_t> &wide() const;
+
+    /**
+     * Call a function with the index vector in use.
+     * @param  f  Function taking a const std::vector<uint16_t> & or a
+     *            const std::vector<uint32_t> &
+     */
+    template <typename F> void visit(F &&f) const
+    {
+        if(wide_) f(wide_indexes_);
+        else f(narrow_indexes_);
+    }
+
+  protected:
+    std::vector<uint16_t> narrow_indexes_;
+    std::vector<uint32_t> wide_indexes_;
+    bool                  wide_;
+
+    /**
+     * Convert the 16 bit indexes to 32 bit indexes.
+     */
+    void widen();
+};
+
+} // namespace cg
+
+#endif
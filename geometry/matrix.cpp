@@ -1,6 +1,7 @@
 #include "geometry/matrix.hpp"
 
 #include "geometry/geometry.hpp"
+#include "geometry/simd.hpp"
 
 #include <cmath>
 
@@ -10,6 +11,42 @@ namespace cg
 // Forward declare logging function
 void logmsg(const char *message, ...);
 
+#if defined(CG_SIMD_SSE)
+namespace
+{
+
+// Shuffle helpers. Lane x of the result comes from lane x of the first
+// source, etc. (the reverse argument order of _MM_SHUFFLE).
+#define CG_SHUFFLE_MASK(x, y, z, w) ((x) | ((y) << 2) | ((z) << 4) | ((w) << 6))
+#define CG_SWIZZLE(v, x, y, z, w) _mm_shuffle_ps((v), (v), CG_SHUFFLE_MASK(x, y, z, w))
+#define CG_SHUFFLE(v1, v2, x, y, z, w) _mm_shuffle_ps((v1), (v2), CG_SHUFFLE_MASK(x, y, z, w))
+
+// 2x2 matrices are stored in one register in row order: (m00 m01 m10 m11)
+
+// 2x2 matrix multiply a * b
+inline __m128 mat2_mul(__m128 a, __m128 b)
+{
+    return _mm_add_ps(_mm_mul_ps(a, CG_SWIZZLE(b, 0, 3, 0, 3)),
+                      _mm_mul_ps(CG_SWIZZLE(a, 1, 0, 3, 2), CG_SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+// 2x2 matrix adjugate multiply adj(a) * b
+inline __m128 mat2_adj_mul(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(CG_SWIZZLE(a, 3, 3, 0, 0), b),
+                      _mm_mul_ps(CG_SWIZZLE(a, 1, 1, 2, 2), CG_SWIZZLE(b, 2, 3, 0, 1)));
+}
+
+// 2x2 matrix multiply adjugate a * adj(b)
+inline __m128 mat2_mul_adj(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(a, CG_SWIZZLE(b, 3, 0, 3, 0)),
+                      _mm_mul_ps(CG_SWIZZLE(a, 1, 0, 3, 2), CG_SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+} // namespace
+#endif
+
 Matrix4x4::Matrix4x4() { set_identity(); }
 
 void Matrix4x4::set_identity()
@@ -32,44 +69,11 @@ void Matrix4x4::set_identity()
     a_[15] = 1.0f;
 }
 
-Matrix4x4::Matrix4x4(const Matrix4x4 &n)
-{
-    m00() = n.m00();
-    m01() = n.m01();
-    m02() = n.m02();
-    m03() = n.m03();
-    m10() = n.m10();
-    m11() = n.m11();
-    m12() = n.m12();
-    m13() = n.m13();
-    m20() = n.m20();
-    m21() = n.m21();
-    m22() = n.m22();
-    m23() = n.m23();
-    m30() = n.m30();
-    m31() = n.m31();
-    m32() = n.m32();
-    m33() = n.m33();
-}
+Matrix4x4::Matrix4x4(const Matrix4x4 &n) : a_(n.a_) {}
 
 Matrix4x4 &Matrix4x4::operator=(const Matrix4x4 &n)
 {
-    m00() = n.m00();
-    m01() = n.m01();
-    m02() = n.m02();
-    m03() = n.m03();
-    m10() = n.m10();
-    m11() = n.m11();
-    m12() = n.m12();
-    m13() = n.m13();
-    m20() = n.m20();
-    m21() = n.m21();
-    m22() = n.m22();
-    m23() = n.m23();
-    m30() = n.m30();
-    m31() = n.m31();
-    m32() = n.m32();
-    m33() = n.m33();
+    a_ = n.a_;
     return *this;
 }
 
@@ -136,12 +140,28 @@ float &Matrix4x4::m(uint32_t row, uint32_t col)
 
 Matrix4x4 Matrix4x4::operator*(const Matrix4x4 &n) const
 {
-    // Unroll the loop, do 1 row at a time.
     Matrix4x4 t;
-    float     a0 = m00();
-    float     a1 = m01();
-    float     a2 = m02();
-    float     a3 = m03();
+#if defined(CG_SIMD_SSE)
+    // Each column of the product is a linear combination of the columns of
+    // this matrix, weighted by the elements of the matching column of n
+    __m128 c0 = _mm_load_ps(&a_[0]);
+    __m128 c1 = _mm_load_ps(&a_[4]);
+    __m128 c2 = _mm_load_ps(&a_[8]);
+    __m128 c3 = _mm_load_ps(&a_[12]);
+    for(uint32_t j = 0; j < 16; j += 4)
+    {
+        __m128 r = _mm_mul_ps(c0, _mm_set1_ps(n.a_[j]));
+        r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_set1_ps(n.a_[j + 1])));
+        r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(n.a_[j + 2])));
+        r = _mm_add_ps(r, _mm_mul_ps(c3, _mm_set1_ps(n.a_[j + 3])));
+        _mm_store_ps(&t.a_[j], r);
+    }
+#else
+    // Unroll the loop, do 1 row at a time.
+    float a0 = m00();
+    float a1 = m01();
+    float a2 = m02();
+    float a3 = m03();
     t.m00() = a0 * n.m00() + a1 * n.m10() + a2 * n.m20() + a3 * n.m30();
     t.m01() = a0 * n.m01() + a1 * n.m11() + a2 * n.m21() + a3 * n.m31();
     t.m02() = a0 * n.m02() + a1 * n.m12() + a2 * n.m22() + a3 * n.m32();
@@ -170,6 +190,7 @@ Matrix4x4 Matrix4x4::operator*(const Matrix4x4 &n) const
     t.m31() = a0 * n.m01() + a1 * n.m11() + a2 * n.m21() + a3 * n.m31();
     t.m32() = a0 * n.m02() + a1 * n.m12() + a2 * n.m22() + a3 * n.m32();
     t.m33() = a0 * n.m03() + a1 * n.m13() + a2 * n.m23() + a3 * n.m33();
+#endif
     return t;
 }
 
@@ -208,6 +229,108 @@ Vector3 Matrix4x4::operator*(const Vector3 &v) const
                    (a_[2] * v.x + a_[6] * v.y + a_[10] * v.z));
 }
 
+void Matrix4x4::transform_points(const Point3 *in, HPoint3 *out, size_t n) const
+{
+#if defined(CG_SIMD_AVX)
+    // Two points per iteration: each 256-bit register holds a column twice
+    __m256 c0 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(&a_[0]));
+    __m256 c1 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(&a_[4]));
+    __m256 c2 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(&a_[8]));
+    __m256 c3 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(&a_[12]));
+    size_t i = 0;
+    for(; i + 2 <= n; i += 2)
+    {
+        __m256 x = _mm256_setr_m128(_mm_set1_ps(in[i].x), _mm_set1_ps(in[i + 1].x));
+        __m256 y = _mm256_setr_m128(_mm_set1_ps(in[i].y), _mm_set1_ps(in[i + 1].y));
+        __m256 z = _mm256_setr_m128(_mm_set1_ps(in[i].z), _mm_set1_ps(in[i + 1].z));
+        __m256 r = _mm256_add_ps(_mm256_mul_ps(c0, x), c3);
+        r = _mm256_add_ps(r, _mm256_mul_ps(c1, y));
+        r = _mm256_add_ps(r, _mm256_mul_ps(c2, z));
+        _mm256_storeu_ps(&out[i].x, r);
+    }
+    for(; i < n; i++) out[i] = *this * in[i];
+#elif defined(CG_SIMD_SSE)
+    __m128 c0 = _mm_load_ps(&a_[0]);
+    __m128 c1 = _mm_load_ps(&a_[4]);
+    __m128 c2 = _mm_load_ps(&a_[8]);
+    __m128 c3 = _mm_load_ps(&a_[12]);
+    for(size_t i = 0; i < n; i++)
+    {
+        __m128 r = _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(in[i].x)), c3);
+        r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_set1_ps(in[i].y)));
+        r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(in[i].z)));
+        _mm_storeu_ps(&out[i].x, r);
+    }
+#else
+    for(size_t i = 0; i < n; i++) out[i] = *this * in[i];
+#endif
+}
+
+void Matrix4x4::transform_points(const Point3 *in, Point3 *out, size_t n) const
+{
+    // Skip the homogeneous divide for affine matrices
+    bool affine = (a_[3] == 0.0f && a_[7] == 0.0f && a_[11] == 0.0f && a_[15] == 1.0f);
+#if defined(CG_SIMD_SSE)
+    __m128 c0 = _mm_load_ps(&a_[0]);
+    __m128 c1 = _mm_load_ps(&a_[4]);
+    __m128 c2 = _mm_load_ps(&a_[8]);
+    __m128 c3 = _mm_load_ps(&a_[12]);
+    alignas(16) float r[4];
+    for(size_t i = 0; i < n; i++)
+    {
+        __m128 v = _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(in[i].x)), c3);
+        v = _mm_add_ps(v, _mm_mul_ps(c1, _mm_set1_ps(in[i].y)));
+        v = _mm_add_ps(v, _mm_mul_ps(c2, _mm_set1_ps(in[i].z)));
+        if(!affine) v = _mm_div_ps(v, CG_SWIZZLE(v, 3, 3, 3, 3));
+
+        // Store 3 components (a 4-wide store would overwrite the next point)
+        _mm_store_ps(r, v);
+        out[i].x = r[0];
+        out[i].y = r[1];
+        out[i].z = r[2];
+    }
+#else
+    for(size_t i = 0; i < n; i++)
+    {
+        Point3 p = in[i];
+        out[i].x = a_[0] * p.x + a_[4] * p.y + a_[8] * p.z + a_[12];
+        out[i].y = a_[1] * p.x + a_[5] * p.y + a_[9] * p.z + a_[13];
+        out[i].z = a_[2] * p.x + a_[6] * p.y + a_[10] * p.z + a_[14];
+        if(!affine)
+        {
+            float w = a_[3] * p.x + a_[7] * p.y + a_[11] * p.z + a_[15];
+            out[i].x /= w;
+            out[i].y /= w;
+            out[i].z /= w;
+        }
+    }
+#endif
+}
+
+void Matrix4x4::transform_vectors(const Vector3 *in, Vector3 *out, size_t n) const
+{
+#if defined(CG_SIMD_SSE)
+    __m128 c0 = _mm_load_ps(&a_[0]);
+    __m128 c1 = _mm_load_ps(&a_[4]);
+    __m128 c2 = _mm_load_ps(&a_[8]);
+    alignas(16) float r[4];
+    for(size_t i = 0; i < n; i++)
+    {
+        __m128 v = _mm_mul_ps(c0, _mm_set1_ps(in[i].x));
+        v = _mm_add_ps(v, _mm_mul_ps(c1, _mm_set1_ps(in[i].y)));
+        v = _mm_add_ps(v, _mm_mul_ps(c2, _mm_set1_ps(in[i].z)));
+
+        // Store 3 components (a 4-wide store would overwrite the next vector)
+        _mm_store_ps(r, v);
+        out[i].x = r[0];
+        out[i].y = r[1];
+        out[i].z = r[2];
+    }
+#else
+    for(size_t i = 0; i < n; i++) out[i] = *this * in[i];
+#endif
+}
+
 Ray3 Matrix4x4::operator*(const Ray3 &ray) const { return Ray3(*this * ray.o, *this * ray.d); }
 
 Matrix4x4 &Matrix4x4::transpose()
@@ -219,6 +342,17 @@ Matrix4x4 &Matrix4x4::transpose()
 Matrix4x4 Matrix4x4::get_transpose() const
 {
     Matrix4x4 t;
+#if defined(CG_SIMD_SSE)
+    __m128 c0 = _mm_load_ps(&a_[0]);
+    __m128 c1 = _mm_load_ps(&a_[4]);
+    __m128 c2 = _mm_load_ps(&a_[8]);
+    __m128 c3 = _mm_load_ps(&a_[12]);
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+    _mm_store_ps(&t.a_[0], c0);
+    _mm_store_ps(&t.a_[4], c1);
+    _mm_store_ps(&t.a_[8], c2);
+    _mm_store_ps(&t.a_[12], c3);
+#else
     t.m00() = m00();
     t.m01() = m10();
     t.m02() = m20();
@@ -235,6 +369,7 @@ Matrix4x4 Matrix4x4::get_transpose() const
     t.m31() = m13();
     t.m32() = m23();
     t.m33() = m33();
+#endif
     return t;
 }
 
@@ -361,6 +496,67 @@ void Matrix4x4::rotate_z(float angle)
 
 Matrix4x4 Matrix4x4::get_inverse() const
 {
+#if defined(CG_SIMD_SSE)
+    // Block-wise inverse using 2x2 sub-matrices. The columns are treated as
+    // the rows of the transpose, and since inverse(transpose(M)) equals
+    // transpose(inverse(M)) the result is stored in column order as well.
+    __m128 c0 = _mm_load_ps(&a_[0]);
+    __m128 c1 = _mm_load_ps(&a_[4]);
+    __m128 c2 = _mm_load_ps(&a_[8]);
+    __m128 c3 = _mm_load_ps(&a_[12]);
+
+    // Sub-matrices
+    __m128 a = _mm_movelh_ps(c0, c1);
+    __m128 b = _mm_movehl_ps(c1, c0);
+    __m128 c = _mm_movelh_ps(c2, c3);
+    __m128 d = _mm_movehl_ps(c3, c2);
+
+    // Determinants of the sub-matrices as (|A| |B| |C| |D|)
+    __m128 det_sub = _mm_sub_ps(_mm_mul_ps(CG_SHUFFLE(c0, c2, 0, 2, 0, 2), CG_SHUFFLE(c1, c3, 1, 3, 1, 3)),
+                                _mm_mul_ps(CG_SHUFFLE(c0, c2, 1, 3, 1, 3), CG_SHUFFLE(c1, c3, 0, 2, 0, 2)));
+    __m128 det_a = CG_SWIZZLE(det_sub, 0, 0, 0, 0);
+    __m128 det_b = CG_SWIZZLE(det_sub, 1, 1, 1, 1);
+    __m128 det_c = CG_SWIZZLE(det_sub, 2, 2, 2, 2);
+    __m128 det_d = CG_SWIZZLE(det_sub, 3, 3, 3, 3);
+
+    // Inverse is 1/|M| * | X Y |, computed from the adjugates of X, Y, Z, W
+    //                    | Z W |
+    __m128 d_c = mat2_adj_mul(d, c);
+    __m128 a_b = mat2_adj_mul(a, b);
+    __m128 x = _mm_sub_ps(_mm_mul_ps(det_d, a), mat2_mul(b, d_c));
+    __m128 w = _mm_sub_ps(_mm_mul_ps(det_a, d), mat2_mul(c, a_b));
+    __m128 y = _mm_sub_ps(_mm_mul_ps(det_b, c), mat2_mul_adj(d, a_b));
+    __m128 z = _mm_sub_ps(_mm_mul_ps(det_c, b), mat2_mul_adj(a, d_c));
+
+    // |M| = |A||D| + |B||C| - trace(adj(A)B adj(D)C)
+    __m128 det_m = _mm_add_ps(_mm_mul_ps(det_a, det_d), _mm_mul_ps(det_b, det_c));
+    __m128 tr = _mm_mul_ps(a_b, CG_SWIZZLE(d_c, 0, 2, 1, 3));
+    tr = _mm_add_ps(tr, CG_SWIZZLE(tr, 2, 3, 0, 1));
+    tr = _mm_add_ps(tr, CG_SWIZZLE(tr, 1, 0, 3, 2));
+    det_m = _mm_sub_ps(det_m, tr);
+
+    // The matrix is singular (has no inverse), set the inverse
+    // to the identity matrix.
+    Matrix4x4 b_inv;
+    if(_mm_cvtss_f32(det_m) == 0.0f)
+    {
+        logmsg("InvertMatrix: Singular matrix");
+        return b_inv;
+    }
+
+    __m128 r_det = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det_m);
+    x = _mm_mul_ps(x, r_det);
+    y = _mm_mul_ps(y, r_det);
+    z = _mm_mul_ps(z, r_det);
+    w = _mm_mul_ps(w, r_det);
+
+    // Apply the adjugate shuffle and store
+    _mm_store_ps(&b_inv.a_[0], CG_SHUFFLE(x, y, 3, 1, 3, 1));
+    _mm_store_ps(&b_inv.a_[4], CG_SHUFFLE(x, y, 2, 0, 2, 0));
+    _mm_store_ps(&b_inv.a_[8], CG_SHUFFLE(z, w, 3, 1, 3, 1));
+    _mm_store_ps(&b_inv.a_[12], CG_SHUFFLE(z, w, 2, 0, 2, 0));
+    return b_inv;
+#else
     int32_t   j, k;
     int32_t   ind;
     float     v1, v2;
@@ -423,6 +619,7 @@ Matrix4x4 Matrix4x4::get_inverse() const
         }
     }
     return b;
+#endif
 }
 
 void Matrix4x4::log(const char *str) const
@@ -17,13 +17,17 @@
 #include "vector3.hpp"
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
 
 namespace cg
 {
 
+class AffineTransform3;
+
 /**
- * 4x4 matrix. All matrix elements (row, col) are indexed base 0.
+ * 4x4 matrix. All matrix elements (row, col) are indexed base 0. Elements
+ * are 16-byte aligned so columns can be loaded directly into SIMD registers.
  */
 class Matrix4x4
 {
@@ -170,6 +174,34 @@ class Matrix4x4
      */
     Vector3 operator*(const Vector3 &v) const;
 
+    /**
+     * Transforms an array of points. Assumes the w coordinate of each input
+     * point is 1. The input and output arrays may not overlap.
+     * @param  in   Points to transform.
+     * @param  out  Transformed homogeneous points (n entries).
+     * @param  n    Number of points.
+     */
+    void transform_points(const Point3 *in, HPoint3 *out, size_t n) const;
+
+    /**
+     * Transforms an array of points, returning cartesian coordinates. The
+     * homogeneous divide is skipped if the last row of the matrix is
+     * (0 0 0 1). Input and output may be the same array.
+     * @param  in   Points to transform.
+     * @param  out  Transformed points (n entries).
+     * @param  n    Number of points.
+     */
+    void transform_points(const Point3 *in, Point3 *out, size_t n) const;
+
+    /**
+     * Transforms an array of vectors (normals or directions). Only the upper
+     * 3x3 portion of the matrix is used. Input and output may be the same array.
+     * @param  in   Vectors to transform.
+     * @param  out  Transformed vectors (n entries).
+     * @param  n    Number of vectors.
+     */
+    void transform_vectors(const Vector3 *in, Vector3 *out, size_t n) const;
+
     /**
      * Transforms a ray by the matrix.  Transforms the ray origin and
      * ray direction.
@@ -247,6 +279,7 @@ class Matrix4x4
 
     /**
      * Calculates the inverse of the current 4x4 matrix and returns it.
+     * If the matrix is singular the identity matrix is returned.
      * @return  Returns the inverse of the current matrix.
      */
     Matrix4x4 get_inverse() const;
@@ -259,7 +292,11 @@ class Matrix4x4
 
   private:
     // Elements of the matrix. Column order.
-    std::array<float, 16> a_;
+    alignas(16) std::array<float, 16> a_;
+
+    // Writes the elements directly (same layout)
+    friend class AffineTransform3;
+    friend Matrix4x4 operator*(const Matrix4x4 &m, const AffineTransform3 &a);
 };
 
 } // namespace cg
@@ -0,0 +1,588 @@
+#include "geometry/mesh_bvh.hpp"
+
+#include "geometry/geometry.hpp"
+
+#include <algorithm>
+#include <future>
+#include <limits>
+#include <thread>
+
+namespace cg
+{
+
+namespace
+{
+
+// Build parameters
+constexpr uint32_t BIN_COUNT = 16;                           // SAH bins per axis
+constexpr uint32_t MIN_LEAF_SIZE = TriangleBatch::SIZE;      // Always make a leaf at or below this size
+constexpr uint32_t MAX_LEAF_SIZE = 4 * TriangleBatch::SIZE;  // Always split above this size (if possible)
+constexpr uint32_t MAX_DEPTH = 60;                           // Limits the traversal stack size
+constexpr uint32_t PARALLEL_MIN_SIZE = 4096;                 // Build subtrees at least this large in parallel
+constexpr float    TRAVERSAL_COST = 1.0f;                    // Cost of a node visit relative to a batch test
+
+// Number of triangle batches needed for a number of triangles. The SAH
+// counts batches since a batch is tested as quickly as a single triangle.
+inline uint32_t batch_count(uint32_t triangles)
+{
+    return (triangles + TriangleBatch::SIZE - 1) / TriangleBatch::SIZE;
+}
+
+// Node entry distance returned when a ray misses a node
+constexpr float NO_HIT = std::numeric_limits<float>::infinity();
+
+// Bounds used during the build
+struct Bounds
+{
+    float mn[3];
+    float mx[3];
+
+    void reset()
+    {
+        for(uint32_t a = 0; a < 3; a++)
+        {
+            mn[a] = std::numeric_limits<float>::max();
+            mx[a] = -std::numeric_limits<float>::max();
+        }
+    }
+
+    void grow(const Bounds &b)
+    {
+        for(uint32_t a = 0; a < 3; a++)
+        {
+            mn[a] = std::min(mn[a], b.mn[a]);
+            mx[a] = std::max(mx[a], b.mx[a]);
+        }
+    }
+
+    void grow(const float *p)
+    {
+        for(uint32_t a = 0; a < 3; a++)
+        {
+            mn[a] = std::min(mn[a], p[a]);
+            mx[a] = std::max(mx[a], p[a]);
+        }
+    }
+
+    // Half the surface area (the factor of 2 does not affect the SAH)
+    float half_area() const
+    {
+        float dx = mx[0] - mn[0];
+        float dy = mx[1] - mn[1];
+        float dz = mx[2] - mn[2];
+        return (dx < 0.0f) ? 0.0f : dx * dy + dy * dz + dz * dx;
+    }
+};
+
+// Triangle bounds and centroid used during the build
+struct BuildTriangle
+{
+    Bounds bounds;
+    float  centroid[3];
+};
+
+// Recursive binned SAH builder. Partitions ranges of the triangle list in
+// place. Each call appends a subtree to a node list; child offsets are
+// relative so subtrees built on other threads can be appended as is.
+class Builder
+{
+  public:
+    Builder(const std::vector<BuildTriangle> &build_triangles, std::vector<uint32_t> &triangles)
+        : build_triangles_(build_triangles), triangles_(triangles)
+    {
+        uint32_t threads = std::max(1u, std::thread::hardware_concurrency());
+        parallel_depth_ = 0;
+        while((1u << parallel_depth_) < threads) { parallel_depth_++; }
+    }
+
+    void build(std::vector<BVHNode> &nodes, uint32_t begin, uint32_t end, uint32_t depth)
+    {
+        size_t node_index = nodes.size();
+        nodes.push_back(BVHNode{});
+
+        Bounds bounds, centroid_bounds;
+        bounds.reset();
+        centroid_bounds.reset();
+        for(uint32_t i = begin; i < end; i++)
+        {
+            const BuildTriangle &t = build_triangles_[triangles_[i]];
+            bounds.grow(t.bounds);
+            centroid_bounds.grow(t.centroid);
+        }
+        for(uint32_t a = 0; a < 3; a++)
+        {
+            nodes[node_index].bmin[a] = bounds.mn[a];
+            nodes[node_index].bmax[a] = bounds.mx[a];
+        }
+
+        uint32_t count = end - begin;
+        uint32_t mid = (count > MIN_LEAF_SIZE && depth < MAX_DEPTH)
+                           ? find_split(bounds, centroid_bounds, begin, end)
+                           : begin;
+        if(mid == begin || mid == end)
+        {
+            nodes[node_index].offset = begin;
+            nodes[node_index].count = count;
+            return;
+        }
+
+        uint32_t right_offset;
+        if(count >= PARALLEL_MIN_SIZE && depth < parallel_depth_)
+        {
+            std::vector<BVHNode> right_nodes;
+            auto right = std::async(std::launch::async, [&]() { build(right_nodes, mid, end, depth + 1); });
+            build(nodes, begin, mid, depth + 1);
+            right.get();
+            right_offset = static_cast<uint32_t>(nodes.size() - node_index);
+            nodes.insert(nodes.end(), right_nodes.begin(), right_nodes.end());
+        }
+        else
+        {
+            build(nodes, begin, mid, depth + 1);
+            right_offset = static_cast<uint32_t>(nodes.size() - node_index);
+            build(nodes, mid, end, depth + 1);
+        }
+        nodes[node_index].offset = right_offset;
+        nodes[node_index].count = 0;
+    }
+
+  protected:
+    const std::vector<BuildTriangle> &build_triangles_;
+    std::vector<uint32_t>            &triangles_;
+    uint32_t                          parallel_depth_;
+
+    // Finds the lowest cost split and partitions the range. Returns the
+    // start of the right half, or begin if a leaf should be formed.
+    uint32_t find_split(const Bounds &bounds, const Bounds &centroid_bounds, uint32_t begin, uint32_t end)
+    {
+        uint32_t count = end - begin;
+        float    best_cost = std::numeric_limits<float>::max();
+        uint32_t best_axis = 0;
+        uint32_t best_bin = 0;
+        for(uint32_t a = 0; a < 3; a++)
+        {
+            float extent = centroid_bounds.mx[a] - centroid_bounds.mn[a];
+            if(extent <= 0.0f) { continue; }
+
+            // Bin the triangle centroids
+            Bounds   bin_bounds[BIN_COUNT];
+            uint32_t bin_count[BIN_COUNT] = {};
+            for(auto &b : bin_bounds) { b.reset(); }
+            float scale = BIN_COUNT / extent;
+            for(uint32_t i = begin; i < end; i++)
+            {
+                const BuildTriangle &t = build_triangles_[triangles_[i]];
+                uint32_t             b = bin_index(t.centroid[a], centroid_bounds.mn[a], scale);
+                bin_bounds[b].grow(t.bounds);
+                bin_count[b]++;
+            }
+
+            // Sweep from the right to get the area of the right side of each
+            // split plane, then from the left to evaluate the cost
+            float  right_area[BIN_COUNT];
+            Bounds right;
+            right.reset();
+            for(uint32_t b = BIN_COUNT - 1; b > 0; b--)
+            {
+                right.grow(bin_bounds[b]);
+                right_area[b] = right.half_area();
+            }
+            Bounds   left;
+            uint32_t left_count = 0;
+            left.reset();
+            for(uint32_t b = 0; b < BIN_COUNT - 1; b++)
+            {
+                left.grow(bin_bounds[b]);
+                left_count += bin_count[b];
+                if(left_count == 0 || left_count == count) { continue; }
+                float cost = batch_count(left_count) * left.half_area() +
+                             batch_count(count - left_count) * right_area[b + 1];
+                if(cost < best_cost)
+                {
+                    best_cost = cost;
+                    best_axis = a;
+                    best_bin = b + 1;
+                }
+            }
+        }
+
+        // Compare with the cost of a leaf (both relative to the node area)
+        float area = bounds.half_area();
+        if(best_cost == std::numeric_limits<float>::max())
+        {
+            // All centroids coincide. Split in half if the leaf would be too big
+            return (count > MAX_LEAF_SIZE) ? begin + count / 2 : begin;
+        }
+        if(count <= MAX_LEAF_SIZE && TRAVERSAL_COST * area + best_cost >= batch_count(count) * area)
+        {
+            return begin;
+        }
+
+        float  mn = centroid_bounds.mn[best_axis];
+        float  scale = BIN_COUNT / (centroid_bounds.mx[best_axis] - mn);
+        auto   first = triangles_.begin() + begin;
+        auto   last = triangles_.begin() + end;
+        auto   split = std::partition(first, last, [&](uint32_t t) {
+            return bin_index(build_triangles_[t].centroid[best_axis], mn, scale) < best_bin;
+        });
+        return begin + static_cast<uint32_t>(split - first);
+    }
+
+    static uint32_t bin_index(float c, float mn, float scale)
+    {
+        return std::min(BIN_COUNT - 1, static_cast<uint32_t>((c - mn) * scale));
+    }
+};
+
+// Slab test of a ray against node bounds. Returns the entry distance, or
+// infinity if the ray misses the box or enters it beyond t_max.
+inline float intersect_node(const BVHNode &node, const Ray3 &ray, const float *inv_d, float t_max)
+{
+    float t0 = 0.0f;
+    float t1 = t_max;
+    const float o[3] = {ray.o.x, ray.o.y, ray.o.z};
+    for(uint32_t a = 0; a < 3; a++)
+    {
+        float t_near = (node.bmin[a] - o[a]) * inv_d[a];
+        float t_far = (node.bmax[a] - o[a]) * inv_d[a];
+        if(t_near > t_far) { std::swap(t_near, t_far); }
+        t0 = (t_near > t0) ? t_near : t0;
+        t1 = (t_far < t1) ? t_far : t1;
+    }
+    return (t0 <= t1) ? t0 : NO_HIT;
+}
+
+// Traversal stack entry for ray packets: node and the lanes that entered it
+struct PacketStackEntry
+{
+    uint32_t index;
+    uint32_t mask;
+};
+
+// Smallest entry distance over a set of lanes
+inline float min_entry(const float *t_entry, uint32_t mask)
+{
+    float t = NO_HIT;
+    for(uint32_t i = 0; i < Ray3Packet::SIZE; i++)
+    {
+        if((mask & (1u << i)) && t_entry[i] < t) { t = t_entry[i]; }
+    }
+    return t;
+}
+
+} // namespace
+
+MeshBVH::MeshBVH() : triangle_count_(0) {}
+
+template <typename V, typename I>
+void MeshBVH::build(const std::vector<V> &vertex_list, const std::vector<I> &face_list)
+{
+    clear();
+    uint32_t face_count = static_cast<uint32_t>(face_list.size() / 3);
+    if(face_count == 0) { return; }
+
+    std::vector<BuildTriangle> build_triangles(face_count);
+    std::vector<uint32_t>      triangles(face_count);
+    for(uint32_t f = 0; f < face_count; f++)
+    {
+        BuildTriangle &t = build_triangles[f];
+        t.bounds.reset();
+        for(uint32_t c = 0; c < 3; c++)
+        {
+            const Point3 &p = vertex_position(vertex_list[face_list[f * 3 + c]]);
+            const float   v[3] = {p.x, p.y, p.z};
+            t.bounds.grow(v);
+        }
+        for(uint32_t a = 0; a < 3; a++) { t.centroid[a] = 0.5f * (t.bounds.mn[a] + t.bounds.mx[a]); }
+        triangles[f] = f;
+    }
+
+    nodes_.reserve(2 * face_count / MIN_LEAF_SIZE);
+    Builder builder(build_triangles, triangles);
+    builder.build(nodes_, 0, face_count, 0);
+
+    // Pack the triangles of each leaf into batches. Leaves refer to their
+    // first batch rather than to the triangle list.
+    batches_.reserve(face_count / TriangleBatch::SIZE + nodes_.size() / 2 + 1);
+    for(BVHNode &node : nodes_)
+    {
+        if(!node.is_leaf()) { continue; }
+        uint32_t first = node.offset;
+        node.offset = static_cast<uint32_t>(batches_.size());
+        for(uint32_t i = 0; i < node.count; i++)
+        {
+            if(i % TriangleBatch::SIZE == 0) { batches_.emplace_back(); }
+            uint32_t f = triangles[first + i];
+            batches_.back().add(vertex_position(vertex_list[face_list[f * 3]]),
+                                vertex_position(vertex_list[face_list[f * 3 + 1]]),
+                                vertex_position(vertex_list[face_list[f * 3 + 2]]),
+                                f);
+        }
+    }
+    triangle_count_ = face_count;
+}
+
+// Vertex and index types used by TriSurface and the geometry classes
+template void MeshBVH::build(const std::vector<Point3> &, const std::vector<uint16_t> &);
+template void MeshBVH::build(const std::vector<Point3> &, const std::vector<uint32_t> &);
+template void MeshBVH::build(const std::vector<VertexAndNormal> &, const std::vector<uint16_t> &);
+template void MeshBVH::build(const std::vector<VertexAndNormal> &, const std::vector<uint32_t> &);
+template void MeshBVH::build(const std::vector<VertexNormalTexture> &, const std::vector<uint16_t> &);
+template void MeshBVH::build(const std::vector<VertexNormalTexture> &, const std::vector<uint32_t> &);
+template void MeshBVH::build(const std::vector<VertexNormalTextureTangent> &, const std::vector<uint16_t> &);
+template void MeshBVH::build(const std::vector<VertexNormalTextureTangent> &, const std::vector<uint32_t> &);
+
+void MeshBVH::clear()
+{
+    nodes_.clear();
+    batches_.clear();
+    triangle_count_ = 0;
+}
+
+bool MeshBVH::empty() const { return batches_.empty(); }
+
+RayMeshIntersectResult MeshBVH::intersect(const Ray3 &ray, float t_min) const
+{
+    RayMeshIntersectResult result{false, t_min, 0.0f, 0.0f, 0};
+    const float inv_d[3] = {1.0f / ray.d.x, 1.0f / ray.d.y, 1.0f / ray.d.z};
+    if(nodes_.empty() || intersect_node(nodes_[0], ray, inv_d, t_min) == NO_HIT)
+    {
+        result.distance = 0.0f;
+        return result;
+    }
+
+    uint32_t stack[MAX_DEPTH + 1];
+    uint32_t stack_size = 0;
+    uint32_t index = 0;
+    while(true)
+    {
+        const BVHNode &node = nodes_[index];
+        if(node.is_leaf())
+        {
+            for(uint32_t b = node.offset, n = node.offset + batch_count(node.count); b < n; b++)
+            {
+                batches_[b].intersect(ray, result);
+            }
+        }
+        else
+        {
+            // Visit the nearer child first. Children beyond the nearest
+            // intersection found so far are skipped.
+            uint32_t left = index + 1;
+            uint32_t right = index + node.offset;
+            float    t_left = intersect_node(nodes_[left], ray, inv_d, result.distance);
+            float    t_right = intersect_node(nodes_[right], ray, inv_d, result.distance);
+            if(t_right < t_left)
+            {
+                std::swap(left, right);
+                std::swap(t_left, t_right);
+            }
+            if(t_left != NO_HIT)
+            {
+                if(t_right != NO_HIT) { stack[stack_size++] = right; }
+                index = left;
+                continue;
+            }
+        }
+        if(stack_size == 0) { break; }
+        index = stack[--stack_size];
+    }
+
+    if(!result.intersects) { result.distance = 0.0f; }
+    return result;
+}
+
+bool MeshBVH::does_intersect_exist(const Ray3 &ray, float t_min) const
+{
+    if(nodes_.empty()) { return false; }
+
+    const float inv_d[3] = {1.0f / ray.d.x, 1.0f / ray.d.y, 1.0f / ray.d.z};
+    if(intersect_node(nodes_[0], ray, inv_d, t_min) == NO_HIT) { return false; }
+
+    uint32_t stack[MAX_DEPTH + 1];
+    uint32_t stack_size = 0;
+    uint32_t index = 0;
+    while(true)
+    {
+        const BVHNode &node = nodes_[index];
+        if(node.is_leaf())
+        {
+            for(uint32_t b = node.offset, n = node.offset + batch_count(node.count); b < n; b++)
+            {
+                if(batches_[b].does_intersect_exist(ray, t_min)) { return true; }
+            }
+        }
+        else
+        {
+            // Any intersection will do, so no need to order the children
+            uint32_t left = index + 1;
+            uint32_t right = index + node.offset;
+            bool     hit_left = intersect_node(nodes_[left], ray, inv_d, t_min) != NO_HIT;
+            bool     hit_right = intersect_node(nodes_[right], ray, inv_d, t_min) != NO_HIT;
+            if(hit_left || hit_right)
+            {
+                if(hit_left && hit_right) { stack[stack_size++] = right; }
+                index = hit_left ? left : right;
+                continue;
+            }
+        }
+        if(stack_size == 0) { break; }
+        index = stack[--stack_size];
+    }
+    return false;
+}
+
+void MeshBVH::intersect(const Ray3Packet &packet, RayMeshIntersectResult *results) const
+{
+    constexpr uint32_t N = Ray3Packet::SIZE;
+    alignas(32) float  t[N];
+    alignas(32) float  u[N] = {};
+    alignas(32) float  v[N] = {};
+    alignas(32) float  t_left[N];
+    alignas(32) float  t_right[N];
+    uint32_t           face[N] = {};
+    uint32_t           hits = 0;
+    for(uint32_t i = 0; i < N; i++) { t[i] = packet.t_max[i]; }
+
+    PacketStackEntry stack[MAX_DEPTH + 1];
+    uint32_t         stack_size = 0;
+    uint32_t         index = 0;
+    uint32_t         mask = nodes_.empty()
+                                ? 0
+                                : packet.intersect_box(nodes_[0].bmin, nodes_[0].bmax, t, packet.active, t_left);
+    while(true)
+    {
+        if(mask != 0)
+        {
+            const BVHNode &node = nodes_[index];
+            if(node.is_leaf())
+            {
+                for(uint32_t b = node.offset, n = node.offset + batch_count(node.count); b < n; b++)
+                {
+                    const TriangleBatch &batch = batches_[b];
+                    for(uint32_t i = 0; i < batch.count; i++)
+                    {
+                        uint32_t updated = packet.intersect_triangle(batch, i, mask, t, u, v);
+                        for(uint32_t lane = 0; updated != 0; lane++, updated >>= 1)
+                        {
+                            if(updated & 1u)
+                            {
+                                face[lane] = batch.face[i];
+                                hits |= 1u << lane;
+                            }
+                        }
+                    }
+                }
+            }
+            else
+            {
+                // Only lanes that entered this node can enter its children.
+                // Visit first the child entered nearest by any lane.
+                uint32_t left = index + 1;
+                uint32_t right = index + node.offset;
+                uint32_t mask_left = packet.intersect_box(nodes_[left].bmin, nodes_[left].bmax, t, mask, t_left);
+                uint32_t mask_right =
+                    packet.intersect_box(nodes_[right].bmin, nodes_[right].bmax, t, mask, t_right);
+                if(mask_left != 0 && mask_right != 0)
+                {
+                    if(min_entry(t_right, mask_right) < min_entry(t_left, mask_left))
+                    {
+                        std::swap(left, right);
+                        std::swap(mask_left, mask_right);
+                    }
+                    stack[stack_size++] = {right, mask_right};
+                    index = left;
+                    mask = mask_left;
+                    continue;
+                }
+                if(mask_left != 0 || mask_right != 0)
+                {
+                    index = (mask_left != 0) ? left : right;
+                    mask = mask_left | mask_right;
+                    continue;
+                }
+            }
+        }
+        if(stack_size == 0) { break; }
+
+        // Test the node again since intersections found after it was pushed
+        // may have shortened some of the rays
+        const PacketStackEntry &entry = stack[--stack_size];
+        index = entry.index;
+        mask = packet.intersect_box(nodes_[index].bmin, nodes_[index].bmax, t, entry.mask, t_left);
+    }
+
+    for(uint32_t i = 0; i < N; i++)
+    {
+        if(hits & (1u << i)) { results[i] = {true, t[i], u[i], v[i], face[i]}; }
+        else results[i] = {false, 0.0f, 0.0f, 0.0f, 0};
+    }
+}
+
+uint32_t MeshBVH::does_intersect_exist(const Ray3Packet &packet) const
+{
+    constexpr uint32_t N = Ray3Packet::SIZE;
+    alignas(32) float  t[N];
+    alignas(32) float  u[N];
+    alignas(32) float  v[N];
+    alignas(32) float  t_entry[N];
+    uint32_t           occluded = 0;
+    for(uint32_t i = 0; i < N; i++) { t[i] = packet.t_max[i]; }
+
+    PacketStackEntry stack[MAX_DEPTH + 1];
+    uint32_t         stack_size = 0;
+    uint32_t         index = 0;
+    uint32_t         mask = nodes_.empty()
+                                ? 0
+                                : packet.intersect_box(nodes_[0].bmin, nodes_[0].bmax, t, packet.active, t_entry);
+    while(true)
+    {
+        // Lanes drop out once they find an intersection
+        mask &= ~occluded;
+        if(mask != 0)
+        {
+            const BVHNode &node = nodes_[index];
+            if(node.is_leaf())
+            {
+                for(uint32_t b = node.offset, n = node.offset + batch_count(node.count); b < n && mask != 0; b++)
+                {
+                    const TriangleBatch &batch = batches_[b];
+                    for(uint32_t i = 0; i < batch.count && mask != 0; i++)
+                    {
+                        occluded |= packet.intersect_triangle(batch, i, mask, t, u, v);
+                        mask &= ~occluded;
+                    }
+                }
+                if((packet.active & ~occluded) == 0) { return occluded; }
+            }
+            else
+            {
+                uint32_t left = index + 1;
+                uint32_t right = index + node.offset;
+                uint32_t mask_left = packet.intersect_box(nodes_[left].bmin, nodes_[left].bmax, t, mask, t_entry);
+                uint32_t mask_right =
+                    packet.intersect_box(nodes_[right].bmin, nodes_[right].bmax, t, mask, t_entry);
+                if(mask_left != 0 || mask_right != 0)
+                {
+                    if(mask_left != 0 && mask_right != 0) { stack[stack_size++] = {right, mask_right}; }
+                    index = (mask_left != 0) ? left : right;
+                    mask = (mask_left != 0) ? mask_left : mask_right;
+                    continue;
+                }
+            }
+        }
+        if(stack_size == 0) { break; }
+        index = stack[stack_size - 1].index;
+        mask = stack[stack_size - 1].mask;
+        stack_size--;
+    }
+    return occluded;
+}
+
+const std::vector<BVHNode> &MeshBVH::get_nodes() const { return nodes_; }
+
+const std::vector<TriangleBatch> &MeshBVH::get_batches() const { return batches_; }
+
+size_t MeshBVH::triangle_count() const { return triangle_count_; }
+
+} // namespace cg
@@ -0,0 +1,147 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:  David W. Nesbitt
+//	File:    mesh_bvh.hpp
+//	Purpose: Bounding volume hierarchy over the triangles of a mesh for
+//           ray queries. Built using the binned surface area heuristic.
+//============================================================================
+
+#ifndef __GEOMETRY_MESH_BVH_HPP__
+#define __GEOMETRY_MESH_BVH_HPP__
+
+#include "geometry/point3.hpp"
+#include "geometry/ray3.hpp"
+#include "geometry/ray3_packet.hpp"
+#include "geometry/triangle_batch.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace cg
+{
+
+/**
+ * BVH node (32 bytes). Nodes are stored depth first so the left child of an
+ * interior node immediately follows it.
+ */
+struct BVHNode
+{
+    float    bmin[3]; // Minimum corner of the node bounds
+    uint32_t offset;  // Leaf: first triangle batch. Interior: offset from this
+                      // node to the right child.
+    float    bmax[3]; // Maximum corner of the node bounds
+    uint32_t count;   // Number of triangles (0 for interior nodes). A leaf
+                      // spans ceil(count / TriangleBatch::SIZE) batches.
+
+    bool is_leaf() const { return count != 0; }
+};
+
+/**
+ * Bounding volume hierarchy over the triangles of an indexed triangle mesh.
+ * Splits are chosen with a binned surface area heuristic. Subtrees of large
+ * meshes are built in parallel. The triangles of each leaf are stored as
+ * TriangleBatch structures so a ray is tested against a batch of triangles
+ * at once, and the BVH can be queried independently of the mesh.
+ */
+class MeshBVH
+{
+  public:
+    /**
+     * Constructor. Creates an empty BVH.
+     */
+    MeshBVH();
+
+    /**
+     * Build the BVH from a vertex list and triangle face list (3 indexes
+     * per face). Replaces any previous hierarchy. Positions are read
+     * directly from the vertex list, which may be Point3 or any of the
+     * vertex structures in types.hpp (16 or 32 bit face indexes).
+     * @param  vertex_list  Vertex list.
+     * @param  face_list    Face index list.
+     */
+    template <typename V, typename I>
+    void build(const std::vector<V> &vertex_list, const std::vector<I> &face_list);
+
+    /**
+     * Remove the hierarchy.
+     */
+    void clear();
+
+    /**
+     * Check whether the BVH has been built.
+     * @return  Returns true if the BVH contains no triangles.
+     */
+    bool empty() const;
+
+    /**
+     * Find the nearest intersection of a ray with the mesh.
+     * @param  ray    Ray to intersect.
+     * @param  t_min  Current minimum intersection (t) value along the ray.
+     * @return Returns whether or not there is an intersection closer than
+     *         t_min, the distance at which the intersection occurs (0.0 if no
+     *         intersection), the barycentric coordinates of intersection,
+     *         and the face index.
+     */
+    RayMeshIntersectResult intersect(const Ray3 &ray, float t_min) const;
+
+    /**
+     * Does an intersection exist between ray and the mesh. The intersection
+     * must occur prior to t_min. Stops at the first intersection found.
+     * @param  ray    Ray to intersect.
+     * @param  t_min  t value for intersection.
+     * @return Returns true if an intersection exists, false if not.
+     */
+    bool does_intersect_exist(const Ray3 &ray, float t_min) const;
+
+    /**
+     * Find the nearest intersection of each active ray in a packet. The rays
+     * traverse the BVH together; lanes that miss a node are masked off for
+     * that subtree. Gives the same results as intersecting each ray alone.
+     * @param  packet   Ray packet. The t_max of each lane is its current
+     *                  minimum intersection value.
+     * @param  results  Returns the result for each lane (Ray3Packet::SIZE
+     *                  entries). Inactive lanes do not intersect.
+     */
+    void intersect(const Ray3Packet &packet, RayMeshIntersectResult *results) const;
+
+    /**
+     * Does an intersection exist for each active ray in a packet, prior to
+     * the t_max of each lane. Lanes stop traversing once an intersection
+     * is found.
+     * @param  packet  Ray packet.
+     * @return Returns a mask of the lanes with an intersection.
+     */
+    uint32_t does_intersect_exist(const Ray3Packet &packet) const;
+
+    /**
+     * Get the nodes. The root is node 0.
+     * @return  Returns the node list.
+     */
+    const std::vector<BVHNode> &get_nodes() const;
+
+    /**
+     * Get the triangle batches in leaf order. Leaf nodes refer to ranges of
+     * this list.
+     * @return  Returns the triangle batches.
+     */
+    const std::vector<TriangleBatch> &get_batches() const;
+
+    /**
+     * Get the number of triangles.
+     * @return  Returns the number of triangles in the BVH.
+     */
+    size_t triangle_count() const;
+
+  protected:
+    std::vector<BVHNode>       nodes_;
+    std::vector<TriangleBatch> batches_;
+    size_t                     triangle_count_;
+};
+
+} // namespace cg
+
+#endif
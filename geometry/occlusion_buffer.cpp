@@ -0,0 +1,343 @@
+#include "geometry/occlusion_buffer.hpp"
+
+#include "geometry/geometry.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <thread>
+
+namespace cg
+{
+
+using namespace simd;
+
+namespace
+{
+
+// Rasterize on several threads only when there is enough work to cover the
+// cost of starting them
+constexpr size_t PARALLEL_MIN_TRIANGLES = 256;
+
+// Vertices closer than this (clip w) are treated as crossing the near plane
+constexpr float MIN_W = 1.0e-5f;
+
+// Boxes are moved this far toward the viewer (window z) before testing so
+// that geometry lying on an occluder surface is not hidden by it
+constexpr float DEPTH_BIAS = 1.0e-5f;
+
+// Offsets of the pixel centers within a SIMD register
+alignas(32) const float LANE_CENTER[8] = {0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f};
+
+// Transform a point to clip coordinates
+inline void to_clip(const Matrix4x4 &m, const Point3 &p, float *c)
+{
+    c[0] = m.m00() * p.x + m.m01() * p.y + m.m02() * p.z + m.m03();
+    c[1] = m.m10() * p.x + m.m11() * p.y + m.m12() * p.z + m.m13();
+    c[2] = m.m20() * p.x + m.m21() * p.y + m.m22() * p.z + m.m23();
+    c[3] = m.m30() * p.x + m.m31() * p.y + m.m32() * p.z + m.m33();
+}
+
+// Largest value in a register
+inline float horizontal_max(vfloat a)
+{
+    alignas(32) float v[WIDTH];
+    store(v, a);
+    float m = v[0];
+    for(uint32_t i = 1; i < WIDTH; i++) { m = std::max(m, v[i]); }
+    return m;
+}
+
+} // namespace
+
+OcclusionBuffer::OcclusionBuffer(uint32_t width, uint32_t height) : max_threads_(0)
+{
+    resize(width, height);
+}
+
+void OcclusionBuffer::resize(uint32_t width, uint32_t height)
+{
+    width_ = std::max(1u, (width + TILE_WIDTH - 1) / TILE_WIDTH) * TILE_WIDTH;
+    height_ = std::max(1u, (height + TILE_HEIGHT - 1) / TILE_HEIGHT) * TILE_HEIGHT;
+    row_blocks_ = width_ / WIDTH;
+    depth_.resize(static_cast<size_t>(row_blocks_) * height_);
+    tile_max_.resize((width_ / TILE_WIDTH) * (height_ / TILE_HEIGHT));
+    clear();
+}
+
+void OcclusionBuffer::clear()
+{
+    DepthBlock far_block;
+    std::fill(far_block.z, far_block.z + WIDTH, 1.0f);
+    std::fill(depth_.begin(), depth_.end(), far_block);
+    std::fill(tile_max_.begin(), tile_max_.end(), 1.0f);
+    triangles_.clear();
+}
+
+void OcclusionBuffer::add_occluder(const OccluderMesh &mesh, const Matrix4x4 &pvm)
+{
+    // Transform the vertices to window coordinates once. Vertices behind
+    // the near plane are flagged with w <= MIN_W.
+    std::vector<float> screen(mesh.vertices.size() * 4);
+    for(size_t i = 0; i < mesh.vertices.size(); i++)
+    {
+        float *s = &screen[i * 4];
+        to_clip(pvm, mesh.vertices[i], s);
+        if(s[3] <= MIN_W) { continue; }
+        float inv_w = 1.0f / s[3];
+        s[0] = (s[0] * inv_w * 0.5f + 0.5f) * width_;
+        s[1] = (s[1] * inv_w * 0.5f + 0.5f) * height_;
+        s[2] = s[2] * inv_w * 0.5f + 0.5f;
+    }
+
+    for(size_t i = 0; i + 2 < mesh.faces.size(); i += 3)
+    {
+        const float *v0 = &screen[mesh.faces[i] * 4];
+        const float *v1 = &screen[mesh.faces[i + 1] * 4];
+        const float *v2 = &screen[mesh.faces[i + 2] * 4];
+
+        // Skipping a triangle only makes the occlusion test more conservative
+        if(v0[3] <= MIN_W || v1[3] <= MIN_W || v2[3] <= MIN_W) { continue; }
+        if(v0[2] < 0.0f || v1[2] < 0.0f || v2[2] < 0.0f) { continue; }
+
+        // Back faces are culled (as with glCullFace(GL_BACK)) so an occluder
+        // never hides what is behind a surface that is not drawn
+        float area = (v1[0] - v0[0]) * (v2[1] - v0[1]) - (v2[0] - v0[0]) * (v1[1] - v0[1]);
+        if(area <= 0.0f) { continue; }
+
+        ScreenTriangle t;
+        t.x_min = std::max(0, static_cast<int32_t>(std::floor(std::min({v0[0], v1[0], v2[0]}))));
+        t.x_max = std::min(static_cast<int32_t>(width_) - 1,
+                           static_cast<int32_t>(std::floor(std::max({v0[0], v1[0], v2[0]}))));
+        t.y_min = std::max(0, static_cast<int32_t>(std::floor(std::min({v0[1], v1[1], v2[1]}))));
+        t.y_max = std::min(static_cast<int32_t>(height_) - 1,
+                           static_cast<int32_t>(std::floor(std::max({v0[1], v1[1], v2[1]}))));
+        if(t.x_min > t.x_max || t.y_min > t.y_max) { continue; }
+
+        // Edge function of edge a->b: (b - a) x (p - a), positive inside
+        const float *v[3] = {v0, v1, v2};
+        for(uint32_t k = 0; k < 3; k++)
+        {
+            const float *a = v[k];
+            const float *b = v[(k + 1) % 3];
+            t.e[k][0] = a[1] - b[1];
+            t.e[k][1] = b[0] - a[0];
+            t.e[k][2] = -(t.e[k][0] * a[0] + t.e[k][1] * a[1]);
+        }
+
+        // Depth plane
+        float dzdx = ((v1[2] - v0[2]) * (v2[1] - v0[1]) - (v2[2] - v0[2]) * (v1[1] - v0[1])) / area;
+        float dzdy = ((v2[2] - v0[2]) * (v1[0] - v0[0]) - (v1[2] - v0[2]) * (v2[0] - v0[0])) / area;
+        t.z[0] = v0[2] - dzdx * v0[0] - dzdy * v0[1];
+        t.z[1] = dzdx;
+        t.z[2] = dzdy;
+        triangles_.push_back(t);
+    }
+}
+
+void OcclusionBuffer::rasterize()
+{
+    uint32_t tile_rows = height_ / TILE_HEIGHT;
+    uint32_t threads = (max_threads_ > 0) ? max_threads_ : std::thread::hardware_concurrency();
+    threads = std::min(tile_rows, std::max(1u, threads));
+    bin_triangles();
+    if(triangles_.size() < PARALLEL_MIN_TRIANGLES || threads < 2)
+    {
+        for(uint32_t r = 0; r < tile_rows; r++) { rasterize_tile_row(r); }
+        return;
+    }
+
+    // Tile rows are interleaved between threads so each gets a similar share
+    // of the screen. Threads write to different rows so no locking is needed.
+    std::vector<std::future<void>> workers;
+    for(uint32_t i = 1; i < threads; i++)
+    {
+        workers.push_back(std::async(std::launch::async, [this, i, threads, tile_rows]() {
+            for(uint32_t r = i; r < tile_rows; r += threads) { rasterize_tile_row(r); }
+        }));
+    }
+    for(uint32_t r = 0; r < tile_rows; r += threads) { rasterize_tile_row(r); }
+    for(auto &w : workers) { w.get(); }
+}
+
+void OcclusionBuffer::bin_triangles()
+{
+    // Count the triangles of each tile row, then place them (counting sort,
+    // so each bin keeps the order the triangles were added in)
+    uint32_t tile_rows = height_ / TILE_HEIGHT;
+    bin_start_.assign(tile_rows + 1, 0);
+    const int32_t tile_height = static_cast<int32_t>(TILE_HEIGHT);
+    for(const auto &t : triangles_)
+    {
+        for(int32_t r = t.y_min / tile_height; r <= t.y_max / tile_height; r++)
+        {
+            bin_start_[r + 1]++;
+        }
+    }
+    for(uint32_t r = 0; r < tile_rows; r++) { bin_start_[r + 1] += bin_start_[r]; }
+
+    bins_.resize(bin_start_[tile_rows]);
+    std::vector<uint32_t> next(bin_start_.begin(), bin_start_.end() - 1);
+    for(uint32_t i = 0; i < triangles_.size(); i++)
+    {
+        const ScreenTriangle &t = triangles_[i];
+        for(int32_t r = t.y_min / tile_height; r <= t.y_max / tile_height; r++)
+        {
+            bins_[next[r]++] = i;
+        }
+    }
+}
+
+void OcclusionBuffer::rasterize_tile_row(uint32_t tile_row)
+{
+    const int32_t row_begin = static_cast<int32_t>(tile_row * TILE_HEIGHT);
+    const int32_t row_end = row_begin + static_cast<int32_t>(TILE_HEIGHT) - 1;
+    const vfloat  lane_x = load(LANE_CENTER);
+
+    for(uint32_t k = bin_start_[tile_row]; k < bin_start_[tile_row + 1]; k++)
+    {
+        const ScreenTriangle &t = triangles_[bins_[k]];
+
+        int32_t y0 = std::max(t.y_min, row_begin);
+        int32_t y1 = std::min(t.y_max, row_end);
+        int32_t b0 = t.x_min / static_cast<int32_t>(WIDTH);
+        int32_t b1 = t.x_max / static_cast<int32_t>(WIDTH);
+        for(int32_t y = y0; y <= y1; y++)
+        {
+            // Edge functions and depth at the first pixel center of the row,
+            // then stepped WIDTH pixels at a time
+            float  py = y + 0.5f;
+            float  px = static_cast<float>(b0 * WIDTH);
+            vfloat x = add(set1(px), lane_x);
+            vfloat e0 = add(mul(set1(t.e[0][0]), x), set1(t.e[0][1] * py + t.e[0][2]));
+            vfloat e1 = add(mul(set1(t.e[1][0]), x), set1(t.e[1][1] * py + t.e[1][2]));
+            vfloat e2 = add(mul(set1(t.e[2][0]), x), set1(t.e[2][1] * py + t.e[2][2]));
+            vfloat z = add(mul(set1(t.z[1]), x), set1(t.z[2] * py + t.z[0]));
+            vfloat step0 = set1(t.e[0][0] * WIDTH);
+            vfloat step1 = set1(t.e[1][0] * WIDTH);
+            vfloat step2 = set1(t.e[2][0] * WIDTH);
+            vfloat step_z = set1(t.z[1] * WIDTH);
+            vfloat zero = set1(0.0f);
+
+            DepthBlock *row = &depth_[static_cast<size_t>(y) * row_blocks_];
+            for(int32_t b = b0; b <= b1; b++)
+            {
+                vfloat inside =
+                    logical_and(cmp_ge(e0, zero), logical_and(cmp_ge(e1, zero), cmp_ge(e2, zero)));
+                vfloat depth = load(row[b].z);
+                vfloat nearer = logical_and(inside, cmp_lt(z, depth));
+                store(row[b].z, select(nearer, z, depth));
+                e0 = add(e0, step0);
+                e1 = add(e1, step1);
+                e2 = add(e2, step2);
+                z = add(z, step_z);
+            }
+        }
+    }
+
+    // Farthest depth in each tile of the row
+    const uint32_t blocks_per_tile = TILE_WIDTH / WIDTH;
+    const uint32_t tiles_x = width_ / TILE_WIDTH;
+    for(uint32_t tx = 0; tx < tiles_x; tx++)
+    {
+        vfloat m = set1(0.0f);
+        for(int32_t y = row_begin; y <= row_end; y++)
+        {
+            size_t            first = static_cast<size_t>(y) * row_blocks_ + tx * blocks_per_tile;
+            const DepthBlock *row = &depth_[first];
+            for(uint32_t b = 0; b < blocks_per_tile; b++) { m = max(m, load(row[b].z)); }
+        }
+        tile_max_[tile_row * tiles_x + tx] = horizontal_max(m);
+    }
+}
+
+bool OcclusionBuffer::is_occluded(const AABB &box, const Matrix4x4 &pvm) const
+{
+    if(box.is_empty()) { return false; }
+
+    // Screen rectangle and nearest depth of the box corners
+    float x_min = static_cast<float>(width_), x_max = 0.0f;
+    float y_min = static_cast<float>(height_), y_max = 0.0f;
+    float z_min = 1.0f;
+    for(uint32_t i = 0; i < 8; i++)
+    {
+        Point3 p((i & 1) ? box.max_point.x : box.min_point.x,
+                 (i & 2) ? box.max_point.y : box.min_point.y,
+                 (i & 4) ? box.max_point.z : box.min_point.z);
+        float c[4];
+        to_clip(pvm, p, c);
+
+        // Boxes crossing the near plane are treated as visible
+        if(c[3] <= MIN_W) { return false; }
+        float inv_w = 1.0f / c[3];
+        float sx = (c[0] * inv_w * 0.5f + 0.5f) * width_;
+        float sy = (c[1] * inv_w * 0.5f + 0.5f) * height_;
+        x_min = std::min(x_min, sx);
+        x_max = std::max(x_max, sx);
+        y_min = std::min(y_min, sy);
+        y_max = std::max(y_max, sy);
+        z_min = std::min(z_min, c[2] * inv_w * 0.5f + 0.5f);
+    }
+    z_min -= DEPTH_BIAS;
+    if(z_min <= 0.0f) { return false; }
+
+    // Pixels overlapped by the rectangle. Boxes off the screen are left to
+    // frustum culling.
+    const int32_t w = static_cast<int32_t>(width_);
+    const int32_t h = static_cast<int32_t>(height_);
+    int32_t       px0 = std::max(0, static_cast<int32_t>(std::floor(x_min)));
+    int32_t       px1 = std::min(w - 1, static_cast<int32_t>(std::floor(x_max)));
+    int32_t       py0 = std::max(0, static_cast<int32_t>(std::floor(y_min)));
+    int32_t       py1 = std::min(h - 1, static_cast<int32_t>(std::floor(y_max)));
+    if(px0 > px1 || py0 > py1) { return false; }
+
+    const int32_t tile_w = static_cast<int32_t>(TILE_WIDTH);
+    const int32_t tile_h = static_cast<int32_t>(TILE_HEIGHT);
+    const int32_t lane_count = static_cast<int32_t>(WIDTH);
+    const int32_t tiles_x = w / tile_w;
+    const vfloat  z = set1(z_min);
+    for(int32_t ty = py0 / tile_h; ty <= py1 / tile_h; ty++)
+    {
+        for(int32_t tx = px0 / tile_w; tx <= px1 / tile_w; tx++)
+        {
+            // Whole tile is nearer than the box
+            if(tile_max_[ty * tiles_x + tx] <= z_min) { continue; }
+
+            // Test the pixels of the rectangle within the tile
+            int32_t y0 = std::max(py0, ty * tile_h);
+            int32_t y1 = std::min(py1, (ty + 1) * tile_h - 1);
+            int32_t x0 = std::max(px0, tx * tile_w);
+            int32_t x1 = std::min(px1, (tx + 1) * tile_w - 1);
+            for(int32_t b = x0 / lane_count; b <= x1 / lane_count; b++)
+            {
+                // Lanes of this register that are within the rectangle
+                uint32_t lanes = (1u << WIDTH) - 1;
+                int32_t  first = b * lane_count;
+                if(x0 > first) { lanes &= ~((1u << (x0 - first)) - 1); }
+                if(x1 < first + lane_count - 1) { lanes &= (1u << (x1 - first + 1)) - 1; }
+                for(int32_t y = y0; y <= y1; y++)
+                {
+                    // Visible where the box is nearer than the occluders
+                    const DepthBlock &block = depth_[static_cast<size_t>(y) * row_blocks_ + b];
+                    if(lanes & movemask(cmp_lt(z, load(block.z)))) { return false; }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+void OcclusionBuffer::set_max_threads(uint32_t threads) { max_threads_ = threads; }
+
+uint32_t OcclusionBuffer::get_width() const { return width_; }
+
+uint32_t OcclusionBuffer::get_height() const { return height_; }
+
+float OcclusionBuffer::get_depth(uint32_t x, uint32_t y) const
+{
+    return depth_[static_cast<size_t>(y) * row_blocks_ + x / WIDTH].z[x % WIDTH];
+}
+
+size_t OcclusionBuffer::triangle_count() const { return triangles_.size(); }
+
+} // namespace cg
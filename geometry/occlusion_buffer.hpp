@@ -0,0 +1,176 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:  David W. Nesbitt
+//	File:    occlusion_buffer.hpp
+//	Purpose: Low resolution CPU depth buffer for occlusion culling.
+//           Occluder triangles are rasterized with SIMD, then bounding
+//           boxes are tested against it before they are drawn.
+//============================================================================
+
+#ifndef __GEOMETRY_OCCLUSION_BUFFER_HPP__
+#define __GEOMETRY_OCCLUSION_BUFFER_HPP__
+
+#include "geometry/aabb.hpp"
+#include "geometry/matrix.hpp"
+#include "geometry/point3.hpp"
+#include "geometry/simd.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace cg
+{
+
+/**
+ * Triangle mesh used as an occluder. Usually a copy (or a simplified
+ * version) of the positions and faces of a drawn mesh.
+ */
+struct OccluderMesh
+{
+    std::vector<Point3>   vertices;
+    std::vector<uint32_t> faces; // 3 indexes per triangle
+};
+
+/**
+ * Software occlusion buffer. Each frame:
+ *   1. clear()
+ *   2. add_occluder() for each occluder (transforms the triangles to screen)
+ *   3. rasterize() - fills the depth buffer
+ *   4. is_occluded() for each object before drawing it
+ *
+ * Depth is window z in [0,1] (0 at the near plane). The buffer is split
+ * into tiles of TILE_WIDTH x TILE_HEIGHT pixels. Each tile stores the
+ * farthest depth of its pixels, so a box behind that depth is occluded in
+ * the tile without testing pixels. Triangles are binned by the rows of
+ * tiles they overlap, and rows of tiles are rasterized in parallel.
+ *
+ * Runs entirely on the CPU, so it works with any GL driver. Occluders are
+ * rasterized at pixel centers with back faces culled (counter-clockwise
+ * triangles are front facing). Triangles crossing the near plane are skipped
+ * and boxes crossing it are never occluded, so results are conservative
+ * apart from pixel sampling at occluder edges.
+ */
+class OcclusionBuffer
+{
+  public:
+    static constexpr uint32_t TILE_WIDTH = 32;
+    static constexpr uint32_t TILE_HEIGHT = 8;
+
+    /**
+     * Constructor.
+     * @param  width   Width in pixels (rounded up to a multiple of TILE_WIDTH)
+     * @param  height  Height in pixels (rounded up to a multiple of TILE_HEIGHT)
+     */
+    OcclusionBuffer(uint32_t width = 256, uint32_t height = 128);
+
+    /**
+     * Change the resolution. Clears the buffer.
+     * @param  width   Width in pixels (rounded up to a multiple of TILE_WIDTH)
+     * @param  height  Height in pixels (rounded up to a multiple of TILE_HEIGHT)
+     */
+    void resize(uint32_t width, uint32_t height);
+
+    /**
+     * Remove all occluders and reset the depth to the far plane.
+     */
+    void clear();
+
+    /**
+     * Add the triangles of an occluder. They are drawn by the next call to
+     * rasterize.
+     * @param  mesh  Occluder mesh (modeling coordinates)
+     * @param  pvm   Composite projection, view, model matrix
+     */
+    void add_occluder(const OccluderMesh &mesh, const Matrix4x4 &pvm);
+
+    /**
+     * Rasterize the occluders added since the last clear and update the
+     * tile depths. Uses several threads when there are many triangles.
+     */
+    void rasterize();
+
+    /**
+     * Test whether a box is hidden behind the rasterized occluders.
+     * @param  box  Bounding box (modeling coordinates)
+     * @param  pvm  Composite projection, view, model matrix
+     * @return Returns true if no part of the box can be visible.
+     */
+    bool is_occluded(const AABB &box, const Matrix4x4 &pvm) const;
+
+    /**
+     * Limit the number of threads used by rasterize.
+     * @param  threads  Maximum number of threads (0 to use one per core).
+     */
+    void set_max_threads(uint32_t threads);
+
+    /**
+     * Get the width of the buffer.
+     * @return  Returns the width in pixels.
+     */
+    uint32_t get_width() const;
+
+    /**
+     * Get the height of the buffer.
+     * @return  Returns the height in pixels.
+     */
+    uint32_t get_height() const;
+
+    /**
+     * Get the depth of a pixel (after rasterize).
+     * @param  x  Pixel column (0 at the left)
+     * @param  y  Pixel row (0 at the bottom)
+     * @return  Returns the depth of the nearest occluder (1 if none).
+     */
+    float get_depth(uint32_t x, uint32_t y) const;
+
+    /**
+     * Get the number of occluder triangles added since the last clear
+     * (after near plane rejection).
+     * @return  Returns the number of triangles.
+     */
+    size_t triangle_count() const;
+
+  protected:
+    // Depth of WIDTH adjacent pixels in a row (aligned for SIMD loads)
+    struct DepthBlock
+    {
+        alignas(32) float z[simd::WIDTH];
+    };
+
+    // Occluder triangle in screen coordinates, set up for rasterization
+    struct ScreenTriangle
+    {
+        float   e[3][3]; // Edge functions A x + B y + C (positive inside)
+        float   z[3];    // Depth plane z0 + dzdx x + dzdy y
+        int32_t x_min, x_max;
+        int32_t y_min, y_max;
+    };
+
+    uint32_t                    width_;
+    uint32_t                    height_;
+    uint32_t                    row_blocks_;  // SIMD registers per row
+    uint32_t                    max_threads_; // 0 for one per core
+    std::vector<DepthBlock>     depth_;       // Pixel depth, rows from the bottom
+    std::vector<float>          tile_max_;    // Farthest depth in each tile
+    std::vector<ScreenTriangle> triangles_;
+    std::vector<uint32_t>       bin_start_;   // First entry of each tile row's bin
+    std::vector<uint32_t>       bins_;        // Triangles overlapping each tile row
+
+    /**
+     * Sort the triangles into bins by the rows of tiles they overlap.
+     */
+    void bin_triangles();
+
+    /**
+     * Rasterize the triangles binned to a row of tiles and update their depths.
+     * @param  tile_row  Tile row index
+     */
+    void rasterize_tile_row(uint32_t tile_row);
+};
+
+} // namespace cg
+
+#endif
@@ -0,0 +1,52 @@
+#include "geometry/radix_sort.hpp"
+
+#include <cstring>
+
+namespace cg
+{
+
+void radix_sort(SortItem *items, SortItem *scratch, size_t count)
+{
+    if(count < 2) { return; }
+
+    // Histogram all 8 bytes in one pass
+    uint32_t counts[8][256] = {};
+    for(size_t i = 0; i < count; i++)
+    {
+        uint64_t key = items[i].key;
+        for(uint32_t b = 0; b < 8; b++) { counts[b][(key >> (b * 8)) & 0xFF]++; }
+    }
+
+    SortItem *src = items;
+    SortItem *dst = scratch;
+    for(uint32_t b = 0; b < 8; b++)
+    {
+        // All keys share this byte, so the pass would not move anything
+        uint32_t *c = counts[b];
+        if(c[(src[0].key >> (b * 8)) & 0xFF] == count) { continue; }
+
+        uint32_t offset = 0;
+        for(uint32_t d = 0; d < 256; d++)
+        {
+            uint32_t n = c[d];
+            c[d] = offset;
+            offset += n;
+        }
+        for(size_t i = 0; i < count; i++) { dst[c[(src[i].key >> (b * 8)) & 0xFF]++] = src[i]; }
+
+        SortItem *tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    if(src != items) { std::memcpy(items, src, count * sizeof(SortItem)); }
+}
+
+uint32_t float_to_sortable(float f)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    return (bits & 0x80000000) ? ~bits : (bits | 0x80000000);
+}
+
+} // namespace cg
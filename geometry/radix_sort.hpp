@@ -0,0 +1,50 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:  David W. Nesbitt
+//	File:    radix_sort.hpp
+//	Purpose: Stable radix sort of 64 bit keys with an index payload, used
+//           to order draws by sort key.
+//============================================================================
+
+#ifndef __GEOMETRY_RADIX_SORT_HPP__
+#define __GEOMETRY_RADIX_SORT_HPP__
+
+#include <cstddef>
+#include <cstdint>
+
+namespace cg
+{
+
+/**
+ * Sort key and the index of the item it was built for.
+ */
+struct SortItem
+{
+    uint64_t key;
+    uint32_t index;
+};
+
+/**
+ * Sort items by key (least significant byte first, 8 bits per pass). The
+ * sort is stable, so items with equal keys keep their order. Passes over
+ * bytes that are the same in every key are skipped.
+ * @param  items    Items to sort (sorted in place)
+ * @param  scratch  Scratch space for count items
+ * @param  count    Number of items
+ */
+void radix_sort(SortItem *items, SortItem *scratch, size_t count);
+
+/**
+ * Convert a float to an unsigned integer with the same ordering (negative
+ * values first).
+ * @param  f  Value
+ * @return  Returns the order preserving bit pattern.
+ */
+uint32_t float_to_sortable(float f);
+
+} // namespace cg
+
+#endif
@@ -2,7 +2,9 @@
 
 #include "geometry/geometry.hpp"
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
 
 namespace cg
 {
@@ -86,8 +88,31 @@ RayObjectIntersectResult Ray3::intersect(const BoundingSphere &sphere) const
 
 RayObjectIntersectResult Ray3::intersect(const AABB &box) const
 {
-    // Required in 605.767
-    return {false, 0.0f};
+    // Slab method. Intersect the ray with the pair of planes bounding the box
+    // along each axis and keep the overlap of the parameter intervals.
+    const float o_a[3] = {o.x, o.y, o.z};
+    const float d_a[3] = {d.x, d.y, d.z};
+    const float mn[3] = {box.min_point.x, box.min_point.y, box.min_point.z};
+    const float mx[3] = {box.max_point.x, box.max_point.y, box.max_point.z};
+    float       t0 = 0.0f;
+    float       t1 = std::numeric_limits<float>::max();
+    for(uint32_t a = 0; a < 3; a++)
+    {
+        if(std::abs(d_a[a]) < EPSILON)
+        {
+            // Ray is parallel to the slab. No hit if the origin is outside it
+            if(o_a[a] < mn[a] || o_a[a] > mx[a]) { return {false, 0.0f}; }
+            continue;
+        }
+        float inv = 1.0f / d_a[a];
+        float t_near = (mn[a] - o_a[a]) * inv;
+        float t_far = (mx[a] - o_a[a]) * inv;
+        if(t_near > t_far) { std::swap(t_near, t_far); }
+        t0 = std::max(t0, t_near);
+        t1 = std::min(t1, t_far);
+        if(t0 > t1) { return {false, 0.0f}; }
+    }
+    return {true, t0};
 }
 
 RayObjectIntersectResult Ray3::intersect(const std::vector<Point3> &polygon,
@@ -100,38 +125,95 @@ RayObjectIntersectResult Ray3::intersect(const std::vector<Point3> &polygon,
 RayTriangleIntersectResult
     Ray3::intersect(const Point3 &v0, const Point3 &v1, const Point3 &v2) const
 {
-    // Required in 605.767
-    return {false, 0.0f, 0.0f, 0.0f};
+    // Solve o + t d = v0 + u e1 + v e2 by Cramer's rule (Moller-Trumbore)
+    // written in terms of the triangle normal n = e1 x e2. The range tests
+    // are done before dividing. simd::intersect_triangle uses the same
+    // operations so TriangleBatch and Ray3Packet give identical results.
+    Vector3 e1(v0, v1);
+    Vector3 e2(v0, v2);
+    Vector3 n = e1.cross(e2);
+    float   den = d.dot(n);
+    Vector3 s(v0, o);
+    Vector3 r = d.cross(s);
+
+    // Flip signs so den is positive. den = 0 if the ray is parallel to the
+    // triangle plane.
+    float sgn = (den < 0.0f) ? -1.0f : 1.0f;
+    float abs_den = den * sgn;
+    float u = e2.dot(r) * sgn;
+    float v = (0.0f - e1.dot(r)) * sgn;
+    float t = (0.0f - s.dot(n)) * sgn;
+    if(den == 0.0f || u < 0.0f || v < 0.0f || u + v > abs_den) { return {false, 0.0f, 0.0f, 0.0f}; }
+
+    // Intersections at (or just past) the ray origin are ignored so that rays
+    // leaving a surface do not hit it again
+    float inv = 1.0f / abs_den;
+    t = t * inv;
+    if(t <= EPSILON) { return {false, 0.0f, 0.0f, 0.0f}; }
+    return {true, t, u * inv, v * inv};
 }
 
 bool Ray3::does_intersect_exist(const Point3 &v0, const Point3 &v1, const Point3 &v2) const
 {
-    // Required in 605.767
-    return false;
+    return intersect(v0, v1, v2).intersects;
 }
 
 RayMeshIntersectResult Ray3::intersect(const std::vector<Point3>   &vertex_list,
                                        const std::vector<uint16_t> &face_list,
                                        float                        t_min) const
 {
-    // Required in 605.767
-    return {false, 0.0f, 0.0f, 0.0f, 0};
+    // Brute force test of the faces, SIZE at a time. Use MeshBVH for large
+    // meshes.
+    RayMeshIntersectResult result{false, t_min, 0.0f, 0.0f, 0};
+    TriangleBatch          batch;
+    for(size_t i = 0; i + 2 < face_list.size(); i += 3)
+    {
+        batch.add(vertex_list[face_list[i]], vertex_list[face_list[i + 1]],
+                  vertex_list[face_list[i + 2]], static_cast<uint32_t>(i / 3));
+        if(batch.count == TriangleBatch::SIZE)
+        {
+            batch.intersect(*this, result);
+            batch.clear();
+        }
+    }
+    if(batch.count > 0) { batch.intersect(*this, result); }
+    if(!result.intersects) { result.distance = 0.0f; }
+    return result;
+}
+
+template <typename V>
+static bool does_intersect_exist_brute_force(const Ray3                  &ray,
+                                             const std::vector<V>        &vertex_list,
+                                             const std::vector<uint16_t> &face_list,
+                                             float                        t_min)
+{
+    TriangleBatch batch;
+    for(size_t i = 0; i + 2 < face_list.size(); i += 3)
+    {
+        batch.add(vertex_position(vertex_list[face_list[i]]),
+                  vertex_position(vertex_list[face_list[i + 1]]),
+                  vertex_position(vertex_list[face_list[i + 2]]), static_cast<uint32_t>(i / 3));
+        if(batch.count == TriangleBatch::SIZE)
+        {
+            if(batch.does_intersect_exist(ray, t_min)) { return true; }
+            batch.clear();
+        }
+    }
+    return batch.count > 0 && batch.does_intersect_exist(ray, t_min);
 }
 
 bool Ray3::does_intersect_exist(const std::vector<Point3>   &vertex_list,
                                 const std::vector<uint16_t> &face_list,
                                 float                        t_min) const
 {
-    // Required in 605.767
-    return false;
+    return does_intersect_exist_brute_force(*this, vertex_list, face_list, t_min);
 }
 
 bool Ray3::does_intersect_exist(const std::vector<VertexAndNormal> &vertex_list,
                                 const std::vector<uint16_t>        &face_list,
                                 float                               t_min) const
 {
-    // Required in 605.767
-    return false;
+    return does_intersect_exist_brute_force(*this, vertex_list, face_list, t_min);
 }
 
 } // namespace cg
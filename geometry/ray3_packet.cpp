@@ -0,0 +1,151 @@
+#include "geometry/ray3_packet.hpp"
+
+#include "geometry/geometry.hpp"
+
+namespace cg
+{
+
+using namespace simd;
+
+Ray3Packet::Ray3Packet() { clear(); }
+
+void Ray3Packet::clear()
+{
+    // Inactive lanes hold a valid ray so that SIMD tests do not produce
+    // floating point exceptions
+    for(uint32_t i = 0; i < SIZE; i++) { set(i, Ray3(), 0.0f); }
+    active = 0;
+}
+
+void Ray3Packet::set(uint32_t lane, const Ray3 &ray, float t)
+{
+    ox[lane] = ray.o.x;
+    oy[lane] = ray.o.y;
+    oz[lane] = ray.o.z;
+    dx[lane] = ray.d.x;
+    dy[lane] = ray.d.y;
+    dz[lane] = ray.d.z;
+    inv_dx[lane] = 1.0f / ray.d.x;
+    inv_dy[lane] = 1.0f / ray.d.y;
+    inv_dz[lane] = 1.0f / ray.d.z;
+    t_max[lane] = t;
+    active |= 1u << lane;
+}
+
+Ray3 Ray3Packet::get(uint32_t lane) const
+{
+    return Ray3(Point3(ox[lane], oy[lane], oz[lane]), Vector3(dx[lane], dy[lane], dz[lane]));
+}
+
+uint32_t Ray3Packet::intersect(const AABB &box, float *distance) const
+{
+    const float bmin[3] = {box.min_point.x, box.min_point.y, box.min_point.z};
+    const float bmax[3] = {box.max_point.x, box.max_point.y, box.max_point.z};
+    alignas(32) float t_entry[SIZE];
+    uint32_t          hits = intersect_box(bmin, bmax, t_max, active, t_entry);
+    for(uint32_t i = 0; i < SIZE; i++) { distance[i] = (hits & (1u << i)) ? t_entry[i] : 0.0f; }
+    return hits;
+}
+
+uint32_t Ray3Packet::intersect(const BoundingSphere &sphere, float *distance) const
+{
+    // Same steps as Ray3::intersect(BoundingSphere), done for all lanes
+    vfloat lx = sub(set1(sphere.center.x), load(ox));
+    vfloat ly = sub(set1(sphere.center.y), load(oy));
+    vfloat lz = sub(set1(sphere.center.z), load(oz));
+    vfloat l2 = add(add(mul(lx, lx), mul(ly, ly)), mul(lz, lz));
+    vfloat s = add(add(mul(lx, load(dx)), mul(ly, load(dy))), mul(lz, load(dz)));
+    vfloat r2 = set1(sphere.radius * sphere.radius);
+    vfloat m2 = sub(l2, mul(s, s));
+
+    // Miss if the sphere is behind the origin (and the origin is outside the
+    // sphere) or if the ray passes outside the sphere
+    vfloat behind = logical_and(cmp_lt(s, set1(0.0f)), cmp_gt(l2, r2));
+    uint32_t hits = active & ~movemask(behind) & ~movemask(cmp_gt(m2, r2));
+
+    // Nearest intersection is s - q if the origin is outside the sphere,
+    // otherwise s + q
+    vfloat q = sqrt(max(sub(r2, m2), set1(0.0f)));
+    vfloat outside = cmp_gt(sub(l2, r2), set1(EPSILON));
+    vfloat t = select(outside, sub(s, q), add(s, q));
+    t = select(mask_from_bits(hits), t, set1(0.0f));
+
+    alignas(32) float result[SIZE];
+    store(result, t);
+    for(uint32_t i = 0; i < SIZE; i++) { distance[i] = result[i]; }
+    return hits;
+}
+
+uint32_t Ray3Packet::intersect_box(const float *bmin, const float *bmax, const float *t_limit,
+                                   uint32_t mask, float *t_entry) const
+{
+    // Slab test. Arguments to min and max are ordered so that a NaN (ray
+    // origin on a slab plane with a 0 direction component) is ignored.
+    vfloat t0 = set1(0.0f);
+    vfloat t1 = load(t_limit);
+
+    vfloat o = load(ox);
+    vfloat inv = load(inv_dx);
+    vfloat t_near = mul(sub(set1(bmin[0]), o), inv);
+    vfloat t_far = mul(sub(set1(bmax[0]), o), inv);
+    t0 = max(min(t_near, t_far), t0);
+    t1 = min(max(t_near, t_far), t1);
+
+    o = load(oy);
+    inv = load(inv_dy);
+    t_near = mul(sub(set1(bmin[1]), o), inv);
+    t_far = mul(sub(set1(bmax[1]), o), inv);
+    t0 = max(min(t_near, t_far), t0);
+    t1 = min(max(t_near, t_far), t1);
+
+    o = load(oz);
+    inv = load(inv_dz);
+    t_near = mul(sub(set1(bmin[2]), o), inv);
+    t_far = mul(sub(set1(bmax[2]), o), inv);
+    t0 = max(min(t_near, t_far), t0);
+    t1 = min(max(t_near, t_far), t1);
+
+    store(t_entry, t0);
+    return mask & movemask(cmp_le(t0, t1));
+}
+
+uint32_t Ray3Packet::intersect_triangle(const Point3 &v0, const Point3 &v1, const Point3 &v2,
+                                        uint32_t mask, float *t, float *u, float *v) const
+{
+    Vector3 e1(v0, v1);
+    Vector3 e2(v0, v2);
+    Vector3 n = e1.cross(e2);
+    return intersect_triangle(set1(v0.x, v0.y, v0.z), set1(e1.x, e1.y, e1.z), set1(e2.x, e2.y, e2.z),
+                              set1(n.x, n.y, n.z), mask, t, u, v);
+}
+
+uint32_t Ray3Packet::intersect_triangle(const TriangleBatch &batch, uint32_t index, uint32_t mask,
+                                        float *t, float *u, float *v) const
+{
+    return intersect_triangle(set1(batch.v0x[index], batch.v0y[index], batch.v0z[index]),
+                              set1(batch.e1x[index], batch.e1y[index], batch.e1z[index]),
+                              set1(batch.e2x[index], batch.e2y[index], batch.e2z[index]),
+                              set1(batch.nx[index], batch.ny[index], batch.nz[index]),
+                              mask, t, u, v);
+}
+
+uint32_t Ray3Packet::intersect_triangle(const vec3 &v0, const vec3 &e1, const vec3 &e2, const vec3 &n,
+                                        uint32_t mask, float *t, float *u, float *v) const
+{
+    // The triangle is common to all lanes. Closer than the current nearest
+    // intersection of each lane.
+    vfloat tt, uu, vv;
+    vfloat t_cur = load(t);
+    vfloat valid = simd::intersect_triangle(load(ox, oy, oz), load(dx, dy, dz), v0, e1, e2, n,
+                                            set1(EPSILON), tt, uu, vv);
+    uint32_t hits = mask & movemask(logical_and(valid, cmp_lt(tt, t_cur)));
+    if(hits == 0) { return 0; }
+
+    vfloat update = mask_from_bits(hits);
+    store(t, select(update, tt, t_cur));
+    store(u, select(update, uu, load(u)));
+    store(v, select(update, vv, load(v)));
+    return hits;
+}
+
+} // namespace cg
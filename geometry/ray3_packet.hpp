@@ -0,0 +1,146 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:  David W. Nesbitt
+//	File:    ray3_packet.hpp
+//	Purpose: Packet of rays stored as structure of arrays. Intersection
+//           methods test all rays in the packet at once using SIMD.
+//============================================================================
+
+#ifndef __GEOMETRY_RAY3_PACKET_HPP__
+#define __GEOMETRY_RAY3_PACKET_HPP__
+
+#include "geometry/aabb.hpp"
+#include "geometry/bounding_sphere.hpp"
+#include "geometry/ray3.hpp"
+#include "geometry/simd.hpp"
+#include "geometry/triangle_batch.hpp"
+
+#include <cstdint>
+
+namespace cg
+{
+
+/**
+ * Packet of SIZE rays (8 with AVX, otherwise 4). Each ray (lane) has an
+ * origin, direction, reciprocal direction (for slab tests) and maximum
+ * distance t_max. Only lanes set in the active mask take part in
+ * intersection tests; the methods return bit masks of the lanes that
+ * intersect. Coherent rays (neighboring pixels, shadow rays to one light)
+ * should be grouped into a packet so they visit the same BVH nodes.
+ *
+ * Per lane array arguments have SIZE elements. Arrays that are loaded or
+ * stored as SIMD registers (t_limit, t_entry, t, u, v) must be 32 byte aligned.
+ */
+struct Ray3Packet
+{
+    static constexpr uint32_t SIZE = simd::WIDTH;
+
+    alignas(32) float ox[SIZE];
+    alignas(32) float oy[SIZE];
+    alignas(32) float oz[SIZE];
+    alignas(32) float dx[SIZE];
+    alignas(32) float dy[SIZE];
+    alignas(32) float dz[SIZE];
+    alignas(32) float inv_dx[SIZE];
+    alignas(32) float inv_dy[SIZE];
+    alignas(32) float inv_dz[SIZE];
+    alignas(32) float t_max[SIZE];
+    uint32_t active; // Bit i is set if lane i holds a ray
+
+    /**
+     * Default constructor. All lanes are inactive.
+     */
+    Ray3Packet();
+
+    /**
+     * Make all lanes inactive.
+     */
+    void clear();
+
+    /**
+     * Set the ray in a lane and make the lane active.
+     * @param  lane   Lane index (0 to SIZE-1)
+     * @param  ray    Ray
+     * @param  t      Maximum distance along the ray.
+     */
+    void set(uint32_t lane, const Ray3 &ray, float t);
+
+    /**
+     * Get the ray in a lane.
+     * @param  lane  Lane index (0 to SIZE-1)
+     * @return Returns the ray.
+     */
+    Ray3 get(uint32_t lane) const;
+
+    /**
+     * Intersection of the active rays with an axis aligned bounding box.
+     * @param  box       AABB to test intersection with
+     * @param  distance  Returns the entry distance for each lane that
+     *                   intersects (0 if the origin is inside the box).
+     * @return Returns a mask of the lanes that intersect the box before t_max.
+     */
+    uint32_t intersect(const AABB &box, float *distance) const;
+
+    /**
+     * Intersection of the active rays with a sphere. Assumes unit length ray
+     * directions (same as Ray3::intersect).
+     * @param  sphere    Sphere to test intersection with
+     * @param  distance  Returns the distance for each lane that intersects.
+     * @return Returns a mask of the lanes that intersect the sphere.
+     */
+    uint32_t intersect(const BoundingSphere &sphere, float *distance) const;
+
+    /**
+     * Slab test of a set of lanes against a box given by its corners.
+     * @param  bmin     Minimum corner (x,y,z)
+     * @param  bmax     Maximum corner (x,y,z)
+     * @param  t_limit  Maximum distance for each lane
+     * @param  mask     Lanes to test
+     * @param  t_entry  Returns the entry distance for each lane (valid
+     *                  only for lanes that intersect)
+     * @return Returns a mask of the lanes that intersect the box before t_limit.
+     */
+    uint32_t intersect_box(const float *bmin, const float *bmax, const float *t_limit,
+                           uint32_t mask, float *t_entry) const;
+
+    /**
+     * Intersection of a set of lanes with a triangle (same test and results
+     * as Ray3::intersect). Lanes that intersect closer than their current
+     * distance t have t, u and v updated.
+     * @param  v0    Vertex 0 of the triangle
+     * @param  v1    Vertex 1 of the triangle
+     * @param  v2    Vertex 2 of the triangle
+     * @param  mask  Lanes to test
+     * @param  t     Current nearest distance of each lane (updated)
+     * @param  u     Barycentric coordinate (updated)
+     * @param  v     Barycentric coordinate (updated)
+     * @return Returns a mask of the lanes that were updated.
+     */
+    uint32_t intersect_triangle(const Point3 &v0, const Point3 &v1, const Point3 &v2,
+                                uint32_t mask, float *t, float *u, float *v) const;
+
+    /**
+     * Intersection of a set of lanes with one triangle of a triangle batch.
+     * Uses the precomputed edges and normal of the triangle.
+     * @param  batch  Triangle batch
+     * @param  index  Index of the triangle within the batch
+     * @param  mask   Lanes to test
+     * @param  t      Current nearest distance of each lane (updated)
+     * @param  u      Barycentric coordinate (updated)
+     * @param  v      Barycentric coordinate (updated)
+     * @return Returns a mask of the lanes that were updated.
+     */
+    uint32_t intersect_triangle(const TriangleBatch &batch, uint32_t index, uint32_t mask,
+                                float *t, float *u, float *v) const;
+
+  private:
+    uint32_t intersect_triangle(const simd::vec3 &v0, const simd::vec3 &e1, const simd::vec3 &e2,
+                                const simd::vec3 &n, uint32_t mask, float *t, float *u, float *v) const;
+};
+
+} // namespace cg
+
+#endif
@@ -0,0 +1,193 @@
+//============================================================================
+//	Johns Hopkins University Engineering for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+
+//	Author:  David W. Nesbitt
+//	File:    simd.hpp
+//	Purpose: Selects the SIMD instruction set used by geometry kernels.
+//           CG_SIMD_SSE is defined when SSE2 is available (all x86-64
+//           builds), CG_SIMD_AVX when the compiler targets AVX (for example
+//           with -DENABLE_AVX=ON). Define CG_NO_SIMD to force scalar code.
+//============================================================================
+
+#ifndef __GEOMETRY_SIMD_HPP__
+#define __GEOMETRY_SIMD_HPP__
+
+#include <cmath>
+#include <cstring>
+
+#if !defined(CG_NO_SIMD)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CG_SIMD_SSE 1
+#include <emmintrin.h>
+#endif
+#if defined(CG_SIMD_SSE) && defined(__AVX__)
+#define CG_SIMD_AVX 1
+#include <immintrin.h>
+#endif
+#endif
+
+#include <cstdint>
+
+namespace cg
+{
+
+/**
+ * Minimal wrappers over SIMD registers used by the ray packet and triangle
+ * kernels. WIDTH is the number of float lanes (8 with AVX, otherwise 4).
+ * Comparisons return lane masks (all bits set where true) that can be
+ * combined with the logical operations, tested with movemask and used with
+ * select. Without SIMD the same operations are done on a plain float array.
+ */
+namespace simd
+{
+
+#if defined(CG_SIMD_AVX)
+constexpr uint32_t WIDTH = 8;
+using vfloat = __m256;
+
+inline vfloat load(const float *p) { return _mm256_load_ps(p); }
+inline void   store(float *p, vfloat a) { _mm256_store_ps(p, a); }
+inline vfloat set1(float a) { return _mm256_set1_ps(a); }
+inline vfloat add(vfloat a, vfloat b) { return _mm256_add_ps(a, b); }
+inline vfloat sub(vfloat a, vfloat b) { return _mm256_sub_ps(a, b); }
+inline vfloat mul(vfloat a, vfloat b) { return _mm256_mul_ps(a, b); }
+inline vfloat div(vfloat a, vfloat b) { return _mm256_div_ps(a, b); }
+inline vfloat min(vfloat a, vfloat b) { return _mm256_min_ps(a, b); }
+inline vfloat max(vfloat a, vfloat b) { return _mm256_max_ps(a, b); }
+inline vfloat sqrt(vfloat a) { return _mm256_sqrt_ps(a); }
+inline vfloat cmp_lt(vfloat a, vfloat b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+inline vfloat cmp_le(vfloat a, vfloat b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+inline vfloat cmp_gt(vfloat a, vfloat b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+inline vfloat cmp_ge(vfloat a, vfloat b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+inline vfloat cmp_neq(vfloat a, vfloat b) { return _mm256_cmp_ps(a, b, _CMP_NEQ_UQ); }
+inline vfloat logical_and(vfloat a, vfloat b) { return _mm256_and_ps(a, b); }
+inline vfloat logical_or(vfloat a, vfloat b) { return _mm256_or_ps(a, b); }
+inline vfloat select(vfloat mask, vfloat a, vfloat b) { return _mm256_blendv_ps(b, a, mask); }
+inline uint32_t movemask(vfloat a) { return static_cast<uint32_t>(_mm256_movemask_ps(a)); }
+inline vfloat   mask_from_bits(uint32_t bits)
+{
+    auto lane = [bits](uint32_t i) { return -static_cast<int>((bits >> i) & 1); };
+    return _mm256_castsi256_ps(
+        _mm256_setr_epi32(lane(0), lane(1), lane(2), lane(3), lane(4), lane(5), lane(6), lane(7)));
+}
+#elif defined(CG_SIMD_SSE)
+constexpr uint32_t WIDTH = 4;
+using vfloat = __m128;
+
+inline vfloat load(const float *p) { return _mm_load_ps(p); }
+inline void   store(float *p, vfloat a) { _mm_store_ps(p, a); }
+inline vfloat set1(float a) { return _mm_set1_ps(a); }
+inline vfloat add(vfloat a, vfloat b) { return _mm_add_ps(a, b); }
+inline vfloat sub(vfloat a, vfloat b) { return _mm_sub_ps(a, b); }
+inline vfloat mul(vfloat a, vfloat b) { return _mm_mul_ps(a, b); }
+inline vfloat div(vfloat a, vfloat b) { return _mm_div_ps(a, b); }
+inline vfloat min(vfloat a, vfloat b) { return _mm_min_ps(a, b); }
+inline vfloat max(vfloat a, vfloat b) { return _mm_max_ps(a, b); }
+inline vfloat sqrt(vfloat a) { return _mm_sqrt_ps(a); }
+inline vfloat cmp_lt(vfloat a, vfloat b) { return _mm_cmplt_ps(a, b); }
+inline vfloat cmp_le(vfloat a, vfloat b) { return _mm_cmple_ps(a, b); }
+inline vfloat cmp_gt(vfloat a, vfloat b) { return _mm_cmpgt_ps(a, b); }
+inline vfloat cmp_ge(vfloat a, vfloat b) { return _mm_cmpge_ps(a, b); }
+inline vfloat cmp_neq(vfloat a, vfloat b) { return _mm_cmpneq_ps(a, b); }
+inline vfloat logical_and(vfloat a, vfloat b) { return _mm_and_ps(a, b); }
+inline vfloat logical_or(vfloat a, vfloat b) { return _mm_or_ps(a, b); }
+inline vfloat select(vfloat mask, vfloat a, vfloat b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+inline uint32_t movemask(vfloat a) { return static_cast<uint32_t>(_mm_movemask_ps(a)); }
+inline vfloat   mask_from_bits(uint32_t bits)
+{
+    const __m128i lane_bits = _mm_setr_epi32(1, 2, 4, 8);
+    __m128i       b = _mm_and_si128(_mm_set1_epi32(static_cast<int>(bits)), lane_bits);
+    return _mm_castsi128_ps(_mm_cmpeq_epi32(b, lane_bits));
+}
+#else
+constexpr uint32_t WIDTH = 4;
+struct vfloat
+{
+    float f[WIDTH];
+};
+
+// Lane masks are stored as floats with all bits set (true) or 0.0 (false)
+inline float mask_value(bool b)
+{
+    uint32_t bits = b ? 0xFFFFFFFFu : 0u;
+    float    f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+inline bool lane_set(float f)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(f));
+    return bits != 0;
+}
+
+#define CG_SIMD_LANES(expr)                                                                        \
+    vfloat r;                                                                                      \
+    for(uint32_t i = 0; i < WIDTH; i++) { r.f[i] = (expr); }                                       \
+    return r
+
+inline vfloat load(const float *p) { CG_SIMD_LANES(p[i]); }
+inline void   store(float *p, vfloat a)
+{
+    for(uint32_t i = 0; i < WIDTH; i++) { p[i] = a.f[i]; }
+}
+inline vfloat set1(float a) { CG_SIMD_LANES(a); }
+inline vfloat add(vfloat a, vfloat b) { CG_SIMD_LANES(a.f[i] + b.f[i]); }
+inline vfloat sub(vfloat a, vfloat b) { CG_SIMD_LANES(a.f[i] - b.f[i]); }
+inline vfloat mul(vfloat a, vfloat b) { CG_SIMD_LANES(a.f[i] * b.f[i]); }
+inline vfloat div(vfloat a, vfloat b) { CG_SIMD_LANES(a.f[i] / b.f[i]); }
+inline vfloat min(vfloat a, vfloat b) { CG_SIMD_LANES(a.f[i] < b.f[i] ? a.f[i] : b.f[i]); }
+inline vfloat max(vfloat a, vfloat b) { CG_SIMD_LANES(a.f[i] > b.f[i] ? a.f[i] : b.f[i]); }
+inline vfloat sqrt(vfloat a) { CG_SIMD_LANES(std::sqrt(a.f[i])); }
+inline vfloat cmp_lt(vfloat a, vfloat b) { CG_SIMD_LANES(mask_value(a.f[i] < b.f[i])); }
+inline vfloat cmp_le(vfloat a, vfloat b) { CG_SIMD_LANES(mask_value(a.f[i] <= b.f[i])); }
+inline vfloat cmp_gt(vfloat a, vfloat b) { CG_SIMD_LANES(mask_value(a.f[i] > b.f[i])); }
+inline vfloat cmp_ge(vfloat a, vfloat b) { CG_SIMD_LANES(mask_value(a.f[i] >= b.f[i])); }
+inline vfloat cmp_neq(vfloat a, vfloat b) { CG_SIMD_LANES(mask_value(a.f[i] != b.f[i])); }
+inline vfloat logical_and(vfloat a, vfloat b) { CG_SIMD_LANES(mask_value(lane_set(a.f[i]) && lane_set(b.f[i]))); }
+inline vfloat logical_or(vfloat a, vfloat b) { CG_SIMD_LANES(mask_value(lane_set(a.f[i]) || lane_set(b.f[i]))); }
+inline vfloat select(vfloat mask, vfloat a, vfloat b) { CG_SIMD_LANES(lane_set(mask.f[i]) ? a.f[i] : b.f[i]); }
+inline vfloat mask_from_bits(uint32_t bits) { CG_SIMD_LANES(mask_value((bits >> i) & 1)); }
+inline uint32_t movemask(vfloat a)
+{
+    uint32_t bits = 0;
+    for(uint32_t i = 0; i < WIDTH; i++) { bits |= lane_set(a.f[i]) ? (1u << i) : 0u; }
+    return bits;
+}
+
+#undef CG_SIMD_LANES
+#endif
+
+/**
+ * 3 component vector with one vector per lane.
+ */
+struct vec3
+{
+    vfloat x;
+    vfloat y;
+    vfloat z;
+};
+
+inline vec3 set1(float x, float y, float z) { return {set1(x), set1(y), set1(z)}; }
+inline vec3 load(const float *x, const float *y, const float *z) { return {load(x), load(y), load(z)}; }
+inline vec3 sub(const vec3 &a, const vec3 &b) { return {sub(a.x, b.x), sub(a.y, b.y), sub(a.z, b.z)}; }
+
+// Same order of operations as Vector3::dot and Vector3::cross
+inline vfloat dot(const vec3 &a, const vec3 &b)
+{
+    return add(add(mul(a.x, b.x), mul(a.y, b.y)), mul(a.z, b.z));
+}
+inline vec3 cross(const vec3 &a, const vec3 &b)
+{
+    return {sub(mul(a.y, b.z), mul(a.z, b.y)), sub(mul(a.z, b.x), mul(a.x, b.z)), sub(mul(a.x, b.y), mul(a.y, b.x))};
+}
+
+} // namespace simd
+} // namespace cg
+
+#endif
@@ -0,0 +1,91 @@
+#include "geometry/triangle_batch.hpp"
+
+#include "geometry/geometry.hpp"
+
+namespace cg
+{
+
+using namespace simd;
+
+TriangleBatch::TriangleBatch() { clear(); }
+
+void TriangleBatch::clear()
+{
+    // Zero all lanes so unused lanes have a zero normal (never intersect)
+    for(float *a : {v0x, v0y, v0z, e1x, e1y, e1z, e2x, e2y, e2z, nx, ny, nz})
+    {
+        for(uint32_t i = 0; i < SIZE; i++) { a[i] = 0.0f; }
+    }
+    for(uint32_t i = 0; i < SIZE; i++) { face[i] = 0; }
+    count = 0;
+}
+
+void TriangleBatch::add(const Point3 &v0, const Point3 &v1, const Point3 &v2, uint32_t face_index)
+{
+    Vector3 e1(v0, v1);
+    Vector3 e2(v0, v2);
+    Vector3 n = e1.cross(e2);
+    v0x[count] = v0.x;
+    v0y[count] = v0.y;
+    v0z[count] = v0.z;
+    e1x[count] = e1.x;
+    e1y[count] = e1.y;
+    e1z[count] = e1.z;
+    e2x[count] = e2.x;
+    e2y[count] = e2.y;
+    e2z[count] = e2.z;
+    nx[count] = n.x;
+    ny[count] = n.y;
+    nz[count] = n.z;
+    face[count] = face_index;
+    count++;
+}
+
+bool TriangleBatch::intersect(const Ray3 &ray, RayMeshIntersectResult &result) const
+{
+    vfloat t, u, v;
+    vfloat valid = intersect_triangle(set1(ray.o.x, ray.o.y, ray.o.z),
+                                      set1(ray.d.x, ray.d.y, ray.d.z),
+                                      load(v0x, v0y, v0z),
+                                      load(e1x, e1y, e1z),
+                                      load(e2x, e2y, e2z),
+                                      load(nx, ny, nz),
+                                      set1(EPSILON),
+                                      t,
+                                      u,
+                                      v);
+    uint32_t hits = movemask(logical_and(valid, cmp_lt(t, set1(result.distance))));
+    if(hits == 0) { return false; }
+
+    // Nearest of the lanes that intersect. Ties go to the first lane (the
+    // face that comes first in the face list).
+    alignas(32) float ts[SIZE];
+    alignas(32) float us[SIZE];
+    alignas(32) float vs[SIZE];
+    store(ts, t);
+    store(us, u);
+    store(vs, v);
+    for(uint32_t i = 0; hits != 0; i++, hits >>= 1)
+    {
+        if((hits & 1u) && ts[i] < result.distance) { result = {true, ts[i], us[i], vs[i], face[i]}; }
+    }
+    return true;
+}
+
+bool TriangleBatch::does_intersect_exist(const Ray3 &ray, float t_min) const
+{
+    vfloat t, u, v;
+    vfloat valid = intersect_triangle(set1(ray.o.x, ray.o.y, ray.o.z),
+                                      set1(ray.d.x, ray.d.y, ray.d.z),
+                                      load(v0x, v0y, v0z),
+                                      load(e1x, e1y, e1z),
+                                      load(e2x, e2y, e2z),
+                                      load(nx, ny, nz),
+                                      set1(EPSILON),
+                                      t,
+                                      u,
+                                      v);
+    return movemask(logical_and(valid, cmp_lt(t, set1(t_min)))) != 0;
+}
+
+} // namespace cg
@@ -0,0 +1,175 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:  David W. Nesbitt
+//	File:    triangle_batch.hpp
+//	Purpose: Groups of triangles precomputed for SIMD ray intersection.
+//============================================================================
+
+#ifndef __GEOMETRY_TRIANGLE_BATCH_HPP__
+#define __GEOMETRY_TRIANGLE_BATCH_HPP__
+
+#include "geometry/ray3.hpp"
+#include "geometry/simd.hpp"
+#include "geometry/types.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace cg
+{
+
+/**
+ * SIZE triangles (8 with AVX, otherwise 4) stored as structure of arrays
+ * for testing one ray against all of them at once. Each triangle is stored
+ * as its first vertex, the 2 edges from it and the (unnormalized) normal
+ * e1 x e2, so no per-ray work is repeated per triangle. Unused lanes have a
+ * zero normal and never intersect.
+ */
+struct TriangleBatch
+{
+    static constexpr uint32_t SIZE = simd::WIDTH;
+
+    alignas(32) float v0x[SIZE];
+    alignas(32) float v0y[SIZE];
+    alignas(32) float v0z[SIZE];
+    alignas(32) float e1x[SIZE];
+    alignas(32) float e1y[SIZE];
+    alignas(32) float e1z[SIZE];
+    alignas(32) float e2x[SIZE];
+    alignas(32) float e2y[SIZE];
+    alignas(32) float e2z[SIZE];
+    alignas(32) float nx[SIZE];
+    alignas(32) float ny[SIZE];
+    alignas(32) float nz[SIZE];
+    uint32_t          face[SIZE]; // Face index of each triangle
+    uint32_t          count;      // Number of triangles in the batch
+
+    /**
+     * Constructor. Creates an empty batch.
+     */
+    TriangleBatch();
+
+    /**
+     * Remove all triangles.
+     */
+    void clear();
+
+    /**
+     * Add a triangle to the batch (count must be less than SIZE).
+     * @param  v0          Vertex 0 of the triangle
+     * @param  v1          Vertex 1 of the triangle
+     * @param  v2          Vertex 2 of the triangle
+     * @param  face_index  Face index reported when the triangle is intersected.
+     */
+    void add(const Point3 &v0, const Point3 &v1, const Point3 &v2, uint32_t face_index);
+
+    /**
+     * Find the nearest intersection of a ray with the triangles in the batch.
+     * @param  ray     Ray to intersect.
+     * @param  result  Nearest intersection so far. result.distance is the
+     *                 current minimum intersection value; the result is
+     *                 replaced if a nearer intersection is found.
+     * @return Returns true if the result was updated.
+     */
+    bool intersect(const Ray3 &ray, RayMeshIntersectResult &result) const;
+
+    /**
+     * Does an intersection exist between the ray and any triangle in the
+     * batch, prior to t_min.
+     * @param  ray    Ray to intersect.
+     * @param  t_min  t value for intersection.
+     * @return Returns true if an intersection exists, false if not.
+     */
+    bool does_intersect_exist(const Ray3 &ray, float t_min) const;
+};
+
+/**
+ * Get the position of a vertex. Lets mesh queries read positions directly
+ * from any of the vertex lists used by TriSurface.
+ */
+inline const Point3 &vertex_position(const Point3 &v) { return v; }
+inline const Point3 &vertex_position(const VertexAndNormal &v) { return v.vertex; }
+inline const Point3 &vertex_position(const VertexNormalTexture &v) { return v.vertex; }
+inline const Point3 &vertex_position(const VertexNormalTextureTangent &v) { return v.vertex; }
+
+/**
+ * Form triangle batches from a vertex list and face list. Faces are packed
+ * in order, SIZE per batch.
+ * @param  vertex_list  Vertex list (Point3 or a vertex structure in types.hpp)
+ * @param  face_list    Face index list (16 or 32 bit, 3 indexes per face)
+ * @param  batches      Returns the triangle batches.
+ */
+template <typename V, typename I>
+void build_triangle_batches(const std::vector<V>       &vertex_list,
+                            const std::vector<I>       &face_list,
+                            std::vector<TriangleBatch> &batches)
+{
+    batches.clear();
+    for(size_t i = 0; i + 2 < face_list.size(); i += 3)
+    {
+        if(batches.empty() || batches.back().count == TriangleBatch::SIZE) { batches.emplace_back(); }
+        batches.back().add(vertex_position(vertex_list[face_list[i]]),
+                           vertex_position(vertex_list[face_list[i + 1]]),
+                           vertex_position(vertex_list[face_list[i + 2]]),
+                           static_cast<uint32_t>(i / 3));
+    }
+}
+
+namespace simd
+{
+
+/**
+ * Ray-triangle intersection for all lanes. Each lane may hold a different
+ * ray, a different triangle, or both. Solves o + t d = v0 + u e1 + v e2
+ * using the triangle normal n = e1 x e2 (Cramer's rule, as in
+ * Moller-Trumbore) with the barycentric range tests done before dividing.
+ * Ray3::intersect uses the same operations so scalar and SIMD results agree.
+ * @param  o      Ray origin
+ * @param  d      Ray direction
+ * @param  v0     Triangle vertex 0
+ * @param  e1     Edge v1 - v0
+ * @param  e2     Edge v2 - v0
+ * @param  n      e1 x e2
+ * @param  t_min  Intersections at or before this distance are ignored (so
+ *                rays leaving a surface do not hit it again)
+ * @param  t      Returns the distance along the ray
+ * @param  u      Returns the barycentric coordinate (weight of v1)
+ * @param  v      Returns the barycentric coordinate (weight of v2)
+ * @return Returns a mask of the lanes that intersect at t > t_min.
+ */
+inline vfloat intersect_triangle(const vec3 &o, const vec3 &d, const vec3 &v0, const vec3 &e1,
+                                 const vec3 &e2, const vec3 &n, vfloat t_min,
+                                 vfloat &t, vfloat &u, vfloat &v)
+{
+    const vfloat zero = set1(0.0f);
+
+    // den = 0 if the ray is parallel to the triangle plane
+    vfloat den = dot(d, n);
+    vec3   s = sub(o, v0);
+    vec3   r = cross(d, s);
+
+    // Scaled barycentrics and distance. Flip signs so den is positive and
+    // the range tests need no division.
+    vfloat sgn = select(cmp_lt(den, zero), set1(-1.0f), set1(1.0f));
+    vfloat abs_den = mul(den, sgn);
+    vfloat uu = mul(dot(e2, r), sgn);
+    vfloat vv = mul(sub(zero, dot(e1, r)), sgn);
+    vfloat tt = mul(sub(zero, dot(s, n)), sgn);
+    vfloat valid = logical_and(cmp_neq(den, zero), logical_and(cmp_ge(uu, zero), cmp_ge(vv, zero)));
+    valid = logical_and(valid, cmp_le(add(uu, vv), abs_den));
+
+    vfloat inv = div(set1(1.0f), abs_den);
+    t = mul(tt, inv);
+    u = mul(uu, inv);
+    v = mul(vv, inv);
+    return logical_and(valid, cmp_gt(t, t_min));
+}
+
+} // namespace simd
+
+} // namespace cg
+
+#endif
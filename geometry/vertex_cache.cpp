@@ -0,0 +1,283 @@
+#include "geometry/vertex_cache.hpp"
+#include "geometry/vector3.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+
+namespace cg
+{
+
+namespace
+{
+
+// FIFO post-transform cache. A vertex is in the cache if fewer than
+// cache_size vertices were added since it was.
+class FifoCache
+{
+  public:
+    FifoCache(uint32_t vertex_count, uint32_t cache_size) :
+        stamps_(vertex_count, 0), cache_size_(cache_size), time_(cache_size + 1)
+    {
+    }
+
+    // Returns 1 if the vertex had to be transformed (and adds it)
+    uint32_t use(uint32_t v)
+    {
+        if(time_ - stamps_[v] <= cache_size_) { return 0; }
+        stamps_[v] = time_++;
+        return 1;
+    }
+
+    // Remove every vertex from the cache
+    void flush() { time_ += cache_size_ + 1; }
+
+  private:
+    std::vector<uint32_t> stamps_;
+    uint32_t              cache_size_;
+    uint32_t              time_;
+};
+
+template <typename I>
+float acmr(const std::vector<I> &faces, uint32_t vertex_count, uint32_t cache_size)
+{
+    size_t tri_count = faces.size() / 3;
+    if(tri_count == 0) { return 0.0f; }
+    FifoCache cache(vertex_count, cache_size);
+    size_t    misses = 0;
+    for(size_t i = 0; i < tri_count * 3; i++) { misses += cache.use(faces[i]); }
+    return static_cast<float>(misses) / static_cast<float>(tri_count);
+}
+
+// Cross product of two triangle edges (length is twice the area)
+Vector3 face_normal(const std::vector<Point3> &positions, const uint32_t *face)
+{
+    Vector3 e1(positions[face[0]], positions[face[1]]);
+    Vector3 e2(positions[face[0]], positions[face[2]]);
+    return e1.cross(e2);
+}
+
+// Area weighted center of triangles [first, last)
+Vector3 area_center(const std::vector<Point3>   &positions,
+                    const std::vector<uint32_t> &faces,
+                    size_t                       first,
+                    size_t                       last)
+{
+    Vector3 weighted(0.0f, 0.0f, 0.0f);
+    Vector3 unweighted(0.0f, 0.0f, 0.0f);
+    float   total_area = 0.0f;
+    for(size_t t = first; t < last; t++)
+    {
+        const uint32_t *face = &faces[t * 3];
+        float           area = face_normal(positions, face).norm();
+        for(uint32_t c = 0; c < 3; c++)
+        {
+            Vector3 v(positions[face[c]]);
+            weighted += v * area;
+            unweighted += v;
+        }
+        total_area += area;
+    }
+    if(total_area > 0.0f) { return weighted * (1.0f / (3.0f * total_area)); }
+    return unweighted * (1.0f / (3.0f * static_cast<float>(last - first)));
+}
+
+} // namespace
+
+float compute_acmr(const std::vector<uint16_t> &faces, uint32_t vertex_count, uint32_t cache_size)
+{
+    return acmr(faces, vertex_count, cache_size);
+}
+
+float compute_acmr(const std::vector<uint32_t> &faces, uint32_t vertex_count, uint32_t cache_size)
+{
+    return acmr(faces, vertex_count, cache_size);
+}
+
+void optimize_vertex_cache(std::vector<uint32_t> &faces, uint32_t vertex_count, uint32_t cache_size)
+{
+    size_t tri_count = faces.size() / 3;
+    if(tri_count == 0 || vertex_count == 0) { return; }
+
+    // Triangles using each vertex, as one list with per vertex offsets
+    std::vector<uint32_t> offsets(vertex_count + 1, 0);
+    for(size_t i = 0; i < tri_count * 3; i++) { offsets[faces[i] + 1]++; }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    std::vector<uint32_t> adjacency(tri_count * 3);
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for(size_t i = 0; i < tri_count * 3; i++)
+    {
+        adjacency[fill[faces[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    // Triangles not yet emitted that use each vertex
+    std::vector<uint32_t> live(vertex_count);
+    for(uint32_t v = 0; v < vertex_count; v++) { live[v] = offsets[v + 1] - offsets[v]; }
+
+    std::vector<uint32_t> stamps(vertex_count, 0);
+    std::vector<uint8_t>  emitted(tri_count, 0);
+    std::vector<uint32_t> dead_end;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> out;
+    dead_end.reserve(tri_count * 3);
+    out.reserve(tri_count * 3);
+
+    uint32_t time = cache_size + 1;
+    uint32_t cursor = 0;
+    int64_t  fan = 0;
+    while(fan >= 0)
+    {
+        // Emit the remaining triangles around the fanning vertex
+        candidates.clear();
+        for(uint32_t k = offsets[fan]; k < offsets[fan + 1]; k++)
+        {
+            uint32_t t = adjacency[k];
+            if(emitted[t]) { continue; }
+            for(uint32_t c = 0; c < 3; c++)
+            {
+                uint32_t v = faces[t * 3 + c];
+                out.push_back(v);
+                dead_end.push_back(v);
+                candidates.push_back(v);
+                live[v]--;
+                if(time - stamps[v] > cache_size) { stamps[v] = time++; }
+            }
+            emitted[t] = 1;
+        }
+
+        // Next fan around the oldest candidate that will still be in the
+        // cache once its triangles are emitted, else any with triangles left
+        fan = -1;
+        int64_t best = -1;
+        for(uint32_t v : candidates)
+        {
+            if(live[v] == 0) { continue; }
+            int64_t priority = 0;
+            if(time - stamps[v] + 2 * live[v] <= cache_size) { priority = time - stamps[v]; }
+            if(priority > best)
+            {
+                best = priority;
+                fan = v;
+            }
+        }
+
+        // Dead end: go back to a recently used vertex, else the next unused
+        // vertex in order
+        while(fan < 0 && !dead_end.empty())
+        {
+            uint32_t v = dead_end.back();
+            dead_end.pop_back();
+            if(live[v] > 0) { fan = v; }
+        }
+        while(fan < 0 && cursor < vertex_count)
+        {
+            if(live[cursor] > 0) { fan = cursor; }
+            else { cursor++; }
+        }
+    }
+    std::copy(out.begin(), out.end(), faces.begin());
+}
+
+void optimize_overdraw(std::vector<uint32_t>     &faces,
+                       const std::vector<Point3> &positions,
+                       uint32_t                   cache_size,
+                       float                      threshold)
+{
+    size_t tri_count = faces.size() / 3;
+    if(tri_count < 2) { return; }
+    uint32_t vertex_count = static_cast<uint32_t>(positions.size());
+
+    // Hard boundaries: triangles whose vertices all miss the cache
+    std::vector<uint32_t> misses(tri_count);
+    std::vector<size_t>   hard;
+    FifoCache             cache(vertex_count, cache_size);
+    for(size_t t = 0; t < tri_count; t++)
+    {
+        misses[t] = cache.use(faces[t * 3]) + cache.use(faces[t * 3 + 1]) +
+                    cache.use(faces[t * 3 + 2]);
+        if(t == 0 || misses[t] == 3) { hard.push_back(t); }
+    }
+    hard.push_back(tri_count);
+
+    // Soft boundaries: split a cluster (flushing the cache) once the part so
+    // far is about as cache friendly as the whole cluster
+    std::vector<size_t> clusters;
+    FifoCache           split_cache(vertex_count, cache_size);
+    for(size_t h = 0; h + 1 < hard.size(); h++)
+    {
+        size_t   first = hard[h];
+        size_t   last = hard[h + 1];
+        uint32_t cluster_misses = 0;
+        for(size_t t = first; t < last; t++) { cluster_misses += misses[t]; }
+        float limit = threshold * static_cast<float>(cluster_misses) / (last - first);
+
+        split_cache.flush();
+        clusters.push_back(first);
+        size_t   start = first;
+        uint32_t running = 0;
+        for(size_t t = first; t < last; t++)
+        {
+            for(uint32_t c = 0; c < 3; c++) { running += split_cache.use(faces[t * 3 + c]); }
+            if(t + 1 < last && static_cast<float>(running) / (t - start + 1) <= limit)
+            {
+                split_cache.flush();
+                clusters.push_back(t + 1);
+                start = t + 1;
+                running = 0;
+            }
+        }
+    }
+    clusters.push_back(tri_count);
+
+    // Sort clusters facing away from the center of the mesh first: they are
+    // the most likely to hide the rest
+    Vector3              mesh_center = area_center(positions, faces, 0, tri_count);
+    size_t               cluster_count = clusters.size() - 1;
+    std::vector<float>   sort_keys(cluster_count);
+    std::vector<size_t>  order(cluster_count);
+    for(size_t c = 0; c < cluster_count; c++)
+    {
+        Vector3 normal(0.0f, 0.0f, 0.0f);
+        for(size_t t = clusters[c]; t < clusters[c + 1]; t++)
+        {
+            normal += face_normal(positions, &faces[t * 3]);
+        }
+        float length = normal.norm();
+        if(length > 0.0f) { normal *= 1.0f / length; }
+        Vector3 center = area_center(positions, faces, clusters[c], clusters[c + 1]);
+        sort_keys[c] = (center - mesh_center).dot(normal);
+        order[c] = c;
+    }
+    std::stable_sort(order.begin(),
+                     order.end(),
+                     [&sort_keys](size_t a, size_t b) { return sort_keys[a] > sort_keys[b]; });
+
+    std::vector<uint32_t> out;
+    out.reserve(tri_count * 3);
+    for(size_t c : order)
+    {
+        out.insert(out.end(), faces.begin() + clusters[c] * 3, faces.begin() + clusters[c + 1] * 3);
+    }
+    std::copy(out.begin(), out.end(), faces.begin());
+}
+
+void optimize_vertex_fetch(std::vector<uint32_t> &faces,
+                           uint32_t               vertex_count,
+                           std::vector<uint32_t> &remap)
+{
+    remap.assign(vertex_count, UINT32_MAX);
+    uint32_t next = 0;
+    for(auto &i : faces)
+    {
+        if(remap[i] == UINT32_MAX) { remap[i] = next++; }
+        i = remap[i];
+    }
+    for(auto &r : remap)
+    {
+        if(r == UINT32_MAX) { r = next++; }
+    }
+}
+
+} // namespace cg
@@ -0,0 +1,104 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:  David W. Nesbitt
+//	File:    vertex_cache.hpp
+//	Purpose: Triangle and vertex reordering for the post-transform vertex
+//           cache, overdraw, and vertex fetch locality.
+//============================================================================
+
+#ifndef __GEOMETRY_VERTEX_CACHE_HPP__
+#define __GEOMETRY_VERTEX_CACHE_HPP__
+
+#include "geometry/point3.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace cg
+{
+
+// Post-transform cache size assumed when reordering and measuring. Tipsify
+// orderings hold up well on caches larger than the one they target.
+constexpr uint32_t VERTEX_CACHE_SIZE = 16;
+
+// Overdraw clusters may have an ACMR this much worse than the clusters
+// Tipsify produced
+constexpr float OVERDRAW_ACMR_THRESHOLD = 1.05f;
+
+/**
+ * Average cache miss ratio of a face list before and after optimization.
+ */
+struct VertexCacheStats
+{
+    float acmr_before;
+    float acmr_after;
+};
+
+/**
+ * Get the average cache miss ratio (vertices transformed per triangle) of a
+ * triangle list, simulating a FIFO post-transform cache. 3 is the worst
+ * case; a regular grid approaches 0.5.
+ * @param  faces         Triangle list (3 indexes per face)
+ * @param  vertex_count  Number of vertices
+ * @param  cache_size    Number of vertices in the cache
+ * @return  Returns the ACMR (0 for an empty list).
+ */
+float compute_acmr(const std::vector<uint16_t> &faces,
+                   uint32_t                     vertex_count,
+                   uint32_t                     cache_size = VERTEX_CACHE_SIZE);
+
+/**
+ * Get the average cache miss ratio of a triangle list with 32 bit indexes
+ * (see above).
+ */
+float compute_acmr(const std::vector<uint32_t> &faces,
+                   uint32_t                     vertex_count,
+                   uint32_t                     cache_size = VERTEX_CACHE_SIZE);
+
+/**
+ * Reorder triangles for the post-transform vertex cache using Tipsify
+ * (Sander, Nehab, and Barczak, "Fast Triangle Reordering for Vertex
+ * Locality and Reduced Overdraw"). Runs in time linear in the number of
+ * triangles.
+ * @param  faces         Triangle list (reordered in place)
+ * @param  vertex_count  Number of vertices
+ * @param  cache_size    Number of vertices in the cache
+ */
+void optimize_vertex_cache(std::vector<uint32_t> &faces,
+                           uint32_t               vertex_count,
+                           uint32_t               cache_size = VERTEX_CACHE_SIZE);
+
+/**
+ * Reorder clusters of a cache optimized triangle list so that triangles
+ * likely to occlude others are drawn first. Clusters start where the
+ * cache is flushed and are split further while their ACMR stays within
+ * threshold of the original, then sorted by how far they face out from
+ * the center of the mesh. Call after optimize_vertex_cache.
+ * @param  faces       Triangle list (reordered in place)
+ * @param  positions   Vertex positions
+ * @param  cache_size  Number of vertices in the cache
+ * @param  threshold   Allowed ACMR increase of a split cluster (>= 1)
+ */
+void optimize_overdraw(std::vector<uint32_t>     &faces,
+                       const std::vector<Point3> &positions,
+                       uint32_t                   cache_size = VERTEX_CACHE_SIZE,
+                       float                      threshold = OVERDRAW_ACMR_THRESHOLD);
+
+/**
+ * Renumber vertices in the order the triangles first use them, so vertex
+ * fetches walk the vertex buffer forward. Vertices no triangle uses keep
+ * their relative order after the used ones.
+ * @param  faces         Triangle list (indexes replaced in place)
+ * @param  vertex_count  Number of vertices
+ * @param  remap         Returns the new index of each old vertex
+ */
+void optimize_vertex_fetch(std::vector<uint32_t> &faces,
+                           uint32_t               vertex_count,
+                           std::vector<uint32_t> &remap);
+
+} // namespace cg
+
+#endif
@@ -0,0 +1,298 @@
+#include "geometry/vertex_packing.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace cg
+{
+
+namespace
+{
+
+constexpr float SNORM16_MAX = 32767.0f;
+constexpr float UNORM16_MAX = 65535.0f;
+
+int16_t to_snorm16(float v)
+{
+    return static_cast<int16_t>(std::lround(std::clamp(v, -1.0f, 1.0f) * SNORM16_MAX));
+}
+
+float from_snorm16(int16_t v) { return std::max(static_cast<float>(v) / SNORM16_MAX, -1.0f); }
+
+uint16_t to_unorm16(float v)
+{
+    return static_cast<uint16_t>(std::lround(std::clamp(v, 0.0f, 1.0f) * UNORM16_MAX));
+}
+
+float sign_not_zero(float v) { return (v >= 0.0f) ? 1.0f : -1.0f; }
+
+} // namespace
+
+void octahedral_encode(const Vector3 &v, int16_t out[2])
+{
+    // Project onto the octahedron |x| + |y| + |z| = 1, then fold the lower
+    // half over the diagonals of the upper half
+    float l1 = std::abs(v.x) + std::abs(v.y) + std::abs(v.z);
+    float x = (l1 > 0.0f) ? v.x / l1 : 0.0f;
+    float y = (l1 > 0.0f) ? v.y / l1 : 0.0f;
+    if(v.z < 0.0f)
+    {
+        float folded_x = (1.0f - std::abs(y)) * sign_not_zero(x);
+        float folded_y = (1.0f - std::abs(x)) * sign_not_zero(y);
+        x = folded_x;
+        y = folded_y;
+    }
+    out[0] = to_snorm16(x);
+    out[1] = to_snorm16(y);
+}
+
+Vector3 octahedral_decode(const int16_t in[2])
+{
+    Vector3 v(from_snorm16(in[0]), from_snorm16(in[1]), 0.0f);
+    v.z = 1.0f - std::abs(v.x) - std::abs(v.y);
+    float t = std::max(-v.z, 0.0f);
+    v.x += (v.x >= 0.0f) ? -t : t;
+    v.y += (v.y >= 0.0f) ? -t : t;
+    return v.normalize();
+}
+
+void qtangent_encode(const Vector3 &normal,
+                     const Vector3 &tangent,
+                     const Vector3 &bitangent,
+                     int16_t        out[4])
+{
+    // Rotation with columns tangent, normal x tangent, and normal
+    Vector3 b = normal.cross(tangent);
+    float   r00 = tangent.x, r01 = b.x, r02 = normal.x;
+    float   r10 = tangent.y, r11 = b.y, r12 = normal.y;
+    float   r20 = tangent.z, r21 = b.z, r22 = normal.z;
+
+    float q[4]; // x, y, z, w
+    float trace = r00 + r11 + r22;
+    if(trace > 0.0f)
+    {
+        float s = 2.0f * std::sqrt(trace + 1.0f);
+        q[0] = (r21 - r12) / s;
+        q[1] = (r02 - r20) / s;
+        q[2] = (r10 - r01) / s;
+        q[3] = 0.25f * s;
+    }
+    else if(r00 > r11 && r00 > r22)
+    {
+        float s = 2.0f * std::sqrt(1.0f + r00 - r11 - r22);
+        q[0] = 0.25f * s;
+        q[1] = (r01 + r10) / s;
+        q[2] = (r02 + r20) / s;
+        q[3] = (r21 - r12) / s;
+    }
+    else if(r11 > r22)
+    {
+        float s = 2.0f * std::sqrt(1.0f + r11 - r00 - r22);
+        q[0] = (r01 + r10) / s;
+        q[1] = 0.25f * s;
+        q[2] = (r12 + r21) / s;
+        q[3] = (r02 - r20) / s;
+    }
+    else
+    {
+        float s = 2.0f * std::sqrt(1.0f + r22 - r00 - r11);
+        q[0] = (r02 + r20) / s;
+        q[1] = (r12 + r21) / s;
+        q[2] = 0.25f * s;
+        q[3] = (r10 - r01) / s;
+    }
+
+    // q and -q are the same rotation, so w can be made positive and its
+    // sign used for the handedness. Keep w at least one snorm16 step from 0
+    // so the sign survives quantization.
+    float length = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+    float sign = (q[3] < 0.0f) ? -1.0f : 1.0f;
+    for(float &c : q) { c *= sign / length; }
+    const float bias = 1.0f / SNORM16_MAX;
+    if(q[3] < bias)
+    {
+        float scale = std::sqrt(1.0f - bias * bias) /
+                      std::max(std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2]), 1.0e-12f);
+        q[0] *= scale;
+        q[1] *= scale;
+        q[2] *= scale;
+        q[3] = bias;
+    }
+    if(bitangent.dot(b) < 0.0f)
+    {
+        for(float &c : q) { c = -c; }
+    }
+    for(uint32_t i = 0; i < 4; i++) { out[i] = to_snorm16(q[i]); }
+}
+
+uint16_t float_to_half(float f)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    uint32_t abs_bits = bits & 0x7FFFFFFF;
+
+    // Infinity and NaN (kept a quiet NaN)
+    if(abs_bits >= 0x7F800000)
+    {
+        return sign | 0x7C00 | ((abs_bits > 0x7F800000) ? 0x0200 : 0);
+    }
+
+    // Too large: rounds to infinity
+    if(abs_bits >= 0x477FF000) { return sign | 0x7C00; }
+
+    // Below the smallest normal half: subnormal (multiples of 2^-24)
+    if(abs_bits < 0x38800000)
+    {
+        float abs_f;
+        std::memcpy(&abs_f, &abs_bits, sizeof(abs_f));
+        return sign | static_cast<uint16_t>(std::lrint(abs_f * 16777216.0f));
+    }
+
+    // Rebias the exponent (127 to 15) and round the mantissa to nearest even
+    abs_bits += 0xC8000FFF + ((abs_bits >> 13) & 1);
+    return sign | static_cast<uint16_t>(abs_bits >> 13);
+}
+
+float half_to_float(uint16_t h)
+{
+    uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+    uint32_t exponent = (h >> 10) & 0x1F;
+    uint32_t mantissa = h & 0x3FF;
+    if(exponent == 0)
+    {
+        float f = std::ldexp(static_cast<float>(mantissa), -24);
+        return sign ? -f : f;
+    }
+    uint32_t bits = (exponent == 31) ? (sign | 0x7F800000 | (mantissa << 13))
+                                     : (sign | ((exponent + 112) << 23) | (mantissa << 13));
+    float    f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+PackedVertices::PackedVertices() :
+    count_(0), stride_(0), normal_offset_(0), texcoord_offset_(0), flags_(0)
+{
+}
+
+void PackedVertices::pack(const std::vector<VertexAndNormal> &vertices, VertexPacking packing)
+{
+    begin(vertices, packing, 2 * sizeof(int16_t), false);
+    for(size_t i = 0; i < count_; i++)
+    {
+        int16_t n[2];
+        octahedral_encode(vertices[i].normal, n);
+        std::memcpy(&data_[i * stride_ + normal_offset_], n, sizeof(n));
+    }
+}
+
+void PackedVertices::pack(const std::vector<VertexNormalTexture> &vertices, VertexPacking packing)
+{
+    begin(vertices, packing, 2 * sizeof(int16_t), true);
+    for(size_t i = 0; i < count_; i++)
+    {
+        int16_t n[2];
+        octahedral_encode(vertices[i].normal, n);
+        std::memcpy(&data_[i * stride_ + normal_offset_], n, sizeof(n));
+        write_texcoord(i, vertices[i].texcoord);
+    }
+}
+
+void PackedVertices::pack(const std::vector<VertexNormalTextureTangent> &vertices,
+                          VertexPacking                                  packing)
+{
+    begin(vertices, packing, 4 * sizeof(int16_t), true);
+    if(count_ > 0) { flags_ = (flags_ & ~PACKED_OCTAHEDRAL_NORMAL) | PACKED_QTANGENT; }
+    for(size_t i = 0; i < count_; i++)
+    {
+        const VertexNormalTextureTangent &v = vertices[i];
+        int16_t                           q[4];
+        qtangent_encode(v.normal, v.tangent, v.bitangent, q);
+        std::memcpy(&data_[i * stride_ + normal_offset_], q, sizeof(q));
+        write_texcoord(i, v.texcoord);
+    }
+}
+
+const std::vector<uint8_t> &PackedVertices::get_data() const { return data_; }
+
+size_t PackedVertices::size() const { return count_; }
+
+uint32_t PackedVertices::get_stride() const { return stride_; }
+
+uint32_t PackedVertices::get_normal_offset() const { return normal_offset_; }
+
+uint32_t PackedVertices::get_texcoord_offset() const { return texcoord_offset_; }
+
+int32_t PackedVertices::get_flags() const { return flags_; }
+
+const Point3 &PackedVertices::get_position_offset() const { return position_offset_; }
+
+const Vector3 &PackedVertices::get_position_scale() const { return position_scale_; }
+
+template <typename V>
+void PackedVertices::begin(const std::vector<V> &vertices,
+                           VertexPacking         packing,
+                           uint32_t              normal_size,
+                           bool                  texcoords)
+{
+    data_.clear();
+    flags_ = 0;
+    count_ = (packing == VertexPacking::NONE) ? 0 : vertices.size();
+    if(count_ == 0)
+    {
+        stride_ = normal_offset_ = texcoord_offset_ = 0;
+        return;
+    }
+
+    bool quantize = (packing == VertexPacking::ATTRIBUTES_AND_POSITIONS);
+    flags_ = PACKED_OCTAHEDRAL_NORMAL | (quantize ? PACKED_POSITION : 0);
+    normal_offset_ = quantize ? 4 * sizeof(uint16_t) : 3 * sizeof(float);
+    texcoord_offset_ = texcoords ? normal_offset_ + normal_size : 0;
+    stride_ = normal_offset_ + normal_size + (texcoords ? 2 * sizeof(uint16_t) : 0);
+    data_.resize(count_ * stride_);
+
+    if(!quantize)
+    {
+        for(size_t i = 0; i < count_; i++)
+        {
+            const Point3 &p = vertices[i].vertex;
+            float         xyz[3] = {p.x, p.y, p.z};
+            std::memcpy(&data_[i * stride_], xyz, sizeof(xyz));
+        }
+        return;
+    }
+
+    // Positions are stored relative to the bounds of the mesh. A flat axis
+    // has a scale of 0 and stores 0.
+    Point3 lo = vertices[0].vertex;
+    Point3 hi = vertices[0].vertex;
+    for(const auto &v : vertices)
+    {
+        lo.set(std::min(lo.x, v.vertex.x), std::min(lo.y, v.vertex.y), std::min(lo.z, v.vertex.z));
+        hi.set(std::max(hi.x, v.vertex.x), std::max(hi.y, v.vertex.y), std::max(hi.z, v.vertex.z));
+    }
+    position_offset_ = lo;
+    position_scale_ = Vector3(hi.x - lo.x, hi.y - lo.y, hi.z - lo.z);
+    float inv[3] = {(position_scale_.x > 0.0f) ? 1.0f / position_scale_.x : 0.0f,
+                    (position_scale_.y > 0.0f) ? 1.0f / position_scale_.y : 0.0f,
+                    (position_scale_.z > 0.0f) ? 1.0f / position_scale_.z : 0.0f};
+    for(size_t i = 0; i < count_; i++)
+    {
+        const Point3 &p = vertices[i].vertex;
+        uint16_t      q[4] = {to_unorm16((p.x - lo.x) * inv[0]),
+                              to_unorm16((p.y - lo.y) * inv[1]),
+                              to_unorm16((p.z - lo.z) * inv[2]),
+                              0};
+        std::memcpy(&data_[i * stride_], q, sizeof(q));
+    }
+}
+
+void PackedVertices::write_texcoord(size_t i, const Point2 &texcoord)
+{
+    uint16_t h[2] = {float_to_half(texcoord.x), float_to_half(texcoord.y)};
+    std::memcpy(&data_[i * stride_ + texcoord_offset_], h, sizeof(h));
+}
+
+} // namespace cg
@@ -0,0 +1,196 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:  David W. Nesbitt
+//	File:    vertex_packing.hpp
+//	Purpose: Compressed vertex formats - octahedral normals, QTangent
+//           frames, half float texture coordinates, and quantized positions.
+//============================================================================
+
+#ifndef __GEOMETRY_VERTEX_PACKING_HPP__
+#define __GEOMETRY_VERTEX_PACKING_HPP__
+
+#include "geometry/types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace cg
+{
+
+/**
+ * How much of a vertex to compress.
+ */
+enum class VertexPacking
+{
+    NONE,                    // 32 bit floats
+    ATTRIBUTES,              // Normals, tangent frames, and texture coordinates
+    ATTRIBUTES_AND_POSITIONS // Also positions, quantized to the mesh bounds
+};
+
+// Flags describing a packed vertex buffer. These match the vertex_packing
+// uniform of the vertex shaders that decode packed vertices.
+constexpr int32_t PACKED_OCTAHEDRAL_NORMAL = 1; // Normal is int16x2 octahedral
+constexpr int32_t PACKED_QTANGENT = 2;          // Normal is an int16x4 QTangent
+constexpr int32_t PACKED_POSITION = 4;          // Position is unorm16 in the bounds
+
+/**
+ * Encode a unit vector as a point on an octahedron unfolded into a square.
+ * @param  v    Unit vector
+ * @param  out  Returns the 2 normalized (snorm16) components
+ */
+void octahedral_encode(const Vector3 &v, int16_t out[2]);
+
+/**
+ * Decode an octahedral unit vector (as the shaders do).
+ * @param  in  2 normalized (snorm16) components
+ * @return  Returns the unit vector.
+ */
+Vector3 octahedral_decode(const int16_t in[2]);
+
+/**
+ * Encode a tangent frame as a unit quaternion whose w sign gives the
+ * handedness of the bitangent. The tangent and normal must be unit length
+ * and orthogonal.
+ * @param  normal     Normal
+ * @param  tangent    Tangent
+ * @param  bitangent  Bitangent (only its side of the normal-tangent plane
+ *                    is kept)
+ * @param  out        Returns the 4 normalized (snorm16) components (x, y, z, w)
+ */
+void qtangent_encode(const Vector3 &normal,
+                     const Vector3 &tangent,
+                     const Vector3 &bitangent,
+                     int16_t        out[4]);
+
+/**
+ * Convert a float to a 16 bit IEEE half float (round to nearest).
+ * @param  f  Value
+ * @return  Returns the half float bits.
+ */
+uint16_t float_to_half(float f);
+
+/**
+ * Convert a 16 bit IEEE half float to a float.
+ * @param  h  Half float bits
+ * @return  Returns the value.
+ */
+float half_to_float(uint16_t h);
+
+/**
+ * Vertex list converted to a compressed, interleaved vertex buffer layout.
+ * Each vertex holds, in order:
+ *   position   3 floats, or 4 unorm16 (the 4th is padding) relative to
+ *              the bounds of the mesh
+ *   normal     int16x2 octahedral normal, or an int16x4 QTangent when the
+ *              vertex list has tangent space
+ *   texcoord   2 half floats (if the vertex list has texture coordinates)
+ * A 56 byte VertexNormalTextureTangent becomes 24 bytes (20 with quantized
+ * positions), a 32 byte VertexNormalTexture 20 (16), and a 24 byte
+ * VertexAndNormal 16 (12).
+ */
+class PackedVertices
+{
+  public:
+    /**
+     * Constructor. Creates an empty list.
+     */
+    PackedVertices();
+
+    /**
+     * Pack positions and normals.
+     * @param  vertices  Vertex list
+     * @param  packing   What to compress (NONE packs nothing)
+     */
+    void pack(const std::vector<VertexAndNormal> &vertices, VertexPacking packing);
+
+    /**
+     * Pack positions, normals, and texture coordinates.
+     */
+    void pack(const std::vector<VertexNormalTexture> &vertices, VertexPacking packing);
+
+    /**
+     * Pack positions, tangent frames (as QTangents), and texture coordinates.
+     */
+    void pack(const std::vector<VertexNormalTextureTangent> &vertices, VertexPacking packing);
+
+    /**
+     * Get the packed vertex data.
+     * @return  Returns size() * get_stride() bytes.
+     */
+    const std::vector<uint8_t> &get_data() const;
+
+    /**
+     * Get the number of vertices.
+     * @return  Returns the number of packed vertices.
+     */
+    size_t size() const;
+
+    /**
+     * Get the size of a packed vertex.
+     * @return  Returns the bytes per vertex.
+     */
+    uint32_t get_stride() const;
+
+    /**
+     * Get the byte offset of the normal (or QTangent) within a vertex.
+     */
+    uint32_t get_normal_offset() const;
+
+    /**
+     * Get the byte offset of the texture coordinates within a vertex (0 if
+     * there are none).
+     */
+    uint32_t get_texcoord_offset() const;
+
+    /**
+     * Get the flags describing the layout (PACKED_*).
+     * @return  Returns the value for the vertex_packing shader uniform.
+     */
+    int32_t get_flags() const;
+
+    /**
+     * Get the position of a quantized coordinate of 0 (the bounds minimum).
+     */
+    const Point3 &get_position_offset() const;
+
+    /**
+     * Get the size of the bounds that quantized coordinates of 1 map to.
+     */
+    const Vector3 &get_position_scale() const;
+
+  protected:
+    std::vector<uint8_t> data_;
+    size_t               count_;
+    uint32_t             stride_;
+    uint32_t             normal_offset_;
+    uint32_t             texcoord_offset_;
+    int32_t              flags_;
+    Point3               position_offset_;
+    Vector3              position_scale_;
+
+    /**
+     * Set up the layout and write the positions of a vertex list.
+     * @param  vertices      Vertex list (any type with a vertex member)
+     * @param  packing       What to compress
+     * @param  normal_size   Bytes of the packed normal
+     * @param  texcoords     True to reserve room for texture coordinates
+     */
+    template <typename V>
+    void begin(const std::vector<V> &vertices,
+               VertexPacking         packing,
+               uint32_t              normal_size,
+               bool                  texcoords);
+
+    /**
+     * Write the texture coordinates of a vertex as half floats.
+     */
+    void write_texcoord(size_t i, const Point2 &texcoord);
+};
+
+} // namespace cg
+
+#endif
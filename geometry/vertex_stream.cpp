@@ -0,0 +1,386 @@
+#include "geometry/vertex_stream.hpp"
+
+#include "geometry/geometry.hpp"
+#include "geometry/simd.hpp"
+
+#include <cmath>
+
+namespace cg
+{
+
+namespace
+{
+
+#if defined(CG_SIMD_SSE)
+// Normalize 4 vectors. Vectors with length <= EPSILON are left unchanged
+// (same as Vector3::normalize).
+inline void normalize4(__m128 &x, __m128 &y, __m128 &z)
+{
+    __m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+    __m128 mask = _mm_cmpgt_ps(len, _mm_set1_ps(EPSILON));
+    __m128 inv = _mm_div_ps(_mm_set1_ps(1.0f), len);
+    inv = _mm_or_ps(_mm_and_ps(mask, inv), _mm_andnot_ps(mask, _mm_set1_ps(1.0f)));
+    x = _mm_mul_ps(x, inv);
+    y = _mm_mul_ps(y, inv);
+    z = _mm_mul_ps(z, inv);
+}
+
+// Gather one attribute of the vertex at corner c of 4 consecutive triangles
+template <typename T>
+inline __m128 gather4(const std::vector<float> &a, const T *idx, uint32_t c)
+{
+    return _mm_setr_ps(a[idx[c]], a[idx[c + 3]], a[idx[c + 6]], a[idx[c + 9]]);
+}
+#endif
+
+} // namespace
+
+VertexStream::VertexStream() {}
+
+void VertexStream::clear() { resize(0); }
+
+size_t VertexStream::size() const { return px_.size(); }
+
+void VertexStream::resize(size_t n)
+{
+    for(auto *a : {&px_, &py_, &pz_, &nx_, &ny_, &nz_, &u_, &v_}) { a->resize(n); }
+    for(auto *a : {&tx_, &ty_, &tz_, &bx_, &by_, &bz_}) { a->assign(n, 0.0f); }
+}
+
+void VertexStream::load(const std::vector<VertexAndNormal> &vertices)
+{
+    resize(vertices.size());
+    for(size_t i = 0; i < vertices.size(); i++)
+    {
+        const VertexAndNormal &vtx = vertices[i];
+        px_[i] = vtx.vertex.x;
+        py_[i] = vtx.vertex.y;
+        pz_[i] = vtx.vertex.z;
+        nx_[i] = vtx.normal.x;
+        ny_[i] = vtx.normal.y;
+        nz_[i] = vtx.normal.z;
+        u_[i] = 0.0f;
+        v_[i] = 0.0f;
+    }
+}
+
+void VertexStream::load(const std::vector<VertexNormalTexture> &vertices)
+{
+    resize(vertices.size());
+    for(size_t i = 0; i < vertices.size(); i++)
+    {
+        const VertexNormalTexture &vtx = vertices[i];
+        px_[i] = vtx.vertex.x;
+        py_[i] = vtx.vertex.y;
+        pz_[i] = vtx.vertex.z;
+        nx_[i] = vtx.normal.x;
+        ny_[i] = vtx.normal.y;
+        nz_[i] = vtx.normal.z;
+        u_[i] = vtx.texcoord.x;
+        v_[i] = vtx.texcoord.y;
+    }
+}
+
+void VertexStream::store(std::vector<VertexAndNormal> &vertices) const
+{
+    vertices.resize(size());
+    for(size_t i = 0; i < vertices.size(); i++)
+    {
+        VertexAndNormal &vtx = vertices[i];
+        vtx.vertex.set(px_[i], py_[i], pz_[i]);
+        vtx.normal.set(nx_[i], ny_[i], nz_[i]);
+    }
+}
+
+void VertexStream::store(std::vector<VertexNormalTexture> &vertices) const
+{
+    vertices.resize(size());
+    for(size_t i = 0; i < vertices.size(); i++)
+    {
+        VertexNormalTexture &vtx = vertices[i];
+        vtx.vertex.set(px_[i], py_[i], pz_[i]);
+        vtx.normal.set(nx_[i], ny_[i], nz_[i]);
+        vtx.texcoord.set(u_[i], v_[i]);
+    }
+}
+
+void VertexStream::store(std::vector<VertexNormalTextureTangent> &vertices) const
+{
+    vertices.resize(size());
+    for(size_t i = 0; i < vertices.size(); i++)
+    {
+        VertexNormalTextureTangent &vtx = vertices[i];
+        vtx.vertex.set(px_[i], py_[i], pz_[i]);
+        vtx.normal.set(nx_[i], ny_[i], nz_[i]);
+        vtx.texcoord.set(u_[i], v_[i]);
+        vtx.tangent.set(tx_[i], ty_[i], tz_[i]);
+        vtx.bitangent.set(bx_[i], by_[i], bz_[i]);
+    }
+}
+
+void VertexStream::accumulate_face_normals(const uint16_t *indexes, size_t index_count)
+{
+    accumulate_face_normals_impl(indexes, index_count);
+}
+
+void VertexStream::accumulate_face_normals(const uint32_t *indexes, size_t index_count)
+{
+    accumulate_face_normals_impl(indexes, index_count);
+}
+
+template <typename T>
+void VertexStream::accumulate_face_normals_impl(const T *indexes, size_t index_count)
+{
+    size_t face_count = index_count / 3;
+    size_t f = 0;
+
+#if defined(CG_SIMD_SSE)
+    // Compute face normals for 4 faces at a time. Adding them to the vertex
+    // normals is done one face at a time since faces in a group of 4 often
+    // share vertices.
+    alignas(16) float fx[4], fy[4], fz[4];
+    for(; f + 4 <= face_count; f += 4)
+    {
+        const T *idx = indexes + f * 3;
+        __m128   x0 = gather4(px_, idx, 0);
+        __m128   y0 = gather4(py_, idx, 0);
+        __m128   z0 = gather4(pz_, idx, 0);
+        __m128   e1x = _mm_sub_ps(gather4(px_, idx, 1), x0);
+        __m128   e1y = _mm_sub_ps(gather4(py_, idx, 1), y0);
+        __m128   e1z = _mm_sub_ps(gather4(pz_, idx, 1), z0);
+        __m128   e2x = _mm_sub_ps(gather4(px_, idx, 2), x0);
+        __m128   e2y = _mm_sub_ps(gather4(py_, idx, 2), y0);
+        __m128   e2z = _mm_sub_ps(gather4(pz_, idx, 2), z0);
+
+        // Face normal = e1 x e2. Normalize so that each face contributes equally
+        __m128 cx = _mm_sub_ps(_mm_mul_ps(e1y, e2z), _mm_mul_ps(e1z, e2y));
+        __m128 cy = _mm_sub_ps(_mm_mul_ps(e1z, e2x), _mm_mul_ps(e1x, e2z));
+        __m128 cz = _mm_sub_ps(_mm_mul_ps(e1x, e2y), _mm_mul_ps(e1y, e2x));
+        normalize4(cx, cy, cz);
+        _mm_store_ps(fx, cx);
+        _mm_store_ps(fy, cy);
+        _mm_store_ps(fz, cz);
+
+        for(uint32_t k = 0; k < 4; k++)
+        {
+            for(uint32_t c = 0; c < 3; c++)
+            {
+                T v = idx[k * 3 + c];
+                nx_[v] += fx[k];
+                ny_[v] += fy[k];
+                nz_[v] += fz[k];
+            }
+        }
+    }
+#endif
+
+    // Remaining faces (or all faces when SIMD is not available)
+    for(; f < face_count; f++)
+    {
+        const T *idx = indexes + f * 3;
+        Point3   p0(px_[idx[0]], py_[idx[0]], pz_[idx[0]]);
+        Vector3  e1(p0, Point3(px_[idx[1]], py_[idx[1]], pz_[idx[1]]));
+        Vector3  e2(p0, Point3(px_[idx[2]], py_[idx[2]], pz_[idx[2]]));
+        Vector3  n = e1.cross(e2).normalize();
+        for(uint32_t c = 0; c < 3; c++)
+        {
+            nx_[idx[c]] += n.x;
+            ny_[idx[c]] += n.y;
+            nz_[idx[c]] += n.z;
+        }
+    }
+}
+
+void VertexStream::normalize_normals()
+{
+    size_t n = size();
+    size_t i = 0;
+
+#if defined(CG_SIMD_SSE)
+    for(; i + 4 <= n; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(&nx_[i]);
+        __m128 y = _mm_loadu_ps(&ny_[i]);
+        __m128 z = _mm_loadu_ps(&nz_[i]);
+        normalize4(x, y, z);
+        _mm_storeu_ps(&nx_[i], x);
+        _mm_storeu_ps(&ny_[i], y);
+        _mm_storeu_ps(&nz_[i], z);
+    }
+#endif
+
+    for(; i < n; i++)
+    {
+        Vector3 v(nx_[i], ny_[i], nz_[i]);
+        v.normalize();
+        nx_[i] = v.x;
+        ny_[i] = v.y;
+        nz_[i] = v.z;
+    }
+}
+
+void VertexStream::accumulate_tangents(const uint16_t *indexes, size_t index_count)
+{
+    accumulate_tangents_impl(indexes, index_count);
+}
+
+void VertexStream::accumulate_tangents(const uint32_t *indexes, size_t index_count)
+{
+    accumulate_tangents_impl(indexes, index_count);
+}
+
+template <typename T>
+void VertexStream::accumulate_tangents_impl(const T *indexes, size_t index_count)
+{
+    constexpr float MIN_DET = 1e-6f;
+
+    size_t face_count = index_count / 3;
+    size_t f = 0;
+
+#if defined(CG_SIMD_SSE)
+    alignas(16) float tx[4], ty[4], tz[4], bx[4], by[4], bz[4];
+    const __m128      sign_mask = _mm_set1_ps(-0.0f);
+    for(; f + 4 <= face_count; f += 4)
+    {
+        const T *idx = indexes + f * 3;
+        __m128   x0 = gather4(px_, idx, 0);
+        __m128   y0 = gather4(py_, idx, 0);
+        __m128   z0 = gather4(pz_, idx, 0);
+        __m128   e1x = _mm_sub_ps(gather4(px_, idx, 1), x0);
+        __m128   e1y = _mm_sub_ps(gather4(py_, idx, 1), y0);
+        __m128   e1z = _mm_sub_ps(gather4(pz_, idx, 1), z0);
+        __m128   e2x = _mm_sub_ps(gather4(px_, idx, 2), x0);
+        __m128   e2y = _mm_sub_ps(gather4(py_, idx, 2), y0);
+        __m128   e2z = _mm_sub_ps(gather4(pz_, idx, 2), z0);
+
+        // Texture coordinate deltas
+        __m128 u0 = gather4(u_, idx, 0);
+        __m128 v0 = gather4(v_, idx, 0);
+        __m128 du1 = _mm_sub_ps(gather4(u_, idx, 1), u0);
+        __m128 dv1 = _mm_sub_ps(gather4(v_, idx, 1), v0);
+        __m128 du2 = _mm_sub_ps(gather4(u_, idx, 2), u0);
+        __m128 dv2 = _mm_sub_ps(gather4(v_, idx, 2), v0);
+
+        // Skip faces with degenerate texture coordinates
+        __m128 det = _mm_sub_ps(_mm_mul_ps(du1, dv2), _mm_mul_ps(du2, dv1));
+        int    valid = _mm_movemask_ps(_mm_cmpnlt_ps(_mm_andnot_ps(sign_mask, det), _mm_set1_ps(MIN_DET)));
+        if(valid == 0) { continue; }
+
+        __m128 r = _mm_div_ps(_mm_set1_ps(1.0f), det);
+        _mm_store_ps(tx, _mm_mul_ps(r, _mm_sub_ps(_mm_mul_ps(dv2, e1x), _mm_mul_ps(dv1, e2x))));
+        _mm_store_ps(ty, _mm_mul_ps(r, _mm_sub_ps(_mm_mul_ps(dv2, e1y), _mm_mul_ps(dv1, e2y))));
+        _mm_store_ps(tz, _mm_mul_ps(r, _mm_sub_ps(_mm_mul_ps(dv2, e1z), _mm_mul_ps(dv1, e2z))));
+        __m128 neg_du2 = _mm_xor_ps(du2, sign_mask);
+        _mm_store_ps(bx, _mm_mul_ps(r, _mm_add_ps(_mm_mul_ps(neg_du2, e1x), _mm_mul_ps(du1, e2x))));
+        _mm_store_ps(by, _mm_mul_ps(r, _mm_add_ps(_mm_mul_ps(neg_du2, e1y), _mm_mul_ps(du1, e2y))));
+        _mm_store_ps(bz, _mm_mul_ps(r, _mm_add_ps(_mm_mul_ps(neg_du2, e1z), _mm_mul_ps(du1, e2z))));
+
+        for(uint32_t k = 0; k < 4; k++)
+        {
+            if((valid & (1 << k)) == 0) { continue; }
+            for(uint32_t c = 0; c < 3; c++)
+            {
+                T v = idx[k * 3 + c];
+                tx_[v] += tx[k];
+                ty_[v] += ty[k];
+                tz_[v] += tz[k];
+                bx_[v] += bx[k];
+                by_[v] += by[k];
+                bz_[v] += bz[k];
+            }
+        }
+    }
+#endif
+
+    for(; f < face_count; f++)
+    {
+        const T *idx = indexes + f * 3;
+        T        i0 = idx[0];
+        T        i1 = idx[1];
+        T        i2 = idx[2];
+        Point3   p0(px_[i0], py_[i0], pz_[i0]);
+        Vector3  e1(p0, Point3(px_[i1], py_[i1], pz_[i1]));
+        Vector3  e2(p0, Point3(px_[i2], py_[i2], pz_[i2]));
+
+        float du1 = u_[i1] - u_[i0];
+        float dv1 = v_[i1] - v_[i0];
+        float du2 = u_[i2] - u_[i0];
+        float dv2 = v_[i2] - v_[i0];
+        float det = du1 * dv2 - du2 * dv1;
+        if(std::abs(det) < MIN_DET) { continue; }
+
+        float   r = 1.0f / det;
+        Vector3 t(r * (dv2 * e1.x - dv1 * e2.x), r * (dv2 * e1.y - dv1 * e2.y), r * (dv2 * e1.z - dv1 * e2.z));
+        Vector3 b(r * (-du2 * e1.x + du1 * e2.x),
+                  r * (-du2 * e1.y + du1 * e2.y),
+                  r * (-du2 * e1.z + du1 * e2.z));
+        for(uint32_t c = 0; c < 3; c++)
+        {
+            tx_[idx[c]] += t.x;
+            ty_[idx[c]] += t.y;
+            tz_[idx[c]] += t.z;
+            bx_[idx[c]] += b.x;
+            by_[idx[c]] += b.y;
+            bz_[idx[c]] += b.z;
+        }
+    }
+}
+
+void VertexStream::orthonormalize_tangents()
+{
+    size_t n = size();
+    size_t i = 0;
+
+#if defined(CG_SIMD_SSE)
+    for(; i + 4 <= n; i += 4)
+    {
+        __m128 nx = _mm_loadu_ps(&nx_[i]);
+        __m128 ny = _mm_loadu_ps(&ny_[i]);
+        __m128 nz = _mm_loadu_ps(&nz_[i]);
+        __m128 tx = _mm_loadu_ps(&tx_[i]);
+        __m128 ty = _mm_loadu_ps(&ty_[i]);
+        __m128 tz = _mm_loadu_ps(&tz_[i]);
+
+        // t' = t - (n . t) * n
+        __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, tx), _mm_mul_ps(ny, ty)), _mm_mul_ps(nz, tz));
+        tx = _mm_sub_ps(tx, _mm_mul_ps(d, nx));
+        ty = _mm_sub_ps(ty, _mm_mul_ps(d, ny));
+        tz = _mm_sub_ps(tz, _mm_mul_ps(d, nz));
+        normalize4(tx, ty, tz);
+
+        // b = n x t
+        __m128 bx = _mm_sub_ps(_mm_mul_ps(ny, tz), _mm_mul_ps(nz, ty));
+        __m128 by = _mm_sub_ps(_mm_mul_ps(nz, tx), _mm_mul_ps(nx, tz));
+        __m128 bz = _mm_sub_ps(_mm_mul_ps(nx, ty), _mm_mul_ps(ny, tx));
+        normalize4(bx, by, bz);
+
+        _mm_storeu_ps(&tx_[i], tx);
+        _mm_storeu_ps(&ty_[i], ty);
+        _mm_storeu_ps(&tz_[i], tz);
+        _mm_storeu_ps(&bx_[i], bx);
+        _mm_storeu_ps(&by_[i], by);
+        _mm_storeu_ps(&bz_[i], bz);
+    }
+#endif
+
+    for(; i < n; i++)
+    {
+        Vector3 nrm(nx_[i], ny_[i], nz_[i]);
+        Vector3 t(tx_[i], ty_[i], tz_[i]);
+        float   d = nrm.dot(t);
+        t.x -= d * nrm.x;
+        t.y -= d * nrm.y;
+        t.z -= d * nrm.z;
+        t.normalize();
+        Vector3 b = nrm.cross(t);
+        b.normalize();
+        tx_[i] = t.x;
+        ty_[i] = t.y;
+        tz_[i] = t.z;
+        bx_[i] = b.x;
+        by_[i] = b.y;
+        bz_[i] = b.z;
+    }
+}
+
+} // namespace cg
@@ -0,0 +1,145 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:  David W. Nesbitt
+//	File:    vertex_stream.hpp
+//	Purpose: Structure of arrays vertex attributes with SIMD kernels for
+//           normal and tangent space generation during mesh build.
+//============================================================================
+
+#ifndef __GEOMETRY_VERTEX_STREAM_HPP__
+#define __GEOMETRY_VERTEX_STREAM_HPP__
+
+#include "geometry/types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace cg
+{
+
+/**
+ * Vertex attributes stored as separate x, y, z (and u, v) arrays so that
+ * per-vertex work can be done 4 (SSE) vertices at a time. Meshes are built
+ * in this form and interleaved into one of the vertex structures in
+ * types.hpp only when the vertex buffer is created.
+ *
+ * Index lists are triangle lists (3 indexes per face) of either 16 or 32
+ * bit indexes. Face normals and tangents are accumulated in face order, so
+ * results match the scalar per-vertex code.
+ */
+class VertexStream
+{
+  public:
+    /**
+     * Constructor. Creates an empty stream.
+     */
+    VertexStream();
+
+    /**
+     * Remove all vertices.
+     */
+    void clear();
+
+    /**
+     * Get the number of vertices.
+     * @return  Returns the number of vertices in the stream.
+     */
+    size_t size() const;
+
+    /**
+     * Load positions and normals from an interleaved vertex list. Tangents
+     * and bitangents are set to 0.
+     * @param  vertices  Vertex list.
+     */
+    void load(const std::vector<VertexAndNormal> &vertices);
+
+    /**
+     * Load positions, normals, and texture coordinates from an interleaved
+     * vertex list. Tangents and bitangents are set to 0.
+     * @param  vertices  Vertex list.
+     */
+    void load(const std::vector<VertexNormalTexture> &vertices);
+
+    /**
+     * Interleave positions and normals into a vertex list.
+     * @param  vertices  Vertex list (resized to the stream size).
+     */
+    void store(std::vector<VertexAndNormal> &vertices) const;
+
+    /**
+     * Interleave positions, normals, and texture coordinates into a vertex list.
+     * @param  vertices  Vertex list (resized to the stream size).
+     */
+    void store(std::vector<VertexNormalTexture> &vertices) const;
+
+    /**
+     * Interleave all attributes into a vertex list.
+     * @param  vertices  Vertex list (resized to the stream size).
+     */
+    void store(std::vector<VertexNormalTextureTangent> &vertices) const;
+
+    /**
+     * Adds the unit length face normal of each triangle to the normals of
+     * its 3 vertices. Vertices are assumed to be in ccw order.
+     * @param  indexes      Triangle list indexes.
+     * @param  index_count  Number of indexes (3 per face).
+     */
+    void accumulate_face_normals(const uint16_t *indexes, size_t index_count);
+    void accumulate_face_normals(const uint32_t *indexes, size_t index_count);
+
+    /**
+     * Normalizes all vertex normals. Normals with length near 0 are left
+     * unchanged (same as Vector3::normalize).
+     */
+    void normalize_normals();
+
+    /**
+     * Adds the tangent and bitangent of each triangle (from the texture
+     * coordinate derivatives) to its 3 vertices. Triangles with degenerate
+     * texture coordinates are skipped.
+     * @param  indexes      Triangle list indexes.
+     * @param  index_count  Number of indexes (3 per face).
+     */
+    void accumulate_tangents(const uint16_t *indexes, size_t index_count);
+    void accumulate_tangents(const uint32_t *indexes, size_t index_count);
+
+    /**
+     * Gram-Schmidt orthonormalization of the tangent space. Makes each
+     * tangent perpendicular to the normal and sets bitangent = normal x tangent.
+     */
+    void orthonormalize_tangents();
+
+  protected:
+    // Positions
+    std::vector<float> px_, py_, pz_;
+
+    // Normals
+    std::vector<float> nx_, ny_, nz_;
+
+    // Texture coordinates
+    std::vector<float> u_, v_;
+
+    // Tangents and bitangents
+    std::vector<float> tx_, ty_, tz_;
+    std::vector<float> bx_, by_, bz_;
+
+    /**
+     * Resize all attribute arrays. New tangents and bitangents are set to 0.
+     * @param  n  Number of vertices.
+     */
+    void resize(size_t n);
+
+    template <typename T>
+    void accumulate_face_normals_impl(const T *indexes, size_t index_count);
+
+    template <typename T>
+    void accumulate_tangents_impl(const T *indexes, size_t index_count);
+};
+
+} // namespace cg
+
+#endif
@@ -0,0 +1,118 @@
+#include "geometry/vertex_welder.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace cg
+{
+
+namespace
+{
+
+// Cell size used for an epsilon of 0 (keeps cell coordinates in range)
+constexpr float MIN_CELL_SIZE = 1.0e-6f;
+
+} // namespace
+
+VertexWelder::VertexWelder(float epsilon) { set_epsilon(epsilon); }
+
+void VertexWelder::clear()
+{
+    entries_.clear();
+    cells_.clear();
+}
+
+void VertexWelder::set_epsilon(float epsilon)
+{
+    clear();
+    epsilon_ = std::max(epsilon, 0.0f);
+    inv_cell_size_ = 1.0f / std::max(2.0f * epsilon_, MIN_CELL_SIZE);
+}
+
+float VertexWelder::get_epsilon() const { return epsilon_; }
+
+size_t VertexWelder::size() const { return entries_.size(); }
+
+void VertexWelder::reserve(size_t count)
+{
+    entries_.reserve(count);
+    cells_.reserve(count);
+}
+
+uint32_t VertexWelder::find(const Point3 &p) const
+{
+    // Cells overlapped by the box of half width epsilon around p (1 or 2
+    // per axis)
+    int64_t  x0 = cell(p.x - epsilon_), x1 = cell(p.x + epsilon_);
+    int64_t  y0 = cell(p.y - epsilon_), y1 = cell(p.y + epsilon_);
+    int64_t  z0 = cell(p.z - epsilon_), z1 = cell(p.z + epsilon_);
+    uint32_t best = UINT32_MAX;
+    for(int64_t x = x0; x <= x1; x++)
+    {
+        for(int64_t y = y0; y <= y1; y++)
+        {
+            for(int64_t z = z0; z <= z1; z++)
+            {
+                auto it = cells_.find(cell_key(x, y, z));
+                if(it == cells_.end()) { continue; }
+                for(uint32_t e = it->second; e != UINT32_MAX; e = entries_[e].next)
+                {
+                    const Entry &entry = entries_[e];
+                    if(entry.index < best && std::abs(entry.position.x - p.x) <= epsilon_ &&
+                       std::abs(entry.position.y - p.y) <= epsilon_ &&
+                       std::abs(entry.position.z - p.z) <= epsilon_)
+                    {
+                        best = entry.index;
+                    }
+                }
+            }
+        }
+    }
+    return best;
+}
+
+void VertexWelder::insert(const Point3 &p, uint32_t index)
+{
+    uint64_t key = cell_key(cell(p.x), cell(p.y), cell(p.z));
+    auto     it = cells_.emplace(key, UINT32_MAX).first;
+    entries_.push_back({p, index, it->second});
+    it->second = static_cast<uint32_t>(entries_.size() - 1);
+}
+
+uint32_t VertexWelder::weld(const Point3 &p, uint32_t index)
+{
+    uint32_t found = find(p);
+    if(found != UINT32_MAX) { return found; }
+    insert(p, index);
+    return index;
+}
+
+uint64_t VertexWelder::cell_key(int64_t x, int64_t y, int64_t z)
+{
+    return static_cast<uint64_t>(x) * 0x9E3779B97F4A7C15ull ^
+           static_cast<uint64_t>(y) * 0xC2B2AE3D27D4EB4Full ^
+           static_cast<uint64_t>(z) * 0x165667B19E3779F9ull;
+}
+
+int64_t VertexWelder::cell(float v) const
+{
+    return static_cast<int64_t>(std::floor(static_cast<double>(v) * inv_cell_size_));
+}
+
+uint32_t build_weld_remap(const std::vector<Point3> &positions,
+                          float                      epsilon,
+                          std::vector<uint32_t>     &remap)
+{
+    VertexWelder welder(epsilon);
+    welder.reserve(positions.size());
+    remap.resize(positions.size());
+    uint32_t count = 0;
+    for(size_t i = 0; i < positions.size(); i++)
+    {
+        remap[i] = welder.weld(positions[i], count);
+        if(remap[i] == count) { count++; }
+    }
+    return count;
+}
+
+} // namespace cg
@@ -0,0 +1,178 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:  David W. Nesbitt
+//	File:    vertex_welder.hpp
+//	Purpose: Spatial hash for finding shared vertices while a mesh is built
+//           and for welding an existing vertex and face list.
+//============================================================================
+
+#ifndef __GEOMETRY_VERTEX_WELDER_HPP__
+#define __GEOMETRY_VERTEX_WELDER_HPP__
+
+#include "geometry/point3.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace cg
+{
+
+// Default distance (per axis) within which two positions are the same vertex
+constexpr float WELD_EPSILON = 1.0e-6f;
+
+/**
+ * Spatial hash of vertex positions. Positions are hashed into a grid of
+ * cells 2 * epsilon wide, so the positions within epsilon of a query lie
+ * in at most 8 cells and a lookup takes expected constant time. Positions
+ * match if they differ by at most epsilon in each coordinate; an epsilon
+ * of 0 matches identical positions only.
+ */
+class VertexWelder
+{
+  public:
+    /**
+     * Constructor.
+     * @param  epsilon  Largest per axis distance of matching positions
+     */
+    explicit VertexWelder(float epsilon = WELD_EPSILON);
+
+    /**
+     * Remove all positions.
+     */
+    void clear();
+
+    /**
+     * Remove all positions and change the weld distance.
+     * @param  epsilon  Largest per axis distance of matching positions
+     */
+    void set_epsilon(float epsilon);
+
+    /**
+     * Get the weld distance.
+     * @return  Returns the largest per axis distance of matching positions.
+     */
+    float get_epsilon() const;
+
+    /**
+     * Get the number of positions added.
+     * @return  Returns the number of positions in the hash.
+     */
+    size_t size() const;
+
+    /**
+     * Reserve space for positions.
+     * @param  count  Number of positions
+     */
+    void reserve(size_t count);
+
+    /**
+     * Find a matching position.
+     * @param  p  Position
+     * @return  Returns the index of the first added position within epsilon
+     *          of p, or UINT32_MAX if there is none.
+     */
+    uint32_t find(const Point3 &p) const;
+
+    /**
+     * Add a position without looking for a match.
+     * @param  p      Position
+     * @param  index  Index of the vertex at p
+     */
+    void insert(const Point3 &p, uint32_t index);
+
+    /**
+     * Find a matching position, adding p if there is none.
+     * @param  p      Position
+     * @param  index  Index to give p if it is added
+     * @return  Returns the index of the matching position, or index.
+     */
+    uint32_t weld(const Point3 &p, uint32_t index);
+
+  protected:
+    // Position in a linked list of the positions hashed to one cell
+    struct Entry
+    {
+        Point3   position;
+        uint32_t index;
+        uint32_t next; // Entry added before this one to the cell, or UINT32_MAX
+    };
+
+    float                                  epsilon_;
+    float                                  inv_cell_size_;
+    std::vector<Entry>                     entries_;
+    std::unordered_map<uint64_t, uint32_t> cells_; // Last entry added to each cell
+
+    /**
+     * Get the hash key of the cell containing a coordinate triple (cells
+     * that collide share a list; positions are compared exactly).
+     */
+    static uint64_t cell_key(int64_t x, int64_t y, int64_t z);
+
+    /**
+     * Get the cell coordinate of a position coordinate.
+     */
+    int64_t cell(float v) const;
+};
+
+/**
+ * Build the mapping that welds a list of positions: positions within
+ * epsilon of an earlier position (see VertexWelder) map to its new index.
+ * @param  positions  Vertex positions
+ * @param  epsilon    Largest per axis distance of welded positions
+ * @param  remap      Returns the new index of each position
+ * @return  Returns the number of vertices left.
+ */
+uint32_t build_weld_remap(const std::vector<Point3> &positions,
+                          float                      epsilon,
+                          std::vector<uint32_t>     &remap);
+
+/**
+ * Weld an existing vertex and face list. Vertices whose positions are
+ * within epsilon of an earlier vertex are replaced by it (its normal and
+ * other attributes are kept), the vertex list is compacted, and triangles
+ * that collapse to a line or point are removed.
+ * @param  vertices  Vertex list (any type with a Point3 vertex member)
+ * @param  faces     Triangle list (3 indexes per face)
+ * @param  epsilon   Largest per axis distance of welded positions
+ * @return  Returns the number of vertices removed.
+ */
+template <typename V>
+uint32_t weld(std::vector<V>        &vertices,
+              std::vector<uint32_t> &faces,
+              float                  epsilon = WELD_EPSILON)
+{
+    std::vector<Point3> positions;
+    positions.reserve(vertices.size());
+    for(const auto &v : vertices) { positions.push_back(v.vertex); }
+    std::vector<uint32_t> remap;
+    uint32_t              count = build_weld_remap(positions, epsilon, remap);
+
+    // The first vertex of each group keeps its place in order
+    std::vector<V> welded(count);
+    for(size_t i = vertices.size(); i-- > 0;) { welded[remap[i]] = vertices[i]; }
+    uint32_t removed = static_cast<uint32_t>(vertices.size()) - count;
+    vertices.swap(welded);
+
+    size_t out = 0;
+    for(size_t f = 0; f + 2 < faces.size(); f += 3)
+    {
+        uint32_t a = remap[faces[f]];
+        uint32_t b = remap[faces[f + 1]];
+        uint32_t c = remap[faces[f + 2]];
+        if(a == b || b == c || c == a) { continue; }
+        faces[out++] = a;
+        faces[out++] = b;
+        faces[out++] = c;
+    }
+    faces.resize(out);
+    return removed;
+}
+
+} // namespace cg
+
+#endif
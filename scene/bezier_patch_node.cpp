@@ -0,0 +1,77 @@
+#include "scene/bezier_patch_node.hpp"
+
+#include "scene/scene_state.hpp"
+#include "scene/vertex_format.hpp"
+
+#include <iostream>
+
+namespace cg
+{
+
+BezierPatchNode::BezierPatchNode(const std::vector<Point3>   &points,
+                                 const std::vector<uint16_t> &indices,
+                                 int32_t                      position_loc) :
+    GeometryNode(), vao_{0}, vbo_{0}, index_buffer_{0},
+    point_count_{static_cast<uint32_t>(points.size())},
+    index_count_{static_cast<uint32_t>(indices.size())}
+{
+    if(index_count_ % BEZIER_PATCH_VERTICES != 0)
+    {
+        std::cout << "BezierPatchNode: " << index_count_ << " indexes is not a whole number of "
+                  << BEZIER_PATCH_VERTICES << " point patches\n";
+        index_count_ -= index_count_ % BEZIER_PATCH_VERTICES;
+    }
+
+    glGenBuffers(1, &vbo_);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    glBufferData(GL_ARRAY_BUFFER, points.size() * sizeof(Point3), points.data(), GL_STATIC_DRAW);
+
+    glGenBuffers(1, &index_buffer_);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer_);
+    glBufferData(
+        GL_ELEMENT_ARRAY_BUFFER, index_count_ * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+
+    // Control points only have a position
+    const VertexAttribute position{VertexAttributeSlot::POSITION, 3, GL_FLOAT, GL_FALSE, 0};
+    glGenVertexArrays(1, &vao_);
+    glBindVertexArray(vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    set_vertex_attributes(
+        &position, 1, sizeof(Point3), make_attribute_locations(position_loc, -1));
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer_);
+
+    // Make sure changes to this VAO are local
+    glBindVertexArray(0);
+
+    set_local_bounds(points);
+}
+
+BezierPatchNode::~BezierPatchNode()
+{
+    glDeleteBuffers(1, &vbo_);
+    glDeleteBuffers(1, &index_buffer_);
+    glDeleteVertexArrays(1, &vao_);
+}
+
+void BezierPatchNode::draw(SceneState &scene_state)
+{
+    // Lights set and materials added since the last draw are uploaded once, here
+    scene_state.light_buffer.upload();
+    scene_state.materials.upload();
+
+    scene_state.gl_state.bind_vertex_array(vao_);
+    glPatchParameteri(GL_PATCH_VERTICES, BEZIER_PATCH_VERTICES);
+    glDrawElements(GL_PATCHES, index_count_, GL_UNSIGNED_SHORT, (void *)0);
+    scene_state.draw_calls++;
+}
+
+uint32_t BezierPatchNode::get_patch_count() const { return index_count_ / BEZIER_PATCH_VERTICES; }
+
+uint32_t BezierPatchNode::get_control_point_count() const { return point_count_; }
+
+size_t BezierPatchNode::get_buffer_size() const
+{
+    return point_count_ * sizeof(Point3) + index_count_ * sizeof(uint16_t);
+}
+
+} // namespace cg
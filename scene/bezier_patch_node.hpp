@@ -0,0 +1,90 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:  David W. Nesbitt
+//	File:    bezier_patch_node.hpp
+//	Purpose: Scene graph geometry node holding bicubic Bezier patches that
+//           are tessellated on the GPU.
+//============================================================================
+
+#ifndef __SCENE_BEZIER_PATCH_NODE_HPP__
+#define __SCENE_BEZIER_PATCH_NODE_HPP__
+
+#include "scene/geometry_node.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace cg
+{
+
+// Control points per bicubic patch (GL_PATCH_VERTICES)
+constexpr uint32_t BEZIER_PATCH_VERTICES = 16;
+
+/**
+ * Bicubic Bezier patches drawn as GL_PATCHES. Only the shared control
+ * points and the 16 control point indexes of each patch are uploaded; the
+ * tessellation control and evaluation shaders of the current program
+ * choose the detail each frame and evaluate the surface (for the teapot
+ * this is 306 points and 32 patches, under 5 KB instead of a mesh per
+ * level). Must be drawn with a program that has tessellation shaders.
+ *
+ * Index 4i + j of a patch is the control point in column i (along u) and
+ * row j (along v), as in BezierPatch. The bounds are those of the control
+ * points, which contain the patches.
+ */
+class BezierPatchNode : public GeometryNode
+{
+  public:
+    /**
+     * Constructor. Uploads the control points and patch indexes.
+     * @param  points        Control points (modeling coordinates)
+     * @param  indices       BEZIER_PATCH_VERTICES control point indexes per patch
+     * @param  position_loc  Location of the control point attribute
+     */
+    BezierPatchNode(const std::vector<Point3>   &points,
+                    const std::vector<uint16_t> &indices,
+                    int32_t                      position_loc);
+
+    /**
+     * Destructor. Deletes the vertex buffers.
+     */
+    virtual ~BezierPatchNode();
+
+    /**
+     * Draw the patches.
+     * @param  scene_state  Current scene state
+     */
+    void draw(SceneState &scene_state) override;
+
+    /**
+     * Get the number of patches.
+     * @return  Returns the patch count.
+     */
+    uint32_t get_patch_count() const;
+
+    /**
+     * Get the number of control points.
+     * @return  Returns the control point count.
+     */
+    uint32_t get_control_point_count() const;
+
+    /**
+     * Get the size of the vertex and index buffers.
+     * @return  Returns the number of bytes uploaded.
+     */
+    size_t get_buffer_size() const;
+
+  protected:
+    GLuint   vao_;
+    GLuint   vbo_;          // Control points
+    GLuint   index_buffer_; // Control point indexes of each patch
+    uint32_t point_count_;
+    uint32_t index_count_;
+};
+
+} // namespace cg
+
+#endif
@@ -28,11 +28,14 @@ void CameraNode::draw(SceneState &scene_state)
     // Copy the current composite projection and viewing matrix to the scene state
     scene_state.pv = proj_ * view_;
 
+    // Frustum planes for culling the children
+    scene_state.frustum.set(scene_state.pv);
+
     // Set the shader PVM matrix - this will allow drawing children without a TransformNode
-    glUniformMatrix4fv(scene_state.pvm_matrix_loc, 1, GL_FALSE, scene_state.pv.get());
+    scene_state.gl_state.uniform_matrix4fv(scene_state.pvm_matrix_loc, scene_state.pv.get());
 
     // Set the camera position
-    glUniform3fv(scene_state.camera_position_loc, 1, &vrp_.x);
+    scene_state.gl_state.uniform3fv(scene_state.camera_position_loc, &vrp_.x);
 
     // Draw children
     SceneNode::draw(scene_state);
@@ -244,4 +247,6 @@ void CameraNode::set_view_matrix()
     view_.m33() = 1.0f;
 }
 
+bool CameraNode::compute_bounds(BoundingSphere & /* sphere */) { return false; }
+
 } // namespace cg
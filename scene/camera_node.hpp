@@ -192,6 +192,9 @@ class CameraNode : public SceneNode
     // Create viewing transformation matrix by composing the translation
     // matrix with the rotation matrix given by the view coordinate axes
     void set_view_matrix();
+
+    // The camera sets the view for its descendants, so it is never culled
+    bool compute_bounds(BoundingSphere &sphere) override;
 };
 
 } // namespace cg
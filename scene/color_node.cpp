@@ -7,10 +7,15 @@ ColorNode::ColorNode() : PresentationNode() {}
 
 ColorNode::ColorNode(const Color4 &c) { material_color_ = c; }
 
+void ColorNode::apply_material(SceneState &scene_state)
+{
+    scene_state.gl_state.uniform3fv(scene_state.material_diffuse_loc, &material_color_.r);
+}
+
 void ColorNode::draw(SceneState &scene_state)
 {
     // Set the current color and draw all children. Very simple lighting support
-    glUniform3fv(scene_state.material_diffuse_loc, 1, &material_color_.r);
+    apply_material(scene_state);
     SceneNode::draw(scene_state);
 }
 
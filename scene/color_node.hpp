@@ -35,6 +35,11 @@ class ColorNode : public PresentationNode
      */
     ColorNode(const Color4 &c);
 
+    /**
+     * Set the current color without drawing children.
+     */
+    void apply_material(SceneState &scene_state) override;
+
     /**
      * Draw this presentation node and its children
      */
@@ -0,0 +1,19 @@
+#include "scene/compiled_scene_node.hpp"
+
+namespace cg
+{
+
+CompiledSceneNode::CompiledSceneNode() {}
+
+CompiledSceneNode::~CompiledSceneNode() {}
+
+void CompiledSceneNode::draw(SceneState &scene_state)
+{
+    if(render_queue_.is_stale(*this)) render_queue_.compile(*this);
+    else render_queue_.update_transforms(*this);
+    render_queue_.draw(scene_state);
+}
+
+const RenderQueue &CompiledSceneNode::get_render_queue() const { return render_queue_; }
+
+} // namespace cg
@@ -0,0 +1,60 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:	 David W. Nesbitt
+//	File:    compiled_scene_node.hpp
+//	Purpose: Scene graph node that draws its children from a compiled,
+//           flat render queue instead of recursive traversal.
+//
+//============================================================================
+
+#ifndef __SCENE_COMPILED_SCENE_NODE_HPP__
+#define __SCENE_COMPILED_SCENE_NODE_HPP__
+
+#include "scene/render_queue.hpp"
+#include "scene/scene_node.hpp"
+
+namespace cg
+{
+
+/**
+ * Compiled scene node. Children are added as with any scene node, but are
+ * drawn from a render queue that is rebuilt only when the structure of the
+ * subtree changes. Transform changes only move the records below them.
+ */
+class CompiledSceneNode : public SceneNode
+{
+  public:
+    /**
+     * Constructor.
+     */
+    CompiledSceneNode();
+
+    /**
+     * Destructor.
+     */
+    virtual ~CompiledSceneNode();
+
+    /**
+     * Draw the children using the compiled render queue. Recompiles the queue
+     * first if the structure of the subtree has changed, or else updates the
+     * records below changed transforms.
+     * @param  scene_state  Current scene state
+     */
+    void draw(SceneState &scene_state) override;
+
+    /**
+     * Get the render queue (compiled on the most recent draw).
+     * @return  Returns the render queue.
+     */
+    const RenderQueue &get_render_queue() const;
+
+  protected:
+    RenderQueue render_queue_;
+};
+
+} // namespace cg
+
+#endif
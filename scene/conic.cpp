@@ -70,6 +70,7 @@ ConicSurface::ConicSurface(float    bottom_radius,
 
     // Construct the face list and create VBOs
     construct_row_col_face_list(num_cols_, num_rows_);
+    optimize_face_order();
     create_vertex_buffers(position_loc, normal_loc);
 }
 
@@ -3,10 +3,52 @@
 namespace cg
 {
 
-GeometryNode::GeometryNode() { node_type_ = SceneNodeType::GEOMETRY; }
+GeometryNode::GeometryNode() : has_local_bounds_(false), is_occluder_(false) { node_type_ = SceneNodeType::GEOMETRY; }
 
 GeometryNode::~GeometryNode() {}
 
 void GeometryNode::draw(SceneState &scene_state) {}
 
+bool GeometryNode::can_draw_instances() const { return false; }
+
+void GeometryNode::draw_instances(SceneState & /* scene_state */,
+                                  const InstanceBuffer & /* instances */,
+                                  uint32_t /* first */,
+                                  uint32_t /* count */)
+{
+}
+
+const PooledMesh *GeometryNode::get_pooled_mesh() const { return nullptr; }
+
+bool GeometryNode::has_local_bounds() const { return has_local_bounds_; }
+
+const AABB &GeometryNode::get_bounding_box() const { return local_box_; }
+
+const BoundingSphere &GeometryNode::get_bounding_sphere() const { return local_sphere_; }
+
+bool GeometryNode::is_occluder() const { return is_occluder_; }
+
+const OccluderMesh &GeometryNode::get_occluder() const { return occluder_; }
+
+void GeometryNode::set_local_bounds(const std::vector<Point3> &positions)
+{
+    if(positions.empty())
+    {
+        has_local_bounds_ = false;
+        return;
+    }
+    local_box_.create(positions);
+    local_sphere_ = BoundingSphere(positions);
+    has_local_bounds_ = true;
+
+    // Cached bounds of any subtree holding this node are now out of date
+    structure_changed();
+}
+
+bool GeometryNode::compute_bounds(BoundingSphere &sphere)
+{
+    sphere = local_sphere_;
+    return has_local_bounds_;
+}
+
 } // namespace cg
@@ -12,13 +12,23 @@
 #ifndef __SCENE_GEOMETRY_NODE_HPP__
 #define __SCENE_GEOMETRY_NODE_HPP__
 
+#include "scene/geometry_pool.hpp"
+#include "scene/instance_buffer.hpp"
 #include "scene/scene_node.hpp"
 
+#include "geometry/aabb.hpp"
+#include "geometry/bounding_sphere.hpp"
+#include "geometry/occlusion_buffer.hpp"
+
+#include <vector>
+
 namespace cg
 {
 
 /**
- * Geometry node base class. Stores and draws geometry.
+ * Geometry node base class. Stores and draws geometry. Derived classes set
+ * the local (modeling coordinate) bounds once their vertices are known so
+ * the node can be culled.
  */
 class GeometryNode : public SceneNode
 {
@@ -38,6 +48,82 @@ class GeometryNode : public SceneNode
      * @param  scene_state  Current scene state
      */
     virtual void draw(SceneState &scene_state) override;
+
+    /**
+     * Check whether this node can be drawn with draw_instances.
+     * @return  Returns true if instanced drawing is supported.
+     */
+    virtual bool can_draw_instances() const;
+
+    /**
+     * Draw a run of instances with one draw call. The model matrix, normal
+     * matrix, and material of each instance come from the instance buffer,
+     * which must be uploaded. The base class draws nothing.
+     * @param  scene_state  Current scene state
+     * @param  instances    Instance buffer
+     * @param  first        First instance of the run
+     * @param  count        Number of instances
+     */
+    virtual void draw_instances(SceneState           &scene_state,
+                                const InstanceBuffer &instances,
+                                uint32_t              first,
+                                uint32_t              count);
+
+    /**
+     * Get where this node's mesh is in a geometry pool.
+     * @return  Returns the pooled mesh, or nullptr if the node has its own
+     *          buffers.
+     */
+    virtual const PooledMesh *get_pooled_mesh() const;
+
+    /**
+     * Check whether local bounds have been set.
+     * @return  Returns true if the bounding box and sphere are valid.
+     */
+    bool has_local_bounds() const;
+
+    /**
+     * Get the bounding box in modeling coordinates.
+     * @return  Returns the local bounding box.
+     */
+    const AABB &get_bounding_box() const;
+
+    /**
+     * Get the bounding sphere in modeling coordinates.
+     * @return  Returns the local bounding sphere.
+     */
+    const BoundingSphere &get_bounding_sphere() const;
+
+    /**
+     * Check whether this node is drawn into the occlusion buffer.
+     * @return  Returns true if this node hides objects behind it.
+     */
+    bool is_occluder() const;
+
+    /**
+     * Get the occluder mesh (modeling coordinates). Empty unless the node
+     * is an occluder.
+     * @return  Returns the occluder mesh.
+     */
+    const OccluderMesh &get_occluder() const;
+
+  protected:
+    AABB           local_box_;
+    BoundingSphere local_sphere_;
+    bool           has_local_bounds_;
+    OccluderMesh   occluder_;
+    bool           is_occluder_;
+
+    /**
+     * Set the local bounding box and sphere from the vertex positions.
+     * @param  positions  Vertex positions (modeling coordinates).
+     */
+    void set_local_bounds(const std::vector<Point3> &positions);
+
+    /**
+     * Bounds of this node are its local bounds (false if not set).
+     */
+    bool compute_bounds(BoundingSphere &sphere) override;
 };
 
 } // namespace cg
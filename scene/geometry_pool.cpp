@@ -0,0 +1,184 @@
+#include "scene/geometry_pool.hpp"
+#include "scene/tri_surface.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace cg
+{
+
+namespace
+{
+
+// Move the surfaces below a node into a pool. Shared nodes are visited once
+// per parent, but a surface is only added the first time.
+void add_surfaces(SceneNode &node, GeometryPool &pool, uint32_t &count)
+{
+    auto *surface = dynamic_cast<TriSurface *>(&node);
+    if(surface != nullptr && surface->get_pooled_mesh() == nullptr &&
+       surface->move_to_pool(pool))
+    {
+        count++;
+    }
+    for(const auto &c : node.get_children()) { add_surfaces(*c, pool, count); }
+}
+
+// Make a buffer hold at least size bytes, keeping its first used bytes.
+// Returns the buffer, a new one if it had to grow.
+GLuint reserve_buffer(GLuint buffer, size_t &capacity, size_t used, size_t size)
+{
+    if(size <= capacity) { return buffer; }
+
+    size_t grown_capacity = std::max(size, capacity * 2);
+    GLuint grown;
+    glGenBuffers(1, &grown);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, grown);
+    glBufferData(GL_COPY_WRITE_BUFFER, grown_capacity, nullptr, GL_STATIC_DRAW);
+    if(used > 0)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, used);
+    }
+    if(buffer != 0) { glDeleteBuffers(1, &buffer); }
+    capacity = grown_capacity;
+    return grown;
+}
+
+} // namespace
+
+GeometryPool::GeometryPool(VertexLayout layout,
+                           int32_t      position_loc,
+                           int32_t      normal_loc,
+                           int32_t      texcoord_loc) :
+    layout_(layout),
+    position_loc_(position_loc),
+    normal_loc_(normal_loc),
+    texcoord_loc_(texcoord_loc),
+    vertex_size_(layout == VertexLayout::POSITION_NORMAL ? sizeof(VertexAndNormal)
+                                                         : sizeof(VertexNormalTexture)),
+    vertex_count_(0),
+    index_count_(0),
+    vertex_capacity_(0),
+    index_capacity_(0),
+    vao_(0),
+    vbo_(0),
+    ibo_(0)
+{
+}
+
+GeometryPool::~GeometryPool()
+{
+    if(vao_ != 0)
+    {
+        glDeleteBuffers(1, &vbo_);
+        glDeleteBuffers(1, &ibo_);
+        glDeleteVertexArrays(1, &vao_);
+    }
+}
+
+VertexLayout GeometryPool::get_layout() const { return layout_; }
+
+PooledMesh GeometryPool::add(const void                  *vertices,
+                             uint32_t                     vertex_count,
+                             const std::vector<uint16_t> &faces)
+{
+    PooledMesh mesh;
+    mesh.pool = this;
+    mesh.index_count = static_cast<GLsizei>(faces.size());
+    mesh.first_index = index_count_;
+    mesh.base_vertex = static_cast<GLint>(vertex_count_);
+
+    size_t offset = vertices_.size();
+    vertices_.resize(offset + vertex_count * vertex_size_);
+    std::memcpy(&vertices_[offset], vertices, vertex_count * vertex_size_);
+    indices_.insert(indices_.end(), faces.begin(), faces.end());
+    vertex_count_ += vertex_count;
+    index_count_ += static_cast<uint32_t>(faces.size());
+    return mesh;
+}
+
+uint32_t GeometryPool::add_subtree(SceneNode &root)
+{
+    uint32_t count = 0;
+    add_surfaces(root, *this, count);
+    return count;
+}
+
+void GeometryPool::bind(SceneState &scene_state)
+{
+    if(!vertices_.empty() || !indices_.empty()) { upload(scene_state); }
+    scene_state.gl_state.bind_vertex_array(vao_);
+}
+
+void GeometryPool::multi_draw(SceneState        &scene_state,
+                              const GLsizei     *counts,
+                              const void *const *offsets,
+                              const GLint       *base_vertices,
+                              GLsizei            draw_count)
+{
+    scene_state.light_buffer.upload();
+    scene_state.materials.upload();
+    bind(scene_state);
+    glMultiDrawElementsBaseVertex(
+        GL_TRIANGLES, counts, GL_UNSIGNED_SHORT, offsets, draw_count, base_vertices);
+    scene_state.draw_calls++;
+    scene_state.multi_draw_calls++;
+}
+
+uint32_t GeometryPool::get_vertex_count() const { return vertex_count_; }
+
+void GeometryPool::upload(SceneState &scene_state)
+{
+    if(vao_ == 0) { glGenVertexArrays(1, &vao_); }
+
+    // Bytes already in the buffers and bytes needed
+    size_t vertex_bytes = static_cast<size_t>(vertex_count_) * vertex_size_;
+    size_t index_bytes = static_cast<size_t>(index_count_) * sizeof(uint16_t);
+    size_t vertex_offset = vertex_bytes - vertices_.size();
+    size_t index_offset = index_bytes - indices_.size() * sizeof(uint16_t);
+    GLuint vbo = reserve_buffer(vbo_, vertex_capacity_, vertex_offset, vertex_bytes);
+    GLuint ibo = reserve_buffer(ibo_, index_capacity_, index_offset, index_bytes);
+
+    // The attribute pointers and the index buffer binding are part of the
+    // vertex array, so a grown buffer is attached again
+    scene_state.gl_state.bind_vertex_array(vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    if(vbo != vbo_)
+    {
+        vbo_ = vbo;
+        set_attribute_pointers();
+    }
+    if(ibo != ibo_)
+    {
+        ibo_ = ibo;
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo_);
+    }
+    if(!vertices_.empty())
+    {
+        glBufferSubData(GL_ARRAY_BUFFER, vertex_offset, vertices_.size(), vertices_.data());
+    }
+    if(!indices_.empty())
+    {
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER,
+                        index_offset,
+                        indices_.size() * sizeof(uint16_t),
+                        indices_.data());
+    }
+
+    // Free the host copy
+    std::vector<uint8_t>().swap(vertices_);
+    std::vector<uint16_t>().swap(indices_);
+}
+
+void GeometryPool::set_attribute_pointers()
+{
+    AttributeLocations locations =
+        make_attribute_locations(position_loc_, normal_loc_, texcoord_loc_);
+    if(layout_ == VertexLayout::POSITION_NORMAL_TEXTURE)
+    {
+        set_vertex_attributes<VertexNormalTexture>(locations);
+    }
+    else { set_vertex_attributes<VertexAndNormal>(locations); }
+}
+
+} // namespace cg
@@ -0,0 +1,167 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:	 David W. Nesbitt
+//	File:    geometry_pool.hpp
+//	Purpose: Shared vertex and index buffers for static meshes with the
+//           same vertex layout.
+//
+//============================================================================
+
+#ifndef __SCENE_GEOMETRY_POOL_HPP__
+#define __SCENE_GEOMETRY_POOL_HPP__
+
+#include "scene/graphics.hpp"
+#include "scene/scene_state.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace cg
+{
+
+class GeometryPool;
+class SceneNode;
+
+/**
+ * Vertex layouts a geometry pool can hold.
+ */
+enum class VertexLayout
+{
+    POSITION_NORMAL,        // VertexAndNormal
+    POSITION_NORMAL_TEXTURE // VertexNormalTexture
+};
+
+/**
+ * Location of a mesh inside a geometry pool.
+ */
+struct PooledMesh
+{
+    GeometryPool *pool = nullptr;
+    GLsizei       index_count = 0;
+    uint32_t      first_index = 0; // Offset of the face list in the index buffer
+    GLint         base_vertex = 0; // Added to each index of the face list
+};
+
+/**
+ * Geometry pool. Holds the vertex and face lists of many static meshes with
+ * one vertex layout in a single vertex buffer and a single index buffer,
+ * drawn through one vertex array object. Each mesh records its first index
+ * and base vertex, so indices stay 16 bit per mesh while the pool grows
+ * past 65535 vertices.
+ *
+ * Consecutive draws from a pool do not rebind the vertex array, and draws
+ * with the same program, material, and transform can be submitted together
+ * with one glMultiDrawElementsBaseVertex (see RenderQueue).
+ *
+ * Meshes added since the last upload are appended to the buffers with
+ * glBufferSubData when the pool is next bound. Buffers that are too small
+ * grow to twice their size (or more) and keep their contents through
+ * glCopyBufferSubData. The host copy of the meshes is freed once uploaded.
+ * The pool must outlive the surfaces moved into it.
+ */
+class GeometryPool
+{
+  public:
+    /**
+     * Constructor.
+     * @param  layout        Vertex layout of the meshes in the pool
+     * @param  position_loc  Vertex position attribute location
+     * @param  normal_loc    Vertex normal attribute location
+     * @param  texcoord_loc  Texture coordinate attribute location (textured layout only)
+     */
+    GeometryPool(VertexLayout layout,
+                 int32_t      position_loc,
+                 int32_t      normal_loc,
+                 int32_t      texcoord_loc = -1);
+
+    /**
+     * Destructor. Deletes the GL objects (requires a current context).
+     */
+    ~GeometryPool();
+
+    /**
+     * Get the vertex layout.
+     * @return  Returns the vertex layout of the pool.
+     */
+    VertexLayout get_layout() const;
+
+    /**
+     * Add a mesh.
+     * @param  vertices      Vertex list in the pool's layout
+     * @param  vertex_count  Number of vertices
+     * @param  faces         Face list (indices relative to the mesh)
+     * @return  Returns where the mesh is in the pool.
+     */
+    PooledMesh add(const void *vertices, uint32_t vertex_count, const std::vector<uint16_t> &faces);
+
+    /**
+     * Move every triangle surface below a node with this pool's layout into
+     * the pool (see TriSurface::move_to_pool).
+     * @param  root  Root of the subtree
+     * @return  Returns the number of surfaces moved.
+     */
+    uint32_t add_subtree(SceneNode &root);
+
+    /**
+     * Bind the vertex array, uploading the meshes added since the last
+     * upload first.
+     * @param  scene_state  Scene state (holds the GL state cache)
+     */
+    void bind(SceneState &scene_state);
+
+    /**
+     * Draw several meshes of the pool with one glMultiDrawElementsBaseVertex.
+     * @param  scene_state    Current scene state
+     * @param  counts         Index count of each mesh
+     * @param  offsets        Byte offset of each mesh's face list
+     * @param  base_vertices  Base vertex of each mesh
+     * @param  draw_count     Number of meshes
+     */
+    void multi_draw(SceneState        &scene_state,
+                    const GLsizei     *counts,
+                    const void *const *offsets,
+                    const GLint       *base_vertices,
+                    GLsizei            draw_count);
+
+    /**
+     * Get the number of vertices in the pool.
+     * @return  Returns the vertex count.
+     */
+    uint32_t get_vertex_count() const;
+
+  protected:
+    VertexLayout          layout_;
+    int32_t               position_loc_;
+    int32_t               normal_loc_;
+    int32_t               texcoord_loc_;
+    uint32_t              vertex_size_;
+    std::vector<uint8_t>  vertices_;        // Vertices added since the last upload
+    std::vector<uint16_t> indices_;         // Indices added since the last upload
+    uint32_t              vertex_count_;    // Vertices in the pool (uploaded or not)
+    uint32_t              index_count_;     // Indices in the pool (uploaded or not)
+    size_t                vertex_capacity_; // Size of the vertex buffer in bytes
+    size_t                index_capacity_;  // Size of the index buffer in bytes
+    GLuint                vao_;
+    GLuint                vbo_;
+    GLuint                ibo_;
+
+    /**
+     * Append the meshes added since the last upload to the GL buffers,
+     * growing them if needed, and free the host copy.
+     * @param  scene_state  Scene state (holds the GL state cache)
+     */
+    void upload(SceneState &scene_state);
+
+    /**
+     * Set the vertex attribute pointers of the bound vertex array to the
+     * bound vertex buffer.
+     */
+    void set_attribute_pointers();
+};
+
+} // namespace cg
+
+#endif
@@ -0,0 +1,238 @@
+#include "scene/gl_state_cache.hpp"
+
+#include <cstring>
+
+namespace cg
+{
+
+namespace
+{
+
+// Binding that is not known (OpenGL names are never this large)
+constexpr GLuint UNKNOWN = 0xFFFFFFFF;
+
+// Uniform locations above this are passed through without caching
+constexpr GLint MAX_CACHED_LOCATION = 4096;
+
+} // namespace
+
+GLStateCache::GLStateCache() { invalidate(); }
+
+void GLStateCache::begin_frame()
+{
+    issued_ = 0;
+    elided_ = 0;
+    program_ = UNKNOWN;
+    program_uniforms_ = nullptr;
+    vertex_array_ = UNKNOWN;
+    active_unit_ = UNKNOWN;
+    for(uint32_t i = 0; i < MAX_TEXTURE_UNITS; i++) { textures_[i] = UNKNOWN; }
+    depth_mask_ = UNKNOWN;
+    color_mask_ = UNKNOWN;
+}
+
+void GLStateCache::end_frame() { bind_vertex_array(0); }
+
+void GLStateCache::invalidate()
+{
+    uniforms_.clear();
+    begin_frame();
+}
+
+void GLStateCache::forget_program(GLuint program)
+{
+    if(program == program_) { program_uniforms_ = nullptr; }
+    uniforms_.erase(program);
+}
+
+void GLStateCache::use_program(GLuint program)
+{
+    if(program == program_)
+    {
+        elided_++;
+        return;
+    }
+    glUseProgram(program);
+    issued_++;
+    program_ = program;
+    program_uniforms_ = (program != 0) ? &uniforms_[program] : nullptr;
+}
+
+GLuint GLStateCache::get_program() const { return (program_ == UNKNOWN) ? 0 : program_; }
+
+void GLStateCache::bind_vertex_array(GLuint vao)
+{
+    if(vao == vertex_array_)
+    {
+        elided_++;
+        return;
+    }
+    glBindVertexArray(vao);
+    issued_++;
+    vertex_array_ = vao;
+}
+
+void GLStateCache::bind_texture(uint32_t unit, GLuint texture)
+{
+    if(unit >= MAX_TEXTURE_UNITS)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        issued_ += 2;
+        active_unit_ = unit;
+        return;
+    }
+    if(textures_[unit] == texture)
+    {
+        elided_++;
+        return;
+    }
+    if(active_unit_ != unit)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        issued_++;
+        active_unit_ = unit;
+    }
+    glBindTexture(GL_TEXTURE_2D, texture);
+    issued_++;
+    textures_[unit] = texture;
+}
+
+void GLStateCache::depth_mask(GLboolean write)
+{
+    GLuint mask = (write == GL_TRUE) ? 1 : 0;
+    if(mask == depth_mask_)
+    {
+        elided_++;
+        return;
+    }
+    glDepthMask(write);
+    issued_++;
+    depth_mask_ = mask;
+}
+
+GLboolean GLStateCache::get_depth_mask()
+{
+    if(depth_mask_ == UNKNOWN)
+    {
+        GLboolean write = GL_TRUE;
+        glGetBooleanv(GL_DEPTH_WRITEMASK, &write);
+        depth_mask_ = (write == GL_TRUE) ? 1 : 0;
+    }
+    return (depth_mask_ != 0) ? GL_TRUE : GL_FALSE;
+}
+
+void GLStateCache::color_mask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha)
+{
+    GLuint mask = ((red == GL_TRUE) ? 1 : 0) | ((green == GL_TRUE) ? 2 : 0) |
+                  ((blue == GL_TRUE) ? 4 : 0) | ((alpha == GL_TRUE) ? 8 : 0);
+    if(mask == color_mask_)
+    {
+        elided_++;
+        return;
+    }
+    glColorMask(red, green, blue, alpha);
+    issued_++;
+    color_mask_ = mask;
+}
+
+void GLStateCache::get_color_mask(GLboolean mask[4])
+{
+    if(color_mask_ == UNKNOWN)
+    {
+        GLboolean write[4] = {GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE};
+        glGetBooleanv(GL_COLOR_WRITEMASK, write);
+        color_mask_ = 0;
+        for(uint32_t i = 0; i < 4; i++) { color_mask_ |= (write[i] == GL_TRUE) ? (1u << i) : 0; }
+    }
+    for(uint32_t i = 0; i < 4; i++) { mask[i] = (color_mask_ & (1u << i)) ? GL_TRUE : GL_FALSE; }
+}
+
+void GLStateCache::uniform1i(GLint location, GLint v)
+{
+    GLfloat bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    if(update_uniform(location, UNIFORM_INT, &bits, 1)) { glUniform1i(location, v); }
+}
+
+void GLStateCache::uniform1f(GLint location, GLfloat v)
+{
+    if(update_uniform(location, UNIFORM_FLOAT, &v, 1)) { glUniform1f(location, v); }
+}
+
+void GLStateCache::uniform2f(GLint location, GLfloat x, GLfloat y)
+{
+    const GLfloat v[2] = {x, y};
+    if(update_uniform(location, UNIFORM_VEC2, v, 2)) { glUniform2fv(location, 1, v); }
+}
+
+void GLStateCache::uniform3f(GLint location, GLfloat x, GLfloat y, GLfloat z)
+{
+    const GLfloat v[3] = {x, y, z};
+    if(update_uniform(location, UNIFORM_VEC3, v, 3)) { glUniform3fv(location, 1, v); }
+}
+
+void GLStateCache::uniform3fv(GLint location, const GLfloat *v)
+{
+    if(update_uniform(location, UNIFORM_VEC3, v, 3)) { glUniform3fv(location, 1, v); }
+}
+
+void GLStateCache::uniform4f(GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w)
+{
+    const GLfloat v[4] = {x, y, z, w};
+    if(update_uniform(location, UNIFORM_VEC4, v, 4)) { glUniform4fv(location, 1, v); }
+}
+
+void GLStateCache::uniform4fv(GLint location, const GLfloat *v)
+{
+    if(update_uniform(location, UNIFORM_VEC4, v, 4)) { glUniform4fv(location, 1, v); }
+}
+
+void GLStateCache::uniform_matrix4fv(GLint location, const GLfloat *m)
+{
+    if(update_uniform(location, UNIFORM_MAT4, m, 16))
+    {
+        glUniformMatrix4fv(location, 1, GL_FALSE, m);
+    }
+}
+
+uint32_t GLStateCache::get_issued_calls() const { return issued_; }
+
+uint32_t GLStateCache::get_elided_calls() const { return elided_; }
+
+bool GLStateCache::update_uniform(GLint          location,
+                                  UniformType    type,
+                                  const GLfloat *value,
+                                  uint32_t       count)
+{
+    // OpenGL ignores location -1, so the call can always be dropped
+    if(location < 0)
+    {
+        elided_++;
+        return false;
+    }
+
+    // Without a known program the value cannot be attributed to one
+    if(program_uniforms_ == nullptr || location > MAX_CACHED_LOCATION)
+    {
+        issued_++;
+        return true;
+    }
+
+    if(static_cast<size_t>(location) >= program_uniforms_->size())
+    {
+        program_uniforms_->resize(location + 1);
+    }
+    UniformValue &u = (*program_uniforms_)[location];
+    if(u.type == type && std::memcmp(u.value, value, count * sizeof(GLfloat)) == 0)
+    {
+        elided_++;
+        return false;
+    }
+    u.type = type;
+    std::memcpy(u.value, value, count * sizeof(GLfloat));
+    issued_++;
+    return true;
+}
+
+} // namespace cg
@@ -0,0 +1,194 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:	 David W. Nesbitt
+//	File:    gl_state_cache.hpp
+//	Purpose: Shadow copy of OpenGL state used while drawing the scene.
+//           Drops calls that would set state to the value it already has.
+//
+//============================================================================
+
+#ifndef __SCENE_GL_STATE_CACHE_HPP__
+#define __SCENE_GL_STATE_CACHE_HPP__
+
+#include "scene/graphics.hpp"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace cg
+{
+
+/**
+ * OpenGL state cache. Tracks the bound program, vertex array, the 2D texture
+ * bound to each texture unit, the depth and color write masks, and the
+ * uniform values of each program. A call
+ * is only passed to OpenGL if it changes the state. Counts the calls issued
+ * and elided since the last begin_frame.
+ *
+ * All drawing code should set this state through the cache. Setup code
+ * (creating buffers and textures, loading shaders) may call OpenGL directly
+ * between frames: begin_frame forgets the bindings and end_frame unbinds the
+ * vertex array. Uniform values are kept across frames (they are stored in
+ * the program), so a uniform set through the cache must not also be set
+ * directly.
+ */
+class GLStateCache
+{
+  public:
+    static constexpr uint32_t MAX_TEXTURE_UNITS = 32;
+
+    /**
+     * Constructor. All state starts unknown.
+     */
+    GLStateCache();
+
+    /**
+     * Start a frame. Resets the call counters and forgets the program,
+     * vertex array, texture bindings, and write masks.
+     */
+    void begin_frame();
+
+    /**
+     * End a frame. Unbinds the vertex array so setup code that runs between
+     * frames cannot modify the last one drawn.
+     */
+    void end_frame();
+
+    /**
+     * Forget all state including uniform values.
+     */
+    void invalidate();
+
+    /**
+     * Forget the uniform values of a program (call when deleting it, since
+     * the name may be reused).
+     * @param  program  Program name
+     */
+    void forget_program(GLuint program);
+
+    /**
+     * Use a shader program (glUseProgram).
+     * @param  program  Program name
+     */
+    void use_program(GLuint program);
+
+    /**
+     * Get the program in use.
+     * @return  Returns the program name (0 if unknown).
+     */
+    GLuint get_program() const;
+
+    /**
+     * Bind a vertex array object (glBindVertexArray).
+     * @param  vao  Vertex array name
+     */
+    void bind_vertex_array(GLuint vao);
+
+    /**
+     * Bind a 2D texture to a texture unit (glActiveTexture, glBindTexture).
+     * @param  unit     Texture unit index (0 for GL_TEXTURE0)
+     * @param  texture  Texture name
+     */
+    void bind_texture(uint32_t unit, GLuint texture);
+
+    /**
+     * Set the depth buffer write mask (glDepthMask).
+     * @param  write  GL_TRUE to write depth values
+     */
+    void depth_mask(GLboolean write);
+
+    /**
+     * Get the depth buffer write mask, reading it from OpenGL if unknown.
+     * @return  Returns GL_TRUE if depth values are written.
+     */
+    GLboolean get_depth_mask();
+
+    /**
+     * Set the color buffer write mask (glColorMask).
+     * @param  red    GL_TRUE to write red
+     * @param  green  GL_TRUE to write green
+     * @param  blue   GL_TRUE to write blue
+     * @param  alpha  GL_TRUE to write alpha
+     */
+    void color_mask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha);
+
+    /**
+     * Get the color buffer write mask, reading it from OpenGL if unknown.
+     * @param  mask  Returns the red, green, blue, and alpha write flags.
+     */
+    void get_color_mask(GLboolean mask[4]);
+
+    /**
+     * Set uniforms of the current program. Locations of -1 are ignored, as
+     * they are by OpenGL.
+     */
+    void uniform1i(GLint location, GLint v);
+    void uniform1f(GLint location, GLfloat v);
+    void uniform2f(GLint location, GLfloat x, GLfloat y);
+    void uniform3f(GLint location, GLfloat x, GLfloat y, GLfloat z);
+    void uniform3fv(GLint location, const GLfloat *v);
+    void uniform4f(GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w);
+    void uniform4fv(GLint location, const GLfloat *v);
+    void uniform_matrix4fv(GLint location, const GLfloat *m);
+
+    /**
+     * Get the number of calls passed to OpenGL since begin_frame.
+     * @return  Returns the number of calls issued.
+     */
+    uint32_t get_issued_calls() const;
+
+    /**
+     * Get the number of redundant calls dropped since begin_frame.
+     * @return  Returns the number of calls elided.
+     */
+    uint32_t get_elided_calls() const;
+
+  protected:
+    // Uniform types (UNIFORM_UNKNOWN for a location not yet set)
+    enum UniformType : uint32_t
+    {
+        UNIFORM_UNKNOWN,
+        UNIFORM_INT,
+        UNIFORM_FLOAT,
+        UNIFORM_VEC2,
+        UNIFORM_VEC3,
+        UNIFORM_VEC4,
+        UNIFORM_MAT4
+    };
+
+    // Last value set for a uniform location (ints are stored by bit pattern)
+    struct UniformValue
+    {
+        UniformType type = UNIFORM_UNKNOWN;
+        GLfloat     value[16];
+    };
+
+    GLuint                                                 program_;
+    GLuint                                                 vertex_array_;
+    GLuint                                                 active_unit_;
+    GLuint                                                 textures_[MAX_TEXTURE_UNITS];
+    GLuint                                                 depth_mask_;
+    GLuint                                                 color_mask_; // Bit per channel
+    std::unordered_map<GLuint, std::vector<UniformValue>> uniforms_;
+    std::vector<UniformValue>                             *program_uniforms_;
+    uint32_t                                               issued_;
+    uint32_t                                               elided_;
+
+    /**
+     * Compare a uniform value with the cached value and store it.
+     * @param  location  Uniform location
+     * @param  type      Uniform type
+     * @param  value     Value (count floats)
+     * @param  count     Number of floats
+     * @return  Returns true if the call must be issued.
+     */
+    bool update_uniform(GLint location, UniformType type, const GLfloat *value, uint32_t count);
+};
+
+} // namespace cg
+
+#endif
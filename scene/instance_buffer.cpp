@@ -0,0 +1,78 @@
+#include "scene/instance_buffer.hpp"
+
+#include <cstddef>
+
+namespace cg
+{
+
+InstanceBuffer::InstanceBuffer() : buffer_(0) {}
+
+InstanceBuffer::~InstanceBuffer()
+{
+    if(buffer_ != 0) { glDeleteBuffers(1, &buffer_); }
+}
+
+void InstanceBuffer::clear() { instances_.clear(); }
+
+void InstanceBuffer::add(const Matrix4x4 &model_matrix,
+                         const Matrix4x4 &normal_matrix,
+                         int32_t          material)
+{
+    instances_.push_back({model_matrix, normal_matrix, material});
+}
+
+uint32_t InstanceBuffer::size() const { return static_cast<uint32_t>(instances_.size()); }
+
+void InstanceBuffer::upload()
+{
+    if(instances_.empty()) { return; }
+    if(buffer_ == 0) { glGenBuffers(1, &buffer_); }
+    glBindBuffer(GL_ARRAY_BUFFER, buffer_);
+    glBufferData(GL_ARRAY_BUFFER,
+                 instances_.size() * sizeof(InstanceData),
+                 instances_.data(),
+                 GL_STREAM_DRAW);
+}
+
+void InstanceBuffer::enable_attributes(const SceneState &scene_state, uint32_t first) const
+{
+    const GLsizei stride = sizeof(InstanceData);
+    const size_t  base = first * sizeof(InstanceData);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer_);
+
+    // A mat4 attribute takes 4 consecutive locations, one per column
+    for(GLint c = 0; c < 4; c++)
+    {
+        size_t model = base + offsetof(InstanceData, model_matrix) + c * 4 * sizeof(float);
+        glEnableVertexAttribArray(scene_state.instance_model_loc + c);
+        glVertexAttribPointer(
+            scene_state.instance_model_loc + c, 4, GL_FLOAT, GL_FALSE, stride, (void *)model);
+        glVertexAttribDivisor(scene_state.instance_model_loc + c, 1);
+
+        size_t normal = base + offsetof(InstanceData, normal_matrix) + c * 4 * sizeof(float);
+        glEnableVertexAttribArray(scene_state.instance_normal_loc + c);
+        glVertexAttribPointer(
+            scene_state.instance_normal_loc + c, 4, GL_FLOAT, GL_FALSE, stride, (void *)normal);
+        glVertexAttribDivisor(scene_state.instance_normal_loc + c, 1);
+    }
+
+    size_t material = base + offsetof(InstanceData, material);
+    glEnableVertexAttribArray(scene_state.instance_material_loc);
+    glVertexAttribIPointer(scene_state.instance_material_loc, 1, GL_INT, stride, (void *)material);
+    glVertexAttribDivisor(scene_state.instance_material_loc, 1);
+}
+
+void InstanceBuffer::disable_attributes(const SceneState &scene_state) const
+{
+    for(GLint c = 0; c < 4; c++)
+    {
+        glVertexAttribDivisor(scene_state.instance_model_loc + c, 0);
+        glDisableVertexAttribArray(scene_state.instance_model_loc + c);
+        glVertexAttribDivisor(scene_state.instance_normal_loc + c, 0);
+        glDisableVertexAttribArray(scene_state.instance_normal_loc + c);
+    }
+    glVertexAttribDivisor(scene_state.instance_material_loc, 0);
+    glDisableVertexAttribArray(scene_state.instance_material_loc);
+}
+
+} // namespace cg
@@ -0,0 +1,106 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:	 David W. Nesbitt
+//	File:    instance_buffer.hpp
+//	Purpose: Per-instance model matrix, normal matrix, and material index
+//           for instanced drawing.
+//
+//============================================================================
+
+#ifndef __SCENE_INSTANCE_BUFFER_HPP__
+#define __SCENE_INSTANCE_BUFFER_HPP__
+
+#include "geometry/matrix.hpp"
+#include "scene/graphics.hpp"
+#include "scene/scene_state.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace cg
+{
+
+/**
+ * Per-instance vertex attributes. The matrices are column major, so each
+ * column feeds one location of a mat4 attribute.
+ */
+struct InstanceData
+{
+    Matrix4x4 model_matrix;
+    Matrix4x4 normal_matrix;
+    int32_t   material;            // Index into the material table
+};
+
+static_assert(sizeof(Matrix4x4) == 16 * sizeof(float), "Matrix4x4 must be 16 packed floats");
+
+/**
+ * Instance buffer. Instances for a frame are added, uploaded with a single
+ * glBufferData, and then drawn in runs: enable_attributes points the
+ * instance attributes of the bound vertex array at a run and
+ * disable_attributes restores the vertex array for non-instanced draws.
+ * The attribute locations come from the scene state (set by programs that
+ * support instancing).
+ */
+class InstanceBuffer
+{
+  public:
+    /**
+     * Constructor. The GL buffer is created on the first upload.
+     */
+    InstanceBuffer();
+
+    /**
+     * Destructor. Deletes the GL buffer (requires a current context).
+     */
+    ~InstanceBuffer();
+
+    /**
+     * Remove all instances.
+     */
+    void clear();
+
+    /**
+     * Add an instance.
+     * @param  model_matrix   Model matrix
+     * @param  normal_matrix  Normal matrix
+     * @param  material       Material table index
+     */
+    void add(const Matrix4x4 &model_matrix, const Matrix4x4 &normal_matrix, int32_t material);
+
+    /**
+     * Get the number of instances.
+     * @return  Returns the number of instances added since the last clear.
+     */
+    uint32_t size() const;
+
+    /**
+     * Upload all instances. The buffer is respecified, so draws still using
+     * the previous contents are not stalled.
+     */
+    void upload();
+
+    /**
+     * Enable the instance attributes of the bound vertex array, starting at
+     * an instance.
+     * @param  scene_state  Scene state (instance attribute locations)
+     * @param  first        First instance of the run
+     */
+    void enable_attributes(const SceneState &scene_state, uint32_t first) const;
+
+    /**
+     * Disable the instance attributes of the bound vertex array.
+     * @param  scene_state  Scene state (instance attribute locations)
+     */
+    void disable_attributes(const SceneState &scene_state) const;
+
+  protected:
+    std::vector<InstanceData> instances_;
+    GLuint                    buffer_;
+};
+
+} // namespace cg
+
+#endif
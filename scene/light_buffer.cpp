@@ -0,0 +1,71 @@
+#include "scene/light_buffer.hpp"
+
+#include <cstring>
+#include <iostream>
+
+namespace cg
+{
+
+LightBuffer::LightBuffer() : buffer_(0), changed_(true), uploads_(0)
+{
+    block_ = LightBlock{};
+}
+
+LightBuffer::~LightBuffer()
+{
+    if(buffer_ != 0) { glDeleteBuffers(1, &buffer_); }
+}
+
+bool LightBuffer::bind_block(GLuint program)
+{
+    GLuint index = glGetUniformBlockIndex(program, "LightBlock");
+    if(index == GL_INVALID_INDEX)
+    {
+        std::cout << "LightBuffer: Error getting LightBlock index\n";
+        return false;
+    }
+    glUniformBlockBinding(program, index, BINDING);
+    return true;
+}
+
+void LightBuffer::set_light(uint32_t index, const LightSource &light)
+{
+    if(index >= MAX_LIGHTS)
+    {
+        std::cout << "LightBuffer: Light index " << index << " exceeds MAX_LIGHTS\n";
+        return;
+    }
+    if(std::memcmp(&block_.lights[index], &light, sizeof(LightSource)) != 0)
+    {
+        block_.lights[index] = light;
+        changed_ = true;
+    }
+    if(index >= static_cast<uint32_t>(block_.num_lights))
+    {
+        block_.num_lights = static_cast<int32_t>(index + 1);
+        changed_ = true;
+    }
+}
+
+void LightBuffer::upload()
+{
+    if(!changed_) { return; }
+
+    if(buffer_ == 0)
+    {
+        glGenBuffers(1, &buffer_);
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer_);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(LightBlock), nullptr, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, BINDING, buffer_);
+    }
+    else glBindBuffer(GL_UNIFORM_BUFFER, buffer_);
+
+    size_t size = offsetof(LightBlock, lights) + block_.num_lights * sizeof(LightSource);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, size, &block_);
+    changed_ = false;
+    uploads_++;
+}
+
+uint32_t LightBuffer::get_upload_count() const { return uploads_; }
+
+} // namespace cg
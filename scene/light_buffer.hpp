@@ -0,0 +1,129 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:	 David W. Nesbitt
+//	File:    light_buffer.hpp
+//	Purpose: Light sources in a std140 uniform block shared by all shader
+//           programs that light geometry.
+//
+//============================================================================
+
+#ifndef __SCENE_LIGHT_BUFFER_HPP__
+#define __SCENE_LIGHT_BUFFER_HPP__
+
+#include "geometry/hpoint3.hpp"
+#include "geometry/vector3.hpp"
+#include "scene/color4.hpp"
+#include "scene/graphics.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace cg
+{
+
+// Number of lights in the uniform block. This is a buffer size: each light
+// takes 112 bytes and every implementation allows blocks of at least 16 KB.
+// MAX_LIGHTS in the shaders must match.
+constexpr uint32_t MAX_LIGHTS = 32;
+
+/**
+ * One light source in std140 layout. Matches the LightSource structure in
+ * the shaders.
+ */
+struct LightSource
+{
+    HPoint3 position;              // If w = 0 the light is directional
+    Color4  ambient;
+    Color4  diffuse;
+    Color4  specular;
+    Vector3 spot_direction;
+    float   spot_cutoff;           // Cosine of the cutoff angle
+    float   spot_exponent;
+    float   constant_attenuation;
+    float   linear_attenuation;
+    float   quadratic_attenuation;
+    int32_t enabled;
+    int32_t spotlight;
+    int32_t padding[2];            // std140 rounds the structure to 16 bytes
+};
+
+/**
+ * Contents of the LightBlock uniform block (std140 layout).
+ */
+struct LightBlock
+{
+    int32_t     num_lights;        // Lights the shaders loop over
+    int32_t     padding[3];        // The array starts on a 16 byte boundary
+    LightSource lights[MAX_LIGHTS];
+};
+
+static_assert(sizeof(LightSource) == 112, "LightSource must match the std140 layout");
+static_assert(offsetof(LightSource, spot_direction) == 64, "LightSource must match std140");
+static_assert(offsetof(LightSource, enabled) == 96, "LightSource must match std140");
+static_assert(offsetof(LightBlock, lights) == 16, "LightBlock must match std140");
+
+/**
+ * Light buffer. Keeps a copy of the LightBlock uniform block. Light nodes
+ * set their light during traversal and the block is uploaded with a single
+ * glBufferSubData before the next draw, only if a light changed. The buffer
+ * is bound to BINDING, and each program that lights geometry connects its
+ * LightBlock to that binding point once with bind_block.
+ *
+ * Lights are shared by all programs and stay set until changed, so a light
+ * node lights everything drawn after it in the frame.
+ */
+class LightBuffer
+{
+  public:
+    static constexpr GLuint BINDING = 0;
+
+    /**
+     * Constructor. The GL buffer is created on the first upload.
+     */
+    LightBuffer();
+
+    /**
+     * Destructor. Deletes the GL buffer (requires a current context).
+     */
+    ~LightBuffer();
+
+    /**
+     * Connect the LightBlock uniform block of a program to BINDING.
+     * @param  program  Linked shader program
+     * @return  Returns false if the program has no LightBlock.
+     */
+    static bool bind_block(GLuint program);
+
+    /**
+     * Set a light. The block is marked changed only if the light differs
+     * from the one already set.
+     * @param  index  Light index (less than MAX_LIGHTS)
+     * @param  light  Light source (the padding must be zero)
+     */
+    void set_light(uint32_t index, const LightSource &light);
+
+    /**
+     * Upload the block if a light changed since the last upload. Only the
+     * lights in use are copied.
+     */
+    void upload();
+
+    /**
+     * Get the number of uploads since construction.
+     * @return  Returns the number of glBufferSubData calls.
+     */
+    uint32_t get_upload_count() const;
+
+  protected:
+    LightBlock block_;
+    GLuint     buffer_;
+    bool       changed_;
+    uint32_t   uploads_;
+};
+
+} // namespace cg
+
+#endif
@@ -69,40 +69,33 @@ void LightNode::set_attenuation(float constant, float linear, float quadratic)
 
 void LightNode::draw(SceneState &scene_state)
 {
-    glUniform1i(scene_state.lights[index_].enabled, static_cast<int>(enabled_));
+    LightSource light = {};
+    light.enabled = static_cast<int32_t>(enabled_);
     if(enabled_)
     {
-        glUniform1i(scene_state.lights[index_].spotlight, static_cast<int>(is_spotlight_));
-        glUniform4fv(scene_state.lights[index_].position, 1, &position_.x);
-        glUniform4fv(scene_state.lights[index_].ambient, 1, &ambient_.r);
-        glUniform4fv(scene_state.lights[index_].diffuse, 1, &diffuse_.r);
-        glUniform4fv(scene_state.lights[index_].specular, 1, &specular_.r);
-        glUniform1f(scene_state.lights[index_].att_constant, const_atten_);
-        glUniform1f(scene_state.lights[index_].att_linear, lin_atten_);
-        glUniform1f(scene_state.lights[index_].att_quadratic, quad_atten_);
+        light.spotlight = static_cast<int32_t>(is_spotlight_);
+        light.position = position_;
+        light.ambient = ambient_;
+        light.diffuse = diffuse_;
+        light.specular = specular_;
+        light.constant_attenuation = const_atten_;
+        light.linear_attenuation = lin_atten_;
+        light.quadratic_attenuation = quad_atten_;
         if(is_spotlight_)
         {
             // Note we use cos of the spotlight cutoff angle so we don't have
             // to compute cos in the shader
-            glUniform1f(scene_state.lights[index_].spot_cutoff, spot_cutoff_);
-            glUniform3fv(scene_state.lights[index_].spot_direction, 1, &spot_direction_.x);
-            glUniform1f(scene_state.lights[index_].spot_exponent, spot_exponent_);
-        }
-
-        // Track the maximum light index that is enabled
-        if(index_ >= (uint32_t)scene_state.max_enabled_light)
-        {
-            glUniform1i(scene_state.lightcount_loc, index_ + 1);
-            scene_state.max_enabled_light = index_;
+            light.spot_cutoff = spot_cutoff_;
+            light.spot_direction = spot_direction_;
+            light.spot_exponent = spot_exponent_;
         }
     }
+    scene_state.light_buffer.set_light(index_, light);
 
     // Draw children of this node
     SceneNode::draw(scene_state);
-
-    // To be proper we should disable this light so it does not impact any nodes that
-    // are not descended from this node
-    glUniform1i(scene_state.lights[index_].enabled, 0);
 }
 
+bool LightNode::compute_bounds(BoundingSphere & /* sphere */) { return false; }
+
 } // namespace cg
@@ -95,9 +95,9 @@ class LightNode : public SceneNode
     void set_attenuation(float constant, float linear, float quadratic);
 
     /**
-     * Draw. Sets the light properties if enabled. Note that only position
-     * is set within the Draw method - since it needs to be transformed by
-     * the current matrix.
+     * Draw. Sets this light in the scene state light buffer (disabled if
+     * not enabled), then draws the children. The light stays set for the
+     * rest of the frame.
      * @param  scene_state  Current scene state.
      */
     void draw(SceneState &scene_state) override;
@@ -118,6 +118,11 @@ class LightNode : public SceneNode
 
     // Light position as a homogeneous coordinate. If w = 0 the light is directional
     HPoint3 position_;
+
+    /**
+     * A light affects everything drawn after it, so it is never culled.
+     */
+    bool compute_bounds(BoundingSphere &sphere) override;
 };
 
 } // namespace cg
@@ -0,0 +1,119 @@
+#include "scene/material_registry.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace cg
+{
+
+MaterialRegistry::MaterialRegistry() :
+    in_use_(0), buffer_(0), dirty_begin_(0), dirty_end_(0),
+    handle_(std::make_shared<MaterialRegistry *>(this))
+{
+    materials_.reserve(MAX_MATERIALS);
+    textures_.reserve(MAX_MATERIALS);
+    references_.reserve(MAX_MATERIALS);
+}
+
+MaterialRegistry::~MaterialRegistry()
+{
+    if(buffer_ != 0) { glDeleteBuffers(1, &buffer_); }
+}
+
+bool MaterialRegistry::bind_block(GLuint program)
+{
+    GLuint index = glGetUniformBlockIndex(program, "MaterialBlock");
+    if(index == GL_INVALID_INDEX)
+    {
+        std::cout << "MaterialRegistry: Error getting MaterialBlock index\n";
+        return false;
+    }
+    glUniformBlockBinding(program, index, BINDING);
+    return true;
+}
+
+uint32_t MaterialRegistry::add(const Material &material, GLuint texture)
+{
+    // Nodes register once, when their material changes, so a linear search
+    // of at most MAX_MATERIALS entries is cheap enough. An unused entry that
+    // still holds the material is taken back as is.
+    uint32_t index = static_cast<uint32_t>(materials_.size());
+    for(uint32_t i = 0; i < materials_.size(); i++)
+    {
+        if(textures_[i] == texture &&
+           std::memcmp(&materials_[i], &material, sizeof(Material)) == 0)
+        {
+            if(references_[i]++ == 0) { in_use_++; }
+            return i;
+        }
+        if(references_[i] == 0 && index == materials_.size()) { index = i; }
+    }
+
+    if(index == MAX_MATERIALS)
+    {
+        std::cout << "MaterialRegistry: More than " << MAX_MATERIALS << " materials in use\n";
+        return INVALID_MATERIAL;
+    }
+    if(index == materials_.size())
+    {
+        materials_.push_back(material);
+        textures_.push_back(texture);
+        references_.push_back(1);
+    }
+    else
+    {
+        materials_[index] = material;
+        textures_[index] = texture;
+        references_[index] = 1;
+    }
+    in_use_++;
+
+    if(dirty_begin_ == dirty_end_)
+    {
+        dirty_begin_ = index;
+        dirty_end_ = index + 1;
+    }
+    else
+    {
+        dirty_begin_ = std::min(dirty_begin_, index);
+        dirty_end_ = std::max(dirty_end_, index + 1);
+    }
+    return index;
+}
+
+void MaterialRegistry::release(uint32_t index)
+{
+    if(index < references_.size() && references_[index] > 0)
+    {
+        if(--references_[index] == 0) { in_use_--; }
+    }
+}
+
+uint32_t MaterialRegistry::size() const { return in_use_; }
+
+std::weak_ptr<MaterialRegistry *> MaterialRegistry::get_handle() const { return handle_; }
+
+void MaterialRegistry::upload()
+{
+    if(dirty_begin_ == dirty_end_) { return; }
+
+    if(buffer_ == 0)
+    {
+        glGenBuffers(1, &buffer_);
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer_);
+        glBufferData(
+            GL_UNIFORM_BUFFER, MAX_MATERIALS * sizeof(Material), nullptr, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, BINDING, buffer_);
+    }
+    else glBindBuffer(GL_UNIFORM_BUFFER, buffer_);
+
+    glBufferSubData(GL_UNIFORM_BUFFER,
+                    dirty_begin_ * sizeof(Material),
+                    (dirty_end_ - dirty_begin_) * sizeof(Material),
+                    &materials_[dirty_begin_]);
+    dirty_begin_ = 0;
+    dirty_end_ = 0;
+}
+
+} // namespace cg
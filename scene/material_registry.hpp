@@ -0,0 +1,146 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:	 David W. Nesbitt
+//	File:    material_registry.hpp
+//	Purpose: Table of unique materials in a std140 uniform block. Draws
+//           select their material by index.
+//
+//============================================================================
+
+#ifndef __SCENE_MATERIAL_REGISTRY_HPP__
+#define __SCENE_MATERIAL_REGISTRY_HPP__
+
+#include "scene/color4.hpp"
+#include "scene/graphics.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace cg
+{
+
+// Number of materials in the uniform block. Each material takes 80 bytes, so
+// the block fits in the 16 KB every implementation allows. MAX_MATERIALS in
+// the shaders must match.
+constexpr uint32_t MAX_MATERIALS = 128;
+
+// Index returned when the table is full
+constexpr uint32_t INVALID_MATERIAL = 0xFFFFFFFF;
+
+/**
+ * One material in std140 layout. Matches the Material structure in the
+ * shaders.
+ */
+struct Material
+{
+    Color4  ambient;
+    Color4  diffuse;
+    Color4  specular;
+    Color4  emission;
+    float   shininess;
+    int32_t use_texture;           // Modulate the lit color by the texture
+    int32_t padding[2];            // std140 rounds the structure to 16 bytes
+};
+
+static_assert(sizeof(Material) == 80, "Material must match the std140 layout");
+static_assert(offsetof(Material, shininess) == 64, "Material must match std140");
+
+/**
+ * Material registry. Presentation nodes register their material (and
+ * texture) once and get back an index into the MaterialBlock uniform block.
+ * Identical materials share one entry, so a draw selects its material with
+ * a single integer uniform and draws that differ only by material can be
+ * batched. The texture is part of the identity of an entry but is bound by
+ * the caller; the block only records whether one is used.
+ *
+ * Entries count the nodes that use them. A node releases its entry when its
+ * material changes and when it is destroyed, and entries no node uses are
+ * reused by later materials, so animated materials and replaced nodes do
+ * not fill the table. Entries changed
+ * since the last upload are uploaded with a single glBufferSubData before
+ * the next draw. The buffer is bound to BINDING, and each program that
+ * reads materials connects its MaterialBlock to that binding point once
+ * with bind_block.
+ */
+class MaterialRegistry
+{
+  public:
+    static constexpr GLuint BINDING = 1;
+
+    /**
+     * Constructor. The GL buffer is created on the first upload.
+     */
+    MaterialRegistry();
+
+    /**
+     * Destructor. Deletes the GL buffer (requires a current context).
+     */
+    ~MaterialRegistry();
+
+    // Nodes keep a handle to the registry, so it cannot be copied
+    MaterialRegistry(const MaterialRegistry &) = delete;
+    MaterialRegistry &operator=(const MaterialRegistry &) = delete;
+
+    /**
+     * Connect the MaterialBlock uniform block of a program to BINDING.
+     * @param  program  Linked shader program
+     * @return  Returns false if the program has no MaterialBlock.
+     */
+    static bool bind_block(GLuint program);
+
+    /**
+     * Get the index of a material, adding it if it is not registered, and
+     * count one more user of the entry.
+     * @param  material  Material (the padding must be zero)
+     * @param  texture   Texture used with the material (0 if none)
+     * @return  Returns the material index, or INVALID_MATERIAL if all
+     *          MAX_MATERIALS entries are in use.
+     */
+    uint32_t add(const Material &material, GLuint texture);
+
+    /**
+     * Count one less user of an entry. The entry can be reused once no
+     * node uses it.
+     * @param  index  Index returned by add
+     */
+    void release(uint32_t index);
+
+    /**
+     * Get a handle to this registry for nodes that hold entries. The handle
+     * expires when the registry is destroyed, so a node destroyed after it
+     * does not release its entry.
+     * @return  Returns the handle.
+     */
+    std::weak_ptr<MaterialRegistry *> get_handle() const;
+
+    /**
+     * Get the number of registered materials.
+     * @return  Returns the number of entries in use.
+     */
+    uint32_t size() const;
+
+    /**
+     * Upload the materials added since the last upload.
+     */
+    void upload();
+
+  protected:
+    std::vector<Material> materials_;
+    std::vector<GLuint>   textures_;    // Texture of each entry
+    std::vector<uint32_t> references_;  // Nodes using each entry
+    uint32_t              in_use_;      // Entries with references
+    GLuint                buffer_;
+    uint32_t              dirty_begin_; // Entries changed since the last upload
+    uint32_t              dirty_end_;
+
+    std::shared_ptr<MaterialRegistry *> handle_; // Points to this registry
+};
+
+} // namespace cg
+
+#endif
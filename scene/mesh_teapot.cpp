@@ -1,6 +1,6 @@
 #include "scene/mesh_teapot.hpp"
 
-#include <algorithm>
+#include <iostream>
 
 namespace cg
 {
@@ -354,169 +354,86 @@ static uint32_t PatchIndices[32][4][4] = {
 
 MeshTeapot::MeshTeapot(uint16_t level, int32_t position_loc, int32_t normal_loc)
 {
-    // Data is 32 patches, each with a 4x4 array of point[3].
-    // Convert array data into a triple-array of Vector3.
-    using PatchType = std::array<std::array<Vector3, 4>, 4>;
-    std::array<PatchType, 32> data;
+    // Segments must fit 32 bits (much lower levels already exceed 32 bit
+    // indexes and are rejected by build)
+    if(level >= 32)
+    {
+        std::cout << "MeshTeapot: level " << level << " exceeds 31 subdivisions\n";
+        end(position_loc, normal_loc);
+        return;
+    }
+    uint32_t segments = 1u << level;
+    build({segments, segments}, position_loc, normal_loc);
+}
 
+MeshTeapot::MeshTeapot(uint32_t u_segments,
+                       uint32_t v_segments,
+                       int32_t  position_loc,
+                       int32_t  normal_loc)
+{
+    build({u_segments, v_segments}, position_loc, normal_loc);
+}
+
+void MeshTeapot::get_patches(std::vector<BezierPatch> &patches)
+{
+    // Data is 32 patches, each with a 4x4 array of control points
+    patches.resize(32);
     for(size_t patch = 0; patch < 32; patch++)
     {
         for(uint32_t j = 0; j < 4; j++)
         {
             for(uint32_t k = 0; k < 4; k++)
             {
-                // Put teapot data into single array for subdivision
-                data[patch][j][k] = teapot_vertex_list[PatchIndices[patch][j][k] - 1];
+                const Vector3 &v = teapot_vertex_list[PatchIndices[patch][j][k] - 1];
+                patches[patch].points[j][k].set(v.x, v.y, v.z);
             }
         }
     }
-
-    // Level 6 or higher would produce more than 65,536 vertices
-    level = std::max<uint16_t>(level, 5);
-
-    // Subdivide all 32 patches
-    for(size_t patch = 0; patch < 32; patch++) { divide_patch(data[patch], level); }
-
-    // End the mesh - construct vertex normals by averaging
-    end(position_loc, normal_loc);
 }
 
-void MeshTeapot::divide_patch(std::array<std::array<Vector3, 4>, 4> patch, uint16_t level)
+void MeshTeapot::get_control_points(std::vector<Point3> &points, std::vector<uint16_t> &indices)
 {
-    // Helper function to determine the number of points on each individual curve.
-    // Note: for integers, this is MUCH faster than std::pow
-    auto powi = [](uint32_t val, uint32_t exp) -> uint32_t
-    {
-        uint32_t res = 1;
-        for(uint32_t i = 0; i < exp; ++i) res *= val;
-        return res;
-    };
-
-    // Each curve will finally have [2^(level) + 1] points.
-    const auto sub_patch_dim = powi(2, level) + 1;
-
-    std::vector<std::vector<Vector3>> row_ctrl_points(4);
-    std::vector<std::vector<Vector3>> patch_vertices(sub_patch_dim);
-
-    // Compute the curves for each patch row
-    for(size_t r = 0; r < 4; ++r)
+    points.resize(teapot_vertex_list.size());
+    for(size_t i = 0; i < teapot_vertex_list.size(); i++)
     {
-        row_ctrl_points[r] =
-            divide_curve(patch[0][r], patch[1][r], patch[2][r], patch[3][r], level);
+        const Vector3 &v = teapot_vertex_list[i];
+        points[i].set(v.x, v.y, v.z);
     }
 
-    // Use the patch rows as the control points for each column
-    for(size_t c = 0; c < sub_patch_dim; ++c)
+    // Patch indices are 1 based
+    indices.resize(32 * 16);
+    for(size_t patch = 0; patch < 32; patch++)
     {
-        patch_vertices[c] = divide_curve(row_ctrl_points[0][c],
-                                         row_ctrl_points[1][c],
-                                         row_ctrl_points[2][c],
-                                         row_ctrl_points[3][c],
-                                         level);
+        for(uint32_t j = 0; j < 4; j++)
+        {
+            for(uint32_t k = 0; k < 4; k++)
+            {
+                indices[patch * 16 + j * 4 + k] =
+                    static_cast<uint16_t>(PatchIndices[patch][j][k] - 1);
+            }
+        }
     }
-
-    // Add the subdividied patch to the mesh
-    add_patch(patch_vertices);
-}
-
-std::vector<Vector3> MeshTeapot::divide_curve(const Vector3 &ctrl_0,
-                                              const Vector3 &ctrl_1,
-                                              const Vector3 &ctrl_2,
-                                              const Vector3 &ctrl_3,
-                                              uint16_t       level)
-{
-    // Level 0: add the start and end points only.
-    // Note: ctrl_1 and ctrl_2 are not on the curve
-    if(level == 0) return {ctrl_0, ctrl_3};
-
-    Vector3 lt_0, lt_1, lt_2, lt_3;
-    Vector3 rt_0, rt_1, rt_2, rt_3;
-
-    Vector3 t = (ctrl_1 + ctrl_2) * 0.5f;
-
-    // end points
-    lt_0 = ctrl_0;
-    rt_3 = ctrl_3;
-
-    // side points
-    lt_1 = (ctrl_0 + ctrl_1) * 0.5f;
-    rt_2 = (ctrl_2 + ctrl_3) * 0.5f;
-
-    // mid points
-    lt_2 = (lt_1 + t) * 0.5f;
-    rt_1 = (rt_2 + t) * 0.5f;
-
-    // middle (on curve)
-    lt_3 = (lt_2 + rt_1) * 0.5f;
-    rt_0 = lt_3;
-
-    // Recursively compute the left and right sides of the curve
-    auto lt_sample = divide_curve(lt_0, lt_1, lt_2, lt_3, level - 1);
-    auto rt_sample = divide_curve(rt_0, rt_1, rt_2, rt_3, level - 1);
-
-    std::vector<Vector3> result;
-    result.reserve(lt_sample.size() + rt_sample.size() - 1);
-
-    // Insert all of the left curve
-    result.insert(result.end(), lt_sample.begin(), lt_sample.end());
-    // Insert all of the right curve, except for the first vertex (which is the
-    // same as the last vertex in the left curve)
-    result.insert(result.end(), std::next(rt_sample.begin()), rt_sample.end());
-
-    return result;
 }
 
-uint16_t MeshTeapot::add_vertex(const Vector3 &v, bool find_existing)
+void MeshTeapot::build(BezierResolution resolution, int32_t position_loc, int32_t normal_loc)
 {
-    if(find_existing) return TriSurface::add_vertex(Point3(v.x, v.y, v.z));
-
-    // Don't search for an equivalent vertex, just append to the vertex list
-    vertices_.push_back(VertexAndNormal(Point3(v.x, v.y, v.z)));
-    return static_cast<uint16_t>(vertices_.size() - 1);
-}
-
-void MeshTeapot::add_patch(const std::vector<std::vector<Vector3>> &patch)
-{
-    size_t patch_size = patch.size();
-    size_t max_idx = patch_size - 1;
-
-    std::vector<std::vector<uint16_t>> patch_idxs(patch_size);
-
-    // Initialize index arrays
-    for(size_t i = 0; i < patch_size; ++i) patch_idxs[i].resize(patch_size);
-
-    // Add left column edge vertices
-    for(size_t r = 0; r < patch_size; ++r) patch_idxs[0][r] = add_vertex(patch[0][r], true);
-
-    // Add right column edge vertices
-    for(size_t r = 0; r < patch_size; ++r)
-        patch_idxs[max_idx][r] = add_vertex(patch[max_idx][r], true);
-
-    // Add bottom row edge vertices
-    for(size_t c = 1; c < max_idx; ++c) patch_idxs[c][0] = add_vertex(patch[c][0], true);
-
-    // Add top row edge vertices
-    for(size_t c = 1; c < max_idx; ++c)
-        patch_idxs[c][max_idx] = add_vertex(patch[c][max_idx], true);
-
-    // Add middle vertices
-    for(size_t r = 1; r < max_idx; ++r)
-        for(size_t c = 1; c < max_idx; ++c) patch_idxs[c][r] = add_vertex(patch[c][r], false);
-
-    // Add the faces using the indices returned by 'add_vertex'
-    for(size_t r = 0; r < max_idx; ++r)
+    // Evaluate all 32 patches and stitch them together
+    std::vector<BezierPatch> patches;
+    get_patches(patches);
+    BezierTessellator tessellator;
+    if(!tessellator.tessellate(patches, resolution))
     {
-        for(size_t c = 0; c < max_idx; ++c)
-        {
-            faces_.push_back(patch_idxs[c][r]);
-            faces_.push_back(patch_idxs[c + 1][r + 1]);
-            faces_.push_back(patch_idxs[c + 1][r]);
-
-            faces_.push_back(patch_idxs[c][r]);
-            faces_.push_back(patch_idxs[c][r + 1]);
-            faces_.push_back(patch_idxs[c + 1][r + 1]);
-        }
+        std::cout << "MeshTeapot: " << resolution.u_segments << " x " << resolution.v_segments
+                  << " segments per patch exceed 32 bit indexes\n";
     }
+    construct(tessellator.get_vertices(), tessellator.get_faces());
+
+    // Patches are emitted one row at a time; reorder the faces for the vertex
+    // cache and overdraw (the spout and handle cover parts of the body)
+    optimize_face_order(true);
+
+    // End the mesh - construct vertex normals by averaging
+    end(position_loc, normal_loc);
 }
 
 } // namespace cg
@@ -5,76 +5,62 @@
 //
 //	Author:  David W. Nesbitt, Brian Russin
 //	File:    mesh_teapot.hpp
-//	Purpose: Construction of the Utah teapot using recursive subdivision.
+//	Purpose: Construction of the Utah teapot from its Bezier patches.
 //============================================================================
 
 #ifndef __SCENE_MESH_TEAPOT_HPP__
 #define __SCENE_MESH_TEAPOT_HPP__
 
-#include "geometry/point3.hpp"
-#include "geometry/vector3.hpp"
+#include "geometry/bezier_patch.hpp"
 #include "scene/tri_surface.hpp"
 
 namespace cg
 {
 
 /**
- *
+ * Utah teapot: 32 bicubic Bezier patches tessellated on the CPU (see
+ * BezierTessellator).
  */
 class MeshTeapot : public TriSurface
 {
   public:
     /**
-     * Constructs the Utah teapot using uniform patch subdivision.  Reads in the
-     * patch vertices and indices into a Vector3 array.  Recursively subdivides and store
-     *	patches into a mesh surface.
-     * @param level Number of levels to subdivide the patches
-     *              Note: level cannot exceed 5, otherwise the number or vertices
-     *                    exceeds the maximum allowed ( max<uint16_t> )
+     * Constructs the Utah teapot with each patch divided into 2^level
+     * segments along each side (the subdivision levels of earlier
+     * versions).
+     * @param level Number of times to halve the patches. Level 6 and
+     *              higher exceed 65,536 vertices and use 32 bit indexes.
      */
     MeshTeapot(uint16_t level, int32_t position_loc, int32_t normal_loc);
 
-  private:
     /**
-     * Divides a patch represented by a 4x4 set of Vector3 vertices.  Each patch
-     * is subdivided into 4 patches.  If the recursion level is 0, the patch is
-     * stored in the mesh surface.
-     * @param patch Patch (4x4 array of Vector3)
-     * @param level Current level of subdivision
+     * Constructs the Utah teapot with any number of segments per patch.
+     * @param  u_segments  Segments along the u side of each patch
+     * @param  v_segments  Segments along the v side of each patch
      */
-    void divide_patch(std::array<std::array<Vector3, 4>, 4> patch, uint16_t level);
+    MeshTeapot(uint32_t u_segments, uint32_t v_segments, int32_t position_loc, int32_t normal_loc);
 
     /**
-     * Helper function to divide a curve recursively until level == 0
-     * @param ctrl_0 Beginning point of a curve
-     * @param ctrl_1 Control point 1 of a curve
-     * @param ctrl_2 Control point 2 of a curve
-     * @param ctrl_3 End point of a curve
-     * @param level Current level of subdivision
-     * @return The fully sub-divided curve
+     * Get the control points of the 32 teapot patches.
+     * @param  patches  Returns the patches.
      */
-    static std::vector<Vector3> divide_curve(const Vector3 &ctrl_0,
-                                             const Vector3 &ctrl_1,
-                                             const Vector3 &ctrl_2,
-                                             const Vector3 &ctrl_3,
-                                             uint16_t       level);
+    static void get_patches(std::vector<BezierPatch> &patches);
 
     /**
-     * Adds a vertex to the mesh; calls TriSurface::add_vertex if
-     * 'find_existing' is true, otherwise appends 'v' to the back
-     * of the mesh.
-     * @param v Vector3 the vertex to add to the mesh
-     * @param find_existing whether or not to search for an already
-     *                      existing vertex at 'v'
-     * @return The index of the added vertex in the mesh
+     * Get the 306 shared control points of the teapot and the 16 control
+     * point indexes of each of its 32 patches (for tessellation on the GPU,
+     * see BezierPatchNode). Patch p uses indexes 16p through 16p + 15, with
+     * index 16p + 4i + j for the control point in column i and row j.
+     * @param  points   Returns the control points.
+     * @param  indices  Returns the patch control point indexes.
      */
-    uint16_t add_vertex(const Vector3 &v, bool find_existing);
+    static void get_control_points(std::vector<Point3> &points, std::vector<uint16_t> &indices);
 
+  private:
     /**
-     * Adds a sub-divided patch to the mesh
-     * @param patch double vector of Vector3
+     * Tessellate the patches and create the vertex buffers.
      */
-    void add_patch(const std::vector<std::vector<Vector3>> &patch);
+    void build(BezierResolution resolution, int32_t position_loc, int32_t normal_loc);
 };
 
 } // namespace cg
@@ -0,0 +1,226 @@
+#include "scene/occlusion_queries.hpp"
+
+#include <cstdint>
+#include <iostream>
+
+namespace cg
+{
+
+namespace
+{
+
+// Box shader. The unit cube is scaled and offset to the bounding box.
+const char *BOX_VERTEX_SHADER = R"(#version 410 core
+in vec3 vtx_position;
+uniform mat4 pvm_matrix;
+uniform vec3 box_min;
+uniform vec3 box_size;
+void main()
+{
+    gl_Position = pvm_matrix * vec4(box_min + vtx_position * box_size, 1.0);
+}
+)";
+
+const char *BOX_FRAGMENT_SHADER = R"(#version 410 core
+out vec4 frag_color;
+void main()
+{
+    frag_color = vec4(1.0);
+}
+)";
+
+// Unit cube corners and triangles
+const float UNIT_CUBE_VERTICES[] = {0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f,
+                                    0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 1.0f,
+                                    1.0f, 1.0f, 1.0f, 0.0f, 1.0f, 1.0f};
+
+const uint8_t UNIT_CUBE_FACES[] = {0, 2, 1, 0, 3, 2, 4, 5, 6, 4, 6, 7, 0, 1, 5, 0, 5, 4,
+                                   3, 6, 2, 3, 7, 6, 0, 4, 7, 0, 7, 3, 1, 2, 6, 1, 6, 5};
+
+// Check whether any corner of the box is in front of the near plane
+bool crosses_near_plane(const AABB &box, const Matrix4x4 &pvm)
+{
+    for(uint32_t i = 0; i < 8; i++)
+    {
+        float x = (i & 1) ? box.max_point.x : box.min_point.x;
+        float y = (i & 2) ? box.max_point.y : box.min_point.y;
+        float z = (i & 4) ? box.max_point.z : box.min_point.z;
+        float cz = pvm.m20() * x + pvm.m21() * y + pvm.m22() * z + pvm.m23();
+        float cw = pvm.m30() * x + pvm.m31() * y + pvm.m32() * z + pvm.m33();
+        if(cw <= 0.0f || cz < -cw) { return true; }
+    }
+    return false;
+}
+
+} // namespace
+
+OcclusionQueries::OcclusionQueries()
+    : pvm_matrix_loc_(-1), box_min_loc_(-1), box_size_loc_(-1), vao_(0), vbo_(0), ibo_(0),
+      target_(GL_ANY_SAMPLES_PASSED), initialized_(false), conditional_supported_(false),
+      conditional_render_(false), saved_cull_face_(false)
+{
+}
+
+OcclusionQueries::~OcclusionQueries()
+{
+    if(initialized_)
+    {
+        glDeleteBuffers(1, &vbo_);
+        glDeleteBuffers(1, &ibo_);
+        glDeleteVertexArrays(1, &vao_);
+        glDeleteProgram(shader_program_.get_program());
+    }
+}
+
+bool OcclusionQueries::init()
+{
+    if(initialized_) { return true; }
+
+    if(!vertex_shader_.create_from_source(BOX_VERTEX_SHADER) ||
+       !fragment_shader_.create_from_source(BOX_FRAGMENT_SHADER))
+    {
+        std::cout << "OcclusionQueries: box shader compile failed\n";
+        return false;
+    }
+    shader_program_.create();
+    if(!shader_program_.attach_shaders(vertex_shader_.get(), fragment_shader_.get()))
+    {
+        std::cout << "OcclusionQueries: box shader link failed\n";
+        return false;
+    }
+    GLuint program = shader_program_.get_program();
+    GLint  position_loc = glGetAttribLocation(program, "vtx_position");
+    pvm_matrix_loc_ = glGetUniformLocation(program, "pvm_matrix");
+    box_min_loc_ = glGetUniformLocation(program, "box_min");
+    box_size_loc_ = glGetUniformLocation(program, "box_size");
+    if(position_loc < 0 || pvm_matrix_loc_ < 0 || box_min_loc_ < 0 || box_size_loc_ < 0)
+    {
+        std::cout << "OcclusionQueries: error getting box shader locations\n";
+        return false;
+    }
+
+    glGenVertexArrays(1, &vao_);
+    glBindVertexArray(vao_);
+    glGenBuffers(1, &vbo_);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(UNIT_CUBE_VERTICES), UNIT_CUBE_VERTICES, GL_STATIC_DRAW);
+    glVertexAttribPointer(position_loc, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
+    glEnableVertexAttribArray(position_loc);
+    glGenBuffers(1, &ibo_);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo_);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(UNIT_CUBE_FACES), UNIT_CUBE_FACES, GL_STATIC_DRAW);
+    glBindVertexArray(0);
+
+    // Conservative queries are core in OpenGL 4.3, conditional rendering in
+    // OpenGL 3.0
+    GLint major = 0;
+    GLint minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+#ifdef GL_ANY_SAMPLES_PASSED_CONSERVATIVE
+    if(major > 4 || (major == 4 && minor >= 3)) { target_ = GL_ANY_SAMPLES_PASSED_CONSERVATIVE; }
+#endif
+    conditional_supported_ = (major >= 3);
+    conditional_render_ = conditional_supported_;
+
+    initialized_ = true;
+    return true;
+}
+
+bool OcclusionQueries::is_initialized() const { return initialized_; }
+
+void OcclusionQueries::set_conditional_render(bool enable)
+{
+    conditional_render_ = enable && conditional_supported_;
+}
+
+bool OcclusionQueries::uses_conditional_render() const { return conditional_render_; }
+
+void OcclusionQueries::save_state() { saved_cull_face_ = glIsEnabled(GL_CULL_FACE) == GL_TRUE; }
+
+void OcclusionQueries::poll(OcclusionQuery &query) const
+{
+    if(!query.pending) { return; }
+
+    GLuint available = 0;
+    glGetQueryObjectuiv(query.id, GL_QUERY_RESULT_AVAILABLE, &available);
+    if(available == GL_FALSE) { return; }
+
+    GLuint samples_passed = 0;
+    glGetQueryObjectuiv(query.id, GL_QUERY_RESULT, &samples_passed);
+    query.visible = (samples_passed != 0);
+    query.pending = false;
+}
+
+bool OcclusionQueries::query_box(GLStateCache    &gl,
+                                 OcclusionQuery  &query,
+                                 const AABB      &box,
+                                 const Matrix4x4 &pvm)
+{
+    if(!initialized_ || query.pending) { return false; }
+
+    // The box would be clipped, possibly leaving no samples for an object
+    // that surrounds the camera
+    if(box.is_empty() || crosses_near_plane(box, pvm))
+    {
+        query.visible = true;
+        return false;
+    }
+
+    if(query.id == 0) { glGenQueries(1, &query.id); }
+
+    // Draw the box into the depth test only. Both faces are drawn so the
+    // result does not depend on the winding after the transform.
+    GLuint program = gl.get_program();
+    if(program == 0)
+    {
+        GLint current = 0;
+        glGetIntegerv(GL_CURRENT_PROGRAM, &current);
+        program = static_cast<GLuint>(current);
+    }
+    GLboolean depth_mask = gl.get_depth_mask();
+    GLboolean color_mask[4];
+    gl.get_color_mask(color_mask);
+    gl.use_program(shader_program_.get_program());
+    gl.color_mask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    gl.depth_mask(GL_FALSE);
+    if(saved_cull_face_) { glDisable(GL_CULL_FACE); }
+
+    gl.uniform_matrix4fv(pvm_matrix_loc_, pvm.get());
+    gl.uniform3f(box_min_loc_, box.min_point.x, box.min_point.y, box.min_point.z);
+    gl.uniform3f(box_size_loc_,
+                 box.max_point.x - box.min_point.x,
+                 box.max_point.y - box.min_point.y,
+                 box.max_point.z - box.min_point.z);
+    glBeginQuery(target_, query.id);
+    gl.bind_vertex_array(vao_);
+    glDrawElements(GL_TRIANGLES, sizeof(UNIT_CUBE_FACES), GL_UNSIGNED_BYTE, (void *)0);
+    glEndQuery(target_);
+
+    if(saved_cull_face_) { glEnable(GL_CULL_FACE); }
+    gl.depth_mask(depth_mask);
+    gl.color_mask(color_mask[0], color_mask[1], color_mask[2], color_mask[3]);
+    gl.use_program(program);
+
+    query.pending = true;
+    return true;
+}
+
+void OcclusionQueries::begin_conditional(const OcclusionQuery &query) const
+{
+    // Do not wait: if the GPU has not finished the query, draw anyway
+    if(conditional_render_) { glBeginConditionalRender(query.id, GL_QUERY_NO_WAIT); }
+}
+
+void OcclusionQueries::end_conditional() const
+{
+    if(conditional_render_) { glEndConditionalRender(); }
+}
+
+void OcclusionQueries::release(OcclusionQuery &query)
+{
+    if(query.id != 0) { glDeleteQueries(1, &query.id); }
+    query = OcclusionQuery();
+}
+
+} // namespace cg
@@ -0,0 +1,154 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:	 David W. Nesbitt
+//	File:    occlusion_queries.hpp
+//	Purpose: Hardware occlusion queries on bounding boxes. Results are read
+//           back a frame late so drawing never waits on the GPU.
+//
+//============================================================================
+
+#ifndef __SCENE_OCCLUSION_QUERIES_HPP__
+#define __SCENE_OCCLUSION_QUERIES_HPP__
+
+#include "geometry/aabb.hpp"
+#include "geometry/matrix.hpp"
+#include "scene/gl_state_cache.hpp"
+#include "scene/graphics.hpp"
+
+#include "shader_support/glsl_shader.hpp"
+#include "shader_support/glsl_shader_program.hpp"
+
+namespace cg
+{
+
+/**
+ * Occlusion query state for one object. The object is drawn while
+ * visible is true. visible only changes when a query result arrives.
+ */
+struct OcclusionQuery
+{
+    GLuint id = 0;          // GL query object (0 until first issued)
+    bool   pending = false; // A query has been issued and its result not read
+    bool   visible = true;  // Result of the last query that completed
+};
+
+/**
+ * Issues occlusion queries by drawing bounding boxes with a trivial shader
+ * (color and depth writes off). Uses GL_ANY_SAMPLES_PASSED_CONSERVATIVE when
+ * the context supports it (OpenGL 4.3), otherwise GL_ANY_SAMPLES_PASSED.
+ *
+ * Typical use for each object, drawn front to back after the occluders:
+ *   poll(q)                       - read last frame's result if available
+ *   query_box(gl, q, box, pvm)    - if no query is pending
+ *   if(!q.visible) skip the object until a later query passes
+ *   begin_conditional(q) / draw / end_conditional()
+ */
+class OcclusionQueries
+{
+  public:
+    /**
+     * Constructor.
+     */
+    OcclusionQueries();
+
+    /**
+     * Destructor. Deletes the GL objects (requires a current context).
+     */
+    ~OcclusionQueries();
+
+    /**
+     * Compile the box shader and create the box vertex array. Requires a
+     * current GL context.
+     * @return  Returns true if successful, false if the shader failed.
+     */
+    bool init();
+
+    /**
+     * Check whether init succeeded.
+     * @return  Returns true if queries can be issued.
+     */
+    bool is_initialized() const;
+
+    /**
+     * Enable or disable conditional rendering (enabled by default when the
+     * context supports it).
+     * @param  enable  True to draw objects with glBeginConditionalRender.
+     */
+    void set_conditional_render(bool enable);
+
+    /**
+     * Check whether objects are drawn with conditional rendering.
+     * @return  Returns true if conditional rendering is used.
+     */
+    bool uses_conditional_render() const;
+
+    /**
+     * Save the face culling state. Call before issuing queries and again
+     * whenever other code may have changed it, since query_box restores it
+     * after drawing the box.
+     */
+    void save_state();
+
+    /**
+     * Read the result of a pending query if it is available. Never waits.
+     * @param  query  Query state (visible is updated when a result arrives).
+     */
+    void poll(OcclusionQuery &query) const;
+
+    /**
+     * Issue a query for a bounding box against the current depth buffer.
+     * Objects whose box crosses the near plane are marked visible and no
+     * query is issued (the box would be clipped). The program in use and
+     * the write masks (as known to the GL state cache) are restored
+     * afterwards.
+     * @param  gl     GL state cache
+     * @param  query  Query state
+     * @param  box    Bounding box (modeling coordinates)
+     * @param  pvm    Composite projection, view, model matrix
+     * @return  Returns true if a query was issued.
+     */
+    bool query_box(GLStateCache &gl, OcclusionQuery &query, const AABB &box, const Matrix4x4 &pvm);
+
+    /**
+     * Begin drawing conditionally on a query issued this frame. Does
+     * nothing if conditional rendering is not used.
+     * @param  query  Query issued this frame
+     */
+    void begin_conditional(const OcclusionQuery &query) const;
+
+    /**
+     * End drawing conditionally (after begin_conditional).
+     */
+    void end_conditional() const;
+
+    /**
+     * Delete the GL query object of an object.
+     * @param  query  Query state (reset to visible with no pending query).
+     */
+    static void release(OcclusionQuery &query);
+
+  protected:
+    GLSLVertexShader   vertex_shader_;
+    GLSLFragmentShader fragment_shader_;
+    GLSLShaderProgram  shader_program_;
+    GLint              pvm_matrix_loc_;
+    GLint              box_min_loc_;
+    GLint              box_size_loc_;
+    GLuint             vao_;
+    GLuint             vbo_;
+    GLuint             ibo_;
+    GLenum             target_;
+    bool               initialized_;
+    bool               conditional_supported_;
+    bool               conditional_render_;
+
+    // State restored after drawing a box
+    bool saved_cull_face_;
+};
+
+} // namespace cg
+
+#endif
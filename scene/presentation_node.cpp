@@ -6,8 +6,19 @@
 namespace cg
 {
 
+namespace
+{
+
+bool same_color(const Color4 &c0, const Color4 &c1)
+{
+    return c0.r == c1.r && c0.g == c1.g && c0.b == c1.b && c0.a == c1.a;
+}
+
+} // namespace
+
 PresentationNode::PresentationNode() :
-    texture_id_(0), has_texture_(false), use_texture_(false)
+    texture_id_(0), has_texture_(false), use_texture_(false), owns_texture_(false),
+    material_index_(INVALID_MATERIAL), material_changed_(true)
 {
     node_type_ = SceneNodeType::PRESENTATION;
     material_shininess_ = 1.0f;
@@ -25,35 +36,74 @@ PresentationNode::PresentationNode(const Color4 &ambient,
     material_shininess_(shininess),
     texture_id_(0),
     has_texture_(false),
-    use_texture_(false)
+    use_texture_(false),
+    owns_texture_(false),
+    material_index_(INVALID_MATERIAL),
+    material_changed_(true)
 {
     node_type_ = SceneNodeType::PRESENTATION;
 }
 
+PresentationNode::PresentationNode(const PresentationNode &other) :
+    SceneNode(other),
+    texture_id_(0),
+    has_texture_(false),
+    use_texture_(false),
+    owns_texture_(false),
+    material_index_(INVALID_MATERIAL),
+    material_changed_(true)
+{
+    copy_material(other);
+}
+
 PresentationNode::~PresentationNode()
 {
-    // Clean up texture if one was loaded
-    if(has_texture_)
+    // Give up the material table entry unless the registry is gone
+    if(auto registry = material_registry_.lock()) { (*registry)->release(material_index_); }
+
+    // Clean up texture if one was loaded (not one copied from another node)
+    if(owns_texture_)
     {
         glDeleteTextures(1, &texture_id_);
     }
 }
 
-void PresentationNode::set_material_ambient(const Color4 &c) { material_ambient_ = c; }
+void PresentationNode::set_material_ambient(const Color4 &c)
+{
+    material_ambient_ = c;
+    material_changed_ = true;
+}
 
-void PresentationNode::set_material_diffuse(const Color4 &c) { material_diffuse_ = c; }
+void PresentationNode::set_material_diffuse(const Color4 &c)
+{
+    material_diffuse_ = c;
+    material_changed_ = true;
+}
 
 void PresentationNode::set_material_ambient_and_diffuse(const Color4 &c)
 {
     material_ambient_ = c;
     material_diffuse_ = c;
+    material_changed_ = true;
 }
 
-void PresentationNode::set_material_specular(const Color4 &c) { material_specular_ = c; }
+void PresentationNode::set_material_specular(const Color4 &c)
+{
+    material_specular_ = c;
+    material_changed_ = true;
+}
 
-void PresentationNode::set_material_emission(const Color4 &c) { material_emission_ = c; }
+void PresentationNode::set_material_emission(const Color4 &c)
+{
+    material_emission_ = c;
+    material_changed_ = true;
+}
 
-void PresentationNode::set_material_shininess(float s) { material_shininess_ = s; }
+void PresentationNode::set_material_shininess(float s)
+{
+    material_shininess_ = s;
+    material_changed_ = true;
+}
 
 // NEW: Load texture from file
 bool PresentationNode::load_texture(const std::string &filename, bool use_mipmaps)
@@ -110,6 +160,8 @@ bool PresentationNode::load_texture(const std::string &filename, bool use_mipmap
 
     has_texture_ = true;
     use_texture_ = true;
+    owns_texture_ = true;
+    material_changed_ = true;
 
     std::cout << "PresentationNode: Successfully loaded texture: " << filename << '\n';
     return true;
@@ -121,35 +173,108 @@ void PresentationNode::enable_texture(bool enable)
     if(has_texture_)
     {
         use_texture_ = enable;
+        material_changed_ = true;
     }
 }
 
 // NEW: Bind texture
-void PresentationNode::bind_texture()
+void PresentationNode::bind_texture(SceneState &scene_state)
+{
+    if(has_texture_ && use_texture_) { scene_state.gl_state.bind_texture(0, texture_id_); }
+}
+
+void PresentationNode::copy_material(const PresentationNode &other)
+{
+    material_ambient_ = other.material_ambient_;
+    material_diffuse_ = other.material_diffuse_;
+    material_specular_ = other.material_specular_;
+    material_emission_ = other.material_emission_;
+    material_shininess_ = other.material_shininess_;
+    if(owns_texture_) { glDeleteTextures(1, &texture_id_); }
+    texture_id_ = other.texture_id_;
+    has_texture_ = other.has_texture_;
+    use_texture_ = other.use_texture_;
+    owns_texture_ = false;
+    material_changed_ = true;
+}
+
+bool PresentationNode::same_material(const PresentationNode &other) const
+{
+    return same_color(material_ambient_, other.material_ambient_) &&
+           same_color(material_diffuse_, other.material_diffuse_) &&
+           same_color(material_specular_, other.material_specular_) &&
+           same_color(material_emission_, other.material_emission_) &&
+           material_shininess_ == other.material_shininess_ &&
+           get_texture() == other.get_texture();
+}
+
+GLuint PresentationNode::get_texture() const
 {
-    if(has_texture_ && use_texture_)
+    return (has_texture_ && use_texture_) ? texture_id_ : 0;
+}
+
+uint32_t PresentationNode::get_material_index(MaterialRegistry &materials)
+{
+    if(material_changed_)
     {
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture_id_);
+        Material m = {};
+        m.ambient = material_ambient_;
+        m.diffuse = material_diffuse_;
+        m.specular = material_specular_;
+        m.emission = material_emission_;
+        m.shininess = material_shininess_;
+        m.use_texture = (use_texture_ && has_texture_) ? 1 : 0;
+
+        // Give up the old entry first so it can be reused for the new one.
+        // A full table is reported once, until the material changes again.
+        if(auto registry = material_registry_.lock()) { (*registry)->release(material_index_); }
+        material_index_ = materials.add(m, get_texture());
+        material_changed_ = false;
+        material_registry_.reset();
+        if(material_index_ != INVALID_MATERIAL) { material_registry_ = materials.get_handle(); }
     }
+    return material_index_;
 }
 
-void PresentationNode::draw(SceneState &scene_state)
+void PresentationNode::apply_material(SceneState &scene_state)
 {
+    GLStateCache &gl = scene_state.gl_state;
+    if(scene_state.material_index_loc >= 0)
+    {
+        // The program reads the material from the material table. If the
+        // table is full, fall back to the material uniforms.
+        uint32_t index = get_material_index(scene_state.materials);
+        if(index != INVALID_MATERIAL)
+        {
+            gl.uniform1i(scene_state.material_index_loc, static_cast<GLint>(index));
+            if(use_texture_ && has_texture_)
+            {
+                bind_texture(scene_state);
+                gl.uniform1i(scene_state.texture_sampler_loc, 0); // Texture unit 0
+            }
+            return;
+        }
+    }
+
     // Set the material uniform values
-    glUniform4fv(scene_state.material_ambient_loc, 1, &material_ambient_.r);
-    glUniform4fv(scene_state.material_diffuse_loc, 1, &material_diffuse_.r);
-    glUniform4fv(scene_state.material_specular_loc, 1, &material_specular_.r);
-    glUniform4fv(scene_state.material_emission_loc, 1, &material_emission_.r);
-    glUniform1f(scene_state.material_shininess_loc, material_shininess_);
+    gl.uniform4fv(scene_state.material_ambient_loc, &material_ambient_.r);
+    gl.uniform4fv(scene_state.material_diffuse_loc, &material_diffuse_.r);
+    gl.uniform4fv(scene_state.material_specular_loc, &material_specular_.r);
+    gl.uniform4fv(scene_state.material_emission_loc, &material_emission_.r);
+    gl.uniform1f(scene_state.material_shininess_loc, material_shininess_);
 
     // NEW: Set texture uniforms
-    glUniform1i(scene_state.use_texture_loc, use_texture_ && has_texture_);
+    gl.uniform1i(scene_state.use_texture_loc, use_texture_ && has_texture_);
     if(use_texture_ && has_texture_)
     {
-        bind_texture();
-        glUniform1i(scene_state.texture_sampler_loc, 0); // Texture unit 0
+        bind_texture(scene_state);
+        gl.uniform1i(scene_state.texture_sampler_loc, 0); // Texture unit 0
     }
+}
+
+void PresentationNode::draw(SceneState &scene_state)
+{
+    apply_material(scene_state);
 
     // Draw children of this node
     SceneNode::draw(scene_state);
@@ -46,10 +46,19 @@ class PresentationNode : public SceneNode
                      float         shininess);
 
     /**
-     * Destructor
+     * Copy constructor. Copies the material as copy_material does; the copy
+     * registers its material on its own.
+     * @param  other  Node to copy
+     */
+    PresentationNode(const PresentationNode &other);
+
+    /**
+     * Destructor. Releases the material table entry.
      */
     ~PresentationNode();
 
+    PresentationNode &operator=(const PresentationNode &) = delete;
+
     /**
      * Set material ambient reflection coefficient.
      * @param  c  Ambient reflection coefficients (color).
@@ -103,8 +112,50 @@ class PresentationNode : public SceneNode
 
     /**
      * NEW: Bind the texture for rendering.
+     * @param  scene_state  Scene state (holds the GL state cache)
      */
-    void bind_texture();
+    void bind_texture(SceneState &scene_state);
+
+    /**
+     * Get the texture bound when the material is applied.
+     * @return  Returns the texture name (0 if no texture is used).
+     */
+    GLuint get_texture() const;
+
+    /**
+     * Copy the material properties and texture of another node (not its
+     * children). The texture is shared, so the other node must outlive
+     * this one.
+     * @param  other  Node to copy the material from
+     */
+    void copy_material(const PresentationNode &other);
+
+    /**
+     * Check whether another node has the same material properties and
+     * texture.
+     * @param  other  Node to compare with
+     * @return  Returns true if drawing with either node looks the same.
+     */
+    bool same_material(const PresentationNode &other) const;
+
+    /**
+     * Get the index of this node's material in the material table,
+     * registering the material the first time and after it changes. A
+     * changed material releases the entry of the old one.
+     * @param  materials  Material registry
+     * @return  Returns the material index, or INVALID_MATERIAL if the table
+     *          is full.
+     */
+    uint32_t get_material_index(MaterialRegistry &materials);
+
+    /**
+     * Set the material properties and texture without drawing children. Used
+     * by draw() and by compiled render queues. If the program reads the
+     * material table only the material index is set. If the table is full
+     * the material uniforms are set instead (if the program has them).
+     * @param  scene_state  Scene state (holds material uniform locations)
+     */
+    virtual void apply_material(SceneState &scene_state);
 
     /**
      * Draw. Sets the material properties and texture.
@@ -123,6 +174,13 @@ class PresentationNode : public SceneNode
     GLuint texture_id_;
     bool   has_texture_;
     bool   use_texture_;
+    bool   owns_texture_; // False if the texture was copied from another node
+
+    // Material table index, valid unless the material changed since it was
+    // registered. The registry is held while the node uses an entry.
+    uint32_t                          material_index_;
+    bool                              material_changed_;
+    std::weak_ptr<MaterialRegistry *> material_registry_;
 };
 
 } // namespace cg
@@ -0,0 +1,660 @@
+#include "scene/render_queue.hpp"
+#include "scene/geometry_node.hpp"
+#include "scene/transform_node.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <typeinfo>
+#include <unordered_map>
+
+namespace cg
+{
+
+namespace
+{
+
+// Sort key fields (see RenderQueue)
+constexpr uint32_t SEGMENT_SHIFT = 48;
+constexpr uint32_t PROGRAM_SHIFT = 40;
+constexpr uint32_t TEXTURE_SHIFT = 32;
+constexpr uint32_t GEOMETRY_SHIFT = 24;
+constexpr uint32_t MATERIAL_SHIFT = 16;
+constexpr uint32_t DEPTH_SHIFT = 16;
+constexpr uint64_t MAX_SEGMENT = 0xFFFF;
+constexpr uint64_t MAX_RANK = 0xFF;
+
+// Rank of a state value in the order values are first found (0 is kept for
+// no value). Values past the largest rank share it, which only costs
+// grouping.
+template <typename T> uint64_t rank(std::unordered_map<T, uint64_t> &ranks, T value)
+{
+    if(value == T()) { return 0; }
+    auto it = ranks.find(value);
+    if(it == ranks.end()) { it = ranks.emplace(value, ranks.size() + 1).first; }
+    return (it->second < MAX_RANK) ? it->second : MAX_RANK;
+}
+
+// Location of a record's mesh in a geometry pool (nullptr for subtrees and
+// geometry with its own buffers)
+const PooledMesh *pooled_mesh(const DrawRecord &r)
+{
+    if(r.is_subtree) { return nullptr; }
+    return static_cast<const GeometryNode *>(r.geometry)->get_pooled_mesh();
+}
+
+// Set the world matrices of a record and its bounds relative to the
+// compiled root
+void set_world(DrawRecord &r, const AffineTransform3 &world)
+{
+    r.world = world;
+    r.world_matrix = world.get_matrix();
+    r.normal_matrix = world.get_normal_matrix();
+    r.has_bounds = r.geometry->get_bounds(r.bounds);
+    if(r.has_bounds) { r.bounds = world * r.bounds; }
+}
+
+} // namespace
+
+RenderQueue::RenderQueue() :
+    compiled_version_(0), compiled_structure_version_(0), compiled_(false), sortable_(false)
+{
+}
+
+RenderQueue::~RenderQueue() { release_queries(); }
+
+void RenderQueue::compile(const SceneNode &root)
+{
+    records_.clear();
+    transforms_.clear();
+    release_queries();
+
+    AffineTransform3  identity;
+    ShaderNode       *shader = nullptr;
+    PresentationNode *material = nullptr;
+    for(const auto &c : root.get_children())
+    {
+        compile_node(c.get(), identity, NO_TRANSFORM, shader, material);
+    }
+
+    build_sort_keys();
+    queries_.resize(records_.size());
+    compiled_version_ = root.get_version();
+    compiled_structure_version_ = root.get_structure_version();
+    compiled_ = true;
+}
+
+void RenderQueue::clear()
+{
+    records_.clear();
+    transforms_.clear();
+    release_queries();
+    compiled_ = false;
+}
+
+bool RenderQueue::is_stale(const SceneNode &root) const
+{
+    return !compiled_ || compiled_structure_version_ != root.get_structure_version();
+}
+
+void RenderQueue::update_transforms(const SceneNode &root)
+{
+    if(root.get_version() == compiled_version_) { return; }
+    compiled_version_ = root.get_version();
+
+    // Parents come before their children, so a transform whose parent moved
+    // is found to have moved as well
+    const AffineTransform3 identity;
+    bool                   moved = false;
+    for(auto &t : transforms_)
+    {
+        t.moved = t.node->get_matrix_version() != t.matrix_version ||
+                  (t.parent != NO_TRANSFORM && transforms_[t.parent].moved);
+        if(!t.moved) continue;
+        const AffineTransform3 &parent =
+            (t.parent != NO_TRANSFORM) ? transforms_[t.parent].world : identity;
+        t.world = parent * t.node->get_matrix();
+        t.matrix_version = t.node->get_matrix_version();
+        moved = true;
+    }
+    if(!moved) { return; }
+
+    for(auto &r : records_)
+    {
+        if(r.transform != NO_TRANSFORM && transforms_[r.transform].moved)
+        {
+            set_world(r, transforms_[r.transform].world);
+        }
+    }
+}
+
+void RenderQueue::draw(SceneState &scene_state) const
+{
+    // Model matrix above the compiled root. This is the identity unless the
+    // queue is drawn below a transform node, in which case the cached world
+    // and normal matrices have to be composed with it.
+    const AffineTransform3 parent = scene_state.model_matrix;
+    const bool             parent_is_identity = (parent.get_type() == AffineType::IDENTITY);
+
+    // Rasterize the visible occluders before drawing anything
+    OcclusionBuffer *occlusion = scene_state.occlusion_buffer;
+    if(occlusion != nullptr)
+    {
+        occlusion->clear();
+        for(const auto &r : records_)
+        {
+            if(r.is_subtree) continue;
+            const auto *geometry = static_cast<const GeometryNode *>(r.geometry);
+            if(!geometry->is_occluder() ||
+               (r.has_bounds &&
+                scene_state.frustum.is_outside(parent_is_identity ? r.bounds : parent * r.bounds)))
+            {
+                continue;
+            }
+            Matrix4x4 pvm = scene_state.pv * (parent_is_identity ? r.world : parent * r.world);
+            occlusion->add_occluder(geometry->get_occluder(), pvm);
+        }
+        occlusion->rasterize();
+    }
+
+    // Cull before any GL calls and build the sort key of each record left.
+    // The depth is the clip z of the bounds center, which increases with
+    // distance from the camera.
+    const Matrix4x4 &pv = scene_state.pv;
+    draws_.clear();
+    for(uint32_t i = 0; i < records_.size(); i++)
+    {
+        const DrawRecord &r = records_[i];
+        BoundingSphere    bounds;
+        if(r.has_bounds)
+        {
+            bounds = parent_is_identity ? r.bounds : parent * r.bounds;
+            if(scene_state.frustum.is_outside(bounds))
+            {
+                scene_state.nodes_culled++;
+                continue;
+            }
+        }
+
+        // Skip geometry hidden behind the occluders. Occluders are not
+        // tested against themselves.
+        if(occlusion != nullptr && !r.is_subtree)
+        {
+            const auto *geometry = static_cast<const GeometryNode *>(r.geometry);
+            if(!geometry->is_occluder() && geometry->has_local_bounds() &&
+               occlusion->is_occluded(geometry->get_bounding_box(),
+                                      pv * (parent_is_identity ? r.world : parent * r.world)))
+            {
+                scene_state.nodes_occluded++;
+                continue;
+            }
+        }
+
+        uint64_t key = r.sort_key;
+        if(r.has_bounds && !r.is_subtree)
+        {
+            const Point3 &c = bounds.center;
+            float         z = pv.m20() * c.x + pv.m21() * c.y + pv.m22() * c.z + pv.m23();
+            key |= float_to_sortable(z) >> DEPTH_SHIFT;
+        }
+        draws_.push_back({key, i});
+    }
+
+    scene_state.state_changes_unsorted += count_state_changes();
+    if(scene_state.sort_draws && sortable_)
+    {
+        scratch_.resize(draws_.size());
+        radix_sort(draws_.data(), scratch_.data(), draws_.size());
+    }
+    scene_state.state_changes += count_state_changes();
+
+    // Queries restore the program that is current when they are issued
+    OcclusionQueries *queries = scene_state.occlusion_queries;
+    if(queries != nullptr) { queries->save_state(); }
+
+    // Whether a run's program supports instancing is checked when the run
+    // is drawn, since records may be drawn with different programs
+    runs_.clear();
+    if(scene_state.instance_draws && queries == nullptr) { build_instance_runs(scene_state, parent); }
+
+    const ShaderNode       *current_shader = nullptr;
+    const PresentationNode *current_material = nullptr;
+    AffineTransform3        model_transform;
+    Matrix4x4               model_matrix;
+    Matrix4x4               normal_matrix;
+    size_t                  next_run = 0;
+    for(size_t k = 0; k < draws_.size(); k++)
+    {
+        if(next_run < runs_.size() && runs_[next_run].first_draw == k)
+        {
+            // Draw the run with one call. Matrices and materials come from
+            // the instance buffer; the material of the first record binds
+            // the texture all of them share. If the program cannot draw
+            // instances, the records are drawn one at a time below.
+            const InstanceRun &run = runs_[next_run++];
+            const DrawRecord  &first = records_[draws_[k].index];
+            apply_state(scene_state, first, current_shader, current_material);
+            if(scene_state.instanced_loc >= 0 && scene_state.material_index_loc >= 0)
+            {
+                GLStateCache &gl = scene_state.gl_state;
+                gl.uniform_matrix4fv(scene_state.pv_matrix_loc, pv.get());
+                gl.uniform1i(scene_state.instanced_loc, 1);
+                static_cast<GeometryNode *>(first.geometry)
+                    ->draw_instances(scene_state, instances_, run.first_instance, run.count);
+                gl.uniform1i(scene_state.instanced_loc, 0);
+                scene_state.nodes_drawn += run.count;
+                k += run.count - 1;
+                continue;
+            }
+        }
+        const SortItem   &d = draws_[k];
+        const DrawRecord &r = records_[d.index];
+
+        const AffineTransform3 *transform = &r.world;
+        const Matrix4x4        *model = &r.world_matrix;
+        const Matrix4x4        *normal = &r.normal_matrix;
+        if(!parent_is_identity)
+        {
+            model_transform = parent * r.world;
+            model_matrix = model_transform.get_matrix();
+            normal_matrix = model_transform.get_normal_matrix();
+            transform = &model_transform;
+            model = &model_matrix;
+            normal = &normal_matrix;
+        }
+        Matrix4x4 pvm = pv * (*transform);
+
+        // Query the bounding box against what has been drawn so far. The
+        // result is read on a later frame, so the record is drawn (or
+        // skipped) based on the most recent result that has arrived.
+        OcclusionQuery *query = nullptr;
+        if(queries != nullptr && !r.is_subtree)
+        {
+            const auto *geometry = static_cast<const GeometryNode *>(r.geometry);
+            if(!geometry->is_occluder() && geometry->has_local_bounds())
+            {
+                OcclusionQuery &q = queries_[d.index];
+                queries->poll(q);
+                bool issued = queries->query_box(scene_state.gl_state, q,
+                                                 geometry->get_bounding_box(), pvm);
+                if(!q.visible)
+                {
+                    scene_state.draws_skipped++;
+                    continue;
+                }
+                if(issued) { query = &q; }
+            }
+        }
+        scene_state.nodes_drawn++;
+
+        // Set the program and material only when they change between
+        // consecutive records
+        apply_state(scene_state, r, current_shader, current_material);
+
+        scene_state.gl_state.uniform_matrix4fv(scene_state.model_matrix_loc, model->get());
+        scene_state.gl_state.uniform_matrix4fv(scene_state.normal_matrix_loc, normal->get());
+        scene_state.gl_state.uniform_matrix4fv(scene_state.pvm_matrix_loc, pvm.get());
+
+        if(r.is_subtree)
+        {
+            // Subtrees may change shader and material state, so do not assume
+            // the current program and material are still set afterwards
+            scene_state.push_transforms();
+            scene_state.model_matrix = *transform;
+            r.geometry->draw(scene_state);
+            scene_state.pop_transforms();
+            current_shader = nullptr;
+            current_material = nullptr;
+            if(queries != nullptr) { queries->save_state(); }
+        }
+        else if(query != nullptr)
+        {
+            // Let the GPU drop the draw if this frame's query fails
+            queries->begin_conditional(*query);
+            r.geometry->draw(scene_state);
+            queries->end_conditional();
+        }
+        else
+        {
+            // Following draws from the same pool with the same material and
+            // transform go out with this one as a single multi-draw
+            // (stopping at the next instance run)
+            size_t   end = (next_run < runs_.size()) ? runs_[next_run].first_draw : draws_.size();
+            uint32_t n = (queries == nullptr) ? multi_draw_length(k, end) : 1;
+            if(n > 1)
+            {
+                multi_draw(scene_state, k, n);
+                scene_state.nodes_drawn += n - 1;
+                k += n - 1;
+            }
+            else r.geometry->draw(scene_state);
+        }
+    }
+}
+
+void RenderQueue::apply_state(SceneState              &scene_state,
+                              const DrawRecord        &r,
+                              const ShaderNode       *&current_shader,
+                              const PresentationNode *&current_material) const
+{
+    // Material uniforms belong to the program, so a new program needs the
+    // material set again
+    if(r.shader != nullptr && r.shader != current_shader)
+    {
+        r.shader->apply(scene_state);
+        current_shader = r.shader;
+        current_material = nullptr;
+    }
+    if(r.material != nullptr && r.material != current_material)
+    {
+        r.material->apply_material(scene_state);
+        current_material = r.material;
+    }
+}
+
+uint32_t RenderQueue::multi_draw_length(size_t first, size_t end) const
+{
+    const DrawRecord &r = records_[draws_[first].index];
+    const PooledMesh *mesh = pooled_mesh(r);
+    if(mesh == nullptr) { return 1; }
+
+    uint32_t n = 1;
+    while(first + n < end)
+    {
+        const DrawRecord &next = records_[draws_[first + n].index];
+        if(next.shader != r.shader || next.material != r.material) break;
+        const PooledMesh *m = pooled_mesh(next);
+        if(m == nullptr || m->pool != mesh->pool ||
+           std::memcmp(&next.world_matrix, &r.world_matrix, sizeof(Matrix4x4)) != 0)
+        {
+            break;
+        }
+        n++;
+    }
+    return n;
+}
+
+void RenderQueue::multi_draw(SceneState &scene_state, size_t first, uint32_t count) const
+{
+    multi_counts_.clear();
+    multi_offsets_.clear();
+    multi_base_vertices_.clear();
+    for(size_t i = first; i < first + count; i++)
+    {
+        const PooledMesh *m = pooled_mesh(records_[draws_[i].index]);
+        multi_counts_.push_back(m->index_count);
+        multi_offsets_.push_back((const void *)(m->first_index * sizeof(uint16_t)));
+        multi_base_vertices_.push_back(m->base_vertex);
+    }
+    pooled_mesh(records_[draws_[first].index])
+        ->pool->multi_draw(scene_state,
+                           multi_counts_.data(),
+                           multi_offsets_.data(),
+                           multi_base_vertices_.data(),
+                           count);
+}
+
+void RenderQueue::release_queries()
+{
+    for(auto &q : queries_) { OcclusionQueries::release(q); }
+    queries_.clear();
+}
+
+size_t RenderQueue::size() const { return records_.size(); }
+
+const std::vector<DrawRecord> &RenderQueue::get_records() const { return records_; }
+
+void RenderQueue::build_instance_runs(SceneState &scene_state, const AffineTransform3 &parent) const
+{
+    const bool parent_is_identity = (parent.get_type() == AffineType::IDENTITY);
+    instances_.clear();
+    uint32_t k = 0;
+    while(k < draws_.size())
+    {
+        const DrawRecord &first = records_[draws_[k].index];
+        uint32_t          n = 1;
+        if(can_instance(scene_state.materials, first, first))
+        {
+            while(k + n < draws_.size() &&
+                  can_instance(scene_state.materials, first, records_[draws_[k + n].index]))
+            {
+                n++;
+            }
+        }
+        if(n > 1)
+        {
+            runs_.push_back({k, n, instances_.size()});
+            for(uint32_t i = k; i < k + n; i++)
+            {
+                const DrawRecord &r = records_[draws_[i].index];
+                int32_t material =
+                    static_cast<int32_t>(r.material->get_material_index(scene_state.materials));
+                if(parent_is_identity) instances_.add(r.world_matrix, r.normal_matrix, material);
+                else
+                {
+                    AffineTransform3 world = parent * r.world;
+                    instances_.add(world.get_matrix(), world.get_normal_matrix(), material);
+                }
+            }
+        }
+        k += n;
+    }
+    if(!runs_.empty()) { instances_.upload(); }
+}
+
+bool RenderQueue::can_instance(MaterialRegistry &materials,
+                               const DrawRecord &first,
+                               const DrawRecord &r) const
+{
+    // Instances read their material from the material table, so each record
+    // needs its own material and an entry in the table. Only the texture has
+    // to be shared.
+    return !r.is_subtree && r.geometry == first.geometry && r.shader == first.shader &&
+           r.material != nullptr && first.material != nullptr &&
+           r.material->get_material_index(materials) != INVALID_MATERIAL &&
+           r.material->get_texture() == first.material->get_texture() &&
+           static_cast<const GeometryNode *>(r.geometry)->can_draw_instances();
+}
+
+void RenderQueue::build_sort_keys()
+{
+    // Pooled records with the same pool, material, and world matrix can be
+    // drawn with one multi-draw, so the group shares a geometry rank (keyed
+    // by its first record) to sort next to each other
+    std::vector<const void *> geometry_keys(records_.size());
+    std::vector<uint32_t>     pooled;
+    for(uint32_t i = 0; i < records_.size(); i++)
+    {
+        geometry_keys[i] = records_[i].geometry;
+        if(pooled_mesh(records_[i]) != nullptr) { pooled.push_back(i); }
+    }
+    auto group_less = [this](uint32_t a, uint32_t b)
+    {
+        const DrawRecord &ra = records_[a];
+        const DrawRecord &rb = records_[b];
+        if(pooled_mesh(ra)->pool != pooled_mesh(rb)->pool)
+        {
+            return std::less<const GeometryPool *>()(pooled_mesh(ra)->pool,
+                                                     pooled_mesh(rb)->pool);
+        }
+        if(ra.material != rb.material)
+        {
+            return std::less<const PresentationNode *>()(ra.material, rb.material);
+        }
+        return std::memcmp(&ra.world_matrix, &rb.world_matrix, sizeof(Matrix4x4)) < 0;
+    };
+    std::stable_sort(pooled.begin(), pooled.end(), group_less);
+    for(size_t i = 0; i < pooled.size();)
+    {
+        size_t j = i + 1;
+        while(j < pooled.size() && !group_less(pooled[i], pooled[j])) j++;
+        if(j - i > 1)
+        {
+            for(size_t g = i; g < j; g++) { geometry_keys[pooled[g]] = &records_[pooled[i]]; }
+        }
+        i = j;
+    }
+
+    std::unordered_map<const ShaderNode *, uint64_t>       programs;
+    std::unordered_map<GLuint, uint64_t>                   textures;
+    std::unordered_map<const void *, uint64_t>             geometry;
+    std::unordered_map<const PresentationNode *, uint64_t> materials;
+    uint64_t                                               segment = 0;
+    bool                                                   inherits_material = false;
+    for(uint32_t i = 0; i < records_.size(); i++)
+    {
+        DrawRecord &r = records_[i];
+        if(r.is_subtree)
+        {
+            r.sort_key = (++segment) << SEGMENT_SHIFT;
+            segment++;
+            inherits_material = false;
+            continue;
+        }
+
+        // Records that inherit the material stay ahead of the first record
+        // that sets one
+        if(r.material == nullptr) inherits_material = true;
+        else if(inherits_material)
+        {
+            segment++;
+            inherits_material = false;
+        }
+        GLuint texture = (r.material != nullptr) ? r.material->get_texture() : 0;
+        r.sort_key = (segment << SEGMENT_SHIFT) |
+                     (rank<const ShaderNode *>(programs, r.shader) << PROGRAM_SHIFT) |
+                     (rank(textures, texture) << TEXTURE_SHIFT) |
+                     (rank(geometry, geometry_keys[i]) << GEOMETRY_SHIFT) |
+                     (rank<const PresentationNode *>(materials, r.material) << MATERIAL_SHIFT);
+    }
+    sortable_ = (segment <= MAX_SEGMENT);
+}
+
+uint32_t RenderQueue::count_state_changes() const
+{
+    // Mirrors the draw loop: the program and material are applied when they
+    // change (the material again after a new program), and subtrees leave
+    // the state unknown
+    const ShaderNode       *shader = nullptr;
+    const PresentationNode *material = nullptr;
+    GLuint                  texture = 0;
+    uint32_t                changes = 0;
+    for(const auto &d : draws_)
+    {
+        const DrawRecord &r = records_[d.index];
+        if(r.shader != nullptr && r.shader != shader)
+        {
+            shader = r.shader;
+            material = nullptr;
+            changes++;
+        }
+        if(r.material != nullptr && r.material != material)
+        {
+            material = r.material;
+            changes++;
+            GLuint t = r.material->get_texture();
+            if(t != 0 && t != texture)
+            {
+                texture = t;
+                changes++;
+            }
+        }
+        if(r.is_subtree)
+        {
+            shader = nullptr;
+            material = nullptr;
+            texture = 0;
+        }
+    }
+    return changes;
+}
+
+void RenderQueue::compile_node(SceneNode              *node,
+                               const AffineTransform3 &world,
+                               uint32_t                transform,
+                               ShaderNode            *&shader,
+                               PresentationNode      *&material)
+{
+    switch(node->node_type())
+    {
+        case SceneNodeType::TRANSFORM:
+        {
+            // Keep the node so its records can be moved without recompiling
+            auto            *transform_node = static_cast<TransformNode *>(node);
+            AffineTransform3 child_world = world * transform_node->get_matrix();
+            uint32_t         child_transform = static_cast<uint32_t>(transforms_.size());
+            transforms_.push_back(
+                {transform_node, transform, transform_node->get_matrix_version(), child_world, false});
+            for(const auto &c : node->get_children())
+            {
+                compile_node(c.get(), child_world, child_transform, shader, material);
+            }
+            break;
+        }
+        case SceneNodeType::PRESENTATION:
+        {
+            // The material stays current after the children, as it does
+            // when the graph is drawn
+            material = static_cast<PresentationNode *>(node);
+            for(const auto &c : node->get_children())
+            {
+                compile_node(c.get(), world, transform, shader, material);
+            }
+            break;
+        }
+        case SceneNodeType::GEOMETRY: add_record(node, world, transform, shader, material, false); break;
+        case SceneNodeType::BASE:
+            // Plain grouping nodes are flattened. Derived classes may override
+            // draw, so keep those as subtrees.
+            if(typeid(*node) == typeid(SceneNode))
+            {
+                for(const auto &c : node->get_children())
+                {
+                    compile_node(c.get(), world, transform, shader, material);
+                }
+            }
+            else add_record(node, world, transform, shader, material, true);
+            break;
+        case SceneNodeType::SHADER:
+        {
+            // The children are drawn with the program, which stays current
+            // after them. A shader that draws more than its children is kept
+            // as a subtree and leaves the program unknown.
+            auto *shader_node = static_cast<ShaderNode *>(node);
+            if(shader_node->can_flatten())
+            {
+                shader = shader_node;
+                for(const auto &c : node->get_children())
+                {
+                    compile_node(c.get(), world, transform, shader, material);
+                }
+            }
+            else
+            {
+                add_record(node, world, transform, shader, material, true);
+                shader = nullptr;
+            }
+            break;
+        }
+        default: add_record(node, world, transform, shader, material, true); break;
+    }
+}
+
+void RenderQueue::add_record(SceneNode              *node,
+                             const AffineTransform3 &world,
+                             uint32_t                transform,
+                             ShaderNode             *shader,
+                             PresentationNode       *material,
+                             bool                    is_subtree)
+{
+    DrawRecord r;
+    r.transform = transform;
+    r.shader = shader;
+    r.material = material;
+    r.geometry = node;
+    r.is_subtree = is_subtree;
+    set_world(r, world);
+    records_.push_back(r);
+}
+
+} // namespace cg
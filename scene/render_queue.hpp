@@ -0,0 +1,305 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:	 David W. Nesbitt
+//	File:    render_queue.hpp
+//	Purpose: Flat, compiled form of a scene graph subtree. Stores one draw
+//           record per geometry node with its world matrix resolved.
+//
+//============================================================================
+
+#ifndef __SCENE_RENDER_QUEUE_HPP__
+#define __SCENE_RENDER_QUEUE_HPP__
+
+#include "geometry/radix_sort.hpp"
+#include "scene/instance_buffer.hpp"
+#include "scene/presentation_node.hpp"
+#include "scene/scene_node.hpp"
+#include "scene/shader_node.hpp"
+#include "scene/transform_node.hpp"
+
+#include <vector>
+
+namespace cg
+{
+
+// Transform index of records that are not below a transform node
+constexpr uint32_t NO_TRANSFORM = 0xFFFFFFFF;
+
+/**
+ * A single draw in a compiled render queue. Pointers are non-owning - the
+ * nodes are owned by the scene graph the queue was compiled from.
+ */
+struct DrawRecord
+{
+    AffineTransform3  world;         // Model transform relative to the compiled root
+    Matrix4x4         world_matrix;  // World transform as a 4x4 matrix
+    Matrix4x4         normal_matrix; // Inverse transpose of the world matrix
+    uint32_t          transform;     // Nearest transform node above (NO_TRANSFORM if none)
+    ShaderNode       *shader;        // Shader to apply (nullptr if inherited)
+    PresentationNode *material;      // Material to apply (nullptr if inherited)
+    SceneNode        *geometry;      // Geometry node, or a subtree drawn with its own draw()
+    bool              is_subtree;    // True if geometry is a subtree (camera, light, etc.)
+    bool              has_bounds;    // False if the record cannot be culled
+    BoundingSphere    bounds;        // Bounds relative to the compiled root
+    uint64_t          sort_key;      // Segment and state part of the sort key
+};
+
+/**
+ * Render queue. Compiles a scene graph subtree into a contiguous array of
+ * draw records so that drawing does not have to traverse the graph. The
+ * queue must be recompiled when the structure of the graph changes (see
+ * is_stale()). When only transforms change, update_transforms refreshes
+ * the world matrices and bounds of the records below the changed transform
+ * nodes in place. Sort keys are kept, so pooled draws grouped for a
+ * multi-draw by world matrix are drawn separately once their transforms
+ * differ.
+ *
+ * Transform, presentation, shader, geometry, and plain SceneNode grouping
+ * nodes are flattened. Any other node (camera, light, a shader that cannot
+ * be flattened, or a class derived from SceneNode that overrides draw) is
+ * kept as a single record and drawn using its own draw method.
+ *
+ * Shader and presentation nodes do not restore the state after drawing
+ * their children, so each record keeps the shader and material of the last
+ * such nodes before it in the graph - the ones the graph would draw it
+ * with. The draw loop applies a record's shader when it changes, and then
+ * its material again, since material uniforms belong to the program.
+ * Records with no shader or material draw with the one current when the
+ * queue is drawn.
+ *
+ * Before drawing, the records that survive culling are sorted by a 64 bit
+ * key: segment (16 bits), program (8), texture (8), geometry (8), material
+ * (8), and depth (16, front to back). A subtree may change any state, so
+ * each subtree record is a segment of its own and draws are only reordered
+ * between subtrees. Records with no material come before any presentation
+ * node in the graph and are also kept in a segment of their own, so they
+ * are not drawn after a record that sets a material. Program, texture,
+ * geometry, and material are ranked in the order they are first found when
+ * compiling (records with no program rank first).
+ *
+ * Sorting places draws of the same geometry next to each other. If the
+ * program supports instancing, each run of consecutive geometry records
+ * with the same geometry, program, and texture is drawn with one instanced
+ * draw call; the records' materials come from the material table. Runs are
+ * not formed while hardware occlusion queries are on, since each record is
+ * then conditionally drawn on its own query.
+ *
+ * Meshes in a geometry pool share one vertex array. Pooled records with
+ * the same pool, material, and world matrix share a geometry rank, so they
+ * sort together and are submitted with one glMultiDrawElementsBaseVertex. (Without
+ * base instance or a draw ID in OpenGL 4.1, draws with different
+ * transforms cannot share a multi-draw; they still skip the vertex array
+ * bind.)
+ */
+class RenderQueue
+{
+  public:
+    /**
+     * Constructor.
+     */
+    RenderQueue();
+
+    /**
+     * Destructor. Deletes any occlusion query objects.
+     */
+    ~RenderQueue();
+
+    /**
+     * Compile the children of a scene node into draw records. Replaces any
+     * previously compiled records.
+     * @param  root  Root of the subtree to compile (root itself is not drawn).
+     */
+    void compile(const SceneNode &root);
+
+    /**
+     * Remove all draw records.
+     */
+    void clear();
+
+    /**
+     * Check whether the structure of the subtree has changed since the last
+     * compile.
+     * @param  root  Root of the compiled subtree
+     * @return  Returns true if the queue needs to be recompiled.
+     */
+    bool is_stale(const SceneNode &root) const;
+
+    /**
+     * Refresh the world matrices and bounds of records below transform nodes
+     * that changed since the last compile or update. The queue must not be
+     * stale.
+     * @param  root  Root of the compiled subtree
+     */
+    void update_transforms(const SceneNode &root);
+
+    /**
+     * Draw all records. World matrices are applied relative to the current
+     * scene state model matrix. Records whose bounds are outside the view
+     * frustum are skipped. If the scene state has an occlusion buffer, the
+     * occluder geometry in this queue is rasterized into it first and
+     * geometry hidden behind it is skipped. If the scene state has occlusion
+     * queries, each geometry record's bounding box is queried and the record
+     * is skipped while its most recent result shows it hidden. The records
+     * left are sorted by state and depth if scene_state.sort_draws is set.
+     * @param  scene_state  Current scene state
+     */
+    void draw(SceneState &scene_state) const;
+
+    /**
+     * Get the number of draw records.
+     * @return  Returns the number of draw records.
+     */
+    size_t size() const;
+
+    /**
+     * Get the draw records.
+     * @return  Returns the list of draw records.
+     */
+    const std::vector<DrawRecord> &get_records() const;
+
+  protected:
+    // Transform node in the compiled subtree. A node below several parents
+    // has an entry for each path to it.
+    struct CompiledTransform
+    {
+        TransformNode   *node;
+        uint32_t         parent;         // Nearest transform above (NO_TRANSFORM if none)
+        uint64_t         matrix_version; // Node matrix version world was computed at
+        AffineTransform3 world;          // World matrix below the node
+        bool             moved;          // World matrix changed in the last update
+    };
+
+    std::vector<DrawRecord>        records_;
+    std::vector<CompiledTransform> transforms_; // Parents before children
+    uint64_t                       compiled_version_;           // Root version when updated
+    uint64_t                       compiled_structure_version_; // Root structure version
+    bool                           compiled_;
+    bool                           sortable_; // False if there are too many segments for the key
+
+    // Records to draw this frame and scratch space for sorting them
+    mutable std::vector<SortItem> draws_;
+    mutable std::vector<SortItem> scratch_;
+
+    // Occlusion query state for each record. Results arrive frames after the
+    // queries are issued, so this changes while drawing.
+    mutable std::vector<OcclusionQuery> queries_;
+
+    // Run of draws_ drawn with one instanced draw call
+    struct InstanceRun
+    {
+        uint32_t first_draw;     // Index of the first draw in draws_
+        uint32_t count;          // Number of draws (and instances)
+        uint32_t first_instance; // Index of the first instance in instances_
+    };
+
+    // Instance runs for this frame and their per-instance data
+    mutable std::vector<InstanceRun> runs_;
+    mutable InstanceBuffer           instances_;
+
+    // Index counts, index offsets, and base vertices of a multi-draw
+    mutable std::vector<GLsizei>      multi_counts_;
+    mutable std::vector<const void *> multi_offsets_;
+    mutable std::vector<GLint>        multi_base_vertices_;
+
+    /**
+     * Delete the occlusion query objects.
+     */
+    void release_queries();
+
+    /**
+     * Set the segment and state part of the sort key of each record.
+     */
+    void build_sort_keys();
+
+    /**
+     * Find the runs of draws in draws_ that can be drawn as instances, add
+     * their instances, and upload the instance buffer.
+     * @param  scene_state  Current scene state
+     * @param  parent       Model matrix above the compiled root
+     */
+    void build_instance_runs(SceneState &scene_state, const AffineTransform3 &parent) const;
+
+    /**
+     * Check whether a record can be drawn in the same instanced draw call as
+     * another record.
+     * @param  materials  Material registry
+     * @param  first      First record of the run
+     * @param  r          Record to add to the run
+     * @return  Returns true if both records draw the same geometry with the
+     *          same program and texture and can be instanced.
+     */
+    bool can_instance(MaterialRegistry &materials, const DrawRecord &first, const DrawRecord &r) const;
+
+    /**
+     * Count the draws starting at a draw in draws_ that can be submitted as
+     * one multi-draw: pooled meshes from the same pool with the same
+     * program, material, and world matrix.
+     * @param  first  Index of the first draw in draws_
+     * @param  end    Index in draws_ the multi-draw must stop before
+     * @return  Returns the number of draws (1 if the first draw cannot be
+     *          combined with the ones after it).
+     */
+    uint32_t multi_draw_length(size_t first, size_t end) const;
+
+    /**
+     * Submit draws from a geometry pool with one multi-draw call. The
+     * material and matrices must already be set.
+     * @param  scene_state  Current scene state
+     * @param  first        Index of the first draw in draws_
+     * @param  count        Number of draws
+     */
+    void multi_draw(SceneState &scene_state, size_t first, uint32_t count) const;
+
+    /**
+     * Apply the shader and material of a record if they differ from the
+     * current ones.
+     * @param  scene_state       Current scene state
+     * @param  r                 Record to draw
+     * @param  current_shader    Current shader (updated)
+     * @param  current_material  Current material (updated)
+     */
+    void apply_state(SceneState              &scene_state,
+                     const DrawRecord        &r,
+                     const ShaderNode       *&current_shader,
+                     const PresentationNode *&current_material) const;
+
+    /**
+     * Count the program, texture, and material changes drawing the records
+     * in draws_ in their current order.
+     * @return  Returns the number of state changes.
+     */
+    uint32_t count_state_changes() const;
+
+    /**
+     * Compile a node and its descendants.
+     * @param  node       Node to compile
+     * @param  world      World matrix at this node
+     * @param  transform  Nearest transform above (index into transforms_)
+     * @param  shader     Current shader in graph order (nullptr if inherited).
+     *                    Updated by the shader nodes compiled.
+     * @param  material   Current material in graph order (nullptr if
+     *                    inherited). Updated by the presentation nodes compiled.
+     */
+    void compile_node(SceneNode              *node,
+                      const AffineTransform3 &world,
+                      uint32_t                transform,
+                      ShaderNode            *&shader,
+                      PresentationNode      *&material);
+
+    /**
+     * Add a draw record.
+     */
+    void add_record(SceneNode              *node,
+                    const AffineTransform3 &world,
+                    uint32_t                transform,
+                    ShaderNode             *shader,
+                    PresentationNode       *material,
+                    bool                    is_subtree);
+};
+
+} // namespace cg
+
+#endif
@@ -25,10 +25,15 @@
 #include "scene/geometry_node.hpp"
 #include "scene/shader_node.hpp"
 #include "scene/camera_node.hpp"
+#include "scene/occlusion_queries.hpp"
+#include "scene/render_queue.hpp"
+#include "scene/compiled_scene_node.hpp"
+#include "scene/static_baker.hpp"
 #include "scene/image_data.hpp"
 // clang-format on
 
 // Model nodes
+#include "scene/bezier_patch_node.hpp"
 #include "scene/conic.hpp"
 #include "scene/mesh_teapot.hpp"
 #include "scene/sphere_section.hpp"
@@ -1,5 +1,8 @@
 #include "scene/scene_node.hpp"
 
+#include <algorithm>
+#include <limits>
+
 namespace cg
 {
 
@@ -19,25 +22,56 @@ std::ostream &operator<<(std::ostream &out, const SceneNodeType &type)
     return out;
 }
 
-SceneNode::SceneNode() : node_type_(SceneNodeType::BASE) {}
+uint64_t SceneNode::last_version_ = 0;
+
+SceneNode::SceneNode()
+    : node_type_(SceneNodeType::BASE), version_(0), structure_version_(0), has_bounds_(false),
+      bounds_version_(std::numeric_limits<uint64_t>::max())
+{
+}
+
+SceneNode::SceneNode(const SceneNode &other)
+    : name_(other.name_), node_type_(other.node_type_), children_(other.children_), version_(0),
+      structure_version_(0), has_bounds_(false),
+      bounds_version_(std::numeric_limits<uint64_t>::max())
+{
+    for(const auto &c : children_) { c->parents_.push_back(this); }
+}
 
 SceneNode::~SceneNode() { destroy(); }
 
 void SceneNode::draw(SceneState &scene_state)
 {
     // Loop through the list and draw the children
-    for(auto c : children_) { c->draw(scene_state); }
+    for(const auto &c : children_) { c->draw(scene_state); }
 }
 
 void SceneNode::update(SceneState &scene_state)
 {
     // Loop through the list and update the children
-    for(auto c : children_) { c->update(scene_state); }
+    for(const auto &c : children_) { c->update(scene_state); }
 }
 
-void SceneNode::destroy() { children_.clear(); }
+void SceneNode::destroy()
+{
+    if(!children_.empty())
+    {
+        for(const auto &c : children_)
+        {
+            auto &parents = c->parents_;
+            parents.erase(std::find(parents.begin(), parents.end(), this));
+        }
+        children_.clear();
+        structure_changed();
+    }
+}
 
-void SceneNode::add_child(std::shared_ptr<SceneNode> node) { children_.push_back(node); }
+void SceneNode::add_child(std::shared_ptr<SceneNode> node)
+{
+    node->parents_.push_back(this);
+    children_.push_back(node);
+    structure_changed();
+}
 
 SceneNodeType SceneNode::node_type() const { return node_type_; }
 
@@ -45,6 +79,54 @@ void SceneNode::set_name(const char *nm) { name_ = nm; }
 
 const std::string &SceneNode::get_name() const { return name_; }
 
+const std::vector<std::shared_ptr<SceneNode>> &SceneNode::get_children() const
+{
+    return children_;
+}
+
+uint64_t SceneNode::get_version() const { return version_; }
+
+uint64_t SceneNode::get_structure_version() const { return structure_version_; }
+
+void SceneNode::subtree_changed() { set_version(++last_version_, false); }
+
+void SceneNode::structure_changed() { set_version(++last_version_, true); }
+
+void SceneNode::set_version(uint64_t version, bool structure)
+{
+    // Shared subtrees have several parents, and an ancestor may be reached
+    // along more than one path
+    if(version_ == version) { return; }
+    version_ = version;
+    if(structure) { structure_version_ = version; }
+    for(SceneNode *p : parents_) { p->set_version(version, structure); }
+}
+
+bool SceneNode::get_bounds(BoundingSphere &sphere)
+{
+    if(bounds_version_ != version_)
+    {
+        has_bounds_ = compute_bounds(bounds_);
+        bounds_version_ = version_;
+    }
+    sphere = bounds_;
+    return has_bounds_;
+}
+
+bool SceneNode::compute_bounds(BoundingSphere &sphere)
+{
+    if(children_.empty()) { return false; }
+
+    BoundingSphere child;
+    for(size_t i = 0; i < children_.size(); i++)
+    {
+        if(!children_[i]->get_bounds(child)) { return false; }
+        if(i == 0) sphere = child;
+        else sphere.merge_with(child);
+    }
+    return true;
+}
+
 void SceneNode::print_graph(std::ostream &out, int32_t level) const
 {
     for(size_t i = 0; i < level; ++i) out << "- ";
@@ -54,7 +136,7 @@ void SceneNode::print_graph(std::ostream &out, int32_t level) const
 
     out << node_type_ << "]\n";
 
-    for(auto c : children_) { c->print_graph(out, level + 1); }
+    for(const auto &c : children_) { c->print_graph(out, level + 1); }
 }
 
 } // namespace cg
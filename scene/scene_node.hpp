@@ -13,6 +13,7 @@
 #ifndef __SCENE_SCENE_NODE_HPP__
 #define __SCENE_SCENE_NODE_HPP__
 
+#include "geometry/bounding_sphere.hpp"
 #include "scene/graphics.hpp"
 #include "scene/scene_state.hpp"
 
@@ -48,11 +49,19 @@ class SceneNode
      */
     SceneNode();
 
+    /**
+     * Copy constructor. The copy holds the same children and has no parents.
+     * @param  other  Node to copy
+     */
+    SceneNode(const SceneNode &other);
+
     /**
      * Destructor
      */
     virtual ~SceneNode();
 
+    SceneNode &operator=(const SceneNode &) = delete;
+
     /**
      * Draw the scene node and its children. The base class just draws the
      * children. Derived classes can use this (SceneNode::draw()) to draw
@@ -98,10 +107,86 @@ class SceneNode
 
     void print_graph(std::ostream &out = std::cout, int32_t level = 0) const;
 
+    /**
+     * Get the children of this node.
+     * @return  Returns the list of child nodes.
+     */
+    const std::vector<std::shared_ptr<SceneNode>> &get_children() const;
+
+    /**
+     * Get the version of this node's subtree. The version changes whenever
+     * this node or a descendant gains or loses a child or has its transform
+     * or bounds changed. Changes outside the subtree leave it as is.
+     * @return  Returns the subtree version.
+     */
+    uint64_t get_version() const;
+
+    /**
+     * Get the structure version of this node's subtree. Like the subtree
+     * version, but transform changes leave it as is. Compiled forms of the
+     * graph (see RenderQueue) compare against this to know when to rebuild.
+     * @return  Returns the structure version.
+     */
+    uint64_t get_structure_version() const;
+
+    /**
+     * Get a bounding sphere of this node and its descendants, in the
+     * coordinate system of this node's parent. The result is cached until
+     * the version of this node changes.
+     * @param  sphere  Returns the bounding sphere.
+     * @return  Returns false if the subtree cannot be bounded (it holds a
+     *          light, a camera, or geometry without bounds) and so must never
+     *          be culled.
+     */
+    bool get_bounds(BoundingSphere &sphere);
+
   protected:
     std::string                             name_;
     SceneNodeType                           node_type_;
     std::vector<std::shared_ptr<SceneNode>> children_;
+    std::vector<SceneNode *>                parents_; // Nodes holding this one as a child
+
+    // Subtree versions (see get_version and get_structure_version) and the
+    // version the cached bounds were computed at (see get_bounds)
+    uint64_t       version_;
+    uint64_t       structure_version_;
+    BoundingSphere bounds_;
+    bool           has_bounds_;
+    uint64_t       bounds_version_;
+
+    // Last version given to a node. Versions are unique, so a change that
+    // reaches a node along two paths is only passed on once.
+    static uint64_t last_version_;
+
+    /**
+     * Mark this node's subtree as changed without changing its structure (a
+     * transform changed). Gives this node and all its ancestors a new
+     * version, so their cached bounds are recomputed.
+     */
+    void subtree_changed();
+
+    /**
+     * Mark the structure of this node's subtree as changed (children or
+     * geometry bounds changed). Also invalidates compiled render queues
+     * holding the subtree.
+     */
+    void structure_changed();
+
+    /**
+     * Set the version of this node and its ancestors.
+     * @param  version    New version
+     * @param  structure  True to set the structure version as well
+     */
+    void set_version(uint64_t version, bool structure);
+
+    /**
+     * Compute the bounds of this node and its descendants (see get_bounds).
+     * The base class merges the bounds of the children. Nodes without
+     * children are not bounded.
+     * @param  sphere  Returns the bounding sphere.
+     * @return  Returns true if the subtree is bounded.
+     */
+    virtual bool compute_bounds(BoundingSphere &sphere);
 };
 
 } // namespace cg
@@ -5,7 +5,16 @@ namespace cg
 
 void SceneState::init()
 {
-    max_enabled_light = 0;
+    gl_state.begin_frame();
+    nodes_drawn = 0;
+    nodes_culled = 0;
+    nodes_occluded = 0;
+    draws_skipped = 0;
+    state_changes_unsorted = 0;
+    state_changes = 0;
+    draw_calls = 0;
+    instanced_calls = 0;
+    multi_draw_calls = 0;
     model_matrix.set_identity();
     model_matrix_stack.clear();
 }
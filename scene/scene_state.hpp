@@ -12,35 +12,22 @@
 #ifndef __SCENE_SCENE_STATE_HPP__
 #define __SCENE_SCENE_STATE_HPP__
 
+#include "geometry/affine_transform3.hpp"
+#include "geometry/frustum.hpp"
 #include "geometry/matrix.hpp"
+#include "geometry/occlusion_buffer.hpp"
+#include "scene/gl_state_cache.hpp"
 #include "scene/graphics.hpp"
-
-#include <list>
+#include "scene/light_buffer.hpp"
+#include "scene/material_registry.hpp"
+#include "scene/occlusion_queries.hpp"
 
 #include <array>
+#include <vector>
 
 namespace cg
 {
 
-constexpr uint32_t MAX_LIGHTS = 8;
-
-// Simple structure to hold light uniform locations
-struct LightUniforms
-{
-    GLint enabled;
-    GLint spotlight;
-    GLint position;
-    GLint ambient;
-    GLint diffuse;
-    GLint specular;
-    GLint att_constant;
-    GLint att_linear;
-    GLint att_quadratic;
-    GLint spot_cutoff;
-    GLint spot_exponent;
-    GLint spot_direction;
-};
-
 /**
  * Scene state structure. Used to store OpenGL state - shader locations,
  * matrices, etc.
@@ -74,23 +61,81 @@ struct SceneState
     GLint texture_sampler_loc; // Texture sampler uniform location
     GLint use_texture_loc;     // Use texture flag uniform location
 
-    // Lights
-    uint32_t      lightcount;        // Number of lights in the scene
-    uint32_t      max_enabled_light; // Index of the maximum enabled light index
-    GLint         lightcount_loc;    // Number of lights uniform
-    LightUniforms lights[MAX_LIGHTS];
+    // Material index uniform location. Programs that read materials from the
+    // material table set it; others set -1 and use the uniforms above.
+    GLint material_index_loc = -1;
+
+    // Instanced drawing locations. Programs that can draw instances set
+    // these, and the model matrix, normal matrix, and material index then
+    // come from per-instance attributes. Others set instanced_loc to -1.
+    GLint instanced_loc = -1;    // Instanced flag uniform location
+    GLint pv_matrix_loc;         // Composite projection and view matrix location
+    GLint instance_model_loc;    // First of 4 model matrix attribute locations
+    GLint instance_normal_loc;   // First of 4 normal matrix attribute locations
+    GLint instance_material_loc; // Material index attribute location
+
+    // Packed vertex locations. Programs that decode packed vertex buffers
+    // (see TriSurface::pack_vertices) set these; others set -1.
+    GLint vertex_packing_loc = -1;  // Packing flags uniform location
+    GLint position_offset_loc = -1; // Quantized position offset location
+    GLint position_scale_loc = -1;  // Quantized position scale location
+
+    // Lights (uniform block shared by all lighting programs)
+    LightBuffer light_buffer;
+
+    // Unique materials (uniform block shared by programs that use the table)
+    MaterialRegistry materials;
 
     // Current matrices
     std::array<float, 16> ortho;        // Orthographic projection matrix (2-D)
     Matrix4x4             ortho_matrix; // Orthographic projection matrix (2-D)
     Matrix4x4             pv;           // Current composite projection and view matrix
-    Matrix4x4             model_matrix; // Current model matrix
+    AffineTransform3      model_matrix; // Current model matrix (affine)
     Matrix4x4             normal_matrix;
 
     Point3 camera_position;
 
-    // Retained state to push/pop modeling matrix
-    std::list<Matrix4x4> model_matrix_stack;
+    // Shadow of the OpenGL state. Drawing code sets programs, bindings, and
+    // uniforms through it so redundant calls are dropped.
+    GLStateCache gl_state;
+
+    // View frustum in world coordinates (set by the camera). Nodes whose
+    // bounds lie outside it are not drawn.
+    Frustum frustum;
+
+    // Frustum culling counts for the current frame (reset by init). A node
+    // is a transform subtree or a render queue record.
+    uint32_t nodes_drawn;  // Nodes tested (or not testable) and drawn
+    uint32_t nodes_culled; // Nodes skipped because they are outside the frustum
+
+    // Software occlusion buffer used by render queues (nullptr disables
+    // occlusion culling). Owned by the application.
+    OcclusionBuffer *occlusion_buffer = nullptr;
+    uint32_t         nodes_occluded; // Nodes skipped because occluders hide them
+
+    // Hardware occlusion queries used by render queues (nullptr disables
+    // them). Owned by the application.
+    OcclusionQueries *occlusion_queries = nullptr;
+    uint32_t          draws_skipped; // Draws skipped because their last query failed
+
+    // Render queues sort their draws by state and depth when this is set.
+    // State changes (program, texture, and material switches between
+    // consecutive draws) are counted both in compiled and in drawn order.
+    bool     sort_draws = true;
+    uint32_t state_changes_unsorted; // State changes if drawn in compiled order
+    uint32_t state_changes;          // State changes in the order drawn
+
+    // Render queues draw consecutive records that share geometry, program,
+    // and texture with one instanced draw call when this is set. Geometry
+    // draw calls are counted for the current frame (reset by init).
+    bool     instance_draws = true;
+    uint32_t draw_calls;       // Geometry draw calls (instanced or not)
+    uint32_t instanced_calls;  // Instanced draw calls
+    uint32_t multi_draw_calls; // Multi-draw calls (geometry pools)
+
+    // Retained state to push/pop modeling matrix. A vector keeps its capacity
+    // across frames so pushing does not allocate once the stack has grown.
+    std::vector<AffineTransform3> model_matrix_stack;
 
     /**
      * Initialize scene state prior to drawing.
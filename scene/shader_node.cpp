@@ -9,6 +9,14 @@ ShaderNode::ShaderNode() { node_type_ = SceneNodeType::SHADER; }
 
 ShaderNode::~ShaderNode() {}
 
+void ShaderNode::draw(SceneState &scene_state)
+{
+    apply(scene_state);
+    SceneNode::draw(scene_state);
+}
+
+bool ShaderNode::can_flatten() const { return true; }
+
 bool ShaderNode::create(const char *vertex_shader_filename, const char *fragment_shader_filename)
 {
     // Create and compile the vertex shader
@@ -34,6 +42,49 @@ bool ShaderNode::create(const char *vertex_shader_filename, const char *fragment
     return true;
 }
 
+bool ShaderNode::create(const char *vertex_shader_filename,
+                        const char *tess_control_shader_filename,
+                        const char *tess_evaluation_shader_filename,
+                        const char *fragment_shader_filename)
+{
+    // Create and compile the vertex shader
+    if(!vertex_shader_.create(vertex_shader_filename))
+    {
+        std::cout << "Vertex Shader compile failed\n";
+        return false;
+    }
+
+    // Create and compile the tessellation control and evaluation shaders
+    if(!tess_control_shader_.create(tess_control_shader_filename))
+    {
+        std::cout << "Tessellation Control Shader compile failed\n";
+        return false;
+    }
+    if(!tess_evaluation_shader_.create(tess_evaluation_shader_filename))
+    {
+        std::cout << "Tessellation Evaluation Shader compile failed\n";
+        return false;
+    }
+
+    // Create and compile the fragment shader
+    if(!fragment_shader_.create(fragment_shader_filename))
+    {
+        std::cout << "Fragment Shader compile failed\n";
+        return false;
+    }
+
+    shader_program_.create();
+    if(!shader_program_.attach_shaders(vertex_shader_.get(),
+                                       tess_control_shader_.get(),
+                                       tess_evaluation_shader_.get(),
+                                       fragment_shader_.get()))
+    {
+        std::cout << "Shader program link failed\n";
+        return false;
+    }
+    return true;
+}
+
 bool ShaderNode::create_from_source(const char *vertex_shader_source,
                                     const char *fragment_shader_source)
 {
@@ -47,6 +47,21 @@ class ShaderNode : public SceneNode
      */
     bool create(const char *vertex_shader_filename, const char *fragment_shader_filename);
 
+    /**
+     * Create a shader program with tessellation shaders given filenames for
+     * the vertex, tessellation control, tessellation evaluation, and fragment
+     * shaders.
+     * @param  vertex_shader_filename           Vertex shader file name
+     * @param  tess_control_shader_filename     Tessellation control shader file name
+     * @param  tess_evaluation_shader_filename  Tessellation evaluation shader file name
+     * @param  fragment_shader_filename         Fragment shader file name
+     * @return  Returns true if successful, false if compile or link errors occur.
+     */
+    bool create(const char *vertex_shader_filename,
+                const char *tess_control_shader_filename,
+                const char *tess_evaluation_shader_filename,
+                const char *fragment_shader_filename);
+
     /**
      * Create a shader program given source char array for the vertex shader and source
      * for the fragment shader.
@@ -59,10 +74,34 @@ class ShaderNode : public SceneNode
     // Derived classes must add this to set all internal uniforms and attribute locations
     virtual bool get_locations() = 0;
 
+    /**
+     * Draw method for shader nodes - apply the program and draw the children.
+     * @param  scene_state  Current scene state.
+     */
+    void draw(SceneState &scene_state) override;
+
+    /**
+     * Enable the program and set the scene state locations and uniforms its
+     * geometry is drawn with. Does not draw the children, so a render queue
+     * can flatten the subtree and apply the program for each of its draws.
+     * @param  scene_state  Current scene state.
+     */
+    virtual void apply(SceneState &scene_state) = 0;
+
+    /**
+     * Check whether the children can be drawn apart from this node after
+     * apply (see RenderQueue).
+     * @return  Returns false if draw does more than apply and draw the
+     *          children.
+     */
+    virtual bool can_flatten() const;
+
   protected:
-    GLSLVertexShader   vertex_shader_;
-    GLSLFragmentShader fragment_shader_;
-    GLSLShaderProgram  shader_program_;
+    GLSLVertexShader         vertex_shader_;
+    GLSLTessControlShader    tess_control_shader_; // Used by tessellation programs only
+    GLSLTessEvaluationShader tess_evaluation_shader_;
+    GLSLFragmentShader       fragment_shader_;
+    GLSLShaderProgram        shader_program_;
 };
 
 } // namespace cg
@@ -30,12 +30,14 @@ SphereSection::SphereSection(float    min_lat,
     float           d_lat = (max_lat_rad - min_lat_rad) / static_cast<float>(num_lat);
     float           d_lon = (max_lon_rad - min_lon_rad) / static_cast<float>(num_lon);
     VertexAndNormal vtx;
-    for(float curr_lon = min_lon_rad; curr_lon < max_lon_rad + EPSILON; curr_lon += d_lon)
+    for(uint32_t i = 0; i <= num_lon; i++)
     {
+        float curr_lon = min_lon_rad + static_cast<float>(i) * d_lon;
         cos_lon = std::cos(curr_lon);
         sin_lon = std::sin(curr_lon);
-        for(float curr_lat = max_lat_rad; curr_lat >= min_lat_rad - EPSILON; curr_lat -= d_lat)
+        for(uint32_t j = 0; j <= num_lat; j++)
         {
+            float curr_lat = max_lat_rad - static_cast<float>(j) * d_lat;
             cos_lat = std::cos(curr_lat);
             vtx.normal.x = cos_lon * cos_lat;
             vtx.normal.y = sin_lon * cos_lat;
@@ -52,6 +54,7 @@ SphereSection::SphereSection(float    min_lat,
 
     // Construct face list.  There are num_lat+1 rows and num_lon+1 columns. Create VBOs
     construct_row_col_face_list(num_lon + 1, num_lat + 1);
+    optimize_face_order();
     create_vertex_buffers(position_loc, normal_loc);
 }
 
@@ -82,16 +85,16 @@ SphereSection::SphereSection(float    min_lat,
     // Texture coordinate increments
     float du = 1.0f / static_cast<float>(num_lon);
     float dv = 1.0f / static_cast<float>(num_lat);
-    float u = 0.0f;
 
-    for(float curr_lon = min_lon_rad; curr_lon < max_lon_rad + EPSILON; curr_lon += d_lon)
+    for(uint32_t i = 0; i <= num_lon; i++)
     {
+        float curr_lon = min_lon_rad + static_cast<float>(i) * d_lon;
         cos_lon = std::cos(curr_lon);
         sin_lon = std::sin(curr_lon);
 
-        float v = 0.0f; // Start from top of texture
-        for(float curr_lat = max_lat_rad; curr_lat >= min_lat_rad - EPSILON; curr_lat -= d_lat)
+        for(uint32_t j = 0; j <= num_lat; j++)
         {
+            float curr_lat = max_lat_rad - static_cast<float>(j) * d_lat;
             cos_lat = std::cos(curr_lat);
             vtx.normal.x = cos_lon * cos_lat;
             vtx.normal.y = sin_lon * cos_lat;
@@ -101,13 +104,11 @@ SphereSection::SphereSection(float    min_lat,
             vtx.vertex.z = radius * vtx.normal.z;
 
             // Set texture coordinates
-            vtx.texcoord.x = u;
-            vtx.texcoord.y = v;
+            vtx.texcoord.x = static_cast<float>(i) * du;
+            vtx.texcoord.y = static_cast<float>(j) * dv; // 0 at the top of the texture
 
             vertices_with_tex_.push_back(vtx);
-            v += dv;
         }
-        u += du;
     }
 
     // Copy the first column of vertices with texture coordinate wrapping
@@ -120,6 +121,7 @@ SphereSection::SphereSection(float    min_lat,
 
     // Construct face list.  There are num_lat+1 rows and num_lon+1 columns. Create VBOs
     construct_row_col_face_list(num_lon + 1, num_lat + 1);
+    optimize_face_order();
     create_vertex_buffers(position_loc, normal_loc, texcoord_loc);
 }
 
@@ -150,16 +152,16 @@ SphereSection::SphereSection(float    min_lat,
     // Texture coordinate increments
     float du = 1.0f / static_cast<float>(num_lon);
     float dv = 1.0f / static_cast<float>(num_lat);
-    float u = 0.0f;
 
-    for(float curr_lon = min_lon_rad; curr_lon < max_lon_rad + EPSILON; curr_lon += d_lon)
+    for(uint32_t i = 0; i <= num_lon; i++)
     {
+        float curr_lon = min_lon_rad + static_cast<float>(i) * d_lon;
         cos_lon = std::cos(curr_lon);
         sin_lon = std::sin(curr_lon);
 
-        float v = 0.0f;
-        for(float curr_lat = max_lat_rad; curr_lat >= min_lat_rad - EPSILON; curr_lat -= d_lat)
+        for(uint32_t j = 0; j <= num_lat; j++)
         {
+            float curr_lat = max_lat_rad - static_cast<float>(j) * d_lat;
             cos_lat = std::cos(curr_lat);
             sin_lat = std::sin(curr_lat);
 
@@ -176,8 +178,8 @@ SphereSection::SphereSection(float    min_lat,
             vtx.vertex.z = radius * vtx.normal.z;
 
             // Texture coordinates
-            vtx.texcoord.x = u;
-            vtx.texcoord.y = v;
+            vtx.texcoord.x = static_cast<float>(i) * du;
+            vtx.texcoord.y = static_cast<float>(j) * dv;
 
             // Analytical tangent: dP/d(lon) direction (eastward, around latitude circles)
             // For sphere: tangent = (-sin(lon), cos(lon), 0)
@@ -192,9 +194,7 @@ SphereSection::SphereSection(float    min_lat,
             vtx.bitangent.z = cos_lat;
 
             vertices_with_tangents_.push_back(vtx);
-            v += dv;
         }
-        u += du;
     }
 
     // Copy the first column with wrapped texture coordinates
@@ -207,6 +207,7 @@ SphereSection::SphereSection(float    min_lat,
 
     // Construct face list
     construct_row_col_face_list(num_lon + 1, num_lat + 1);
+    optimize_face_order();
 
     // Create buffers directly (tangent space already computed analytically)
     has_tangent_space_ = true;
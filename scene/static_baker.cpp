@@ -0,0 +1,227 @@
+#include "scene/static_baker.hpp"
+#include "scene/transform_node.hpp"
+
+#include <algorithm>
+#include <future>
+#include <thread>
+#include <typeinfo>
+
+namespace cg
+{
+
+namespace
+{
+
+// Copy surfaces on one thread below this many
+constexpr size_t PARALLEL_MIN_SURFACES = 16;
+
+// Add a node below a transform and a copy of a material (each only if
+// needed)
+void attach(SceneNode                        &parent,
+            const std::shared_ptr<SceneNode> &node,
+            const AffineTransform3           &world,
+            const PresentationNode           *material)
+{
+    std::shared_ptr<SceneNode> child = node;
+    if(world.get_type() != AffineType::IDENTITY)
+    {
+        auto transform = std::make_shared<TransformNode>();
+        transform->set_matrix(world);
+        transform->add_child(child);
+        child = transform;
+    }
+    if(material != nullptr)
+    {
+        auto presentation = std::make_shared<PresentationNode>();
+        presentation->copy_material(*material);
+        presentation->add_child(child);
+        child = presentation;
+    }
+    parent.add_child(child);
+}
+
+} // namespace
+
+StaticBaker::StaticBaker(int32_t position_loc, int32_t normal_loc, int32_t texcoord_loc) :
+    position_loc_(position_loc),
+    normal_loc_(normal_loc),
+    texcoord_loc_(texcoord_loc),
+    surface_count_(0),
+    merged_count_(0),
+    kept_count_(0)
+{
+}
+
+std::shared_ptr<SceneNode> StaticBaker::bake(const SceneNode &root)
+{
+    groups_.clear();
+    kept_.clear();
+    AffineTransform3 identity;
+    for(const auto &c : root.get_children()) { collect(c, identity, nullptr); }
+
+    // Place each surface in its merged mesh
+    surface_count_ = 0;
+    for(auto &g : groups_)
+    {
+        uint32_t vertex_count = 0;
+        uint32_t index_count = 0;
+        for(auto &item : g.items)
+        {
+            item.first_vertex = vertex_count;
+            item.first_index = index_count;
+            vertex_count += item.surface->get_vertex_count();
+            index_count += item.surface->get_index_count();
+        }
+        if(g.textured) g.textured_vertices.resize(vertex_count);
+        else g.vertices.resize(vertex_count);
+        g.faces.resize(index_count);
+        surface_count_ += static_cast<uint32_t>(g.items.size());
+    }
+    merge_groups();
+
+    // Create the merged surfaces (GL calls stay on this thread)
+    auto baked = std::make_shared<SceneNode>();
+    for(auto &g : groups_)
+    {
+        auto surface = std::make_shared<TriSurface>();
+        if(g.textured)
+        {
+            surface->construct(g.textured_vertices, g.faces);
+            surface->create_vertex_buffers(position_loc_, normal_loc_, texcoord_loc_);
+        }
+        else
+        {
+            surface->construct(g.vertices, g.faces);
+            surface->create_vertex_buffers(position_loc_, normal_loc_);
+        }
+        if(g.occluder) { surface->set_occluder(true); }
+        attach(*baked, surface, identity, g.material);
+    }
+    for(const auto &k : kept_) { attach(*baked, k.node, k.world, k.material); }
+
+    merged_count_ = static_cast<uint32_t>(groups_.size());
+    kept_count_ = static_cast<uint32_t>(kept_.size());
+    groups_.clear();
+    kept_.clear();
+    return baked;
+}
+
+uint32_t StaticBaker::get_surface_count() const { return surface_count_; }
+
+uint32_t StaticBaker::get_merged_count() const { return merged_count_; }
+
+uint32_t StaticBaker::get_kept_count() const { return kept_count_; }
+
+void StaticBaker::collect(const std::shared_ptr<SceneNode> &node,
+                          const AffineTransform3           &world,
+                          const PresentationNode           *material)
+{
+    switch(node->node_type())
+    {
+        case SceneNodeType::TRANSFORM:
+        {
+            AffineTransform3 child_world =
+                world * static_cast<TransformNode *>(node.get())->get_matrix();
+            for(const auto &c : node->get_children()) { collect(c, child_world, material); }
+            return;
+        }
+        case SceneNodeType::PRESENTATION:
+        {
+            auto *presentation = static_cast<PresentationNode *>(node.get());
+            for(const auto &c : node->get_children()) { collect(c, world, presentation); }
+            return;
+        }
+        case SceneNodeType::GEOMETRY:
+        {
+            auto *surface = dynamic_cast<TriSurface *>(node.get());
+            if(surface != nullptr && !surface->has_tangent_space() &&
+               surface->has_cpu_data() && surface->get_index_count() > 0)
+            {
+                find_group(*surface, material).items.push_back({surface, world, 0, 0});
+                return;
+            }
+            break;
+        }
+        case SceneNodeType::BASE:
+            // Derived classes may override draw, so only plain grouping
+            // nodes are flattened
+            if(typeid(*node) == typeid(SceneNode))
+            {
+                for(const auto &c : node->get_children()) { collect(c, world, material); }
+                return;
+            }
+            break;
+        default: break;
+    }
+    kept_.push_back({node, world, material});
+}
+
+StaticBaker::BakeGroup &StaticBaker::find_group(const TriSurface       &surface,
+                                                const PresentationNode *material)
+{
+    bool textured = surface.has_texture_coords();
+    bool occluder = surface.is_occluder();
+    for(auto &g : groups_)
+    {
+        if(g.textured != textured || g.occluder != occluder) { continue; }
+        if(g.material == material ||
+           (g.material != nullptr && material != nullptr && g.material->same_material(*material)))
+        {
+            return g;
+        }
+    }
+    groups_.emplace_back();
+    BakeGroup &g = groups_.back();
+    g.material = material;
+    g.textured = textured;
+    g.occluder = occluder;
+    return g;
+}
+
+void StaticBaker::merge_groups()
+{
+    // Each surface writes to its own range of the merged lists, so the
+    // copies need no locking
+    std::vector<std::pair<BakeGroup *, const BakeItem *>> jobs;
+    for(auto &g : groups_)
+    {
+        for(const auto &item : g.items) { jobs.emplace_back(&g, &item); }
+    }
+    auto copy = [&jobs](size_t first, size_t step) {
+        for(size_t i = first; i < jobs.size(); i += step)
+        {
+            BakeGroup      &g = *jobs[i].first;
+            const BakeItem &item = *jobs[i].second;
+            uint32_t       *faces = g.faces.data() + item.first_index;
+            if(g.textured)
+            {
+                item.surface->copy_transformed(item.world,
+                                               g.textured_vertices.data() + item.first_vertex,
+                                               faces,
+                                               item.first_vertex);
+            }
+            else
+            {
+                item.surface->copy_transformed(
+                    item.world, g.vertices.data() + item.first_vertex, faces, item.first_vertex);
+            }
+        }
+    };
+
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    if(jobs.size() < PARALLEL_MIN_SURFACES || threads < 2)
+    {
+        copy(0, 1);
+        return;
+    }
+    threads = std::min(threads, jobs.size());
+    std::vector<std::future<void>> workers;
+    for(size_t i = 1; i < threads; i++)
+    {
+        workers.push_back(std::async(std::launch::async, copy, i, threads));
+    }
+    copy(0, threads);
+    for(auto &w : workers) { w.get(); }
+}
+
+} // namespace cg
@@ -0,0 +1,151 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:	 David W. Nesbitt
+//	File:    static_baker.hpp
+//	Purpose: Bakes static scene graph subtrees into a few pre-transformed,
+//           merged triangle surfaces.
+//
+//============================================================================
+
+#ifndef __SCENE_STATIC_BAKER_HPP__
+#define __SCENE_STATIC_BAKER_HPP__
+
+#include "scene/presentation_node.hpp"
+#include "scene/scene_node.hpp"
+#include "scene/tri_surface.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace cg
+{
+
+/**
+ * Static baker. Walks a subtree that never changes, applies the
+ * accumulated transforms to the vertices and normals of each triangle
+ * surface on the CPU, and merges the surfaces that share a material,
+ * vertex layout, and occluder flag into one TriSurface. A room of
+ * transform, material, and surface nodes becomes a handful of draws.
+ *
+ * Transform, presentation, and plain SceneNode grouping nodes are
+ * flattened as in RenderQueue. Everything else (shader, camera, and light
+ * nodes, surfaces with tangent space or released CPU data, and other
+ * geometry) is kept as is, below a transform and material equivalent to
+ * the ones it had. Since a nested shader node is kept whole, everything
+ * merged is drawn with the program inherited from above the subtree.
+ *
+ * Surfaces are copied into the merged meshes in parallel. A merged mesh
+ * with more than 65536 vertices uses 32 bit indexes. The baked subtree
+ * shares the textures of the original materials, so the original graph
+ * must be kept alive (or at least its presentation nodes).
+ */
+class StaticBaker
+{
+  public:
+    /**
+     * Constructor.
+     * @param  position_loc  Vertex position attribute location
+     * @param  normal_loc    Vertex normal attribute location
+     * @param  texcoord_loc  Texture coordinate attribute location (-1 if the
+     *                       program has none)
+     */
+    StaticBaker(int32_t position_loc, int32_t normal_loc, int32_t texcoord_loc = -1);
+
+    /**
+     * Bake the children of a node. The node itself is not changed.
+     * @param  root  Root of the static subtree
+     * @return  Returns a grouping node holding the merged surfaces and the
+     *          nodes that were kept.
+     */
+    std::shared_ptr<SceneNode> bake(const SceneNode &root);
+
+    /**
+     * Get the number of surfaces merged by the last bake.
+     * @return  Returns the number of surfaces merged.
+     */
+    uint32_t get_surface_count() const;
+
+    /**
+     * Get the number of merged surfaces created by the last bake.
+     * @return  Returns the number of merged surfaces.
+     */
+    uint32_t get_merged_count() const;
+
+    /**
+     * Get the number of nodes kept as is by the last bake.
+     * @return  Returns the number of kept nodes.
+     */
+    uint32_t get_kept_count() const;
+
+  protected:
+    // A surface to merge and where its copy goes in the merged mesh
+    struct BakeItem
+    {
+        const TriSurface *surface;
+        AffineTransform3  world;
+        uint32_t          first_vertex;
+        uint32_t          first_index;
+    };
+
+    // Surfaces merged into one mesh
+    struct BakeGroup
+    {
+        const PresentationNode          *material;
+        bool                             textured;
+        bool                             occluder;
+        std::vector<BakeItem>            items;
+        std::vector<VertexAndNormal>     vertices;
+        std::vector<VertexNormalTexture> textured_vertices;
+        std::vector<uint32_t>            faces;
+    };
+
+    // A node that is not baked, with its accumulated transform and material
+    struct KeptNode
+    {
+        std::shared_ptr<SceneNode> node;
+        AffineTransform3           world;
+        const PresentationNode    *material;
+    };
+
+    int32_t                position_loc_;
+    int32_t                normal_loc_;
+    int32_t                texcoord_loc_;
+    std::vector<BakeGroup> groups_;
+    std::vector<KeptNode>  kept_;
+    uint32_t               surface_count_;
+    uint32_t               merged_count_;
+    uint32_t               kept_count_;
+
+    /**
+     * Add the surfaces below a node to the merge groups and the nodes that
+     * cannot be merged to the kept list.
+     * @param  node      Node
+     * @param  world     Accumulated transform above the node
+     * @param  material  Nearest material above the node (nullptr if none)
+     */
+    void collect(const std::shared_ptr<SceneNode> &node,
+                 const AffineTransform3           &world,
+                 const PresentationNode           *material);
+
+    /**
+     * Find or add the merge group for a surface.
+     * @param  surface   Surface to merge
+     * @param  material  Material of the surface (nullptr if none)
+     * @return  Returns the merge group.
+     */
+    BakeGroup &find_group(const TriSurface &surface, const PresentationNode *material);
+
+    /**
+     * Copy the surfaces of every group into the merged vertex and face
+     * lists, in parallel.
+     */
+    void merge_groups();
+};
+
+} // namespace cg
+
+#endif
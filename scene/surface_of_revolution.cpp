@@ -51,21 +51,30 @@ SurfaceOfRevolution::SurfaceOfRevolution(std::vector<Point3> &v,
     // ConstructRowColFaceList forms ccw triangles
     std::reverse(vertices_.begin(), vertices_.end());
 
-    // Create a rotation matrix
-    Matrix4x4 m;
-    m.rotate_z(360.0f / static_cast<float>(n));
+    // Copy the "edge" vertices and normals into contiguous arrays so each
+    // column can be formed with the batched matrix transforms
+    std::vector<Point3>  edge_vertices(num_rows_), col_vertices(num_rows_);
+    std::vector<Vector3> edge_normals(num_rows_), col_normals(num_rows_);
+    for(uint32_t j = 0; j < num_rows_; j++)
+    {
+        edge_vertices[j] = vertices_[j].vertex;
+        edge_normals[j] = vertices_[j].normal;
+    }
 
-    // Rotate the prior "edge" vertices
-    uint32_t index = 0; // Index to the prior edge at this row
-    for(uint32_t i = 0; i < n; i++)
+    // Rotate the edge to form each column. Each column uses its own rotation
+    // from the edge so error does not accumulate around the surface
+    vertices_.reserve(num_rows_ * (n + 2));
+    for(uint32_t i = 1; i <= n; i++)
     {
+        Matrix4x4 m;
+        m.rotate_z(360.0f * static_cast<float>(i) / static_cast<float>(n));
+        m.transform_points(edge_vertices.data(), col_vertices.data(), num_rows_);
+        m.transform_vectors(edge_normals.data(), col_normals.data(), num_rows_);
         for(uint32_t j = 0; j < num_rows_; j++)
         {
-            // Rotate the vertex and the normal
-            vtx.vertex = m * vertices_[index].vertex;
-            vtx.normal = m * vertices_[index].normal;
+            vtx.vertex = col_vertices[j];
+            vtx.normal = col_normals[j];
             vertices_.push_back(vtx);
-            index++;
         }
     }
 
@@ -74,6 +83,7 @@ SurfaceOfRevolution::SurfaceOfRevolution(std::vector<Point3> &v,
 
     // Construct the face list and create VBOs
     construct_row_col_face_list(num_cols_, num_rows_);
+    optimize_face_order();
     create_vertex_buffers(position_loc, normal_loc);
 }
 
@@ -140,31 +150,37 @@ SurfaceOfRevolution::SurfaceOfRevolution(std::vector<Point3> &v,
     // ConstructRowColFaceList forms ccw triangles
     std::reverse(vertices_with_tex_.begin(), vertices_with_tex_.end());
 
-    // Create a rotation matrix for each step
-    Matrix4x4 rotation_step;
-    rotation_step.rotate_z(360.0f / static_cast<float>(n));
-
-    // Texture coordinate increment for each rotation step
-    float du = 1.0f / static_cast<float>(n);
+    // Copy the "edge" vertices and normals into contiguous arrays so each
+    // column can be formed with the batched matrix transforms
+    std::vector<Point3>  edge_vertices(num_rows_), col_vertices(num_rows_);
+    std::vector<Vector3> edge_normals(num_rows_), col_normals(num_rows_);
+    for(uint32_t j = 0; j < num_rows_; j++)
+    {
+        edge_vertices[j] = vertices_with_tex_[j].vertex;
+        edge_normals[j] = vertices_with_tex_[j].normal;
+    }
 
-    // Rotate the prior "edge" vertices
-    uint32_t index = 0; // Index to the prior edge at this row
-    for(uint32_t i = 0; i < n; i++)
+    // Rotate the edge to form each column. Each column uses its own rotation
+    // from the edge so error does not accumulate around the surface
+    vertices_with_tex_.reserve(num_rows_ * (n + 2));
+    for(uint32_t i = 1; i <= n; i++)
     {
-        float u = static_cast<float>(i + 1) / static_cast<float>(n);
-        
+        float u = static_cast<float>(i) / static_cast<float>(n);
+
+        Matrix4x4 m;
+        m.rotate_z(360.0f * u);
+        m.transform_points(edge_vertices.data(), col_vertices.data(), num_rows_);
+        m.transform_vectors(edge_normals.data(), col_normals.data(), num_rows_);
         for(uint32_t j = 0; j < num_rows_; j++)
         {
-            // Rotate the vertex and the normal incrementally from previous column
-            vtx.vertex = rotation_step * vertices_with_tex_[index].vertex;
-            vtx.normal = rotation_step * vertices_with_tex_[index].normal;
-            
+            vtx.vertex = col_vertices[j];
+            vtx.normal = col_normals[j];
+
             // Update u texture coordinate (wraps around the cylinder)
             vtx.texcoord.x = u;
-            vtx.texcoord.y = vertices_with_tex_[index].texcoord.y;
-            
+            vtx.texcoord.y = vertices_with_tex_[j].texcoord.y;
+
             vertices_with_tex_.push_back(vtx);
-            index++;
         }
     }
 
@@ -178,6 +194,7 @@ SurfaceOfRevolution::SurfaceOfRevolution(std::vector<Point3> &v,
 
     // Construct the face list and create VBOs
     construct_row_col_face_list(num_cols_, num_rows_);
+    optimize_face_order();
     create_vertex_buffers(position_loc, normal_loc, texcoord_loc);
 }
 
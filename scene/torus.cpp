@@ -44,8 +44,10 @@ TorusSurface::TorusSurface(float    ring_radius,
     }
 
     // Construct face list and create VBOs. There are num_tube+1 rows (outer for
-    // loop) and num_ring+1 columns (inner for loop).
+    // loop) and num_ring+1 columns (inner for loop). The inner side of the
+    // torus is hidden by the outer side, so order faces for overdraw too.
     construct_row_col_face_list(num_tube + 1, num_ring + 1);
+    optimize_face_order(true);
     create_vertex_buffers(position_loc, normal_loc);
 }
 
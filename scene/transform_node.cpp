@@ -4,6 +4,8 @@ namespace cg
 {
 
 TransformNode::TransformNode()
+    : matrix_version_(0), dirty_(true), pvm_valid_(false), world_bounds_valid_(false),
+      world_bounds_version_(0), has_world_bounds_(false)
 {
     node_type_ = SceneNodeType::TRANSFORM;
     load_identity();
@@ -11,39 +13,121 @@ TransformNode::TransformNode()
 
 TransformNode::~TransformNode() {}
 
-void TransformNode::load_identity() { model_matrix_.set_identity(); }
+void TransformNode::load_identity()
+{
+    model_matrix_.set_identity();
+    set_dirty();
+}
 
-void TransformNode::translate(float x, float y, float z) { model_matrix_.translate(x, y, z); }
+void TransformNode::translate(float x, float y, float z)
+{
+    model_matrix_.translate(x, y, z);
+    set_dirty();
+}
 
-void TransformNode::rotate(float deg, Vector3 &v) { model_matrix_.rotate(deg, v.x, v.y, v.z); }
+void TransformNode::rotate(float deg, Vector3 &v)
+{
+    model_matrix_.rotate(deg, v.x, v.y, v.z);
+    set_dirty();
+}
 
-void TransformNode::rotate_x(float deg) { model_matrix_.rotate_x(deg); }
+void TransformNode::rotate_x(float deg)
+{
+    model_matrix_.rotate_x(deg);
+    set_dirty();
+}
 
-void TransformNode::rotate_y(float deg) { model_matrix_.rotate_y(deg); }
+void TransformNode::rotate_y(float deg)
+{
+    model_matrix_.rotate_y(deg);
+    set_dirty();
+}
 
-void TransformNode::rotate_z(float deg) { model_matrix_.rotate_z(deg); }
+void TransformNode::rotate_z(float deg)
+{
+    model_matrix_.rotate_z(deg);
+    set_dirty();
+}
 
-void TransformNode::scale(float x, float y, float z) { model_matrix_.scale(x, y, z); }
+void TransformNode::scale(float x, float y, float z)
+{
+    model_matrix_.scale(x, y, z);
+    set_dirty();
+}
+
+void TransformNode::set_matrix(const AffineTransform3 &m)
+{
+    model_matrix_ = m;
+    set_dirty();
+}
+
+const AffineTransform3 &TransformNode::get_matrix() const { return model_matrix_; }
+
+uint64_t TransformNode::get_matrix_version() const { return matrix_version_; }
+
+void TransformNode::set_dirty()
+{
+    dirty_ = true;
+    subtree_changed();
+    matrix_version_ = version_;
+}
 
 void TransformNode::draw(SceneState &scene_state)
 {
+    // Recompute the world and normal matrices only when the local transform
+    // changed or the parent model matrix differs from the one last used. Any
+    // change above this node changes the parent model matrix, so descendants
+    // of a changed node are recomputed as well. Note the right-multiply - this
+    // allows hierarchical transformations in the scene
+    if(dirty_ || !(scene_state.model_matrix == parent_matrix_))
+    {
+        parent_matrix_ = scene_state.model_matrix;
+        world_transform_ = parent_matrix_ * model_matrix_;
+        world_matrix_ = world_transform_.get_matrix();
+
+        // Normal transform matrix (transpose of the inverse of the model matrix).
+        // This transforms normals into view coordinates. Only needs a 3x3
+        // inverse, or none for rigid and uniform scale transforms
+        normal_matrix_ = world_transform_.get_normal_matrix();
+        dirty_ = false;
+        pvm_valid_ = false;
+        world_bounds_valid_ = false;
+    }
+
+    // Skip the subtree before any GL calls if it is outside the view frustum.
+    // World bounds are recomputed when the world matrix or this subtree
+    // changes.
+    if(!world_bounds_valid_ || world_bounds_version_ != version_)
+    {
+        BoundingSphere local;
+        has_world_bounds_ = SceneNode::compute_bounds(local);
+        if(has_world_bounds_) { world_bounds_ = world_transform_ * local; }
+        world_bounds_valid_ = true;
+        world_bounds_version_ = version_;
+    }
+    if(has_world_bounds_ && scene_state.frustum.is_outside(world_bounds_))
+    {
+        scene_state.nodes_culled++;
+        return;
+    }
+    scene_state.nodes_drawn++;
+
     // Copy current transforms onto stack
     scene_state.push_transforms();
 
-    // Apply this modeling transform to the current modeling matrix.
-    // Note the right-multiply - this allows hierarchical transformations
-    // in the scene
-    scene_state.model_matrix *= model_matrix_;
-    glUniformMatrix4fv(scene_state.model_matrix_loc, 1, GL_FALSE, scene_state.model_matrix.get());
-
-    // Set the normal transform matrix (transpose of the inverse of the model matrix).
-    // This transforms normals into view coordinates
-    Matrix4x4 normal_matrix = scene_state.model_matrix.get_inverse().transpose();
-    glUniformMatrix4fv(scene_state.normal_matrix_loc, 1, GL_FALSE, normal_matrix.get());
+    // Composite projection, view, modeling matrix. Only changes when the
+    // camera moves or the world matrix is recomputed
+    if(!pvm_valid_ || !(scene_state.pv == pv_matrix_))
+    {
+        pv_matrix_ = scene_state.pv;
+        pvm_matrix_ = pv_matrix_ * world_transform_;
+        pvm_valid_ = true;
+    }
 
-    // Set the composite projection, view, modeling matrix
-    Matrix4x4 pvm = scene_state.pv * scene_state.model_matrix;
-    glUniformMatrix4fv(scene_state.pvm_matrix_loc, 1, GL_FALSE, pvm.get());
+    scene_state.model_matrix = world_transform_;
+    scene_state.gl_state.uniform_matrix4fv(scene_state.model_matrix_loc, world_matrix_.get());
+    scene_state.gl_state.uniform_matrix4fv(scene_state.normal_matrix_loc, normal_matrix_.get());
+    scene_state.gl_state.uniform_matrix4fv(scene_state.pvm_matrix_loc, pvm_matrix_.get());
 
     // Draw all children
     SceneNode::draw(scene_state);
@@ -54,4 +138,12 @@ void TransformNode::draw(SceneState &scene_state)
 
 void TransformNode::update(SceneState &scene_state) {}
 
+bool TransformNode::compute_bounds(BoundingSphere &sphere)
+{
+    BoundingSphere children;
+    if(!SceneNode::compute_bounds(children)) { return false; }
+    sphere = model_matrix_ * children;
+    return true;
+}
+
 } // namespace cg
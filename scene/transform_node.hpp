@@ -21,7 +21,13 @@ namespace cg
 
 /**
  * Transform node. Applies a transformation. This class allows OpenGL style
- * transforms applied to the scene graph.
+ * transforms applied to the scene graph. The composite world matrix, its
+ * normal matrix, and the composite projection-view-model matrix are cached
+ * and only recomputed when this node's transform changes or the matrices
+ * above it change (so a change propagates to all descendants). A node that
+ * is shared by several parents recomputes when reached from a different parent.
+ * The world space bounds of the subtree are cached the same way and used to
+ * skip the whole subtree when it is outside the view frustum.
  */
 class TransformNode : public SceneNode
 {
@@ -82,6 +88,25 @@ class TransformNode : public SceneNode
      */
     void scale(float x, float y, float z);
 
+    /**
+     * Replace the local modeling transformation.
+     * @param  m  Modeling transformation
+     */
+    void set_matrix(const AffineTransform3 &m);
+
+    /**
+     * Get the local modeling transformation.
+     * @return  Returns the local modeling matrix of this node.
+     */
+    const AffineTransform3 &get_matrix() const;
+
+    /**
+     * Get the version of the local modeling transformation. Changes each
+     * time the transformation is set or modified.
+     * @return  Returns the matrix version.
+     */
+    uint64_t get_matrix_version() const;
+
     /**
      * Draw this transformation node and its children
      * @param  scene_state   Current scene state
@@ -95,7 +120,34 @@ class TransformNode : public SceneNode
     void update(SceneState &scene_state) override;
 
   protected:
-    Matrix4x4 model_matrix_; // Local modeling transformation
+    AffineTransform3 model_matrix_;   // Local modeling transformation
+    uint64_t         matrix_version_; // Subtree version when model_matrix_ last changed
+
+    // Cached matrices
+    bool             dirty_;           // Local modeling transformation changed
+    bool             pvm_valid_;       // Cached pvm matrix is valid for world_transform_
+    AffineTransform3 parent_matrix_;   // Parent model matrix used for world_transform_
+    AffineTransform3 world_transform_; // Parent model matrix * local modeling transformation
+    Matrix4x4        world_matrix_;    // world_transform_ as a 4x4 matrix (for the shader)
+    Matrix4x4        normal_matrix_;   // Inverse transpose of world_transform_
+    Matrix4x4        pv_matrix_;       // Projection-view matrix used to compute pvm_matrix_
+    Matrix4x4        pvm_matrix_;      // Composite projection, view, model matrix
+
+    // Cached world space bounds of the children
+    bool           world_bounds_valid_;   // World bounds computed for world_transform_
+    uint64_t       world_bounds_version_; // Subtree version the world bounds were computed at
+    bool           has_world_bounds_;     // False if the subtree cannot be culled
+    BoundingSphere world_bounds_;         // Bounds of the children in world coordinates
+
+    /**
+     * Mark the local modeling transformation as changed.
+     */
+    void set_dirty();
+
+    /**
+     * Bounds of the children transformed by the local modeling transformation.
+     */
+    bool compute_bounds(BoundingSphere &sphere) override;
 };
 
 } // namespace cg
@@ -1,11 +1,84 @@
 #include "scene/tri_surface.hpp"
+#include "geometry/vertex_stream.hpp"
 
-#include <cmath>
+#include <cstdint>
+#include <iostream>
 
 namespace cg
 {
 
-TriSurface::TriSurface() : vao_{0}, vbo_{0}, facebuffer_{0}, has_texture_coords_{false}, has_tangent_space_{false}, GeometryNode()
+namespace
+{
+
+// Copy a vertex and face list into a merged mesh, transforming positions
+// and normals to world coordinates
+template <typename V, typename I>
+void copy_transformed_lists(const std::vector<V>    &src_vertices,
+                            const std::vector<I>    &src_faces,
+                            const AffineTransform3 &world,
+                            V                      *vertices,
+                            uint32_t               *faces,
+                            uint32_t                base_vertex)
+{
+    Matrix4x4 normal_matrix = world.get_normal_matrix();
+    for(const auto &v : src_vertices)
+    {
+        *vertices = v;
+        vertices->vertex = world * v.vertex;
+        vertices->normal = normal_matrix * v.normal;
+        vertices->normal.normalize();
+        vertices++;
+    }
+
+    // A transform with a negative determinant mirrors the triangles, so swap
+    // two indexes of each to keep them counter-clockwise
+    Matrix4x4 m = world.get_matrix();
+    float     det = m.m00() * (m.m11() * m.m22() - m.m12() * m.m21()) -
+                m.m01() * (m.m10() * m.m22() - m.m12() * m.m20()) +
+                m.m02() * (m.m10() * m.m21() - m.m11() * m.m20());
+    uint32_t second = (det < 0.0f) ? 2 : 1;
+    for(size_t i = 0; i + 2 < src_faces.size(); i += 3)
+    {
+        faces[i] = base_vertex + src_faces[i];
+        faces[i + second] = base_vertex + src_faces[i + 1];
+        faces[i + 3 - second] = base_vertex + src_faces[i + 2];
+    }
+}
+
+// Move each vertex to its new index. Lists this surface was not built with
+// are empty and left alone.
+template <typename V>
+void reorder_vertices(std::vector<V> &vertices, const std::vector<uint32_t> &remap)
+{
+    if(vertices.size() != remap.size()) { return; }
+    std::vector<V> reordered(vertices.size());
+    for(size_t i = 0; i < vertices.size(); i++) { reordered[remap[i]] = vertices[i]; }
+    vertices.swap(reordered);
+}
+
+// Release the surfaces below a node. Shared nodes are visited once per
+// parent, but a surface frees its lists only the first time.
+void release_surfaces(SceneNode &node, size_t &bytes)
+{
+    auto *surface = dynamic_cast<TriSurface *>(&node);
+    if(surface != nullptr) { bytes += surface->release_cpu_data(); }
+    for(const auto &c : node.get_children()) { release_surfaces(*c, bytes); }
+}
+
+} // namespace
+
+size_t release_cpu_data(SceneNode &root)
+{
+    size_t bytes = 0;
+    release_surfaces(root, bytes);
+    return bytes;
+}
+
+TriSurface::TriSurface() :
+    GeometryNode(), vao_{0}, vbo_{0}, facebuffer_{0},
+    attribute_locs_{make_attribute_locations(-1, -1)}, vertex_size_{0}, packing_flags_{0},
+    has_texture_coords_{false}, has_tangent_space_{false}, index_type_{GL_UNSIGNED_SHORT},
+    keep_cpu_data_{false}, cpu_data_released_{false}, released_vertex_count_{0}
 {
 }
 
@@ -19,16 +92,234 @@ TriSurface::~TriSurface()
 
 void TriSurface::draw(SceneState &scene_state)
 {
+    // Lights set and materials added since the last draw are uploaded once, here
+    scene_state.light_buffer.upload();
+    scene_state.materials.upload();
+    set_packing_uniforms(scene_state);
+    if(pooled_.pool != nullptr)
+    {
+        pooled_.pool->bind(scene_state);
+        glDrawElementsBaseVertex(GL_TRIANGLES,
+                                 face_count_,
+                                 GL_UNSIGNED_SHORT,
+                                 (void *)(pooled_.first_index * sizeof(uint16_t)),
+                                 pooled_.base_vertex);
+    }
+    else
+    {
+        scene_state.gl_state.bind_vertex_array(vao_);
+        glDrawElements(GL_TRIANGLES, face_count_, index_type_, (void *)0);
+    }
+    scene_state.draw_calls++;
+}
+
+bool TriSurface::can_draw_instances() const { return !has_tangent_space_; }
+
+void TriSurface::draw_instances(SceneState           &scene_state,
+                                const InstanceBuffer &instances,
+                                uint32_t              first,
+                                uint32_t              count)
+{
+    scene_state.light_buffer.upload();
+    scene_state.materials.upload();
+    set_packing_uniforms(scene_state);
+    if(pooled_.pool != nullptr)
+    {
+        pooled_.pool->bind(scene_state);
+        instances.enable_attributes(scene_state, first);
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES,
+                                          face_count_,
+                                          GL_UNSIGNED_SHORT,
+                                          (void *)(pooled_.first_index * sizeof(uint16_t)),
+                                          count,
+                                          pooled_.base_vertex);
+    }
+    else
+    {
+        scene_state.gl_state.bind_vertex_array(vao_);
+        instances.enable_attributes(scene_state, first);
+        glDrawElementsInstanced(GL_TRIANGLES, face_count_, index_type_, (void *)0, count);
+    }
+    instances.disable_attributes(scene_state);
+    scene_state.draw_calls++;
+    scene_state.instanced_calls++;
+}
+
+bool TriSurface::move_to_pool(GeometryPool &pool)
+{
+    if(pooled_.pool != nullptr) { return pooled_.pool == &pool; }
+    if(has_tangent_space_ || vao_ == 0 || faces_.is_wide() || packing_flags_ != 0 ||
+       cpu_data_released_)
+    {
+        return false;
+    }
+
+    if(has_texture_coords_)
+    {
+        if(pool.get_layout() != VertexLayout::POSITION_NORMAL_TEXTURE) { return false; }
+        pooled_ = pool.add(vertices_with_tex_.data(),
+                           static_cast<uint32_t>(vertices_with_tex_.size()),
+                           faces_.narrow());
+    }
+    else
+    {
+        if(pool.get_layout() != VertexLayout::POSITION_NORMAL) { return false; }
+        pooled_ =
+            pool.add(vertices_.data(), static_cast<uint32_t>(vertices_.size()), faces_.narrow());
+    }
+
+    glDeleteBuffers(1, &vbo_);
+    glDeleteBuffers(1, &facebuffer_);
+    glDeleteVertexArrays(1, &vao_);
+    vbo_ = 0;
+    facebuffer_ = 0;
+    vao_ = 0;
+    return true;
+}
+
+bool TriSurface::pack_vertices(VertexPacking packing)
+{
+    if(vao_ == 0 || pooled_.pool != nullptr || packing_flags_ != 0 || cpu_data_released_)
+    {
+        std::cout << "TriSurface: pack vertices once, after creating the vertex buffers and "
+                     "before releasing the CPU data\n";
+        return false;
+    }
+    if(packing == VertexPacking::NONE) { return true; }
+
+    PackedVertices packed;
+    if(has_tangent_space_) { packed.pack(vertices_with_tangents_, packing); }
+    else if(has_texture_coords_) { packed.pack(vertices_with_tex_, packing); }
+    else { packed.pack(vertices_, packing); }
+    if(packed.size() == 0) { return false; }
+
+    // Replace the vertex buffer contents and point the attributes at the
+    // packed layout. The QTangent replaces the tangent and bitangent, so
+    // those arrays are disabled.
+    int32_t         flags = packed.get_flags();
+    bool            quantized = (flags & PACKED_POSITION) != 0;
+    VertexAttribute attributes[3] = {
+        {VertexAttributeSlot::POSITION,
+         3,
+         static_cast<GLenum>(quantized ? GL_UNSIGNED_SHORT : GL_FLOAT),
+         static_cast<GLboolean>(quantized ? GL_TRUE : GL_FALSE),
+         0},
+        {VertexAttributeSlot::NORMAL,
+         (flags & PACKED_QTANGENT) ? 4 : 2,
+         GL_SHORT,
+         GL_TRUE,
+         packed.get_normal_offset()},
+        {VertexAttributeSlot::TEXCOORD, 2, GL_HALF_FLOAT, GL_FALSE, packed.get_texcoord_offset()}};
+    size_t attribute_count = (packed.get_texcoord_offset() != 0) ? 3 : 2;
     glBindVertexArray(vao_);
-    glDrawElements(GL_TRIANGLES, face_count_, GL_UNSIGNED_SHORT, (void *)0);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    glBufferData(
+        GL_ARRAY_BUFFER, packed.get_data().size(), packed.get_data().data(), GL_STATIC_DRAW);
+    set_vertex_attributes(attributes,
+                          attribute_count,
+                          static_cast<GLsizei>(packed.get_stride()),
+                          attribute_locs_);
     glBindVertexArray(0);
+
+    vertex_size_ = packed.get_stride();
+    packing_flags_ = flags;
+    position_offset_ = packed.get_position_offset();
+    position_scale_ = packed.get_position_scale();
+    return true;
+}
+
+uint32_t TriSurface::get_vertex_size() const { return vertex_size_; }
+
+void TriSurface::keep_cpu_data() { keep_cpu_data_ = true; }
+
+size_t TriSurface::release_cpu_data()
+{
+    if(keep_cpu_data_ || cpu_data_released_ || (vao_ == 0 && pooled_.pool == nullptr))
+    {
+        return 0;
+    }
+
+    // Swap with empty lists: clear() keeps the capacity
+    released_vertex_count_ = get_vertex_count();
+    size_t bytes = vertices_.capacity() * sizeof(VertexAndNormal) +
+                   vertices_with_tex_.capacity() * sizeof(VertexNormalTexture) +
+                   vertices_with_tangents_.capacity() * sizeof(VertexNormalTextureTangent) +
+                   faces_.size() * faces_.index_size();
+    std::vector<VertexAndNormal>().swap(vertices_);
+    std::vector<VertexNormalTexture>().swap(vertices_with_tex_);
+    std::vector<VertexNormalTextureTangent>().swap(vertices_with_tangents_);
+    faces_ = IndexList();
+    welder_ = VertexWelder(welder_.get_epsilon());
+    cpu_data_released_ = true;
+    return bytes;
+}
+
+bool TriSurface::has_cpu_data() const { return !cpu_data_released_; }
+
+const PooledMesh *TriSurface::get_pooled_mesh() const
+{
+    return (pooled_.pool != nullptr) ? &pooled_ : nullptr;
+}
+
+bool TriSurface::has_texture_coords() const { return has_texture_coords_; }
+
+bool TriSurface::has_tangent_space() const { return has_tangent_space_; }
+
+uint32_t TriSurface::get_vertex_count() const
+{
+    if(cpu_data_released_) { return released_vertex_count_; }
+    if(has_tangent_space_) { return static_cast<uint32_t>(vertices_with_tangents_.size()); }
+    if(has_texture_coords_) { return static_cast<uint32_t>(vertices_with_tex_.size()); }
+    return static_cast<uint32_t>(vertices_.size());
+}
+
+uint32_t TriSurface::get_index_count() const
+{
+    return cpu_data_released_ ? static_cast<uint32_t>(face_count_)
+                              : static_cast<uint32_t>(faces_.size());
+}
+
+void TriSurface::copy_transformed(const AffineTransform3 &world,
+                                  VertexAndNormal        *vertices,
+                                  uint32_t               *faces,
+                                  uint32_t                base_vertex) const
+{
+    faces_.visit([&](const auto &f)
+                 { copy_transformed_lists(vertices_, f, world, vertices, faces, base_vertex); });
+}
+
+void TriSurface::copy_transformed(const AffineTransform3 &world,
+                                  VertexNormalTexture    *vertices,
+                                  uint32_t               *faces,
+                                  uint32_t                base_vertex) const
+{
+    faces_.visit(
+        [&](const auto &f)
+        { copy_transformed_lists(vertices_with_tex_, f, world, vertices, faces, base_vertex); });
 }
 
 void TriSurface::construct(const std::vector<VertexAndNormal> &v, const std::vector<uint16_t> &f)
 {
     vertices_ = v;
-    faces_ = f;
+    faces_.assign(f);
     has_texture_coords_ = false;
+    welder_.clear();
+}
+
+void TriSurface::construct(const std::vector<VertexAndNormal> &v, const std::vector<uint32_t> &f)
+{
+    vertices_ = v;
+    faces_.assign(f);
+    has_texture_coords_ = false;
+    welder_.clear();
+}
+
+void TriSurface::construct(const std::vector<VertexNormalTexture> &v,
+                           const std::vector<uint32_t>        &f)
+{
+    vertices_with_tex_ = v;
+    faces_.assign(f);
+    has_texture_coords_ = true;
 }
 
 void TriSurface::add_polygon(const std::vector<Point3> &vertex_list)
@@ -41,7 +332,7 @@ void TriSurface::add_polygon(const std::vector<Point3> &vertex_list)
 
     // Add vertices to the vertex list (with the face normal).
     // Save the current index so the face list is properly constructed
-    size_t curr_vertex = vertices_.size();
+    uint32_t curr_vertex = static_cast<uint32_t>(vertices_.size());
     for(const auto &v : vertex_list)
     {
         vertex.vertex = v;
@@ -49,7 +340,7 @@ void TriSurface::add_polygon(const std::vector<Point3> &vertex_list)
     }
 
     // Form face list as if this was a triangle fan (always use the 1st vertex)
-    for(size_t i = 2, n = vertex_list.size(); i < n; i++)
+    for(uint32_t i = 2, n = static_cast<uint32_t>(vertex_list.size()); i < n; i++)
     {
         faces_.push_back(curr_vertex);
         faces_.push_back(curr_vertex + i - 1);
@@ -64,38 +355,23 @@ void TriSurface::add(const Point3 &v0, const Point3 &v1, const Point3 &v2)
     faces_.push_back(add_vertex(v2));
 }
 
+void TriSurface::set_weld_epsilon(float epsilon) { welder_.set_epsilon(epsilon); }
+
 void TriSurface::end(int32_t position_loc, int32_t normal_loc)
 {
-    // Iterate through the face list and calculate the normals for each
-    // face and add the normal to each vertex in the face list. This
-    // assumes the vertex normals are initilaized to 0 (in constructor
-    // of VertexAndNormal)
-    uint32_t v0, v1, v2;
-    Vector3  e1, e2, face_normal;
-    auto     face_vertex = faces_.begin();
-    while(face_vertex != faces_.end())
-    {
-        // Get the vertices of the face (assumes ccw order)
-        v0 = *face_vertex++;
-        v1 = *face_vertex++;
-        v2 = *face_vertex++;
-
-        // Calculate surface normal. Normalize it since cross products
-        // do not ensure unit length normals. We need to make sure normals
-        // are same length so averaging works properly
-        e1.set(vertices_[v0].vertex, vertices_[v1].vertex);
-        e2.set(vertices_[v0].vertex, vertices_[v2].vertex);
-        face_normal = (e1.cross(e2)).normalize();
-
-        // Add the face normal to the vertex normals of the triangle
-        vertices_[v0].normal += face_normal;
-        vertices_[v1].normal += face_normal;
-        vertices_[v2].normal += face_normal;
-    }
-
-    // Normalize the vertex normals - this essentially averages the
-    // adjoining face normals.
-    for(auto &v : vertices_) { v.normal.normalize(); }
+    // The mesh is complete, so the spatial hash is no longer needed
+    welder_ = VertexWelder(welder_.get_epsilon());
+
+    // Calculate the normal for each face and add it to each vertex of the
+    // face, then normalize - this essentially averages the adjoining face
+    // normals. This assumes the vertex normals are initialized to 0 (in
+    // constructor of VertexAndNormal). The work is done on a structure of
+    // arrays copy of the vertex list, which is interleaved again for upload.
+    VertexStream stream;
+    stream.load(vertices_);
+    faces_.visit([&stream](const auto &f) { stream.accumulate_face_normals(f.data(), f.size()); });
+    stream.normalize_normals();
+    stream.store(vertices_);
 
     // Create the vertex and face buffers
     create_vertex_buffers(position_loc, normal_loc);
@@ -104,51 +380,37 @@ void TriSurface::end(int32_t position_loc, int32_t normal_loc)
 void TriSurface::create_vertex_buffers(int32_t position_loc, int32_t normal_loc)
 {
     has_texture_coords_ = false;
-
-    // Generate vertex buffers for the vertex list and the face list
-    glGenBuffers(1, &vbo_);
-    glGenBuffers(1, &facebuffer_);
-
-    // Bind the vertex list to the vertex buffer object
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-    glBufferData(GL_ARRAY_BUFFER,
-                 vertices_.size() * sizeof(VertexAndNormal),
-                 (void *)&vertices_[0],
-                 GL_STATIC_DRAW);
-
-    // Bind the face list to the vertex buffer object
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, facebuffer_);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                 faces_.size() * sizeof(uint16_t),
-                 (void *)&faces_[0],
-                 GL_STATIC_DRAW);
-
-    // Copy the face list count for use in Draw
-    face_count_ = static_cast<GLsizei>(faces_.size());
-
-    // Allocate a VAO, enable it and set the vertex attribute arrays and pointers
-    glGenVertexArrays(1, &vao_);
-    glBindVertexArray(vao_);
-
-    // Bind the vertex buffer, set the vertex position attribute and the vertex normal attribute
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-    glVertexAttribPointer(position_loc, 3, GL_FLOAT, GL_FALSE, sizeof(VertexAndNormal), (void *)0);
-    glVertexAttribPointer(
-        normal_loc, 3, GL_FLOAT, GL_FALSE, sizeof(VertexAndNormal), (void *)(sizeof(Point3)));
-    glEnableVertexAttribArray(position_loc);
-    glEnableVertexAttribArray(normal_loc);
-
-    // Bind the face list buffer and draw.
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, facebuffer_);
-
-    // Make sure changes to this VAO are local
-    glBindVertexArray(0);
+    create_vertex_buffers(vertices_, make_attribute_locations(position_loc, normal_loc));
 }
 
 // Version with texture coordinates
 void TriSurface::create_vertex_buffers(int32_t position_loc, int32_t normal_loc, int32_t texcoord_loc)
 {
     has_texture_coords_ = true;
+    create_vertex_buffers(vertices_with_tex_,
+                          make_attribute_locations(position_loc, normal_loc, texcoord_loc));
+}
+
+// Version with tangent space
+void TriSurface::create_vertex_buffers(int32_t position_loc,
+                                       int32_t normal_loc,
+                                       int32_t texcoord_loc,
+                                       int32_t tangent_loc,
+                                       int32_t bitangent_loc)
+{
+    has_texture_coords_ = true;
+    has_tangent_space_ = true;
+    create_vertex_buffers(vertices_with_tangents_,
+                          make_attribute_locations(
+                              position_loc, normal_loc, texcoord_loc, tangent_loc, bitangent_loc));
+}
+
+template <typename V>
+void TriSurface::create_vertex_buffers(const std::vector<V>     &vertices,
+                                       const AttributeLocations &locations)
+{
+    attribute_locs_ = locations;
+    vertex_size_ = sizeof(V);
 
     // Generate vertex buffers for the vertex list and the face list
     glGenBuffers(1, &vbo_);
@@ -156,54 +418,17 @@ void TriSurface::create_vertex_buffers(int32_t position_loc, int32_t normal_loc,
 
     // Bind the vertex list to the vertex buffer object
     glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-    glBufferData(GL_ARRAY_BUFFER,
-                 vertices_with_tex_.size() * sizeof(VertexNormalTexture),
-                 (void *)&vertices_with_tex_[0],
-                 GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(V), vertices.data(), GL_STATIC_DRAW);
 
     // Bind the face list to the vertex buffer object
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, facebuffer_);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                 faces_.size() * sizeof(uint16_t),
-                 (void *)&faces_[0],
-                 GL_STATIC_DRAW);
-
-    // Copy the face list count for use in Draw
-    face_count_ = static_cast<GLsizei>(faces_.size());
+    upload_faces();
+    update_local_bounds();
 
     // Allocate a VAO, enable it and set the vertex attribute arrays and pointers
     glGenVertexArrays(1, &vao_);
     glBindVertexArray(vao_);
-
-    // Bind the vertex buffer, set the vertex attributes
     glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-    
-    // Position attribute (location 0)
-    if(position_loc >= 0)
-    {
-        glVertexAttribPointer(position_loc, 3, GL_FLOAT, GL_FALSE, 
-                             sizeof(VertexNormalTexture), 
-                             (void *)0);
-        glEnableVertexAttribArray(position_loc);
-    }
-    
-    // Normal attribute (location 1)
-    if(normal_loc >= 0)
-    {
-        glVertexAttribPointer(normal_loc, 3, GL_FLOAT, GL_FALSE, 
-                             sizeof(VertexNormalTexture), 
-                             (void *)(sizeof(Point3)));
-        glEnableVertexAttribArray(normal_loc);
-    }
-    
-    //Texture coordinate attribute (location 2)
-    if(texcoord_loc >= 0)
-    {
-        glVertexAttribPointer(texcoord_loc, 2, GL_FLOAT, GL_FALSE, 
-                             sizeof(VertexNormalTexture), 
-                             (void *)(sizeof(Point3) + sizeof(Vector3)));
-        glEnableVertexAttribArray(texcoord_loc);
-    }
+    set_vertex_attributes<V>(locations);
 
     // Bind the face list buffer
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, facebuffer_);
@@ -214,6 +439,15 @@ void TriSurface::create_vertex_buffers(int32_t position_loc, int32_t normal_loc,
 
 void TriSurface::construct_row_col_face_list(uint32_t num_rows, uint32_t num_cols)
 {
+    // Indexes past 16 bits widen the face list, but the grid must still be
+    // addressable with 32 bit indexes
+    if(static_cast<uint64_t>(num_rows) * num_cols > static_cast<uint64_t>(UINT32_MAX) + 1)
+    {
+        std::cout << "TriSurface: " << num_rows << " x " << num_cols
+                  << " vertex grid exceeds 32 bit indexes\n";
+        return;
+    }
+    faces_.reserve(faces_.size() + 6 * static_cast<size_t>(num_rows - 1) * (num_cols - 1));
     for(uint32_t row = 0; row < num_rows - 1; row++)
     {
         for(uint32_t col = 0; col < num_cols - 1; col++)
@@ -231,206 +465,185 @@ void TriSurface::construct_row_col_face_list(uint32_t num_rows, uint32_t num_col
     }
 }
 
-uint16_t TriSurface::get_index(uint32_t row, uint32_t col, uint32_t num_cols) const
+uint32_t TriSurface::get_index(uint32_t row, uint32_t col, uint32_t num_cols) const
 {
-    return static_cast<uint16_t>((row * num_cols) + col);
+    return (row * num_cols) + col;
 }
 
-uint16_t TriSurface::add_vertex(const Point3 &vtx)
+uint32_t TriSurface::add_vertex(const Point3 &vtx)
 {
-    // Check if vertex is in the list. This is just a brute force method.
-    // Efficiency can be improved but we only use this at startup
-    uint16_t index = 0;
-    for(const auto &v : vertices_)
+    // Hash vertices appended since the last call (add_polygon, subclasses),
+    // starting over if the vertex list was replaced or shrank
+    if(welder_.size() > vertices_.size()) { welder_.clear(); }
+    for(size_t i = welder_.size(); i < vertices_.size(); i++)
     {
-        if(vtx == v.vertex) { return index; }
-        index++;
+        welder_.insert(vertices_[i].vertex, static_cast<uint32_t>(i));
     }
 
-    // Not in the list, add it. Make sure the vertex normal is initialized
-    // to (0,0,0)
-    VertexAndNormal vertex_and_normal(vtx);
-    vertices_.push_back(vertex_and_normal);
-    return static_cast<uint16_t>(vertices_.size() - 1);
+    // Use the vertex if it is in the list, else add it. Make sure the vertex
+    // normal is initialized to (0,0,0)
+    uint32_t index = welder_.weld(vtx, static_cast<uint32_t>(vertices_.size()));
+    if(index == vertices_.size()) { vertices_.push_back(VertexAndNormal(vtx)); }
+    return index;
 }
 
-void TriSurface::calculate_tangent_space()
+VertexCacheStats TriSurface::optimize_face_order(bool reduce_overdraw)
 {
-    if (vertices_with_tex_.empty())
+    VertexCacheStats stats{0.0f, 0.0f};
+    if(vao_ != 0 || pooled_.pool != nullptr)
     {
-        return;
+        std::cout << "TriSurface: reorder faces before creating the vertex buffers\n";
+        return stats;
     }
 
-    // Initialize tangent space vertices from texture vertices
-    vertices_with_tangents_.resize(vertices_with_tex_.size());
-    for (size_t i = 0; i < vertices_with_tex_.size(); i++)
-    {
-        vertices_with_tangents_[i].vertex = vertices_with_tex_[i].vertex;
-        vertices_with_tangents_[i].normal = vertices_with_tex_[i].normal;
-        vertices_with_tangents_[i].texcoord = vertices_with_tex_[i].texcoord;
-        vertices_with_tangents_[i].tangent = Vector3(0.0f, 0.0f, 0.0f);
-        vertices_with_tangents_[i].bitangent = Vector3(0.0f, 0.0f, 0.0f);
-    }
+    std::vector<Point3> positions;
+    get_positions(positions);
+    uint32_t              vertex_count = static_cast<uint32_t>(positions.size());
+    std::vector<uint32_t> faces;
+    faces_.visit([&faces](const auto &f) { faces.assign(f.begin(), f.end()); });
 
-    // Calculate tangent and bitangent for each triangle
-    for (size_t i = 0; i < faces_.size(); i += 3)
+    // The optimizers index per-vertex tables with the face indexes
+    for(uint32_t index : faces)
     {
-        uint16_t i0 = faces_[i];
-        uint16_t i1 = faces_[i + 1];
-        uint16_t i2 = faces_[i + 2];
-
-        const Point3 &v0 = vertices_with_tangents_[i0].vertex;
-        const Point3 &v1 = vertices_with_tangents_[i1].vertex;
-        const Point3 &v2 = vertices_with_tangents_[i2].vertex;
-
-        const Point2 &uv0 = vertices_with_tangents_[i0].texcoord;
-        const Point2 &uv1 = vertices_with_tangents_[i1].texcoord;
-        const Point2 &uv2 = vertices_with_tangents_[i2].texcoord;
-
-        // Edge vectors
-        Vector3 edge1(v0, v1);
-        Vector3 edge2(v0, v2);
-
-        // UV deltas
-        float du1 = uv1.x - uv0.x;
-        float dv1 = uv1.y - uv0.y;
-        float du2 = uv2.x - uv0.x;
-        float dv2 = uv2.y - uv0.y;
-
-        float det = du1 * dv2 - du2 * dv1;
-        if (std::abs(det) < 1e-6f)
+        if(index >= vertex_count)
         {
-            // Degenerate UV - use default tangent space
-            continue;
+            std::cout << "TriSurface: face index " << index << " is past the " << vertex_count
+                      << " vertices, faces not reordered\n";
+            return stats;
         }
-
-        float r = 1.0f / det;
-
-        Vector3 tangent(
-            r * (dv2 * edge1.x - dv1 * edge2.x),
-            r * (dv2 * edge1.y - dv1 * edge2.y),
-            r * (dv2 * edge1.z - dv1 * edge2.z)
-        );
-
-        Vector3 bitangent(
-            r * (-du2 * edge1.x + du1 * edge2.x),
-            r * (-du2 * edge1.y + du1 * edge2.y),
-            r * (-du2 * edge1.z + du1 * edge2.z)
-        );
-
-        // Accumulate for averaging
-        vertices_with_tangents_[i0].tangent += tangent;
-        vertices_with_tangents_[i1].tangent += tangent;
-        vertices_with_tangents_[i2].tangent += tangent;
-
-        vertices_with_tangents_[i0].bitangent += bitangent;
-        vertices_with_tangents_[i1].bitangent += bitangent;
-        vertices_with_tangents_[i2].bitangent += bitangent;
     }
+    stats.acmr_before = compute_acmr(faces, vertex_count);
+
+    optimize_vertex_cache(faces, vertex_count);
+    if(reduce_overdraw) { optimize_overdraw(faces, positions); }
+
+    // Vertices in first use order. Texture coordinate and tangent space
+    // lists both exist once calculate_tangent_space is called.
+    std::vector<uint32_t> remap;
+    optimize_vertex_fetch(faces, vertex_count, remap);
+    reorder_vertices(vertices_, remap);
+    reorder_vertices(vertices_with_tex_, remap);
+    reorder_vertices(vertices_with_tangents_, remap);
+    faces_.assign(faces);
+    welder_.clear();
+
+    stats.acmr_after = compute_acmr(faces, vertex_count);
+    return stats;
+}
 
-    // Orthonormalize using Gram-Schmidt
-    for (auto &v : vertices_with_tangents_)
+void TriSurface::calculate_tangent_space()
+{
+    if (vertices_with_tex_.empty())
     {
-        Vector3 &n = v.normal;
-        Vector3 &t = v.tangent;
-        Vector3 &b = v.bitangent;
-
-        // Gram-Schmidt: t' = t - (n . t) * n
-        float dot_nt = n.dot(t);
-        t.x -= dot_nt * n.x;
-        t.y -= dot_nt * n.y;
-        t.z -= dot_nt * n.z;
-        t.normalize();
-
-        // Recalculate bitangent: b = n x t
-        b = n.cross(t);
-        b.normalize();
+        return;
     }
 
+    // Accumulate the tangent and bitangent of each triangle at its vertices,
+    // then orthonormalize using Gram-Schmidt (t' = t - (n . t) * n, b = n x t).
+    // Degenerate UV faces are skipped.
+    VertexStream stream;
+    stream.load(vertices_with_tex_);
+    faces_.visit([&stream](const auto &f) { stream.accumulate_tangents(f.data(), f.size()); });
+    stream.orthonormalize_tangents();
+    stream.store(vertices_with_tangents_);
+
     has_tangent_space_ = true;
 }
 
-void TriSurface::create_vertex_buffers(int32_t position_loc, int32_t normal_loc, int32_t texcoord_loc,
-                                       int32_t tangent_loc, int32_t bitangent_loc)
+void TriSurface::build_bvh()
 {
-    has_texture_coords_ = true;
-    has_tangent_space_ = true;
-
-    // Generate vertex buffers
-    glGenBuffers(1, &vbo_);
-    glGenBuffers(1, &facebuffer_);
-
-    // Bind vertex data
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-    glBufferData(GL_ARRAY_BUFFER,
-                 vertices_with_tangents_.size() * sizeof(VertexNormalTextureTangent),
-                 (void *)&vertices_with_tangents_[0],
-                 GL_STATIC_DRAW);
-
-    // Bind face data
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, facebuffer_);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                 faces_.size() * sizeof(uint16_t),
-                 (void *)&faces_[0],
-                 GL_STATIC_DRAW);
-
-    face_count_ = static_cast<GLsizei>(faces_.size());
-
-    // Create and configure VAO
-    glGenVertexArrays(1, &vao_);
-    glBindVertexArray(vao_);
+    if(cpu_data_released_)
+    {
+        std::cout << "TriSurface: build the BVH before releasing the CPU data\n";
+        return;
+    }
 
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    // Use whichever vertex list this surface was built with. The BVH reads
+    // positions directly from it.
+    faces_.visit(
+        [this](const auto &f)
+        {
+            if(!vertices_.empty()) { bvh_.build(vertices_, f); }
+            else if(!vertices_with_tex_.empty()) { bvh_.build(vertices_with_tex_, f); }
+            else { bvh_.build(vertices_with_tangents_, f); }
+        });
+}
 
-    size_t offset = 0;
+const MeshBVH &TriSurface::get_bvh() const { return bvh_; }
 
-    // Position (3 floats)
-    if (position_loc >= 0)
+void TriSurface::set_occluder(bool occluder)
+{
+    if(cpu_data_released_)
     {
-        glVertexAttribPointer(position_loc, 3, GL_FLOAT, GL_FALSE,
-                              sizeof(VertexNormalTextureTangent), (void *)offset);
-        glEnableVertexAttribArray(position_loc);
+        std::cout << "TriSurface: set occluders before releasing the CPU data\n";
+        return;
     }
-    offset += sizeof(Point3);
-
-    // Normal (3 floats)
-    if (normal_loc >= 0)
+    is_occluder_ = occluder;
+    occluder_.vertices.clear();
+    occluder_.faces.clear();
+    if(occluder)
     {
-        glVertexAttribPointer(normal_loc, 3, GL_FLOAT, GL_FALSE,
-                              sizeof(VertexNormalTextureTangent), (void *)offset);
-        glEnableVertexAttribArray(normal_loc);
+        get_positions(occluder_.vertices);
+        faces_.visit([this](const auto &f) { occluder_.faces.assign(f.begin(), f.end()); });
     }
-    offset += sizeof(Vector3);
+}
 
-    // Texcoord (2 floats)
-    if (texcoord_loc >= 0)
+void TriSurface::get_positions(std::vector<Point3> &positions) const
+{
+    // Use whichever vertex list this surface was built with
+    positions.clear();
+    if(!vertices_.empty())
     {
-        glVertexAttribPointer(texcoord_loc, 2, GL_FLOAT, GL_FALSE,
-                              sizeof(VertexNormalTextureTangent), (void *)offset);
-        glEnableVertexAttribArray(texcoord_loc);
+        positions.reserve(vertices_.size());
+        for(const auto &v : vertices_) { positions.push_back(v.vertex); }
     }
-    offset += sizeof(Point2);
-
-    // Tangent (3 floats)
-    if (tangent_loc >= 0)
+    else if(!vertices_with_tex_.empty())
     {
-        glVertexAttribPointer(tangent_loc, 3, GL_FLOAT, GL_FALSE,
-                              sizeof(VertexNormalTextureTangent), (void *)offset);
-        glEnableVertexAttribArray(tangent_loc);
+        positions.reserve(vertices_with_tex_.size());
+        for(const auto &v : vertices_with_tex_) { positions.push_back(v.vertex); }
     }
-    offset += sizeof(Vector3);
+    else
+    {
+        positions.reserve(vertices_with_tangents_.size());
+        for(const auto &v : vertices_with_tangents_) { positions.push_back(v.vertex); }
+    }
+}
+
+void TriSurface::update_local_bounds()
+{
+    std::vector<Point3> positions;
+    get_positions(positions);
+    set_local_bounds(positions);
+}
 
-    // Bitangent (3 floats)
-    if (bitangent_loc >= 0)
+void TriSurface::set_packing_uniforms(SceneState &scene_state) const
+{
+    // Uniform values are cached, so unchanged layouts cost nothing
+    scene_state.gl_state.uniform1i(scene_state.vertex_packing_loc, packing_flags_);
+    if(packing_flags_ & PACKED_POSITION)
     {
-        glVertexAttribPointer(bitangent_loc, 3, GL_FLOAT, GL_FALSE,
-                              sizeof(VertexNormalTextureTangent), (void *)offset);
-        glEnableVertexAttribArray(bitangent_loc);
+        scene_state.gl_state.uniform3f(scene_state.position_offset_loc,
+                                       position_offset_.x,
+                                       position_offset_.y,
+                                       position_offset_.z);
+        scene_state.gl_state.uniform3f(scene_state.position_scale_loc,
+                                       position_scale_.x,
+                                       position_scale_.y,
+                                       position_scale_.z);
     }
+}
 
+void TriSurface::upload_faces()
+{
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, facebuffer_);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                 faces_.size() * faces_.index_size(),
+                 faces_.data(),
+                 GL_STATIC_DRAW);
 
-    glBindVertexArray(0);
+    // Copy the face list count and index type for use in Draw
+    face_count_ = static_cast<GLsizei>(faces_.size());
+    index_type_ = faces_.is_wide() ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
 }
 
 } // namespace cg
@@ -13,14 +13,28 @@
 #ifndef __SCENE_TRI_SURFACE_HPP__
 #define __SCENE_TRI_SURFACE_HPP__
 
+#include "geometry/index_list.hpp"
+#include "geometry/mesh_bvh.hpp"
+#include "geometry/vertex_cache.hpp"
+#include "geometry/vertex_packing.hpp"
+#include "geometry/vertex_welder.hpp"
 #include "scene/geometry_node.hpp"
+#include "scene/vertex_format.hpp"
 
 namespace cg
 {
 
 /**
  * Triangle mesh surface. Uses indexed vertex arrays. Stores
- * vertices as VertexAndNormal or VertexNormalTexture.
+ * vertices as VertexAndNormal or VertexNormalTexture. The face list uses
+ * 16 bit indexes unless the mesh has more than 65536 vertices, in which
+ * case it switches to 32 bit indexes (see IndexList). The vertex buffer
+ * can be replaced by a compressed one (see pack_vertices).
+ *
+ * The vertex attribute setup of each vertex type comes from its
+ * VertexFormat. Once uploaded, the CPU copies of the vertex and face lists
+ * can be released (see release_cpu_data) unless a consumer that reads them
+ * later asked to keep them (see keep_cpu_data).
  */
 class TriSurface : public GeometryNode
 {
@@ -40,6 +54,21 @@ class TriSurface : public GeometryNode
      */
     void draw(SceneState &scene_state) override;
 
+    /**
+     * Check whether this surface can be instanced. Surfaces with tangent
+     * space cannot: their tangent and bitangent attributes may use the
+     * locations of the instance attributes.
+     */
+    bool can_draw_instances() const override;
+
+    /**
+     * Draw a run of instances with glDrawElementsInstanced.
+     */
+    void draw_instances(SceneState           &scene_state,
+                        const InstanceBuffer &instances,
+                        uint32_t              first,
+                        uint32_t              count) override;
+
     /**
      * Construct triangle surface by passing in vertex list and face list
      * @param  v  List of vertices (position and normal)
@@ -47,9 +76,26 @@ class TriSurface : public GeometryNode
      */
     void construct(const std::vector<VertexAndNormal> &v, const std::vector<uint16_t> &f);
 
+    /**
+     * Construct triangle surface from a vertex list and a 32 bit face list.
+     * The face list is stored with 16 bit indexes if all of them fit.
+     * @param  v  List of vertices (position and normal)
+     * @param  f  Index list for triangles
+     */
+    void construct(const std::vector<VertexAndNormal> &v, const std::vector<uint32_t> &f);
+
+    /**
+     * Construct textured triangle surface from a vertex list and a 32 bit
+     * face list (see above).
+     * @param  v  List of vertices (position, normal, and texture coordinates)
+     * @param  f  Index list for triangles
+     */
+    void construct(const std::vector<VertexNormalTexture> &v, const std::vector<uint32_t> &f);
+
     /**
      * Adds the vertices of the triangle to the vertex list. Accounts for
-     * shared vertices by checking if the vertex is already in the list.
+     * shared vertices by checking if the vertex is already in the list
+     * (within the weld epsilon, see set_weld_epsilon).
      * Manages the face list as well - stores indexes into the vertex list
      * for this triangle. This method allows triangles to be added one at
      * a time to a curved surface. Call End() when done to get vertex normal
@@ -67,6 +113,13 @@ class TriSurface : public GeometryNode
      */
     void add_polygon(const std::vector<Point3> &vertex_list);
 
+    /**
+     * Set the distance within which add treats positions as the same
+     * vertex. Compared per axis; 0 shares identical positions only.
+     * @param  epsilon  Weld distance (WELD_EPSILON by default)
+     */
+    void set_weld_epsilon(float epsilon);
+
     /**
      * Marks the end of a triangle mesh. Calculates the vertex normals.
      */
@@ -88,12 +141,158 @@ class TriSurface : public GeometryNode
     void create_vertex_buffers(int32_t position_loc, int32_t normal_loc, int32_t texcoord_loc,
                                int32_t tangent_loc, int32_t bitangent_loc);
 
+    /**
+     * Replace the vertex buffer with a compressed one (see PackedVertices):
+     * octahedral normals or QTangent frames, half float texture
+     * coordinates, and optionally quantized positions. The program that
+     * draws the surface must decode them (the vertex_packing uniform).
+     * Call once, after the vertex buffers are created. Packed surfaces are
+     * not added to geometry pools.
+     * @param  packing  What to compress
+     * @return  Returns false if the vertex buffers do not exist yet, the
+     *          surface is pooled, or it is already packed.
+     */
+    bool pack_vertices(VertexPacking packing);
+
+    /**
+     * Get the size of a vertex in the vertex buffer.
+     * @return  Returns the bytes per vertex (0 before the buffers exist).
+     */
+    uint32_t get_vertex_size() const;
+
+    /**
+     * Move the vertex and face lists into a geometry pool and delete this
+     * surface's own buffers. The vertex lists are kept until
+     * release_cpu_data is called.
+     * @param  pool  Geometry pool
+     * @return  Returns false (and leaves the surface unchanged) if the pool
+     *          has a different vertex layout, the surface has tangent space,
+     *          or its CPU copies were released.
+     */
+    bool move_to_pool(GeometryPool &pool);
+
+    /**
+     * Keep the CPU copies of the vertex and face lists when release_cpu_data
+     * is called. For consumers that read them after upload (picking,
+     * physics, rebuilding a BVH). Cannot be undone.
+     */
+    void keep_cpu_data();
+
+    /**
+     * Free the CPU copies of the vertex and face lists once they are in a
+     * vertex buffer or a geometry pool. Bounds, the BVH, and the occluder
+     * mesh are separate copies and stay valid, as do the vertex and index
+     * counts. Afterwards the surface can still be drawn, but not packed,
+     * pooled, reordered, or baked.
+     * @return  Returns the number of bytes freed (0 if the surface is not
+     *          uploaded yet, was asked to keep its copies, or was already
+     *          released).
+     */
+    size_t release_cpu_data();
+
+    /**
+     * Check whether the CPU copies of the vertex and face lists exist.
+     * @return  Returns false once release_cpu_data has freed them.
+     */
+    bool has_cpu_data() const;
+
+    /**
+     * Get where this surface is in a geometry pool.
+     * @return  Returns the pooled mesh, or nullptr if not pooled.
+     */
+    const PooledMesh *get_pooled_mesh() const override;
+
+    /**
+     * Check whether the surface was built with texture coordinates.
+     * @return  Returns true if the vertex list has texture coordinates.
+     */
+    bool has_texture_coords() const;
+
+    /**
+     * Check whether the surface was built with tangent space.
+     * @return  Returns true if the vertex list has tangents and bitangents.
+     */
+    bool has_tangent_space() const;
+
+    /**
+     * Get the number of vertices.
+     * @return  Returns the size of the vertex list this surface was built with
+     *          (also after the list is released).
+     */
+    uint32_t get_vertex_count() const;
+
+    /**
+     * Get the number of face list indexes (3 per triangle).
+     * @return  Returns the size of the face list.
+     */
+    uint32_t get_index_count() const;
+
+    /**
+     * Copy the vertex and face lists into a merged mesh, transforming
+     * positions and normals to world coordinates. Triangles are reversed if
+     * the transform mirrors them so they stay counter-clockwise. Used by
+     * StaticBaker; the surface must not have texture coordinates and must
+     * still have its CPU copies.
+     * @param  world        World transform of the surface
+     * @param  vertices     Returns get_vertex_count() transformed vertices
+     * @param  faces        Returns get_index_count() indexes
+     * @param  base_vertex  Index of the first copied vertex in the merged mesh
+     */
+    void copy_transformed(const AffineTransform3 &world,
+                          VertexAndNormal        *vertices,
+                          uint32_t               *faces,
+                          uint32_t                base_vertex) const;
+
+    /**
+     * Copy the textured vertex and face lists into a merged mesh (see
+     * above). The surface must have texture coordinates.
+     */
+    void copy_transformed(const AffineTransform3 &world,
+                          VertexNormalTexture    *vertices,
+                          uint32_t               *faces,
+                          uint32_t                base_vertex) const;
+
+    /**
+     * Reorder the face list for the post-transform vertex cache (Tipsify)
+     * and optionally to reduce overdraw, then renumber the vertices in the
+     * order the faces first use them. Shape constructors opt in by calling
+     * this once the vertex and face lists are complete, before the vertex
+     * buffers are created and before build_bvh or set_occluder. Face lists
+     * that index past the vertex list are left as they are.
+     * @param  reduce_overdraw  Also order clusters of faces so that those
+     *                          likely to occlude others are drawn first
+     *                          (for concave surfaces).
+     * @return  Returns the ACMR of the face list before and after.
+     */
+    VertexCacheStats optimize_face_order(bool reduce_overdraw = false);
+
     /**
      * Calculate tangent space vectors from texture coordinates.
      * Must be called after vertices_with_tex_ is populated.
      */
     void calculate_tangent_space();
 
+    /**
+     * Builds a bounding volume hierarchy over the triangles of this surface
+     * for ray queries (picking, baking). Call once the vertex and face lists
+     * are complete.
+     */
+    void build_bvh();
+
+    /**
+     * Get the bounding volume hierarchy (empty unless build_bvh was called).
+     * @return  Returns the BVH for this surface.
+     */
+    const MeshBVH &get_bvh() const;
+
+    /**
+     * Use this surface as an occluder. Copies the positions and faces into
+     * the occluder mesh, so call once the vertex and face lists are
+     * complete. Best suited to large, simple surfaces (walls, table tops).
+     * @param  occluder  True to make this surface an occluder.
+     */
+    void set_occluder(bool occluder);
+
   protected:
     // Vertex buffer support
     GLsizei face_count_;
@@ -101,6 +300,16 @@ class TriSurface : public GeometryNode
     GLuint  vbo_;
     GLuint  facebuffer_;
 
+    // Attribute locations the vertex array was set up with
+    AttributeLocations attribute_locs_;
+
+    // Layout of the vertex buffer: bytes per vertex and the PACKED_* flags
+    // and position dequantization of a packed buffer
+    uint32_t vertex_size_;
+    int32_t  packing_flags_;
+    Point3   position_offset_;
+    Vector3  position_scale_;
+
     // Vertex and normal list
     std::vector<VertexAndNormal> vertices_;
 
@@ -112,8 +321,26 @@ class TriSurface : public GeometryNode
     std::vector<VertexNormalTextureTangent> vertices_with_tangents_;
     bool                                    has_tangent_space_;
 
-    // Use uint16_t for face list indexes (OpenGL ES compatible)
-    std::vector<uint16_t> faces_;
+    // Face list. Uses uint16_t indexes (OpenGL ES compatible) unless an
+    // index does not fit.
+    IndexList faces_;
+    GLenum    index_type_; // Index type of the face buffer (set on upload)
+
+    // CPU copy state: the vertex count is recorded when the lists are freed
+    bool     keep_cpu_data_;
+    bool     cpu_data_released_;
+    uint32_t released_vertex_count_;
+
+    // Location in a geometry pool (pool is nullptr if the surface uses its
+    // own buffers)
+    PooledMesh pooled_;
+
+    // Bounding volume hierarchy for ray queries
+    MeshBVH bvh_;
+
+    // Spatial hash of the vertex list for add_vertex. Vertices appended
+    // directly are hashed on the next add_vertex.
+    VertexWelder welder_;
 
     /**
      * Form triangle face indexes for a surface constructed using a double loop -
@@ -127,17 +354,58 @@ class TriSurface : public GeometryNode
 
     // Convenience method to get the index into the vertex list given the
     // "row" and "column" of the subdivision/grid
-    uint16_t get_index(uint32_t row, uint32_t col, uint32_t num_cols) const;
+    uint32_t get_index(uint32_t row, uint32_t col, uint32_t num_cols) const;
 
     /**
      * Adds a vertex to the surface vertex list.  Returns the index into the
-     * vertex list.  If the vertex is already in the list it does not
-     * replicate it.
+     * vertex list.  If the vertex is already in the list (within the weld
+     * epsilon) it does not replicate it. Takes expected constant time.
      * @param  vtx  Vertex
      */
-    uint16_t add_vertex(const Point3 &vtx);
+    uint32_t add_vertex(const Point3 &vtx);
+
+    /**
+     * Get the vertex positions from whichever vertex list this surface was
+     * built with.
+     * @param  positions  Returns the vertex positions.
+     */
+    void get_positions(std::vector<Point3> &positions) const;
+
+    /**
+     * Set the local bounding box and sphere from the vertex list. Called
+     * when the vertex buffers are created.
+     */
+    void update_local_bounds();
+
+    /**
+     * Tell the current program how to decode the vertex buffer.
+     */
+    void set_packing_uniforms(SceneState &scene_state) const;
+
+    /**
+     * Create the vertex array, vertex buffer, and face buffer for a vertex
+     * list, setting up the attributes from VertexFormat<V>.
+     * @param  vertices   Vertex list
+     * @param  locations  Attribute location of each slot
+     */
+    template <typename V>
+    void create_vertex_buffers(const std::vector<V> &vertices, const AttributeLocations &locations);
+
+    /**
+     * Upload the face list to the face buffer and set the face count and
+     * index type.
+     */
+    void upload_faces();
 };
 
+/**
+ * Release the CPU copies of every uploaded surface below a node (see
+ * TriSurface::release_cpu_data). Shared surfaces are released once.
+ * @param  root  Root of the subtree
+ * @return  Returns the number of bytes freed.
+ */
+size_t release_cpu_data(SceneNode &root);
+
 } // namespace cg
 
 #endif
@@ -31,6 +31,7 @@ UnitSquareSurface::UnitSquareSurface(uint32_t n, int32_t position_loc, int32_t n
 
     // Construct the face list and create VBOs
     construct_row_col_face_list(n + 1, n + 1);
+    optimize_face_order();
     create_vertex_buffers(position_loc, normal_loc);
 
     std::cout << "vertex list size = " << vertices_.size();
@@ -68,6 +69,7 @@ UnitSquareSurface::UnitSquareSurface(uint32_t n, int32_t position_loc, int32_t n
 
     // Construct the face list and create VBOs with texture coordinates
     construct_row_col_face_list(n + 1, n + 1);
+    optimize_face_order();
     create_vertex_buffers(position_loc, normal_loc, tex_coord_loc);
 
     std::cout << "vertex list size = " << vertices_with_tex_.size();
@@ -105,6 +107,7 @@ UnitSquareSurface::UnitSquareSurface(uint32_t n, int32_t position_loc, int32_t n
 
     // Construct the face list and create VBOs with texture coordinates
     construct_row_col_face_list(n + 1, n + 1);
+    optimize_face_order();
     create_vertex_buffers(position_loc, normal_loc, tex_coord_loc);
 
     std::cout << "vertex list size with texture = " << vertices_with_tex_.size();
@@ -146,6 +149,7 @@ UnitSquareSurface::UnitSquareSurface(uint32_t n, int32_t position_loc, int32_t n
 
     // Construct the face list and create VBOs with tangent space
     construct_row_col_face_list(n + 1, n + 1);
+    optimize_face_order();
     has_tangent_space_ = true;
     create_vertex_buffers(position_loc, normal_loc, tex_coord_loc, tangent_loc, bitangent_loc);
 
@@ -0,0 +1,36 @@
+#include "scene/vertex_format.hpp"
+
+namespace cg
+{
+
+void set_vertex_attributes(const VertexAttribute    *attributes,
+                           size_t                    count,
+                           GLsizei                   stride,
+                           const AttributeLocations &locations)
+{
+    bool used[VERTEX_ATTRIBUTE_SLOT_COUNT] = {};
+    for(size_t i = 0; i < count; i++)
+    {
+        const VertexAttribute &a = attributes[i];
+        uint32_t               slot = static_cast<uint32_t>(a.slot);
+        used[slot] = true;
+        GLint loc = locations[slot];
+        if(loc < 0) { continue; }
+        glVertexAttribPointer(loc,
+                              a.size,
+                              a.type,
+                              a.normalized,
+                              stride,
+                              reinterpret_cast<const void *>(static_cast<uintptr_t>(a.offset)));
+        glEnableVertexAttribArray(loc);
+    }
+
+    // A layout without a slot (a packed QTangent replaces the tangent and
+    // bitangent) must not leave an earlier pointer enabled
+    for(uint32_t slot = 0; slot < VERTEX_ATTRIBUTE_SLOT_COUNT; slot++)
+    {
+        if(!used[slot] && locations[slot] >= 0) { glDisableVertexAttribArray(locations[slot]); }
+    }
+}
+
+} // namespace cg
@@ -0,0 +1,139 @@
+//============================================================================
+//	Johns Hopkins University Engineering Programs for Professionals
+//	605.667 Computer Graphics and 605.767 Applied Computer Graphics
+//	Instructor:	Brian Russin
+//
+//	Author:	 David W. Nesbitt
+//	File:    vertex_format.hpp
+//	Purpose: Compile-time descriptions of the interleaved vertex layouts and
+//           the vertex attribute pointer setup they drive.
+//
+//============================================================================
+
+#ifndef __SCENE_VERTEX_FORMAT_HPP__
+#define __SCENE_VERTEX_FORMAT_HPP__
+
+#include "geometry/types.hpp"
+#include "scene/graphics.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace cg
+{
+
+/**
+ * Vertex attributes a layout can provide. Each is bound to the attribute
+ * location the program gives for it (see AttributeLocations).
+ */
+enum class VertexAttributeSlot
+{
+    POSITION,
+    NORMAL,
+    TEXCOORD,
+    TANGENT,
+    BITANGENT
+};
+
+constexpr uint32_t VERTEX_ATTRIBUTE_SLOT_COUNT = 5;
+
+/**
+ * Attribute location of each VertexAttributeSlot (-1 if the program does
+ * not use it).
+ */
+using AttributeLocations = std::array<GLint, VERTEX_ATTRIBUTE_SLOT_COUNT>;
+
+/**
+ * Make attribute locations for the slots in order (unlisted slots are -1).
+ */
+constexpr AttributeLocations make_attribute_locations(GLint position_loc,
+                                                      GLint normal_loc,
+                                                      GLint texcoord_loc = -1,
+                                                      GLint tangent_loc = -1,
+                                                      GLint bitangent_loc = -1)
+{
+    return AttributeLocations{position_loc, normal_loc, texcoord_loc, tangent_loc, bitangent_loc};
+}
+
+/**
+ * One attribute of an interleaved vertex: the arguments of
+ * glVertexAttribPointer other than the location and stride.
+ */
+struct VertexAttribute
+{
+    VertexAttributeSlot slot;
+    GLint               size;       // Number of components
+    GLenum              type;       // Component type
+    GLboolean           normalized; // Integer components map to [0,1] or [-1,1]
+    uint32_t            offset;     // Byte offset within the vertex
+};
+
+/**
+ * Compile-time layout of a vertex structure. Specializations list the
+ * attributes of the structure in order.
+ */
+template <typename V>
+struct VertexFormat;
+
+template <>
+struct VertexFormat<VertexAndNormal>
+{
+    static constexpr std::array<VertexAttribute, 2> attributes{
+        {{VertexAttributeSlot::POSITION, 3, GL_FLOAT, GL_FALSE, offsetof(VertexAndNormal, vertex)},
+         {VertexAttributeSlot::NORMAL, 3, GL_FLOAT, GL_FALSE, offsetof(VertexAndNormal, normal)}}};
+};
+
+template <>
+struct VertexFormat<VertexNormalTexture>
+{
+    using V = VertexNormalTexture;
+    static constexpr std::array<VertexAttribute, 3> attributes{
+        {{VertexAttributeSlot::POSITION, 3, GL_FLOAT, GL_FALSE, offsetof(V, vertex)},
+         {VertexAttributeSlot::NORMAL, 3, GL_FLOAT, GL_FALSE, offsetof(V, normal)},
+         {VertexAttributeSlot::TEXCOORD, 2, GL_FLOAT, GL_FALSE, offsetof(V, texcoord)}}};
+};
+
+template <>
+struct VertexFormat<VertexNormalTextureTangent>
+{
+    using V = VertexNormalTextureTangent;
+    static constexpr std::array<VertexAttribute, 5> attributes{
+        {{VertexAttributeSlot::POSITION, 3, GL_FLOAT, GL_FALSE, offsetof(V, vertex)},
+         {VertexAttributeSlot::NORMAL, 3, GL_FLOAT, GL_FALSE, offsetof(V, normal)},
+         {VertexAttributeSlot::TEXCOORD, 2, GL_FLOAT, GL_FALSE, offsetof(V, texcoord)},
+         {VertexAttributeSlot::TANGENT, 3, GL_FLOAT, GL_FALSE, offsetof(V, tangent)},
+         {VertexAttributeSlot::BITANGENT, 3, GL_FLOAT, GL_FALSE, offsetof(V, bitangent)}}};
+};
+
+/**
+ * Point the attributes of the bound vertex array at the bound array buffer.
+ * Attributes the program has a location for are enabled; locations of slots
+ * the layout does not have are disabled.
+ * @param  attributes  Attributes of the layout
+ * @param  count       Number of attributes
+ * @param  stride      Bytes per vertex
+ * @param  locations   Attribute location of each slot
+ */
+void set_vertex_attributes(const VertexAttribute    *attributes,
+                           size_t                    count,
+                           GLsizei                   stride,
+                           const AttributeLocations &locations);
+
+/**
+ * Point the attributes of the bound vertex array at a buffer of V (see
+ * above).
+ * @param  locations  Attribute location of each slot
+ */
+template <typename V>
+void set_vertex_attributes(const AttributeLocations &locations)
+{
+    set_vertex_attributes(VertexFormat<V>::attributes.data(),
+                          VertexFormat<V>::attributes.size(),
+                          sizeof(V),
+                          locations);
+}
+
+} // namespace cg
+
+#endif
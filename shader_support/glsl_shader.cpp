@@ -92,6 +92,16 @@ void GLSLShader::log_compile_error(GLuint shader)
 
 GLSLVertexShader::GLSLVertexShader() : GLSLShader("Vertex", GL_VERTEX_SHADER) {}
 
+GLSLTessControlShader::GLSLTessControlShader() :
+    GLSLShader("Tessellation Control", GL_TESS_CONTROL_SHADER)
+{
+}
+
+GLSLTessEvaluationShader::GLSLTessEvaluationShader() :
+    GLSLShader("Tessellation Evaluation", GL_TESS_EVALUATION_SHADER)
+{
+}
+
 GLSLFragmentShader::GLSLFragmentShader() : GLSLShader("Fragment", GL_FRAGMENT_SHADER) {}
 
 } // namespace cg
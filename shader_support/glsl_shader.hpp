@@ -77,6 +77,24 @@ class GLSLVertexShader : public GLSLShader
     GLSLVertexShader();
 };
 
+/**
+ * GLSL tessellation control shader
+ */
+class GLSLTessControlShader : public GLSLShader
+{
+  public:
+    GLSLTessControlShader();
+};
+
+/**
+ * GLSL tessellation evaluation shader
+ */
+class GLSLTessEvaluationShader : public GLSLShader
+{
+  public:
+    GLSLTessEvaluationShader();
+};
+
 /**
  * GLSL fragment shader
  */
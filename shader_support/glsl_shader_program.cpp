@@ -24,6 +24,16 @@ bool GLSLShaderProgram::attach_shaders(GLuint vertex_shader, GLuint fragment_sha
     return true;
 }
 
+bool GLSLShaderProgram::attach_shaders(GLuint vertex_shader,
+                                       GLuint tess_control_shader,
+                                       GLuint tess_evaluation_shader,
+                                       GLuint fragment_shader)
+{
+    glAttachShader(shader_program_, tess_control_shader);
+    glAttachShader(shader_program_, tess_evaluation_shader);
+    return attach_shaders(vertex_shader, fragment_shader);
+}
+
 GLuint GLSLShaderProgram::get_program() const { return shader_program_; }
 
 void GLSLShaderProgram::use() { glUseProgram(shader_program_); }
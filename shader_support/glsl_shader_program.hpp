@@ -35,6 +35,15 @@ class GLSLShaderProgram
      */
     bool attach_shaders(GLuint vertex_shader, GLuint fragment_shader);
 
+    /**
+     * Attach the specified shaders, including tessellation control and
+     * evaluation shaders. Programs with tessellation shaders draw GL_PATCHES.
+     */
+    bool attach_shaders(GLuint vertex_shader,
+                        GLuint tess_control_shader,
+                        GLuint tess_evaluation_shader,
+                        GLuint fragment_shader);
+
     /**
      * Get the shader program handle
      * @return  Returns the handle to the shader program.